@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""Large-file check for the 64-bit offset paths.
+
+Writes a file of fixed-length lines past 4 GB (every line's number and byte
+offset are known from its position), puts markers on the lines that cross and
+follow the 2 GB and 4 GB boundaries and on the last line, then searches for them
+with `TotalSearch --headless` and checks the line number, byte offset and text of
+every match. Exit status 0 when all match, 1 otherwise.
+
+    python3 scripts/check_large_file.py [--exe ./TotalSearch.exe] [--engine builtin] ...
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+LINE_BYTES = 100                    # Every line, newline included
+LINES_PER_BLOCK = 100000
+GB = 1024 * 1024 * 1024
+
+
+def line_text(number, marker=""):
+    head = "%012d %s " % (number, marker or "filler")
+    return head + "x" * (LINE_BYTES - 1 - len(head))
+
+
+def marker_lines(total_lines):
+    """Marker name by line number (1-based)."""
+    markers = {}
+    for name, boundary in (("2G", 2 * GB), ("4G", 4 * GB)):
+        crossing = (boundary - 1) // LINE_BYTES + 1  # Holds the last byte before the boundary
+        markers[crossing] = "MARKER_%s_CROSS" % name
+        markers[crossing + 1] = "MARKER_%s_AFTER" % name
+    markers[total_lines] = "MARKER_LAST"
+    return markers
+
+
+def write_file(path, total_lines, markers):
+    start = time.time()
+    with open(path, "wb") as out:
+        for first in range(1, total_lines + 1, LINES_PER_BLOCK):
+            last = min(total_lines, first + LINES_PER_BLOCK - 1)
+            block = "\n".join(line_text(n, markers.get(n, "")) for n in range(first, last + 1)) + "\n"
+            out.write(block.encode("ascii"))
+    print("Wrote %s: %d lines, %.2f GB in %.0f s" %
+          (path, total_lines, total_lines * LINE_BYTES / GB, time.time() - start))
+
+
+def run_search(exe, path, engine):
+    command = [exe, "--headless", "-e", "MARKER_[0-9A-Z_]+", "-p", path, "--max-results", "0", "--format", "jsonl"]
+    if engine:
+        command += ["--engine", engine]
+    print("Running: " + " ".join(command))
+    start = time.time()
+    result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True)
+    print("Search took %.1f s, exit status %d" % (time.time() - start, result.returncode))
+    if result.returncode != 0:
+        sys.stderr.write(result.stderr)
+    records = [json.loads(line) for line in result.stdout.splitlines() if line.strip()]
+    return result.returncode, [record for record in records if record.get("type") == "match"]
+
+
+def check_matches(matches, markers):
+    failures = 0
+    found = {}
+    for match in matches:
+        found[match["line"]] = match
+
+    for number in sorted(markers):
+        expected_offset = (number - 1) * LINE_BYTES
+        expected_text = line_text(number, markers[number])
+        match = found.get(number)
+        if match is None:
+            print("FAIL %-18s line %d (offset %d) not reported" % (markers[number], number, expected_offset))
+            failures += 1
+            continue
+        problems = []
+        if match["offset"] != expected_offset:
+            problems.append("offset %d, expected %d" % (match["offset"], expected_offset))
+        if match.get("text") != expected_text:
+            problems.append("text %r" % match.get("text"))
+        if problems:
+            print("FAIL %-18s line %d: %s" % (markers[number], number, "; ".join(problems)))
+            failures += 1
+        else:
+            print("ok   %-18s line %d at offset %d" % (markers[number], number, expected_offset))
+
+    extra = sorted(set(found) - set(markers))
+    if extra:
+        print("FAIL %d matches on lines without a marker, e.g. line %d" % (len(extra), extra[0]))
+        failures += 1
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Check line numbers and byte offsets past 2 GB and 4 GB through --headless.")
+    parser.add_argument("--exe", default="./TotalSearch.exe" if os.name == "nt" else "./TotalSearch",
+                        help="TotalSearch executable")
+    parser.add_argument("--file", help="Test file to write (default: in the temp directory)")
+    parser.add_argument("--size-gb", type=float, default=4.5, help="File size, at least 4.1 GB")
+    parser.add_argument("--engine", action="append", default=[],
+                        help="Search backend to check (repeatable; default: the one in App.ini)")
+    parser.add_argument("--keep", action="store_true", help="Keep the file, and reuse it if it has the right size")
+    args = parser.parse_args()
+
+    if args.size_gb < 4.1:
+        parser.error("--size-gb must be at least 4.1 to reach past 4 GB")
+
+    total_lines = int(args.size_gb * GB) // LINE_BYTES
+    markers = marker_lines(total_lines)
+    path = args.file or os.path.join(tempfile.gettempdir(), "totalsearch_large_%d.log" % total_lines)
+
+    if not (args.keep and os.path.exists(path) and os.path.getsize(path) == total_lines * LINE_BYTES):
+        write_file(path, total_lines, markers)
+
+    failures = 0
+    try:
+        for engine in args.engine or [None]:
+            status, matches = run_search(args.exe, path, engine)
+            if status != 0:
+                failures += 1
+            failures += check_matches(matches, markers)
+    finally:
+        if not args.keep:
+            os.remove(path)
+
+    print("Large file check " + ("passed" if failures == 0 else "FAILED (%d problems)" % failures))
+    return 0 if failures == 0 else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
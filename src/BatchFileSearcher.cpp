@@ -0,0 +1,326 @@
+#include "BatchFileSearcher.h"
+#include "RgJsonParser.h"
+#include "logger.h"
+#include <QFile>
+#include <QTextStream>
+#include <cstring>
+
+BatchFileSearcher::BatchFileSearcher(FileSearcher *engine, const QVector<NamedPattern> &patterns, QObject *parent)
+    : FileSearcher(parent)
+    , m_engine(engine)
+    , m_patterns(patterns.mid(0, MaxPatterns))
+    , m_options(QRegularExpression::NoPatternOption)
+    , m_fixedString(false)
+    , m_nextTicket(0)
+    , m_emitTicket(0)
+    , m_unattributedLines(0)
+{
+    m_engine->setParent(this);
+
+    if (patterns.size() > MaxPatterns) {
+        LOG_WARNING("BatchFileSearcher: " + QString::number(patterns.size()) + " patterns given, only the first " +
+                    QString::number(MaxPatterns) + " are searched");
+    }
+
+    connect(m_engine, &FileSearcher::outputChunk, this, [this](const QByteArray &jsonLines) {
+        filterEngineChunk(jsonLines);
+    }, Qt::DirectConnection);
+    connect(m_engine, &FileSearcher::finished, this, [this](int exitCode) {
+        finishRun(exitCode);
+    });
+    connect(m_engine, &FileSearcher::errorOccurred, this, &FileSearcher::errorOccurred, Qt::DirectConnection);
+    connect(m_engine, &FileSearcher::fileSearched, this, &FileSearcher::fileSearched, Qt::DirectConnection);
+}
+
+BatchFileSearcher::~BatchFileSearcher()
+{
+    qDeleteAll(m_freeMatchers);
+}
+
+bool BatchFileSearcher::loadPatternList(const QString &filePath, QVector<NamedPattern> *patterns, QString *error)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *error = QString("Cannot open pattern list %1: %2").arg(filePath, file.errorString());
+        return false;
+    }
+
+    patterns->clear();
+    QTextStream in(&file);
+    int lineNumber = 0;
+    while (!in.atEnd()) {
+        QString line = in.readLine();
+        lineNumber++;
+        if (line.trimmed().isEmpty() || line.trimmed().startsWith('#')) {
+            continue;
+        }
+
+        NamedPattern named;
+        int tab = line.indexOf('\t');
+        if (tab >= 0) {
+            named.name = line.left(tab).trimmed();
+            named.pattern = line.mid(tab + 1);
+        } else {
+            named.pattern = line;
+        }
+        if (named.pattern.isEmpty()) {
+            *error = QString("%1:%2: empty pattern").arg(filePath).arg(lineNumber);
+            return false;
+        }
+        if (named.name.isEmpty()) {
+            named.name = named.pattern;
+        }
+        patterns->append(named);
+    }
+
+    if (patterns->isEmpty()) {
+        *error = QString("No patterns in %1").arg(filePath);
+        return false;
+    }
+    if (patterns->size() > MaxPatterns) {
+        *error = QString("%1 has %2 patterns - a batch search takes at most %3").arg(filePath).arg(patterns->size()).arg(MaxPatterns);
+        return false;
+    }
+
+    LOG_INFO("BatchFileSearcher: Loaded " + QString::number(patterns->size()) + " patterns from " + filePath);
+    return true;
+}
+
+QString BatchFileSearcher::escapeLiteral(const QString &text)
+{
+    // Only the characters that are special outside a class - ripgrep rejects some escapes of
+    // other characters (\< and \> are word boundaries there)
+    static const QString special = QStringLiteral("\\.+*?()|[]{}^$");
+    QString escaped;
+    escaped.reserve(text.size() * 2);
+    for (QChar c : text) {
+        if (special.contains(c)) {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+QString BatchFileSearcher::combinedPattern(const QVector<NamedPattern> &patterns, bool fixedString)
+{
+    QStringList alternatives;
+    for (const NamedPattern &named : patterns) {
+        alternatives << "(?:" + (fixedString ? escapeLiteral(named.pattern) : named.pattern) + ")";
+    }
+    return alternatives.join('|');
+}
+
+QString BatchFileSearcher::engineName() const
+{
+    return m_engine->engineName();
+}
+
+bool BatchFileSearcher::canSearchTargets(const QVector<SearchTarget> &targets) const
+{
+    return m_engine->canSearchTargets(targets);
+}
+
+QStringList BatchFileSearcher::candidateFiles(const RGSearchParams &params) const
+{
+    return m_engine->candidateFiles(params);
+}
+
+void BatchFileSearcher::start(const RGSearchParams &params)
+{
+    m_cancelled.store(false);
+    m_engine->setCancelToken(m_cancelToken);
+    m_engine->setFlowControl(m_flowControl);
+    m_timer.start();
+
+    // The engine gets one regular expression - literal patterns are escaped into it
+    RGSearchParams engineParams = params;
+    m_fixedString = params.fixed_string;
+    engineParams.pattern = combinedPattern(m_patterns, m_fixedString);
+    engineParams.add_pattern.clear();
+    engineParams.fixed_string = false;
+
+    // Smart case as the engines decide it, over the whole pattern list
+    QString allPatterns;
+    for (const NamedPattern &named : m_patterns) {
+        allPatterns += named.pattern;
+    }
+    bool caseless = false;
+    if (params.case_sensitive) {
+        caseless = false;
+    } else if (params.ignore_case) {
+        caseless = true;
+    } else if (params.smart_case) {
+        caseless = allPatterns.toLower() == allPatterns;
+    }
+    m_options = caseless ? QRegularExpression::CaseInsensitiveOption : QRegularExpression::NoPatternOption;
+
+    {
+        QMutexLocker locker(&m_matcherMutex);
+        qDeleteAll(m_freeMatchers);
+        m_freeMatchers.clear();
+    }
+    {
+        QMutexLocker locker(&m_orderMutex);
+        m_nextTicket = 0;
+        m_emitTicket = 0;
+        m_patternLines = QVector<int>(m_patterns.size(), 0);
+        m_unattributedLines = 0;
+    }
+
+    // Patterns the engine accepts but QRegularExpression does not are never attributed
+    Matchers *matchers = takeMatchers();
+    for (int i = 0; i < m_patterns.size(); ++i) {
+        if (!matchers->expressions[i].isValid()) {
+            LOG_WARNING("BatchFileSearcher: Pattern '" + m_patterns[i].name + "' cannot be attributed: " +
+                        matchers->expressions[i].errorString());
+        }
+    }
+    returnMatchers(matchers);
+
+    LOG_INFO("BatchFileSearcher: " + QString::number(m_patterns.size()) + " patterns in one " + engineName() +
+             " pass" + (caseless ? " (case insensitive)" : ""));
+
+    if (m_hasTargets) {
+        m_engine->setTargets(m_targets);
+    }
+    m_engine->start(engineParams);
+}
+
+void BatchFileSearcher::cancel()
+{
+    FileSearcher::cancel();
+    m_engine->cancel();
+}
+
+BatchFileSearcher::Matchers *BatchFileSearcher::takeMatchers()
+{
+    {
+        QMutexLocker locker(&m_matcherMutex);
+        if (!m_freeMatchers.isEmpty()) {
+            return m_freeMatchers.takeLast();
+        }
+    }
+
+    Matchers *matchers = new Matchers;
+    for (const NamedPattern &named : m_patterns) {
+        QRegularExpression expression(m_fixedString ? escapeLiteral(named.pattern) : named.pattern, m_options);
+        expression.optimize();
+        matchers->expressions.append(expression);
+    }
+    return matchers;
+}
+
+void BatchFileSearcher::returnMatchers(Matchers *matchers)
+{
+    QMutexLocker locker(&m_matcherMutex);
+    m_freeMatchers.append(matchers);
+}
+
+quint64 BatchFileSearcher::attribute(const Matchers &matchers, const QString &line) const
+{
+    quint64 mask = 0;
+    for (int i = 0; i < matchers.expressions.size(); ++i) {
+        const QRegularExpression &expression = matchers.expressions[i];
+        if (expression.isValid() && expression.match(line).hasMatch()) {
+            mask |= quint64(1) << i;
+        }
+    }
+    return mask;
+}
+
+void BatchFileSearcher::filterEngineChunk(const QByteArray &jsonLines)
+{
+    quint64 ticket;
+    {
+        QMutexLocker locker(&m_orderMutex);
+        ticket = m_nextTicket++;
+    }
+
+    // ===== ATTRIBUTION (in parallel on the engine's threads) =====
+    QByteArray output;
+    output.reserve(jsonLines.size() + jsonLines.size() / 8);
+    QVector<int> patternLines(m_patterns.size(), 0);
+    int unattributedLines = 0;
+
+    Matchers *matchers = takeMatchers();
+    RgJsonRecord record;
+    const char *data = jsonLines.constData();
+    const char *end = data + jsonLines.size();
+    for (const char *lineStart = data; lineStart < end; ) {
+        const char *lineEnd = static_cast<const char*>(memchr(lineStart, '\n', size_t(end - lineStart)));
+        const char *next = lineEnd ? lineEnd + 1 : end;
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+        const char *recordStart = lineStart;
+        lineStart = next;
+
+        if (!RgJsonParser::parseLine(recordStart, lineEnd, &record) || record.type != RgJsonRecord::Match) {
+            output.append(recordStart, next - recordStart);
+            continue;
+        }
+
+        quint64 mask = attribute(*matchers, record.lines.toLineString());
+        QByteArray ids;
+        for (int i = 0; i < m_patterns.size(); ++i) {
+            if (mask & (quint64(1) << i)) {
+                ids += (ids.isEmpty() ? "" : ",") + QByteArray::number(i);
+                patternLines[i]++;
+            }
+        }
+        if (mask == 0) {
+            unattributedLines++;
+        }
+
+        // Into the data object - the record ends with the data object's brace and its own
+        qsizetype length = lineEnd - recordStart;
+        qsizetype outerClose = length - 1;
+        while (outerClose >= 0 && recordStart[outerClose] != '}') {
+            --outerClose;
+        }
+        qsizetype dataClose = outerClose - 1;
+        while (dataClose >= 0 && recordStart[dataClose] == ' ') {
+            --dataClose;
+        }
+        if (outerClose > 0 && dataClose > 0 && recordStart[dataClose] == '}') {
+            output.append(recordStart, dataClose);
+            output.append(",\"patterns\":[" + ids + "]");
+            output.append(recordStart + dataClose, next - (recordStart + dataClose));
+        } else {
+            output.append(recordStart, next - recordStart);
+        }
+    }
+    returnMatchers(matchers);
+
+    // ===== RELEASE IN ARRIVAL ORDER =====
+    QMutexLocker locker(&m_orderMutex);
+    while (m_emitTicket != ticket) {
+        m_orderChanged.wait(&m_orderMutex);
+    }
+    for (int i = 0; i < patternLines.size(); ++i) {
+        m_patternLines[i] += patternLines[i];
+    }
+    m_unattributedLines += unattributedLines;
+    if (!output.isEmpty()) {
+        emit outputChunk(output);
+    }
+    m_emitTicket++;
+    m_orderChanged.wakeAll();
+}
+
+void BatchFileSearcher::finishRun(int engineExitCode)
+{
+    {
+        QMutexLocker locker(&m_orderMutex);
+        QStringList counts;
+        for (int i = 0; i < m_patterns.size(); ++i) {
+            counts << m_patterns[i].name + ": " + QString::number(m_patternLines[i]);
+        }
+        LOG_INFO("BatchFileSearcher: Matched lines per pattern after " + QString::number(m_timer.elapsed()) +
+                 " ms - " + counts.join(", ") + (m_unattributedLines > 0
+                 ? ", " + QString::number(m_unattributedLines) + " lines matched by none alone" : QString()));
+    }
+
+    emit finished(engineExitCode);
+}
@@ -0,0 +1,82 @@
+#ifndef BATCHFILESEARCHER_H
+#define BATCHFILESEARCHER_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <QRegularExpression>
+#include <QElapsedTimer>
+#include "filesearcher.h"
+
+// Batch search of a list of named patterns in one pass over the files. The engine searches one
+// alternation of all patterns - each file is read once, whatever the number of patterns - and
+// only the lines it matched are tested against every pattern again. Match records leave with the
+// ids of the patterns that matched the line ("patterns": [0, 3] in their data), so the results
+// can be grouped per pattern. Case options apply to all patterns alike; smart case looks at all
+// of them together.
+class BatchFileSearcher : public FileSearcher
+{
+    Q_OBJECT
+
+public:
+    using NamedPattern = NamedSearchPattern;
+
+    // Pattern ids are bits of SearchResultStore::patternMask
+    static constexpr int MaxPatterns = 64;
+
+    // "name<TAB>pattern" per line; a line without a tab is a pattern named by itself, empty
+    // lines and lines starting with # are skipped
+    static bool loadPatternList(const QString &filePath, QVector<NamedPattern> *patterns, QString *error);
+
+    // One regular expression matching what any of patterns matches
+    static QString combinedPattern(const QVector<NamedPattern> &patterns, bool fixedString);
+
+    // Takes ownership of engine
+    BatchFileSearcher(FileSearcher *engine, const QVector<NamedPattern> &patterns, QObject *parent = nullptr);
+    ~BatchFileSearcher();
+
+    QString engineName() const override;
+
+    // params.pattern and add_pattern are replaced by the combined pattern of the list
+    void start(const RGSearchParams &params) override;
+    void cancel() override;
+
+    bool canSearchTargets(const QVector<SearchTarget> &targets) const override;
+    QStringList candidateFiles(const RGSearchParams &params) const override;
+
+private:
+    // Expressions of all patterns for one thread at a time (QRegularExpression is only reentrant)
+    struct Matchers {
+        QVector<QRegularExpression> expressions;
+    };
+    Matchers *takeMatchers();
+    void returnMatchers(Matchers *matchers);
+
+    // Bits of the patterns matching line
+    quint64 attribute(const Matchers &matchers, const QString &line) const;
+
+    void filterEngineChunk(const QByteArray &jsonLines);
+    void finishRun(int engineExitCode);
+
+    // Regex special characters escaped the same way for ripgrep, PCRE and Hyperscan
+    static QString escapeLiteral(const QString &text);
+
+    FileSearcher *m_engine;
+    QVector<NamedPattern> m_patterns;
+    QRegularExpression::PatternOptions m_options;
+    bool m_fixedString;
+    QElapsedTimer m_timer;
+
+    QMutex m_matcherMutex;
+    QVector<Matchers*> m_freeMatchers;
+
+    // Chunks are attributed in parallel and passed on in the order they arrived
+    QMutex m_orderMutex;
+    QWaitCondition m_orderChanged;
+    quint64 m_nextTicket;
+    quint64 m_emitTicket;
+    QVector<int> m_patternLines;    // Matched lines per pattern
+    int m_unattributedLines;        // Found by the engine, but by none of the patterns alone
+};
+
+#endif // BATCHFILESEARCHER_H
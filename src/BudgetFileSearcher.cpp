@@ -0,0 +1,159 @@
+#include "BudgetFileSearcher.h"
+#include "RgJsonParser.h"
+#include "logger.h"
+#include <cstring>
+
+BudgetFileSearcher::BudgetFileSearcher(FileSearcher *engine, int maxPerFile, int maxTotal, QObject *parent)
+    : FileSearcher(parent)
+    , m_engine(engine)
+    , m_maxPerFile(qMax(0, maxPerFile))
+    , m_maxTotal(qMax(0, maxTotal))
+    , m_totalMatches(0)
+    , m_droppedMatches(0)
+    , m_budgetReached(false)
+{
+    m_engine->setParent(this);
+
+    connect(m_engine, &FileSearcher::outputChunk, this, [this](const QByteArray &jsonLines) {
+        filterEngineChunk(jsonLines);
+    }, Qt::DirectConnection);
+    connect(m_engine, &FileSearcher::finished, this, [this](int exitCode) {
+        finishRun(exitCode);
+    });
+    connect(m_engine, &FileSearcher::errorOccurred, this, &FileSearcher::errorOccurred, Qt::DirectConnection);
+    connect(m_engine, &FileSearcher::fileSearched, this, &FileSearcher::fileSearched, Qt::DirectConnection);
+}
+
+BudgetFileSearcher::~BudgetFileSearcher()
+{
+}
+
+QString BudgetFileSearcher::engineName() const
+{
+    return m_engine->engineName();
+}
+
+bool BudgetFileSearcher::canSearchTargets(const QVector<SearchTarget> &targets) const
+{
+    return m_engine->canSearchTargets(targets);
+}
+
+QStringList BudgetFileSearcher::candidateFiles(const RGSearchParams &params) const
+{
+    return m_engine->candidateFiles(params);
+}
+
+void BudgetFileSearcher::start(const RGSearchParams &params)
+{
+    m_cancelled.store(false);
+    m_engine->setCancelToken(m_cancelToken);
+    m_engine->setFlowControl(m_flowControl);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_fileMatches.clear();
+        m_totalMatches = 0;
+        m_droppedMatches = 0;
+        m_budgetReached = false;
+    }
+    m_timer.start();
+
+    if (m_hasTargets) {
+        m_engine->setTargets(m_targets);
+    }
+    m_engine->start(params);
+}
+
+void BudgetFileSearcher::cancel()
+{
+    FileSearcher::cancel();
+    m_engine->cancel();
+}
+
+void BudgetFileSearcher::filterEngineChunk(const QByteArray &jsonLines)
+{
+    bool reachedNow = false;
+    {
+        QMutexLocker locker(&m_mutex);
+
+        QByteArray output;
+        output.reserve(jsonLines.size());
+
+        RgJsonRecord record;
+        const char *data = jsonLines.constData();
+        const char *end = data + jsonLines.size();
+        for (const char *lineStart = data; lineStart < end; ) {
+            const char *lineEnd = static_cast<const char*>(memchr(lineStart, '\n', size_t(end - lineStart)));
+            const char *next = lineEnd ? lineEnd + 1 : end;
+            if (!lineEnd) {
+                lineEnd = end;
+            }
+            const char *recordStart = lineStart;
+            lineStart = next;
+
+            bool forward = true;
+            if (RgJsonParser::parseLine(recordStart, lineEnd, &record) && !record.path.isNull()) {
+                QByteArray rawPath = record.path.raw.toByteArray();
+                auto file = m_fileMatches.find(rawPath);
+
+                if (record.type == RgJsonRecord::Begin) {
+                    forward = !m_budgetReached;
+                    if (forward && file == m_fileMatches.end()) {
+                        m_fileMatches.insert(rawPath, 0);
+                    }
+                } else if (record.type == RgJsonRecord::Match) {
+                    if (file == m_fileMatches.end()) {
+                        file = m_fileMatches.insert(rawPath, 0);
+                    }
+                    forward = !m_budgetReached && (m_maxPerFile == 0 || file.value() < m_maxPerFile);
+                    if (forward) {
+                        file.value()++;
+                        m_totalMatches++;
+                        if (m_maxTotal > 0 && m_totalMatches >= m_maxTotal) {
+                            m_budgetReached = true;
+                            reachedNow = true;
+                        }
+                    } else {
+                        m_droppedMatches++;
+                    }
+                } else if (record.type == RgJsonRecord::End) {
+                    // Files cut off by the total budget keep their stats, later files are left out
+                    forward = !m_budgetReached || file != m_fileMatches.end();
+                }
+            }
+
+            if (forward) {
+                output.append(recordStart, next - recordStart);
+            }
+        }
+
+        // Emitted while locked so chunks keep the engine's order
+        if (!output.isEmpty()) {
+            emit outputChunk(output);
+        }
+    }
+
+    if (reachedNow) {
+        LOG_INFO("BudgetFileSearcher: " + QString::number(m_maxTotal) + " matches reached after " +
+                 QString::number(m_timer.elapsed()) + " ms, stopping the " + engineName() + " search");
+
+        // Chunks may come from an engine thread - ripgrep is only stopped from its own thread
+        QMetaObject::invokeMethod(this, [this]() { m_engine->cancel(); }, Qt::QueuedConnection);
+        emit budgetReached(m_maxTotal);
+    }
+}
+
+void BudgetFileSearcher::finishRun(int engineExitCode)
+{
+    bool budgetReached = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        budgetReached = m_budgetReached;
+        LOG_INFO("BudgetFileSearcher: " + QString::number(m_totalMatches) + " matches passed on, " +
+                 QString::number(m_droppedMatches) + " dropped (max " + QString::number(m_maxPerFile) +
+                 " per file, " + QString::number(m_maxTotal) + " in all) after " +
+                 QString::number(m_timer.elapsed()) + " ms");
+    }
+
+    // A search stopped by the budget still found matches
+    emit finished(budgetReached ? 0 : engineExitCode);
+}
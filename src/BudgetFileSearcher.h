@@ -0,0 +1,52 @@
+#ifndef BUDGETFILESEARCHER_H
+#define BUDGETFILESEARCHER_H
+
+#include <QMutex>
+#include <QHash>
+#include <QElapsedTimer>
+#include "filesearcher.h"
+
+// Result budgets in front of a search backend: at most maxPerFile match records of a file and
+// maxTotal in all are passed on (0 = no limit). The engines stop a file at params.max_count
+// themselves; this keeps the limit exact where they cannot (ripgrep ranges, cached replays).
+// Once the total is reached the engine is cancelled - the search stops producing results nobody
+// is shown - and only the end records of files already passed on still go out.
+class BudgetFileSearcher : public FileSearcher
+{
+    Q_OBJECT
+
+public:
+    // Takes ownership of engine
+    BudgetFileSearcher(FileSearcher *engine, int maxPerFile, int maxTotal, QObject *parent = nullptr);
+    ~BudgetFileSearcher();
+
+    QString engineName() const override;
+
+    void start(const RGSearchParams &params) override;
+    void cancel() override;
+
+    bool canSearchTargets(const QVector<SearchTarget> &targets) const override;
+    QStringList candidateFiles(const RGSearchParams &params) const override;
+
+signals:
+    // The total budget was used up and the engine cancelled
+    void budgetReached(int matches);
+
+private:
+    void filterEngineChunk(const QByteArray &jsonLines);
+    void finishRun(int engineExitCode);
+
+    FileSearcher *m_engine;
+    int m_maxPerFile;
+    int m_maxTotal;
+    QElapsedTimer m_timer;
+
+    // Engine output arrives from its worker threads
+    QMutex m_mutex;
+    QHash<QByteArray, int> m_fileMatches;   // Match records passed on, by data.path as written
+    int m_totalMatches;
+    int m_droppedMatches;
+    bool m_budgetReached;
+};
+
+#endif // BUDGETFILESEARCHER_H
@@ -0,0 +1,630 @@
+#include "CachedFileSearcher.h"
+#include "RgJsonParser.h"
+#include "CompressedFile.h"
+#include "logger.h"
+#include <QCache>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <QSettings>
+#include <cstring>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+// Cached results of all searches, shared by every CachedFileSearcher - cost is in KB
+QMutex &resultCacheMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+QCache<QString, CachedFileSearcher::CacheEntry> &resultCache()
+{
+    static QCache<QString, CachedFileSearcher::CacheEntry> cache;
+    return cache;
+}
+
+// "0.001234s" -> nanoseconds
+qint64 elapsedNs(const RgJsonText &human)
+{
+    QString text = human.toString();
+    if (text.endsWith('s')) {
+        text.chop(1);
+    }
+    return qint64(text.toDouble() * 1e9);
+}
+
+bool sameBytes(const QByteArray &a, QByteArrayView b)
+{
+    return a.size() == b.size() && memcmp(a.constData(), b.data(), size_t(b.size())) == 0;
+}
+
+} // namespace
+
+// ===== CachedFile / CacheEntry =====
+
+int CachedFileSearcher::CachedFile::matchCount() const
+{
+    int count = 0;
+    for (const CachedMatch &line : lines) {
+        count += line.matches;
+    }
+    return count;
+}
+
+void CachedFileSearcher::CachedFile::truncate(int lineCount)
+{
+    if (lineCount >= lines.size()) {
+        return;
+    }
+    records.truncate(lineCount > 0 ? lines[lineCount - 1].recordEnd : 0);
+    lines.resize(lineCount);
+}
+
+qint64 CachedFileSearcher::CacheEntry::bytes() const
+{
+    qint64 total = 0;
+    for (const CachedFile &file : files) {
+        total += file.records.size() + file.lines.size() * qint64(sizeof(CachedMatch)) + file.path.size() * 2;
+    }
+    return total;
+}
+
+// ===== CachedFileSearcher =====
+
+CachedFileSearcher::CachedFileSearcher(FileSearcher *engine, QObject *parent)
+    : FileSearcher(parent)
+    , m_engine(engine)
+    , m_cacheLimitKB(256 * 1024)
+    , m_fullSearch(false)
+    , m_bytesToSearch(0)
+    , m_entryBytes(0)
+    , m_cacheable(true)
+{
+    m_engine->setParent(this);
+
+    QSettings settings("app.ini", QSettings::IniFormat);
+    settings.beginGroup("RGSearch");
+    m_cacheLimitKB = qMax(1, settings.value("ResultCacheMB", 256).toInt()) * 1024;
+    settings.endGroup();
+
+    // Engine output is merged with the cached results before it goes on
+    connect(m_engine, &FileSearcher::outputChunk, this, [this](const QByteArray &jsonLines) {
+        filterEngineChunk(jsonLines);
+    }, Qt::DirectConnection);
+    connect(m_engine, &FileSearcher::finished, this, [this](int exitCode) {
+        finishRun(exitCode);
+    });
+    connect(m_engine, &FileSearcher::errorOccurred, this, &FileSearcher::errorOccurred, Qt::DirectConnection);
+    connect(m_engine, &FileSearcher::fileSearched, this, [this](const QString &filePath) {
+        engineFileDone(filePath);
+    }, Qt::DirectConnection);
+}
+
+CachedFileSearcher::~CachedFileSearcher()
+{
+}
+
+QString CachedFileSearcher::engineName() const
+{
+    return m_engine->engineName();
+}
+
+QStringList CachedFileSearcher::candidateFiles(const RGSearchParams &params) const
+{
+    return m_engine->candidateFiles(params);
+}
+
+CachedFileSearcher::Fingerprint CachedFileSearcher::fingerprint(const QString &filePath)
+{
+    Fingerprint result;
+
+#ifdef Q_OS_WIN
+    // One handle gives size, write time and file index; sharing everything keeps writers unaffected
+    HANDLE handle = CreateFileW(reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(filePath).utf16()),
+                                FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return result;
+    }
+    BY_HANDLE_FILE_INFORMATION info;
+    if (GetFileInformationByHandle(handle, &info)) {
+        result.size = (qint64(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+        result.modified = (qint64(info.ftLastWriteTime.dwHighDateTime) << 32) | info.ftLastWriteTime.dwLowDateTime;
+        result.fileId = (quint64(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+    }
+    CloseHandle(handle);
+#else
+    struct stat st;
+    if (::stat(QFile::encodeName(filePath).constData(), &st) == 0) {
+        result.size = qint64(st.st_size);
+#ifdef Q_OS_MACOS
+        result.modified = qint64(st.st_mtimespec.tv_sec) * 1000000000LL + st.st_mtimespec.tv_nsec;
+#else
+        result.modified = qint64(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+#endif
+        result.fileId = quint64(st.st_ino);
+    }
+#endif
+
+    return result;
+}
+
+QString CachedFileSearcher::normalizedPath(const QString &filePath)
+{
+    QString normalized = QDir::cleanPath(QFileInfo(filePath).absoluteFilePath());
+#ifdef Q_OS_WIN
+    normalized = normalized.toLower();
+#endif
+    return normalized;
+}
+
+QString CachedFileSearcher::cacheKey(const RGSearchParams &params) const
+{
+    // Case flags as the engines apply them: -s wins over -i, -i over -S
+    QString caseMode = params.case_sensitive ? "s" : params.ignore_case ? "i" : params.smart_case ? "S" : "";
+
+    QStringList globs;
+    for (const QString &glob : params.incl_exclude.split(',', Qt::SkipEmptyParts)) {
+        if (!glob.trimmed().isEmpty()) {
+            globs << glob.trimmed();
+        }
+    }
+
+    QStringList parts;
+    parts << engineName() << normalizedPath(params.path) << params.pattern << params.add_pattern
+          << (params.fixed_string ? "F" : "") << caseMode << globs.join(',')
+          << (params.search_compressed ? "z" : "") << params.time_from.trimmed() + "~" + params.time_to.trimmed();
+    return parts.join(QChar(0x1f));
+}
+
+void CachedFileSearcher::start(const RGSearchParams &params)
+{
+    m_cancelled.store(false);
+    m_engine->setCancelToken(m_cancelToken);
+    m_engine->setFlowControl(m_flowControl);
+    m_params = params;
+    m_cacheKey = cacheKey(params);
+
+    m_fingerprints.clear();
+    m_candidatePaths.clear();
+    m_engineTargets.clear();
+    m_grownFiles.clear();
+    m_endedFiles.clear();
+    m_fullSearch = false;
+    m_bytesToSearch = 0;
+    m_entry = CacheEntry();
+    m_entryBytes = 0;
+    m_cacheable = true;
+    m_lastPathRaw.clear();
+    m_lastPathKey.clear();
+
+    m_timer.start();
+
+    // Fingerprinting and replay touch every file, so they run off the UI thread
+    QThread *thread = QThread::create([this]() {
+        prepareRun();
+    });
+    connect(thread, &QThread::finished, this, [this, thread]() {
+        thread->deleteLater();
+        startEngine();
+    });
+    thread->start();
+}
+
+void CachedFileSearcher::cancel()
+{
+    FileSearcher::cancel();
+    m_engine->cancel();
+}
+
+bool CachedFileSearcher::findTailStart(const CachedFile &cached, qint64 *offset, qint64 *line) const
+{
+    qint64 oldSize = cached.fingerprint.size;
+
+    // Count lines from the last known line start, a matched line if there is a later one
+    qint64 anchorOffset = cached.anchorOffset;
+    qint64 anchorLine = cached.anchorLine;
+    if (!cached.lines.isEmpty() && cached.lines.last().offset > anchorOffset && cached.lines.last().offset < oldSize) {
+        anchorOffset = cached.lines.last().offset;
+        anchorLine = cached.lines.last().lineNumber;
+    }
+    if (anchorOffset >= oldSize) {
+        *offset = anchorOffset;
+        *line = anchorLine;
+        return anchorOffset == oldSize;
+    }
+
+    QFile file(cached.path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    qint64 length = oldSize - anchorOffset;
+    uchar *mapped = file.map(anchorOffset, length);
+    if (!mapped) {
+        return false;
+    }
+    const char *data = reinterpret_cast<const char*>(mapped);
+
+    // The last line of the old size may have been incomplete - it is searched again with the tail
+    qint64 completeLength = length;
+    while (completeLength > 0 && data[completeLength - 1] != '\n') {
+        completeLength--;
+    }
+
+    qint64 lineNumber = anchorLine;
+    const char *p = data;
+    const char *end = data + completeLength;
+    while (p < end) {
+        const void *nl = memchr(p, '\n', size_t(end - p));
+        if (!nl) {
+            break;
+        }
+        p = static_cast<const char*>(nl) + 1;
+        lineNumber++;
+    }
+
+    file.unmap(mapped);
+
+    *offset = anchorOffset + completeLength;
+    *line = lineNumber;
+    return true;
+}
+
+void CachedFileSearcher::prepareRun()
+{
+    LOG_INFO("CachedFileSearcher: ===THREAD=== prepareRun for path: " + m_params.path + " <<<<<STARTed<<<<<");
+
+    try {
+        CacheEntry cached;
+        bool hit = false;
+        {
+            QMutexLocker cacheLocker(&resultCacheMutex());
+            if (CacheEntry *entry = resultCache().object(m_cacheKey)) {
+                cached = *entry;  // Implicitly shared, nothing is copied here
+                hit = true;
+            }
+        }
+
+        // ===== STEP 1: FINGERPRINT CANDIDATE FILES AND COMPARE WITH THE CACHE =====
+        QStringList files;
+        if (m_hasTargets) {
+            for (const SearchTarget &target : m_targets) {
+                files << target.filePath;
+            }
+        } else {
+            files = m_engine->candidateFiles(m_params);
+        }
+        QHash<QString, CachedFile> carried;    // Unchanged files, and the kept part of grown files
+        QVector<SearchTarget> targets;
+        QStringList goneFiles;
+        int unchangedCount = 0;
+        int grownCount = 0;
+
+        for (const QString &filePath : files) {
+            if (isCancelled()) {
+                return;
+            }
+
+            QString key = normalizedPath(filePath);
+            Fingerprint current = fingerprint(filePath);
+            if (!current.isValid()) {
+                goneFiles << filePath;
+                continue;
+            }
+            m_fingerprints.insert(key, current);
+            m_candidatePaths.insert(key, filePath);
+
+            SearchTarget target;
+            target.filePath = filePath;
+
+            auto it = cached.files.constFind(key);
+            if (it != cached.files.constEnd()) {
+                const CachedFile &file = it.value();
+                target.filePath = file.path;
+
+                if (file.fingerprint == current) {
+                    carried.insert(key, file);
+                    unchangedCount++;
+                    continue;
+                }
+
+                // Same file with more bytes (appended, not rotated or rewritten): search the tail only.
+                // Offsets of decompressed files are not file offsets - they are searched whole.
+                qint64 tailOffset = 0;
+                qint64 tailLine = 1;
+                bool decompressed = m_params.search_compressed && CompressedFile::isCompressedPath(filePath);
+                if (!decompressed && current.fileId == file.fingerprint.fileId && current.size > file.fingerprint.size &&
+                    current.modified >= file.fingerprint.modified && findTailStart(file, &tailOffset, &tailLine)) {
+                    CachedFile kept = file;
+                    int keep = kept.lines.size();
+                    while (keep > 0 && kept.lines[keep - 1].offset >= tailOffset) {
+                        keep--;
+                    }
+                    kept.truncate(keep);
+                    kept.anchorOffset = tailOffset;
+                    kept.anchorLine = tailLine;
+                    carried.insert(key, kept);
+                    m_grownFiles.insert(key);
+                    grownCount++;
+
+                    target.startOffset = tailOffset;
+                    target.startLine = tailLine;
+                }
+            }
+            targets.append(target);
+        }
+
+        // ===== STEP 2: DECIDE WHAT THE ENGINE SEARCHES =====
+        if (!hit) {
+            m_fullSearch = true;
+        } else if (!m_engine->canSearchTargets(targets)) {
+            // Engines that cannot start at an offset search grown files whole
+            for (SearchTarget &target : targets) {
+                if (target.startOffset > 0) {
+                    carried.remove(normalizedPath(target.filePath));
+                    target.startOffset = 0;
+                    target.startLine = 1;
+                }
+            }
+            grownCount = 0;
+            m_grownFiles.clear();
+            m_fullSearch = !m_engine->canSearchTargets(targets);
+        }
+
+        if (m_fullSearch) {
+            for (const Fingerprint &current : m_fingerprints) {
+                m_bytesToSearch += current.size;
+            }
+            LOG_INFO("CachedFileSearcher: " + QString(hit ? "Too many changed files" : "No cached results") +
+                     ", full " + engineName() + " search of " + QString::number(m_fingerprints.size()) + " files");
+            return;
+        }
+
+        m_engineTargets = targets;
+        for (const SearchTarget &target : targets) {
+            m_bytesToSearch += m_fingerprints.value(normalizedPath(target.filePath)).size - target.startOffset;
+        }
+
+        // ===== STEP 3: REPLAY CACHED RESULTS =====
+        QMutexLocker locker(&m_mutex);
+        m_entry.files = carried;
+        m_entryBytes = m_entry.bytes();
+
+        FileSearchRecordWriter writer(this);
+        for (const QString &filePath : files) {
+            QString key = normalizedPath(filePath);
+            auto it = carried.constFind(key);
+            if (it == carried.constEnd() || it.value().lines.isEmpty()) {
+                continue;
+            }
+            const CachedFile &file = it.value();
+            writer.appendRecords(file.path, file.records);
+            // Grown files get their end record once the tail is searched
+            if (!m_grownFiles.contains(key)) {
+                writer.endFile(file.path, file.lines.size(), file.matchCount(), file.fingerprint.size, file.elapsedNs);
+            }
+        }
+        writer.flush();
+
+        // Unchanged files are done with their replay, those without a match included
+        for (const QString &filePath : files) {
+            QString key = normalizedPath(filePath);
+            if (carried.contains(key) && !m_grownFiles.contains(key)) {
+                emit fileSearched(filePath);
+            }
+        }
+        for (const QString &filePath : goneFiles) {
+            emit fileSearched(filePath);
+        }
+
+        LOG_INFO("CachedFileSearcher: " + QString::number(unchangedCount) + " files unchanged, " +
+                 QString::number(grownCount) + " grown, " +
+                 QString::number(targets.size() - grownCount) + " new or changed - " +
+                 QString::number(m_bytesToSearch) + " bytes left to search, cached results replayed after " +
+                 QString::number(m_timer.elapsed()) + " ms");
+
+    } catch (const std::exception &e) {
+        LOG_ERROR("CachedFileSearcher: Exception in prepareRun: " + QString(e.what()));
+        m_fullSearch = true;
+    } catch (...) {
+        LOG_ERROR("CachedFileSearcher: Unknown exception in prepareRun");
+        m_fullSearch = true;
+    }
+
+    LOG_INFO("CachedFileSearcher: ===THREAD=== prepareRun for path: " + m_params.path + " >>>>>ENDed>>>>>");
+}
+
+void CachedFileSearcher::startEngine()
+{
+    if (isCancelled()) {
+        finishRun(1);
+        return;
+    }
+
+    if (m_fullSearch) {
+        if (m_hasTargets) {
+            m_engine->setTargets(m_targets);
+        } else {
+            m_engine->clearTargets();
+        }
+        m_engine->start(m_params);
+        return;
+    }
+
+    if (m_engineTargets.isEmpty()) {
+        LOG_INFO("CachedFileSearcher: Nothing changed, answered from the cache");
+        finishRun(0);
+        return;
+    }
+
+    m_engine->setTargets(m_engineTargets);
+    m_engine->start(m_params);
+}
+
+void CachedFileSearcher::filterEngineChunk(const QByteArray &jsonLines)
+{
+    // Engines emit from their worker threads
+    QMutexLocker locker(&m_mutex);
+
+    QByteArray output;
+    output.reserve(jsonLines.size());
+
+    RgJsonRecord record;
+    const char *data = jsonLines.constData();
+    const char *end = data + jsonLines.size();
+    for (const char *lineStart = data; lineStart < end; ) {
+        const char *lineEnd = static_cast<const char*>(memchr(lineStart, '\n', size_t(end - lineStart)));
+        const char *next = lineEnd ? lineEnd + 1 : end;
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+
+        bool forward = true;
+        if (RgJsonParser::parseLine(lineStart, lineEnd, &record)) {
+            CachedFile *file = nullptr;
+            if (record.type == RgJsonRecord::Match || record.type == RgJsonRecord::End) {
+                // Consecutive records of one file share the decoded path
+                if (!sameBytes(m_lastPathRaw, record.path.raw)) {
+                    m_lastPathRaw = record.path.raw.toByteArray();
+                    QString path = record.path.toString();
+                    m_lastPathKey = normalizedPath(path);
+                    if (!m_entry.files.contains(m_lastPathKey)) {
+                        CachedFile newFile;
+                        newFile.path = path;
+                        m_entry.files.insert(m_lastPathKey, newFile);
+                    }
+                }
+                file = &m_entry.files[m_lastPathKey];
+            }
+
+            if (record.type == RgJsonRecord::Match) {
+                if (m_cacheable) {
+                    file->records.append(lineStart, lineEnd - lineStart);
+                    file->records.append('\n');
+                    m_entryBytes += (lineEnd - lineStart) + 1 + qint64(sizeof(CachedMatch));
+                    if (m_entryBytes > qint64(m_cacheLimitKB) * 1024) {
+                        LOG_INFO("CachedFileSearcher: Results exceed the result cache (" +
+                                 QString::number(m_cacheLimitKB / 1024) + " MB), this search is not cached");
+                        m_cacheable = false;
+                        for (CachedFile &cachedFile : m_entry.files) {
+                            cachedFile.records.clear();
+                        }
+                    }
+                }
+                CachedMatch line;
+                line.offset = record.absoluteOffset;
+                line.lineNumber = record.lineNumber;
+                line.recordEnd = int(file->records.size());
+                line.matches = int(record.submatches.size());
+                file->lines.append(line);
+            } else if (record.type == RgJsonRecord::End) {
+                file->elapsedNs = elapsedNs(record.statsElapsedHuman);
+                // The end record of a grown file is written with the cached part in finishRun
+                forward = !m_grownFiles.contains(m_lastPathKey);
+            } else if (record.type == RgJsonRecord::Summary) {
+                // Replaced by the summary of the merged results
+                forward = false;
+            }
+        }
+
+        if (forward) {
+            output.append(lineStart, next - lineStart);
+        }
+        lineStart = next;
+    }
+
+    if (!output.isEmpty()) {
+        emit outputChunk(output);
+    }
+}
+
+void CachedFileSearcher::engineFileDone(const QString &filePath)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+
+        // The tail of a grown file is searched - its end record covers the cached part too
+        QString key = normalizedPath(filePath);
+        if (m_grownFiles.contains(key) && !m_endedFiles.contains(key)) {
+            m_endedFiles.insert(key);
+            const CachedFile &file = m_entry.files[key];
+            if (!file.lines.isEmpty()) {
+                FileSearchRecordWriter writer(this);
+                writer.endFile(file.path, file.lines.size(), file.matchCount(),
+                               m_fingerprints.value(key).size, file.elapsedNs);
+                writer.flush();
+            }
+        }
+    }
+    emit fileSearched(filePath);
+}
+
+void CachedFileSearcher::finishRun(int engineExitCode)
+{
+    int matchedLines = 0;
+    int matches = 0;
+    int filesWithMatch = 0;
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        // ===== END RECORDS OF GROWN FILES AND THE MERGED SUMMARY =====
+        FileSearchRecordWriter writer(this);
+        for (const QString &key : m_grownFiles) {
+            const CachedFile &file = m_entry.files[key];
+            if (!file.lines.isEmpty() && !m_endedFiles.contains(key)) {
+                writer.endFile(file.path, file.lines.size(), file.matchCount(),
+                               m_fingerprints.value(key).size, file.elapsedNs);
+            }
+        }
+        for (const CachedFile &file : m_entry.files) {
+            matchedLines += file.lines.size();
+            matches += file.matchCount();
+            filesWithMatch += file.lines.isEmpty() ? 0 : 1;
+        }
+        writer.summary(matchedLines, matches, m_fingerprints.size(), filesWithMatch,
+                       m_bytesToSearch, m_timer.nsecsElapsed());
+        writer.flush();
+
+        // ===== STORE THE MERGED RESULTS =====
+        if (!isCancelled() && engineExitCode != 2 && m_cacheable) {
+            CacheEntry *entry = new CacheEntry();
+            for (auto it = m_fingerprints.constBegin(); it != m_fingerprints.constEnd(); ++it) {
+                CachedFile file = m_entry.files.value(it.key());
+                if (file.path.isEmpty()) {
+                    file.path = m_candidatePaths.value(it.key());
+                }
+                file.fingerprint = it.value();
+
+                // Lines written while the search ran may lie beyond the fingerprinted size
+                int keep = file.lines.size();
+                while (keep > 0 && file.lines[keep - 1].offset >= file.fingerprint.size) {
+                    keep--;
+                }
+                file.truncate(keep);
+                entry->files.insert(it.key(), file);
+            }
+
+            int cost = int(qMax<qint64>(1, entry->bytes() / 1024));
+            QMutexLocker cacheLocker(&resultCacheMutex());
+            resultCache().setMaxCost(m_cacheLimitKB);
+            if (!resultCache().insert(m_cacheKey, entry, cost)) {
+                LOG_INFO("CachedFileSearcher: Results too large for the result cache, not cached");
+            }
+        }
+    }
+
+    int exitCode = (engineExitCode == 2) ? 2 : (matchedLines > 0 ? 0 : 1);
+    LOG_INFO("CachedFileSearcher: " + engineName() + " search with cache done in " + QString::number(m_timer.elapsed()) +
+             " ms: " + QString::number(matchedLines) + " matched lines in " + QString::number(filesWithMatch) + " files" +
+             (isCancelled() ? " (cancelled)" : ""));
+    emit finished(exitCode);
+}
@@ -0,0 +1,103 @@
+#ifndef CACHEDFILESEARCHER_H
+#define CACHEDFILESEARCHER_H
+
+#include <QMutex>
+#include <QHash>
+#include <QSet>
+#include <QElapsedTimer>
+#include "filesearcher.h"
+#include "FileFingerprint.h"
+
+// Result cache in front of a search backend. Match records are cached per file for each set of
+// normalized search parameters, together with the file's size, modification time and file id.
+// Repeating a search replays the files that did not change, searches only the appended tail of
+// files that grew (the whole file if the engine cannot start at an offset) and the files that are
+// new or changed, and merges everything into one record stream with a combined summary.
+// Given targets, only those files are looked at (whole files); otherwise the engine's candidates.
+class CachedFileSearcher : public FileSearcher
+{
+    Q_OBJECT
+
+public:
+    // Identity of a file's contents on disk
+    using Fingerprint = FileFingerprint;
+
+    // Cached results of one file
+    struct CachedMatch {
+        qint64 offset = 0;          // absolute_offset (line start)
+        qint64 lineNumber = 0;
+        int recordEnd = 0;          // End of the record in CachedFile::records
+        int matches = 0;            // Submatches on the line
+    };
+
+    struct CachedFile {
+        QString path;               // As reported by the engine
+        Fingerprint fingerprint;    // Taken before the file was searched
+        QByteArray records;         // Match records as JSON lines
+        QVector<CachedMatch> lines;
+        qint64 elapsedNs = 0;
+
+        // A known line start and its number, so a tail search does not count lines from 0
+        qint64 anchorOffset = 0;
+        qint64 anchorLine = 1;
+
+        int matchCount() const;
+        void truncate(int lineCount);   // Keep only the first lineCount matched lines
+    };
+
+    struct CacheEntry {
+        QHash<QString, CachedFile> files;   // By normalized path, files without matches included
+        qint64 bytes() const;
+    };
+
+    // Takes ownership of engine
+    explicit CachedFileSearcher(FileSearcher *engine, QObject *parent = nullptr);
+    ~CachedFileSearcher();
+
+    QString engineName() const override;
+    QStringList candidateFiles(const RGSearchParams &params) const override;
+
+    void start(const RGSearchParams &params) override;
+    void cancel() override;
+
+    static Fingerprint fingerprint(const QString &filePath);
+
+private:
+    // ===== RUN STAGES =====
+    void prepareRun();                                  // Search thread: fingerprint, replay, pick targets
+    void startEngine();
+    void filterEngineChunk(const QByteArray &jsonLines);
+    void engineFileDone(const QString &filePath);       // Any thread
+    void finishRun(int engineExitCode);
+
+    // Where to resume a grown file: the start of its last complete line and that line's number
+    bool findTailStart(const CachedFile &cached, qint64 *offset, qint64 *line) const;
+
+    QString cacheKey(const RGSearchParams &params) const;
+    static QString normalizedPath(const QString &filePath);
+
+    FileSearcher *m_engine;
+    RGSearchParams m_params;
+    QString m_cacheKey;
+    QElapsedTimer m_timer;
+    int m_cacheLimitKB;                             // [RGSearch] ResultCacheMB in app.ini
+
+    // Set up by prepareRun before the engine starts
+    QHash<QString, Fingerprint> m_fingerprints;     // Candidate files by normalized path
+    QHash<QString, QString> m_candidatePaths;       // Normalized path -> path as enumerated
+    QVector<SearchTarget> m_engineTargets;
+    QSet<QString> m_grownFiles;                     // Normalized paths searched from a tail
+    QSet<QString> m_endedFiles;                     // Grown files whose end record went out
+    bool m_fullSearch;                              // Engine searches params.path itself
+    qint64 m_bytesToSearch;
+
+    // Merged results - filled by the replay and by engine output from any thread
+    QMutex m_mutex;
+    CacheEntry m_entry;
+    qint64 m_entryBytes;
+    bool m_cacheable;                               // False once the entry outgrows the cache
+    QByteArray m_lastPathRaw;                       // Path of the last engine record, undecoded
+    QString m_lastPathKey;
+};
+
+#endif // CACHEDFILESEARCHER_H
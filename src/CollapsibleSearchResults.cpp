@@ -2,6 +2,7 @@
 #include "JsonParseWorker.h"
 #include "logger.h"
 #include "DetachablePane.h"
+#include "SearchFlowControl.h"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
@@ -18,15 +19,32 @@
 #include <QHBoxLayout>
 #include <QResizeEvent>
 #include <QElapsedTimer>
+#include <QSettings>
 #include <QFileInfo>
+#include <limits>
+#ifdef Q_OS_WIN
 #include <windows.h>
 #include <psapi.h>
+#else
+#include <QFile>
+#include <unistd.h>
+#endif
 
 // JsonParseWorker implementation moved to JsonParseWorker.cpp
 
+namespace {
+// Time per event loop pass spent inserting result batches (leaves room for a 60 Hz repaint)
+constexpr int DEFAULT_FRAME_BUDGET_MS = 12;
+
+// Files opened when a search completes, and match rows shown by expanding at most
+constexpr int DEFAULT_EXPAND_FIRST_FILES = 20;
+constexpr int DEFAULT_EXPAND_MAX_ROWS = 100000;
+}
+
 CollapsibleSearchResults::CollapsibleSearchResults(QWidget *parent)
     : QWidget(parent)
-    , m_treeWidget(nullptr)
+    , m_treeView(nullptr)
+    , m_model(nullptr)
     , m_mainLayout(nullptr)
     , m_currentFileLabel(nullptr)
     , m_toggleButton(nullptr)
@@ -38,57 +56,67 @@ CollapsibleSearchResults::CollapsibleSearchResults(QWidget *parent)
 
     , m_pendingTotalMatchedLines(0)
     , m_actualFileCount(0)
+    , m_batchDrainScheduled(false)
+    , m_frameBudgetMs(DEFAULT_FRAME_BUDGET_MS)
+    , m_completionPending(false)
+    , m_completedMatches(0)
+    , m_completedFiles(0)
+    , m_abortsPending(0)
 
 {
     // Create main layout
     m_mainLayout = new QVBoxLayout(this);
     m_mainLayout->setContentsMargins(0, 0, 0, 0);
     
-    // Create tree widget
-    m_treeWidget = new QTreeWidget(this);
-    m_treeWidget->setHeaderLabels(QStringList() << "🔍 Search Results for pattern:");
-    m_treeWidget->setAlternatingRowColors(true);
-    m_treeWidget->setRootIsDecorated(true);
-    m_treeWidget->setExpandsOnDoubleClick(true);
-    m_treeWidget->setSortingEnabled(false);
+    // Create tree view over the results model - rows exist only as model indexes
+    m_model = new SearchResultsModel(this);
+    m_model->setHeaderText("🔍 Search Results for pattern:");
+    connect(m_model, &SearchResultsModel::fileMatchesRequested,
+            this, &CollapsibleSearchResults::fileMatchesRequested);
+    m_treeView = new QTreeView(this);
+    m_treeView->setModel(m_model);
+    m_treeView->setAlternatingRowColors(true);
+    m_treeView->setRootIsDecorated(true);
+    m_treeView->setExpandsOnDoubleClick(true);
+    m_treeView->setSortingEnabled(false);
     
     // Hide the tree header to save space
-    m_treeWidget->setHeaderHidden(true);
+    m_treeView->setHeaderHidden(true);
     
     // Force horizontal scroll bar to always be available
-    m_treeWidget->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-    m_treeWidget->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-    m_treeWidget->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    m_treeView->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+    m_treeView->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+    m_treeView->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
     
     // Set a reasonable minimum width for the tree widget
-    m_treeWidget->setMinimumWidth(300);
+    m_treeView->setMinimumWidth(300);
     
     // Configure tree widget for better horizontal scrolling
-    m_treeWidget->setWordWrap(false);
-    m_treeWidget->setTextElideMode(Qt::ElideNone);
+    m_treeView->setWordWrap(false);
+    m_treeView->setTextElideMode(Qt::ElideNone);
     
     // Force scroll bars to always be visible
-    m_treeWidget->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
-    m_treeWidget->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
+    m_treeView->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
+    m_treeView->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
     
-    // Set tree widget to expand columns to content
-    m_treeWidget->setUniformRowHeights(false);
-    m_treeWidget->setItemsExpandable(true);
+    // Uniform row heights let the view lay out and scroll without asking every row for its size
+    m_treeView->setUniformRowHeights(true);
+    m_treeView->setItemsExpandable(true);
     
     // Force the tree to calculate proper column widths
-    m_treeWidget->resizeColumnToContents(0);
+    m_treeView->resizeColumnToContents(0);
     
     // Configure the tree to handle wide content properly
-    m_treeWidget->setTextElideMode(Qt::ElideNone);
-    m_treeWidget->setWordWrap(false);
+    m_treeView->setTextElideMode(Qt::ElideNone);
+    m_treeView->setWordWrap(false);
     
     // Connect signals
-    connect(m_treeWidget, &QTreeWidget::itemClicked, this, &CollapsibleSearchResults::onItemClicked);
-    connect(m_treeWidget, &QTreeWidget::itemExpanded, this, &CollapsibleSearchResults::onItemExpanded);
-    connect(m_treeWidget, &QTreeWidget::itemCollapsed, this, &CollapsibleSearchResults::onItemCollapsed);
+    connect(m_treeView, &QTreeView::clicked, this, &CollapsibleSearchResults::onItemClicked);
+    connect(m_treeView, &QTreeView::expanded, this, &CollapsibleSearchResults::onItemExpanded);
+    connect(m_treeView, &QTreeView::collapsed, this, &CollapsibleSearchResults::onItemCollapsed);
     
     // Connect scroll signal for dynamic file path updates
-    connect(m_treeWidget->verticalScrollBar(), &QScrollBar::valueChanged, 
+    connect(m_treeView->verticalScrollBar(), &QScrollBar::valueChanged, 
             this, &CollapsibleSearchResults::updateCurrentFileDisplay);
     
     // Position updates no longer needed since widget is in layout
@@ -166,7 +194,7 @@ CollapsibleSearchResults::CollapsibleSearchResults(QWidget *parent)
     topLayout->addWidget(m_toggleButton);
     
     m_mainLayout->addLayout(topLayout);
-    m_mainLayout->addWidget(m_treeWidget);
+    m_mainLayout->addWidget(m_treeView);
     
     // File path widget is now part of the layout, no manual positioning needed
 }
@@ -181,9 +209,9 @@ void CollapsibleSearchResults::clear()
     
     logMemoryUsage("Clear - before");
     
-    m_treeWidget->clear();
-    m_fileItems.clear();
-    m_fileStats.clear();
+    m_model->clear();
+    m_pendingBatches.clear();
+    m_completionPending = false;
     
     // Force Qt memory cleanup
     QApplication::processEvents();
@@ -227,9 +255,8 @@ void CollapsibleSearchResults::stopParsing()
     m_pendingSummaryText.clear();
     m_pendingTotalMatchedLines = 0;
     m_actualFileCount = 0;
-    m_pendingFileItems.clear();
-    m_pendingMatchItems.clear();
-    m_pendingFileStats.clear();
+    m_pendingBatches.clear();
+    m_completionPending = false;
     
     LOG_INFO("CollapsibleSearchResults: stopParsing - Background parsing terminated");
 }
@@ -242,7 +269,8 @@ void CollapsibleSearchResults::stopParsing()
 
 
 
-void CollapsibleSearchResults::addSearchResults(const QString &pattern, const QString &jsonData, const QString &searchPath)
+void CollapsibleSearchResults::addSearchResults(const QString &pattern, const QString &jsonData, const QString &searchPath,
+                                                const SearchCancelToken &token)
 {
     LOG_INFO("addSearchResults: Function started");
     QElapsedTimer timer;
@@ -250,15 +278,15 @@ void CollapsibleSearchResults::addSearchResults(const QString &pattern, const QS
     
     try {
         // Check if tree widget exists
-        if (!m_treeWidget) {
-            LOG_ERROR("addSearchResults: m_treeWidget is null - cannot proceed!");
+        if (!m_treeView) {
+            LOG_ERROR("addSearchResults: m_treeView is null - cannot proceed!");
             return;
         }
         
         clear();
         
         LOG_INFO("addSearchResults: Starting async parsing");
-        addSearchResultsAsync(pattern, jsonData, searchPath);
+        addSearchResultsAsync(pattern, jsonData, searchPath, token);
         
         LOG_INFO("addSearchResults: Function completed");
         LOG_INFO("addSearchResults: Total function time: " + QString::number(timer.elapsed()) + " ms");
@@ -290,14 +318,164 @@ QString CollapsibleSearchResults::createMatchDisplayText(const QString &filePath
 
 // createParseThread method removed - now handled in addSearchResultsAsync
 
-void CollapsibleSearchResults::addSearchResultsAsync(const QString &pattern, const QString &jsonData, const QString &searchPath)
+void CollapsibleSearchResults::ensureParseThread()
+{
+    if (!m_parseThread) {
+        LOG_INFO("CollapsibleSearchResults: Creating parse thread");
+        m_parseThread = new QThread(this);
+        m_parseWorker = new JsonParseWorker();
+        m_parseWorker->moveToThread(m_parseThread);
+        
+        // Connect worker signals to main thread slots
+        connect(m_parseWorker, &JsonParseWorker::parsingStarted, 
+                this, &CollapsibleSearchResults::onParsingStarted, Qt::QueuedConnection);
+        connect(m_parseWorker, &JsonParseWorker::parsingProgress, 
+                this, &CollapsibleSearchResults::onParsingProgress, Qt::QueuedConnection);
+        connect(m_parseWorker, &JsonParseWorker::parsingCompleted, 
+                this, &CollapsibleSearchResults::onParsingCompleted, Qt::QueuedConnection);
+        connect(m_parseWorker, &JsonParseWorker::parsingError, 
+                this, &CollapsibleSearchResults::onParsingError, Qt::QueuedConnection);
+        connect(m_parseWorker, &JsonParseWorker::resultBatchReady, 
+                this, &CollapsibleSearchResults::onResultBatchReady, Qt::QueuedConnection);
+        connect(m_parseWorker, &JsonParseWorker::summaryParsed, 
+                this, &CollapsibleSearchResults::onSummaryParsed, Qt::QueuedConnection);
+        connect(m_parseWorker, &JsonParseWorker::streamAborted, 
+                this, &CollapsibleSearchResults::onStreamAborted, Qt::QueuedConnection);
+        connect(m_parseWorker, &JsonParseWorker::fileBatchReady, 
+                this, &CollapsibleSearchResults::onFileBatchReady, Qt::QueuedConnection);
+        
+        // Connect thread finished signal to cleanup
+        connect(m_parseThread, &QThread::finished, m_parseWorker, &QObject::deleteLater);
+        connect(m_parseThread, &QThread::finished, m_parseThread, &QObject::deleteLater);
+        
+        m_parseThread->start();
+        LOG_INFO("CollapsibleSearchResults: Parse thread created and started");
+    }
+}
+
+void CollapsibleSearchResults::loadFrameBudget()
+{
+    QSettings settings("app.ini", QSettings::IniFormat);
+    settings.beginGroup("RGSearch");
+    m_frameBudgetMs = qBound(1, settings.value("UiFrameBudgetMs", DEFAULT_FRAME_BUDGET_MS).toInt(), 1000);
+    settings.endGroup();
+    
+    LOG_INFO("CollapsibleSearchResults: UI frame budget " + QString::number(m_frameBudgetMs) + " ms");
+}
+
+void CollapsibleSearchResults::setPatternGroups(const QStringList &names, const QStringList &patterns)
+{
+    if (m_isParsing) {
+        LOG_INFO("CollapsibleSearchResults: Already parsing, pattern groups unchanged");
+        return;
+    }
+    if (!names.isEmpty()) {
+        LOG_INFO("CollapsibleSearchResults: Results grouped by " + QString::number(names.size()) + " patterns");
+    }
+    m_model->setPatternGroups(names, patterns);
+}
+
+void CollapsibleSearchResults::beginStreamingResults(const QString &pattern, const QString &searchPath,
+                                                     const SearchCancelToken &token)
+{
+    LOG_INFO("CollapsibleSearchResults: beginStreamingResults started");
+    
+    try {
+        if (!m_treeView) {
+            LOG_ERROR("CollapsibleSearchResults: beginStreamingResults - m_treeView is null!");
+            return;
+        }
+        
+        if (m_isParsing) {
+            LOG_INFO("CollapsibleSearchResults: Already parsing, ignoring new stream");
+            return;
+        }
+        
+        clear();
+        loadFrameBudget();
+        
+        QString headerText;
+        if (pattern.isEmpty()) {
+            headerText = "🔍 Search Results for pattern:";
+        } else {
+            headerText = QString("🔍 Search Results for pattern: '%1'").arg(pattern);
+        }
+        m_model->setHeaderText(headerText);
+        
+        ensureParseThread();
+        
+        m_isParsing = true;
+        m_cancelToken = token;
+        m_flowControl.reset();
+        QMetaObject::invokeMethod(m_parseWorker, "beginStream", Qt::QueuedConnection,
+                                 Q_ARG(QString, pattern),
+                                 Q_ARG(QString, searchPath),
+                                 Q_ARG(SearchCancelToken, token));
+        
+        LOG_INFO("CollapsibleSearchResults: beginStreamingResults - stream opened in background parser");
+        
+    } catch (const std::exception& e) {
+        LOG_ERROR("CollapsibleSearchResults: beginStreamingResults exception: " + QString(e.what()));
+        m_isParsing = false;
+    } catch (...) {
+        LOG_ERROR("CollapsibleSearchResults: beginStreamingResults unknown exception");
+        m_isParsing = false;
+    }
+}
+
+void CollapsibleSearchResults::appendStreamingChunk(const QByteArray &jsonLines)
+{
+    // Chunks are queued to the worker in arrival order and dropped there once consumed
+    if (!m_isParsing || !m_parseWorker) {
+        return;
+    }
+    
+    QMetaObject::invokeMethod(m_parseWorker, "parseJsonChunk", Qt::QueuedConnection,
+                             Q_ARG(QByteArray, jsonLines));
+}
+
+void CollapsibleSearchResults::abortStreamingResults()
+{
+    if (!m_isParsing || !m_parseWorker) {
+        return;
+    }
+    
+    LOG_INFO("CollapsibleSearchResults: abortStreamingResults - dropping the open stream");
+    
+    // Everything the worker sent for this stream arrives before its streamAborted
+    m_abortsPending++;
+    m_isParsing = false;
+    m_pendingBatches.clear();
+    m_completionPending = false;
+    QMetaObject::invokeMethod(m_parseWorker, "abortStream", Qt::QueuedConnection);
+}
+
+void CollapsibleSearchResults::onStreamAborted()
+{
+    m_abortsPending--;
+}
+
+void CollapsibleSearchResults::finishStreamingResults()
+{
+    LOG_INFO("CollapsibleSearchResults: finishStreamingResults - closing stream");
+    
+    if (!m_isParsing || !m_parseWorker) {
+        return;
+    }
+    
+    // Queued behind the remaining chunks, so parsingCompleted arrives after the last match
+    QMetaObject::invokeMethod(m_parseWorker, "endStream", Qt::QueuedConnection);
+}
+
+void CollapsibleSearchResults::addSearchResultsAsync(const QString &pattern, const QString &jsonData, const QString &searchPath,
+                                                     const SearchCancelToken &token)
 {
     LOG_INFO("CollapsibleSearchResults: addSearchResultsAsync started");
     
     try {
         // Safety checks
-        if (!m_treeWidget) {
-            LOG_ERROR("CollapsibleSearchResults: addSearchResultsAsync - m_treeWidget is null!");
+        if (!m_treeView) {
+            LOG_ERROR("CollapsibleSearchResults: addSearchResultsAsync - m_treeView is null!");
             return;
         }
         
@@ -308,6 +486,7 @@ void CollapsibleSearchResults::addSearchResultsAsync(const QString &pattern, con
         
         // Clear previous results
         clear();
+        loadFrameBudget();
         LOG_INFO("CollapsibleSearchResults: addSearchResultsAsync - clear completed");
         
         // Set initial header
@@ -317,50 +496,22 @@ void CollapsibleSearchResults::addSearchResultsAsync(const QString &pattern, con
         } else {
             headerText = QString("🔍 Search Results for pattern: '%1'").arg(pattern);
         }
-        m_treeWidget->setHeaderLabels(QStringList() << headerText);
+        m_model->setHeaderText(headerText);
         
         // Create parse thread and worker if they don't exist
-        if (!m_parseThread) {
-            LOG_INFO("CollapsibleSearchResults: Creating parse thread");
-            m_parseThread = new QThread(this);
-            m_parseWorker = new JsonParseWorker();
-            m_parseWorker->moveToThread(m_parseThread);
-            
-            // Connect worker signals to main thread slots
-            connect(m_parseWorker, &JsonParseWorker::parsingStarted, 
-                    this, &CollapsibleSearchResults::onParsingStarted, Qt::QueuedConnection);
-            connect(m_parseWorker, &JsonParseWorker::parsingProgress, 
-                    this, &CollapsibleSearchResults::onParsingProgress, Qt::QueuedConnection);
-            connect(m_parseWorker, &JsonParseWorker::parsingCompleted, 
-                    this, &CollapsibleSearchResults::onParsingCompleted, Qt::QueuedConnection);
-            connect(m_parseWorker, &JsonParseWorker::parsingError, 
-                    this, &CollapsibleSearchResults::onParsingError, Qt::QueuedConnection);
-            connect(m_parseWorker, &JsonParseWorker::fileItemCreated, 
-                    this, &CollapsibleSearchResults::onFileItemCreated, Qt::QueuedConnection);
-            connect(m_parseWorker, &JsonParseWorker::matchItemCreated, 
-                    this, &CollapsibleSearchResults::onMatchItemCreated, Qt::QueuedConnection);
-            connect(m_parseWorker, &JsonParseWorker::fileStatsUpdated, 
-                    this, &CollapsibleSearchResults::onFileStatsUpdated, Qt::QueuedConnection);
-            connect(m_parseWorker, &JsonParseWorker::summaryParsed, 
-                    this, &CollapsibleSearchResults::onSummaryParsed, Qt::QueuedConnection);
-            
-            // Connect thread finished signal to cleanup
-            connect(m_parseThread, &QThread::finished, m_parseWorker, &QObject::deleteLater);
-            connect(m_parseThread, &QThread::finished, m_parseThread, &QObject::deleteLater);
-            
-            m_parseThread->start();
-            LOG_INFO("CollapsibleSearchResults: Parse thread created and started");
-        }
+        ensureParseThread();
         
         // Start async parsing
         m_isParsing = true;
+        m_cancelToken = token;
         LOG_INFO("CollapsibleSearchResults: Starting background JSON parsing");
         
         // Call the worker's parse method in the background thread
         QMetaObject::invokeMethod(m_parseWorker, "parseJsonData", Qt::QueuedConnection,
                                  Q_ARG(QString, pattern),
                                  Q_ARG(QString, jsonData),
-                                 Q_ARG(QString, searchPath));
+                                 Q_ARG(QString, searchPath),
+                                 Q_ARG(SearchCancelToken, token));
         
         LOG_INFO("CollapsibleSearchResults: addSearchResultsAsync - parsing started in background");
         
@@ -463,11 +614,15 @@ void CollapsibleSearchResults::onParsingStarted()
 {
     LOG_INFO("CollapsibleSearchResults: onParsingStarted - SIGNAL RECEIVED!");
     
+    if (m_abortsPending > 0) {
+        return;  // Left over from an aborted stream
+    }
+    
     m_parseStartTime.start();
     
     // Update header with processing message
-    if (m_treeWidget) {
-        m_treeWidget->setHeaderLabels(QStringList() << "⚙️ Processing search results...");
+    if (m_treeView) {
+        m_model->setHeaderText("⚙️ Processing search results...");
     }
     LOG_INFO("CollapsibleSearchResults: onParsingStarted - completed");
 }
@@ -476,6 +631,10 @@ void CollapsibleSearchResults::onParsingProgress(int percentage, int files)
 {
     LOG_INFO("CollapsibleSearchResults: onParsingProgress - " + QString::number(percentage) + "% in " + QString::number(files) + " files");
     
+    if (m_abortsPending > 0) {
+        return;  // Left over from an aborted stream
+    }
+    
     // Progress tracking moved to main window
     
     // Emit progress signal for main window
@@ -486,6 +645,26 @@ void CollapsibleSearchResults::onParsingCompleted(int totalMatches, int totalFil
 {
     LOG_INFO("CollapsibleSearchResults: onParsingCompleted - SIGNAL RECEIVED! " + QString::number(totalMatches) + " matches in " + QString::number(totalFiles) + " files");
     
+    if (m_abortsPending > 0) {
+        return;  // Left over from an aborted stream
+    }
+    
+    if (m_cancelToken.isCancelled() && !m_pendingBatches.isEmpty()) {
+        // Stopped - results not in the tree yet are dropped instead of inserted first
+        LOG_INFO("CollapsibleSearchResults: onParsingCompleted - session cancelled, dropping " +
+                 QString::number(m_pendingBatches.size()) + " pending batches");
+        m_pendingBatches.clear();
+    }
+    
+    if (!m_pendingBatches.isEmpty()) {
+        // Results are still being inserted - complete after the last batch
+        LOG_INFO("CollapsibleSearchResults: onParsingCompleted - " + QString::number(m_pendingBatches.size()) + " batches still pending");
+        m_completionPending = true;
+        m_completedMatches = totalMatches;
+        m_completedFiles = totalFiles;
+        return;
+    }
+    
     logMemoryUsage("Parsing completed - start");
     
     // Progress tracking moved to main window
@@ -493,16 +672,8 @@ void CollapsibleSearchResults::onParsingCompleted(int totalMatches, int totalFil
     
     // Add summary item
     if (totalMatches > 0) {
-        QTreeWidgetItem *summaryItem = new QTreeWidgetItem(m_treeWidget);
         QString summaryText = QString("✅ Found %1 matches in %2 files").arg(totalMatches).arg(totalFiles);
-        summaryItem->setText(0, summaryText);
-        summaryItem->setBackground(0, QColor(100, 255, 100));
-        
-        QFont summaryFont = summaryItem->font(0);
-        summaryFont.setBold(true);
-        summaryFont.setPointSize(10);
-        summaryItem->setFont(0, summaryFont);
-        summaryItem->setFlags(summaryItem->flags() & ~Qt::ItemIsSelectable);
+        m_model->setStatus(SearchResultsModel::SummaryStatus, summaryText);
         
             // Update pane title with "Search Results" + summary information
     updatePaneTitle("Search Results - " + summaryText);
@@ -511,18 +682,15 @@ void CollapsibleSearchResults::onParsingCompleted(int totalMatches, int totalFil
     m_lastSummaryText = summaryText;
     
     // Simple horizontal scroll setup - make column much wider than needed
-    m_treeWidget->setColumnWidth(0, m_treeWidget->width() * 2);
+    m_treeView->setColumnWidth(0, m_treeView->width() * 2);
     }
     
-    // Expand file items
-    m_treeWidget->setUpdatesEnabled(false);
-    for (int i = 0; i < m_treeWidget->topLevelItemCount(); ++i) {
-        QTreeWidgetItem *item = m_treeWidget->topLevelItem(i);
-        if (item && item->text(0).startsWith("📁")) {
-            item->setExpanded(true);
-        }
-    }
-    m_treeWidget->setUpdatesEnabled(true);
+    // Open the first files only - the tree lays out every row of an expanded file
+    QSettings settings("app.ini", QSettings::IniFormat);
+    settings.beginGroup("RGSearch");
+    int expandFiles = qMax(0, settings.value("ExpandFirstFiles", DEFAULT_EXPAND_FIRST_FILES).toInt());
+    settings.endGroup();
+    expandFirstFiles(expandFiles);
     
     // Update current file display - only use delayed call to avoid blocking
     QTimer::singleShot(100, this, &CollapsibleSearchResults::updateCurrentFileDisplay);
@@ -531,6 +699,8 @@ void CollapsibleSearchResults::onParsingCompleted(int totalMatches, int totalFil
     
     m_isParsing = false;
     LOG_INFO("CollapsibleSearchResults: onParsingCompleted - parsing finished");
+    LOG_INFO("CollapsibleSearchResults: Result store holds " + QString::number(resultStore().matchCount()) + " matches in " +
+             QString::number(resultStore().fileCount()) + " files (" + QString::number(resultStore().memoryUsage() / 1024) + " KB)");
     
     logMemoryUsage("Parsing completed - end");
     
@@ -544,12 +714,16 @@ void CollapsibleSearchResults::onParsingError(const QString &error)
 {
     LOG_INFO("CollapsibleSearchResults: onParsingError - " + error);
     
+    if (m_abortsPending > 0) {
+        return;  // Left over from an aborted stream
+    }
+    
 
     
     // Update header with error message
-    if (m_treeWidget) {
+    if (m_treeView) {
         QString errorHeader = "❌ Parsing error: " + error;
-        m_treeWidget->setHeaderLabels(QStringList() << errorHeader);
+        m_model->setHeaderText(errorHeader);
         
         // Also update pane title with "Search Results" + error information
         updatePaneTitle("Search Results - " + errorHeader);
@@ -557,44 +731,74 @@ void CollapsibleSearchResults::onParsingError(const QString &error)
     m_isParsing = false;
 }
 
-void CollapsibleSearchResults::onFileItemCreated(const QString &filePath, const QString &displayText)
+void CollapsibleSearchResults::onResultBatchReady(const SearchResultBatchPtr &batch)
 {
-    LOG_INFO("CollapsibleSearchResults: onFileItemCreated - " + filePath);
-    
-    // Track actual file count
-    m_actualFileCount++;
-    
-    QTreeWidgetItem *fileItem = new QTreeWidgetItem(m_treeWidget);
-    fileItem->setText(0, displayText);
-    fileItem->setBackground(0, QColor(240, 240, 240));
-    
-    QFont fileFont = fileItem->font(0);
-    fileFont.setBold(true);
-    fileFont.setPointSize(10);
-    fileItem->setFont(0, fileFont);
+    if (!batch || m_abortsPending > 0 || m_cancelToken.isCancelled()) {
+        return;
+    }
     
-    fileItem->setIcon(0, QApplication::style()->standardIcon(QStyle::SP_FileIcon));
-    fileItem->setFlags(fileItem->flags() & ~Qt::ItemIsSelectable);
+    m_pendingBatches.append(batch);
+    if (!m_batchDrainScheduled) {
+        m_batchDrainScheduled = true;
+        QTimer::singleShot(0, this, &CollapsibleSearchResults::processPendingBatches);
+    }
+}
+
+void CollapsibleSearchResults::appendFileMatches(const QByteArray &jsonLines, const SearchCancelToken &token)
+{
+    if (token.isCancelled() || !m_parseWorker) {
+        return;
+    }
+    QMetaObject::invokeMethod(m_parseWorker, "parseFileMatches", Qt::QueuedConnection,
+                              Q_ARG(QByteArray, jsonLines), Q_ARG(SearchCancelToken, token));
+}
+
+void CollapsibleSearchResults::onFileBatchReady(const SearchResultBatchPtr &batch, const SearchCancelToken &token)
+{
+    // Matches of a file of replaced results must not be added to the new ones
+    if (!batch || token.isCancelled()) {
+        return;
+    }
     
-    // Store reference for later updates
-    m_fileItems[filePath] = fileItem;
+    m_pendingBatches.append(batch);
+    if (!m_batchDrainScheduled) {
+        m_batchDrainScheduled = true;
+        QTimer::singleShot(0, this, &CollapsibleSearchResults::processPendingBatches);
+    }
 }
 
-void CollapsibleSearchResults::onMatchItemCreated(const QString &filePath, int lineNumber, const QString &lineText)
+void CollapsibleSearchResults::processPendingBatches()
 {
+    QElapsedTimer frameTimer;
+    frameTimer.start();
     
-    if (m_fileItems.contains(filePath)) {
-        QTreeWidgetItem *fileItem = m_fileItems[filePath];
-        QTreeWidgetItem *matchItem = new QTreeWidgetItem();
-        
-        // Format the text with line number - this creates the visible text in the tree
-        matchItem->setText(0, QString("  Line %1: %2").arg(lineNumber).arg(lineText.trimmed()));
-        matchItem->setData(0, Qt::UserRole, filePath);
-        matchItem->setData(0, Qt::UserRole + 1, lineNumber);
-        
-        fileItem->addChild(matchItem);
-        
-        // No recalculation during parsing - will be done once at the end
+    if (m_cancelToken.isCancelled()) {
+        m_pendingBatches.clear();
+    }
+    
+    // Whole batches until the budget is used up, then yield to the event loop
+    while (!m_pendingBatches.isEmpty()) {
+        SearchResultBatchPtr batch = m_pendingBatches.takeFirst();
+        int filesBefore = m_model->fileCount();
+        m_model->appendBatch(*batch);
+        m_actualFileCount += m_model->fileCount() - filesBefore;
+        if (m_flowControl) {
+            m_flowControl->consumed(batch->streamBytes);
+        }
+        if (frameTimer.elapsed() >= m_frameBudgetMs) {
+            break;
+        }
+    }
+    
+    if (!m_pendingBatches.isEmpty()) {
+        QTimer::singleShot(0, this, &CollapsibleSearchResults::processPendingBatches);
+        return;
+    }
+    
+    m_batchDrainScheduled = false;
+    if (m_completionPending) {
+        m_completionPending = false;
+        onParsingCompleted(m_completedMatches, m_completedFiles);
     }
 }
 
@@ -602,6 +806,10 @@ void CollapsibleSearchResults::onSummaryParsed(const QString &summaryText, int t
 {
     LOG_INFO("CollapsibleSearchResults: onSummaryParsed - " + summaryText + " (" + QString::number(totalMatchedLines) + " lines)");
     
+    if (m_abortsPending > 0) {
+        return;  // Left over from an aborted stream
+    }
+    
     logMemoryUsage("Summary parsed");
     
     // Store summary data for later use
@@ -610,9 +818,9 @@ void CollapsibleSearchResults::onSummaryParsed(const QString &summaryText, int t
     
     // Update header with the summary text from JsonParseWorker
     if (!summaryText.isEmpty()) {
-        m_treeWidget->setHeaderLabels(QStringList() << summaryText);
+        m_model->setHeaderText(summaryText);
     } else {
-        m_treeWidget->setHeaderLabels(QStringList() << "⚙️ Processing search results...");
+        m_model->setHeaderText("⚙️ Processing search results...");
     }
     
     // Progress bar removed - now handled in main window
@@ -621,133 +829,65 @@ void CollapsibleSearchResults::onSummaryParsed(const QString &summaryText, int t
 
 
 
-void CollapsibleSearchResults::onFileStatsUpdated(const QString &filePath, const QString &elapsedTime, int matchedLines)
-{
-    LOG_INFO("CollapsibleSearchResults: onFileStatsUpdated - " + filePath + " (" + elapsedTime + ", " + QString::number(matchedLines) + " lines)");
-    
-    if (m_fileItems.contains(filePath)) {
-        QTreeWidgetItem *fileItem = m_fileItems[filePath];
-        QString newText = QString("📁 %1 (%2, %3 lines)").arg(filePath).arg(elapsedTime).arg(matchedLines);
-        fileItem->setText(0, newText);
-    }
-}
-
-
-
-
 ////===========================================================================================================
 ////===========================================================================================================
 ////===========================================================================================================
 
 
 
+int CollapsibleSearchResults::selectedMatchRow() const
+{
+    return m_model->matchRowOf(m_treeView->currentIndex());
+}
+
 QString CollapsibleSearchResults::getSelectedFilePath() const
 {
-    QTreeWidgetItem *currentItem = m_treeWidget->currentItem();
-    if (currentItem && currentItem->data(0, Qt::UserRole).isValid()) {
-        return currentItem->data(0, Qt::UserRole).toString();
+    int row = selectedMatchRow();
+    if (row >= 0) {
+        return resultStore().filePath(resultStore().matchFileId(row));
     }
     return QString();
 }
 
 int CollapsibleSearchResults::getSelectedLineNumber() const
 {
-    QTreeWidgetItem *currentItem = m_treeWidget->currentItem();
-    if (currentItem && currentItem->data(0, Qt::UserRole + 1).isValid()) {
-        return currentItem->data(0, Qt::UserRole + 1).toInt();
+    int row = selectedMatchRow();
+    if (row >= 0) {
+        return resultStore().lineNumber(row);
     }
     return -1;
 }
 
-void CollapsibleSearchResults::onItemClicked(QTreeWidgetItem *item, int column)
+void CollapsibleSearchResults::onItemClicked(const QModelIndex &index)
 {
-    Q_UNUSED(column)
+    // Only match rows resolve to a result row
+    int row = m_model->matchRowOf(index);
+    if (row < 0) return;
     
-    if (!item) return;
-    
-    // Check if this is a match item (has file path and line number data)
-    QString filePath = item->data(0, Qt::UserRole).toString();
-    int lineNumber = item->data(0, Qt::UserRole + 1).toInt();
+    QString filePath = resultStore().filePath(resultStore().matchFileId(row));
+    int lineNumber = resultStore().lineNumber(row);
+    qint64 byteOffset = resultStore().byteOffset(row);
     
     if (!filePath.isEmpty() && lineNumber > 0) {
-        emit resultSelected(filePath, lineNumber);
+        emit resultSelected(filePath, lineNumber, byteOffset);
     }
 }
 
-void CollapsibleSearchResults::onItemExpanded(QTreeWidgetItem *item)
+void CollapsibleSearchResults::onItemExpanded(const QModelIndex &index)
 {
-    if (item) {
-        item->setIcon(0, QApplication::style()->standardIcon(QStyle::SP_DirOpenIcon));
-        // Update file display when items are expanded
-        updateCurrentFileDisplay();
-    }
+    m_model->setFileExpanded(index, true);
+    // Update file display when items are expanded
+    updateCurrentFileDisplay();
 }
 
-void CollapsibleSearchResults::onItemCollapsed(QTreeWidgetItem *item)
+void CollapsibleSearchResults::onItemCollapsed(const QModelIndex &index)
 {
-    if (item) {
-        item->setIcon(0, QApplication::style()->standardIcon(QStyle::SP_DirClosedIcon));
-    }
+    m_model->setFileExpanded(index, false);
 }
 
-QTreeWidgetItem* CollapsibleSearchResults::createFileItem(const QString &filePath)
-{
-    if (!m_treeWidget) {
-        return nullptr;
-    }
-    
-    QTreeWidgetItem *fileItem = new QTreeWidgetItem(m_treeWidget);
-    
-    // Check if we have statistics for this file
-    QString displayText;
-    if (m_fileStats.contains(filePath)) {
-        QPair<QString, int> stats = m_fileStats[filePath];
-        displayText = QString("📁 %1 (Search tool %2, Found %3 lines)")
-                        .arg(filePath)
-                        .arg(stats.first)  // elapsed time
-                        .arg(stats.second); // matched lines
-    } else {
-        displayText = QString("📁 %1").arg(filePath);
-    }
-    
-    // ===== VISIBLE UPDATE: TREE ITEM TEXT =====
-    // Set the initial text for the file item - this creates the visible text in the tree
-    fileItem->setText(0, displayText);
-    
-    // ===== VISIBLE UPDATE: TREE ITEM STYLING =====
-    // Set background color and font styling - this changes the visual appearance
-    fileItem->setBackground(0, QColor(240, 240, 240));
-    
-    QFont fileFont = fileItem->font(0);
-    fileFont.setBold(true);
-    fileFont.setPointSize(10);
-    fileItem->setFont(0, fileFont);
-    
-    // ===== VISIBLE UPDATE: TREE ITEM ICON =====
-    // Set folder icon - this changes the visual appearance
-    fileItem->setIcon(0, QApplication::style()->standardIcon(QStyle::SP_DirOpenIcon));
-    fileItem->setFlags(fileItem->flags() & ~Qt::ItemIsSelectable);
-    
-    return fileItem;
-}
-
-QTreeWidgetItem* CollapsibleSearchResults::createMatchItem(const QString &filePath, int lineNumber, const QString &lineText)
-{
-    QTreeWidgetItem *matchItem = new QTreeWidgetItem();
-    
-    // ===== VISIBLE UPDATE: TREE ITEM TEXT =====
-    // Set the text for the match item - this creates the visible text in the tree
-    matchItem->setText(0, QString("  Line %1: %2").arg(lineNumber).arg(lineText.trimmed()));
-    
-    // Store file path and line number in item data (not visible, used for navigation)
-    matchItem->setData(0, Qt::UserRole, filePath);
-    matchItem->setData(0, Qt::UserRole + 1, lineNumber);
-    
-    return matchItem;
-}
 void CollapsibleSearchResults::updateCurrentFileDisplay()
 {
-    if (!m_treeWidget || m_treeWidget->topLevelItemCount() == 0) {
+    if (!m_treeView || m_model->fileCount() == 0) {
         if (m_currentFileLabel) {
             m_currentFileLabel->setVisible(false);
         }
@@ -770,130 +910,86 @@ void CollapsibleSearchResults::updateCurrentFileDisplay()
 
 QString CollapsibleSearchResults::getCurrentVisibleFile() const
 {
-    if (!m_treeWidget) return QString();
+    if (!m_treeView) return QString();
     
-    // For large datasets, just return the first file item to avoid performance issues
-    // The itemAt() method is extremely slow with 2+ million items
-    for (int i = 0; i < m_treeWidget->topLevelItemCount(); ++i) {
-        QTreeWidgetItem *topItem = m_treeWidget->topLevelItem(i);
-        if (topItem && topItem->text(0).startsWith("📁")) {
-            QString text = topItem->text(0);
-            if (text.startsWith("📁 ")) {
-                return text.mid(3); // Remove "📁 " prefix
-            }
-        }
+    // File of the topmost visible row - indexAt() is cheap with uniform row heights
+    QModelIndex topIndex = m_treeView->indexAt(QPoint(0, 0));
+    int fileId = m_model->fileIdOf(topIndex);
+    if (fileId < 0) {
+        fileId = (m_model->fileCount() > 0) ? 0 : -1;
     }
     
-    return QString();
+    return (fileId >= 0) ? resultStore().filePath(fileId) : QString();
 }
 
 // Positioning methods removed - widget is now part of layout
 
 void CollapsibleSearchResults::collapseAll()
 {
-    if (m_treeWidget) {
-        QElapsedTimer timer;
-        timer.start();
-        
-        // Temporarily disable updates for better performance
-        m_treeWidget->setUpdatesEnabled(false);
-        
-        // Collapse only file items (top-level items that start with 📁)
-        for (int i = 0; i < m_treeWidget->topLevelItemCount(); ++i) {
-            QTreeWidgetItem *item = m_treeWidget->topLevelItem(i);
-            if (item && item->text(0).startsWith("📁")) {
-                item->setExpanded(false);
-            }
-        }
-        
-        m_treeWidget->setUpdatesEnabled(true);
-        
-        qint64 elapsed = timer.elapsed();
-    
+    if (m_treeView) {
+        // Only file rows have children
+        m_treeView->collapseAll();
+        m_model->setAllFilesExpanded(false);
     }
 }
 
 void CollapsibleSearchResults::expandAll()
 {
-    if (m_treeWidget) {
-        QElapsedTimer timer;
-        timer.start();
-        
-        // Temporarily disable updates for better performance
-        m_treeWidget->setUpdatesEnabled(false);
-        
-        // Expand only file items (top-level items that start with 📁)
-        for (int i = 0; i < m_treeWidget->topLevelItemCount(); ++i) {
-            QTreeWidgetItem *item = m_treeWidget->topLevelItem(i);
-            if (item && item->text(0).startsWith("📁")) {
-                item->setExpanded(true);
-            }
+    if (m_treeView) {
+        expandFirstFiles(std::numeric_limits<int>::max());
+    }
+}
+
+int CollapsibleSearchResults::expandFirstFiles(int maxFiles)
+{
+    QSettings settings("app.ini", QSettings::IniFormat);
+    settings.beginGroup("RGSearch");
+    qint64 maxRows = qMax(1, settings.value("ExpandMaxRows", DEFAULT_EXPAND_MAX_ROWS).toInt());
+    settings.endGroup();
+
+    // Counted files have no rows yet - expanding one would search it for its matches
+    int topRows = m_model->rowCount();
+    int expanded = 0;
+    qint64 rows = 0;
+    for (int row = 0; row < topRows && expanded < maxFiles && rows < maxRows; ++row) {
+        QModelIndex index = m_model->index(row, 0);
+        int children = m_model->rowCount(index);
+        if (children == 0) {
+            continue;
         }
-        
-        m_treeWidget->setUpdatesEnabled(true);
-        
-        qint64 elapsed = timer.elapsed();
-    
+        m_treeView->expand(index);
+        expanded++;
+        rows += children;
     }
+
+    LOG_INFO("CollapsibleSearchResults: Expanded " + QString::number(expanded) + " of " + QString::number(topRows) +
+             " rows (" + QString::number(rows) + " matches shown)");
+    return expanded;
 }
 
 void CollapsibleSearchResults::toggleExpandCollapse()
 {
-    if (m_treeWidget) {
-        QElapsedTimer timer;
-        timer.start();
-        
+    if (m_treeView) {
         // Toggle the state
         m_isExpanded = !m_isExpanded;
         
         // Update button text and icon
         if (m_isExpanded) {
             m_toggleButton->setText("📂 Collapse All");
+            expandAll();
         } else {
             m_toggleButton->setText("📁 Expand All");
+            collapseAll();
         }
-        
-        // Temporarily disable updates for better performance
-        m_treeWidget->setUpdatesEnabled(false);
-        
-        // Expand or collapse all file items based on current state
-        for (int i = 0; i < m_treeWidget->topLevelItemCount(); ++i) {
-            QTreeWidgetItem *item = m_treeWidget->topLevelItem(i);
-            if (item && item->text(0).startsWith("📁")) {
-                item->setExpanded(m_isExpanded);
-            }
-        }
-        
-        m_treeWidget->setUpdatesEnabled(true);
-        
-        qint64 elapsed = timer.elapsed();
-    
     }
 }
 
 void CollapsibleSearchResults::showSearchingMessage()
 {
-    if (m_treeWidget) {
-        // Clear existing items
-        m_treeWidget->clear();
-        
-        // Create a special item to show the searching message
-        QTreeWidgetItem *searchingItem = new QTreeWidgetItem(m_treeWidget);
-        searchingItem->setText(0, "🔍 Searching...");
-        searchingItem->setText(1, "Please wait while searching for matches");
-        
-        // Style the searching message
-        searchingItem->setBackground(0, QColor(240, 240, 240));  // Light gray background
-        searchingItem->setForeground(0, QColor(102, 102, 102));  // Dark gray text
-        searchingItem->setFont(0, QFont("Arial", 12, QFont::Bold));
-        
-        // Make it non-selectable and non-expandable
-        searchingItem->setFlags(searchingItem->flags() & ~Qt::ItemIsSelectable);
-        
-        // Expand to show the message
-        searchingItem->setExpanded(true);
-        
-    
+    if (m_treeView) {
+        // Clear existing results and show the searching message as a status row
+        m_model->clear();
+        m_model->setStatus(SearchResultsModel::SearchingStatus, "🔍 Searching...");
     }
 }
 
@@ -907,6 +1003,7 @@ void CollapsibleSearchResults::logMemoryUsage(const QString& stage)
 
 qint64 CollapsibleSearchResults::getCurrentMemoryUsage() const
 {
+#ifdef Q_OS_WIN
     // Get process memory usage on Windows
     HANDLE process = GetCurrentProcess();
     PROCESS_MEMORY_COUNTERS_EX pmc;
@@ -914,6 +1011,15 @@ qint64 CollapsibleSearchResults::getCurrentMemoryUsage() const
         return pmc.WorkingSetSize;
     }
     return 0;
+#else
+    // Resident pages from /proc/self/statm
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    QList<QByteArray> fields = statm.readAll().split(' ');
+    return (fields.size() > 1) ? fields[1].toLongLong() * sysconf(_SC_PAGESIZE) : 0;
+#endif
 }
 
 void CollapsibleSearchResults::resetParseThread()
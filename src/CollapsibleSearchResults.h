@@ -3,8 +3,7 @@
 
 #include <QWidget>
 #include <QVBoxLayout>
-#include <QTreeWidget>
-#include <QTreeWidgetItem>
+#include <QTreeView>
 #include <QHeaderView>
 #include <QString>
 #include <QMap>
@@ -13,9 +12,15 @@
 #include <QThread> // Added for QThread
 #include <QProgressBar>
 #include <QObject>
+#include <QVector>
+#include <QSharedPointer>
+#include "SearchResultStore.h"
+#include "SearchResultsModel.h"
+#include "SearchCancelToken.h"
 
 // Forward declaration
 class JsonParseWorker;
+class SearchFlowControl;
 
 // No longer using JsonParseWorker - JSON parsing is now done directly in createParseThread
 
@@ -30,25 +35,50 @@ public:
     // Clear all results
     void clear();
     
-    // Add search results from JSON data
-    void addSearchResults(const QString &pattern, const QString &jsonData, const QString &searchPath = QString());
+    // Add search results from JSON data - parsing and insertion stop once token is cancelled
+    void addSearchResults(const QString &pattern, const QString &jsonData, const QString &searchPath = QString(),
+                          const SearchCancelToken &token = SearchCancelToken());
     
     // Get selected file path and line number
     QString getSelectedFilePath() const;
     int getSelectedLineNumber() const;
     
-    // Collapse/Expand all results
+    // All matches of the current results, shared by every consumer (tree, viewer, highlighting)
+    const SearchResultStore &resultStore() const { return m_model->store(); }
+    
+    // Collapse/Expand all results - expanding stops after [RGSearch] ExpandMaxRows match rows
     void collapseAll();
     void expandAll();
     void toggleExpandCollapse();
     void showSearchingMessage();
 
     // New method for non-blocking parsing
-    void addSearchResultsAsync(const QString &pattern, const QString &jsonData, const QString &searchPath);
+    void addSearchResultsAsync(const QString &pattern, const QString &jsonData, const QString &searchPath,
+                               const SearchCancelToken &token = SearchCancelToken());
     
     // Create parse thread (called after cleanup)
     void createParseThread();
     
+    // Batch search: the next results are grouped by the patterns of this list (empty = by file).
+    // Set before beginStreamingResults
+    void setPatternGroups(const QStringList &names, const QStringList &patterns);
+    
+    // Streaming mode: results fill in while ripgrep is still running
+    void beginStreamingResults(const QString &pattern, const QString &searchPath,
+                               const SearchCancelToken &token = SearchCancelToken());
+    void appendStreamingChunk(const QByteArray &jsonLines);
+    void finishStreamingResults();
+    
+    // Backlog of the search feeding the open stream - batches are reported consumed once they
+    // are in the model (set after beginStreamingResults)
+    void setFlowControl(const QSharedPointer<SearchFlowControl> &flow) { m_flowControl = flow; }
+    
+    // Drop the open stream so a new one can begin right away (live search)
+    void abortStreamingResults();
+    
+    // JSON lines of a counted file searched after fileMatchesRequested - dropped once token is cancelled
+    void appendFileMatches(const QByteArray &jsonLines, const SearchCancelToken &token);
+    
     // Stop parsing - terminate background parsing thread
     void stopParsing();
     
@@ -74,7 +104,8 @@ public:
 
 
 signals:
-    void resultSelected(const QString &filePath, int lineNumber);
+    // byteOffset: start of the line in the file (ripgrep's absolute_offset), -1 if unknown
+    void resultSelected(const QString &filePath, int lineNumber, qint64 byteOffset);
     
     // New signals for async parsing
     void parsingStarted();
@@ -83,36 +114,49 @@ signals:
     void parsingError(const QString &error);
     void startParsing(const QString &pattern, const QString &jsonData, const QString &searchPath);
     void querySearchStateFromMain();
+    
+    // A file whose matches were only counted was expanded
+    void fileMatchesRequested(const QString &filePath);
 
 private slots:
-    void onItemClicked(QTreeWidgetItem *item, int column);
-    void onItemExpanded(QTreeWidgetItem *item);
-    void onItemCollapsed(QTreeWidgetItem *item);
+    void onItemClicked(const QModelIndex &index);
+    void onItemExpanded(const QModelIndex &index);
+    void onItemCollapsed(const QModelIndex &index);
     
     // New slots for async parsing
     Q_INVOKABLE void onParsingStarted();
     Q_INVOKABLE void onParsingProgress(int percentage, int files);
     Q_INVOKABLE void onParsingCompleted(int totalMatches, int totalFiles);
     Q_INVOKABLE void onParsingError(const QString &error);
-    Q_INVOKABLE void onFileItemCreated(const QString &filePath, const QString &displayText);
-    Q_INVOKABLE void onMatchItemCreated(const QString &filePath, int lineNumber, const QString &lineText);
-    Q_INVOKABLE void onFileStatsUpdated(const QString &filePath, const QString &elapsedTime, int matchedLines);
+    Q_INVOKABLE void onResultBatchReady(const SearchResultBatchPtr &batch);
     Q_INVOKABLE void onSummaryParsed(const QString &summaryText, int totalMatchedLines);
+    Q_INVOKABLE void onStreamAborted();
+    Q_INVOKABLE void onFileBatchReady(const SearchResultBatchPtr &batch, const SearchCancelToken &token);
 
 
 private:
-    QTreeWidget *m_treeWidget;
-    QMap<QString, QTreeWidgetItem*> m_fileItems; // Map file path to tree item
-    QMap<QString, QPair<QString, int>> m_fileStats; // Map file path to (elapsed_time, matched_lines)
+    QTreeView *m_treeView;
+    SearchResultsModel *m_model;           // Files and matches of the current results
     QVBoxLayout *m_mainLayout;
     
     // Helper methods
-    QTreeWidgetItem* createFileItem(const QString &filePath);
-    QTreeWidgetItem* createMatchItem(const QString &filePath, int lineNumber, const QString &lineText);
+    int selectedMatchRow() const;  // -1 if no match item is selected
     QString parseRGSummary(const QString &jsonData, int* outMatchedLines = nullptr);
 
     QString createFileDisplayText(const QString &filePath, const QString &elapsedTime = QString(), int matchedLines = 0);
     QString createMatchDisplayText(const QString &filePath, int lineNumber, const QString &lineText);
+    
+    // Create the parse thread and worker on first use
+    void ensureParseThread();
+    
+    // Result batches are inserted within a per-frame time budget ([RGSearch] UiFrameBudgetMs)
+    // so the event loop can paint and handle input between them
+    void loadFrameBudget();
+    void processPendingBatches();
+    
+    // Expand rows with matches from the top, at most maxFiles of them; returns how many
+    int expandFirstFiles(int maxFiles);
+    
     // Current file display functionality
     void updateCurrentFileDisplay();
     QString getCurrentVisibleFile() const;
@@ -132,10 +176,23 @@ private:
     QString m_pendingSummaryText;
     int m_pendingTotalMatchedLines;
     int m_actualFileCount;
-
-    QList<QPair<QString, QString>> m_pendingFileItems; // filePath, displayText
-    QList<QPair<QString, QPair<int, QString>>> m_pendingMatchItems; // filePath, (lineNumber, lineText)
-    QList<QPair<QString, QPair<QString, int>>> m_pendingFileStats; // filePath, (elapsedTime, matchedLines)
+    
+    // Batches received but not yet inserted into the tree
+    QList<SearchResultBatchPtr> m_pendingBatches;
+    bool m_batchDrainScheduled;
+    int m_frameBudgetMs;
+    
+    // parsingCompleted that arrived while batches were still pending
+    bool m_completionPending;
+    int m_completedMatches;
+    int m_completedFiles;
+    
+    // Aborted streams whose streamAborted has not arrived yet - their signals are ignored
+    int m_abortsPending;
+    
+    // Session of the results being parsed - once cancelled, batches not yet inserted are dropped
+    SearchCancelToken m_cancelToken;
+    QSharedPointer<SearchFlowControl> m_flowControl;
     
     QString m_lastSummaryText; // Store last summary text for search time updates
 };
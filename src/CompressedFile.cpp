@@ -0,0 +1,591 @@
+#include "CompressedFile.h"
+#include "CachedFileSearcher.h"
+#include "SplitFileSearch.h"
+#include "logger.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSettings>
+#include <cstring>
+
+#ifdef TOTALSEARCH_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef TOTALSEARCH_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+
+const quint32 IndexMagic = 0x545A4931;     // "TZI1"
+const qint32 IndexVersion = 1;
+
+// Compressed bytes read at a time
+const qint64 InputBytes = 256 * 1024;
+
+// Largest distance a deflate stream refers back to - the window kept at a gzip checkpoint
+const int WindowBytes = 32 * 1024;
+
+QString normalizedPath(const QString &filePath)
+{
+    QString normalized = QDir::cleanPath(QFileInfo(filePath).absoluteFilePath());
+#ifdef Q_OS_WIN
+    normalized = normalized.toLower();
+#endif
+    return normalized;
+}
+
+} // namespace
+
+CompressedFile::CompressedFile(const QString &filePath, Format format)
+    : m_filePath(filePath)
+    , m_format(format)
+    , m_fileSize(-1)
+    , m_fileModified(0)
+    , m_size(0)
+    , m_lineCount(0)
+{
+    CachedFileSearcher::Fingerprint current = CachedFileSearcher::fingerprint(filePath);
+    m_fileSize = current.size;
+    m_fileModified = current.modified;
+}
+
+CompressedFile::Format CompressedFile::formatOf(const QString &filePath)
+{
+    QString suffix = QFileInfo(filePath).suffix().toLower();
+    if (suffix == "gz" || suffix == "tgz") {
+        return Gzip;
+    }
+    if (suffix == "zst" || suffix == "zstd") {
+        return Zstd;
+    }
+    return None;
+}
+
+bool CompressedFile::isCompressedPath(const QString &filePath)
+{
+    static const QStringList suffixes = {"gz", "tgz", "bz2", "tbz2", "xz", "txz", "lz4", "lzma", "br", "zst", "zstd"};
+    QString suffix = QFileInfo(filePath).suffix();
+    return suffix == "Z" || suffixes.contains(suffix.toLower());
+}
+
+bool CompressedFile::isSupported(Format format)
+{
+    switch (format) {
+    case Gzip:
+#ifdef TOTALSEARCH_HAVE_ZLIB
+        return true;
+#else
+        return false;
+#endif
+    case Zstd:
+#ifdef TOTALSEARCH_HAVE_ZSTD
+        return true;
+#else
+        return false;
+#endif
+    default:
+        return false;
+    }
+}
+
+bool CompressedFile::isCurrent() const
+{
+    CachedFileSearcher::Fingerprint current = CachedFileSearcher::fingerprint(m_filePath);
+    return current.isValid() && current.size == m_fileSize && current.modified == m_fileModified;
+}
+
+// ===== FULL PASSES =====
+
+bool CompressedFile::decompress(const QString &filePath, const Sink &sink, QString *error)
+{
+    Format format = formatOf(filePath);
+    if (!isSupported(format)) {
+        *error = "No in-process decompression for " + filePath;
+        return false;
+    }
+
+    // Files without an index yet get it from this pass
+    CompressedFile index(filePath, format);
+    bool indexed = index.load();
+    IndexBuilder builder;
+    builder.span = checkpointBytes();
+
+    bool stopped = false;
+    if (!run(filePath, format, Checkpoint(), sink, indexed ? nullptr : &builder, &stopped, error)) {
+        return false;
+    }
+    if (!indexed && !stopped) {
+        index.adopt(builder);
+        index.save();
+    }
+    return true;
+}
+
+QSharedPointer<CompressedFile> CompressedFile::open(const QString &filePath, QString *error,
+                                                   const std::atomic<bool> *cancel)
+{
+    Format format = formatOf(filePath);
+    if (!isSupported(format)) {
+        *error = "No in-process decompression for " + filePath;
+        return QSharedPointer<CompressedFile>();
+    }
+
+    QSharedPointer<CompressedFile> file(new CompressedFile(filePath, format));
+    if (file->m_fileSize < 0) {
+        *error = "Cannot read " + filePath;
+        return QSharedPointer<CompressedFile>();
+    }
+    if (file->load()) {
+        return file;
+    }
+
+    LOG_INFO("CompressedFile: Building the checkpoint index of " + filePath);
+    QElapsedTimer timer;
+    timer.start();
+
+    IndexBuilder builder;
+    builder.span = checkpointBytes();
+    bool stopped = false;
+    Sink sink = [cancel](const char *, qint64) {
+        return !cancel || !cancel->load();
+    };
+    if (!run(filePath, format, Checkpoint(), sink, &builder, &stopped, error)) {
+        return QSharedPointer<CompressedFile>();
+    }
+    if (stopped) {
+        *error = "Indexing cancelled";
+        return QSharedPointer<CompressedFile>();
+    }
+
+    file->adopt(builder);
+    file->save();
+    LOG_INFO("CompressedFile: Indexed " + filePath + " - " + QString::number(file->m_size / (1024 * 1024)) + " MB, " +
+             QString::number(file->m_lineCount) + " lines, " + QString::number(file->m_checkpoints.size()) +
+             " checkpoints in " + QString::number(timer.elapsed()) + " ms");
+    return file;
+}
+
+void CompressedFile::adopt(const IndexBuilder &builder)
+{
+    m_checkpoints = builder.checkpoints;
+    m_size = builder.size;
+    m_lineCount = builder.newlines + ((builder.size > 0 && builder.lastByte != '\n') ? 1 : 0);
+}
+
+// ===== WINDOWS =====
+
+QByteArray CompressedFile::readLines(qint64 firstLine, qint64 lines, QString *error) const
+{
+    firstLine = qMax<qint64>(1, firstLine);
+
+    // Line firstLine starts after newline firstLine - 1, so a checkpoint with fewer newlines
+    // before it lies in front of that line
+    Checkpoint from;
+    for (const Checkpoint &checkpoint : m_checkpoints) {
+        if (checkpoint.newlines >= firstLine - 1) {
+            break;
+        }
+        from = checkpoint;
+    }
+
+    qint64 skipLines = firstLine - 1 - from.newlines;
+    qint64 linesLeft = lines;
+    QByteArray text;
+
+    Sink sink = [&](const char *data, qint64 size) {
+        const char *p = data;
+        const char *end = data + size;
+        while (skipLines > 0 && p < end) {
+            const char *newline = static_cast<const char*>(memchr(p, '\n', size_t(end - p)));
+            if (!newline) {
+                return true;
+            }
+            p = newline + 1;
+            skipLines--;
+        }
+        while (linesLeft > 0 && p < end) {
+            const char *newline = static_cast<const char*>(memchr(p, '\n', size_t(end - p)));
+            if (!newline) {
+                text.append(p, end - p);
+                return true;
+            }
+            text.append(p, newline + 1 - p);
+            linesLeft--;
+            p = newline + 1;
+        }
+        return linesLeft > 0;
+    };
+
+    bool stopped = false;
+    if (!run(m_filePath, m_format, from, sink, nullptr, &stopped, error)) {
+        return QByteArray();
+    }
+    return text;
+}
+
+// ===== DECOMPRESSION =====
+
+bool CompressedFile::run(const QString &filePath, Format format, const Checkpoint &from, const Sink &sink,
+                         IndexBuilder *builder, bool *stopped, QString *error)
+{
+    *stopped = false;
+    if (format == Gzip) {
+        return inflateFrom(filePath, from, sink, builder, stopped, error);
+    }
+    if (format == Zstd) {
+        return zstdFrom(filePath, from, sink, builder, stopped, error);
+    }
+    *error = "Not a compressed file: " + filePath;
+    return false;
+}
+
+bool CompressedFile::inflateFrom(const QString &filePath, const Checkpoint &from, const Sink &sink,
+                                 IndexBuilder *builder, bool *stopped, QString *error)
+{
+#ifdef TOTALSEARCH_HAVE_ZLIB
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = "Cannot open " + filePath + ": " + file.errorString();
+        return false;
+    }
+
+    // From the start the gzip header is read (47 also takes zlib streams), from a checkpoint
+    // the raw deflate data after it
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    bool raw = from.in > 0;
+    if (inflateInit2(&strm, raw ? -15 : 47) != Z_OK) {
+        *error = "Cannot initialize inflate for " + filePath;
+        return false;
+    }
+    struct InflateGuard {
+        z_stream *strm;
+        ~InflateGuard() { inflateEnd(strm); }
+    } guard{&strm};
+
+    qint64 totalIn = from.in;
+    if (raw) {
+        if (!file.seek(from.in - (from.bits ? 1 : 0))) {
+            *error = "Cannot seek in " + filePath;
+            return false;
+        }
+        if (from.bits) {
+            char c = 0;
+            if (!file.getChar(&c)) {
+                *error = "Cannot read " + filePath;
+                return false;
+            }
+            inflatePrime(&strm, from.bits, uchar(c) >> (8 - from.bits));
+        }
+        QByteArray window = qUncompress(from.window);
+        inflateSetDictionary(&strm, reinterpret_cast<const Bytef*>(window.constData()), uInt(window.size()));
+    }
+
+    // The output buffer is the 32K window as well - a checkpoint copies it in order
+    QByteArray input(InputBytes, Qt::Uninitialized);
+    QByteArray output(WindowBytes, Qt::Uninitialized);
+    Bytef *outputData = reinterpret_cast<Bytef*>(output.data());
+    strm.next_out = outputData;
+    strm.avail_out = WindowBytes;
+
+    int ret = Z_OK;
+    bool outputFull = false;
+    bool memberStart = false;   // A member ended and more bytes follow - maybe only padding
+    forever {
+        // A full output buffer may hold back output that needs no more input
+        if (strm.avail_in == 0 && !outputFull) {
+            qint64 read = file.read(input.data(), InputBytes);
+            if (read < 0) {
+                *error = "Cannot read " + filePath + ": " + file.errorString();
+                return false;
+            }
+            if (read == 0) {
+                break;
+            }
+            strm.next_in = reinterpret_cast<Bytef*>(input.data());
+            strm.avail_in = uInt(read);
+        }
+        if (strm.avail_out == 0) {
+            strm.next_out = outputData;
+            strm.avail_out = WindowBytes;
+        }
+
+        Bytef *produced = strm.next_out;
+        uInt availIn = strm.avail_in;
+        ret = inflate(&strm, Z_BLOCK);
+        totalIn += availIn - strm.avail_in;
+        qint64 count = strm.next_out - produced;
+        outputFull = (strm.avail_out == 0);
+
+        if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR || ret == Z_STREAM_ERROR) {
+            if (memberStart && ret == Z_DATA_ERROR) {
+                break;      // Not another gzip member, e.g. zeros after the last one
+            }
+            *error = QString("Corrupt gzip data in %1 at byte %2: %3")
+                         .arg(filePath).arg(totalIn).arg(strm.msg ? strm.msg : "inflate failed");
+            return false;
+        }
+
+        if (count > 0) {
+            memberStart = false;
+            const char *data = reinterpret_cast<const char*>(produced);
+            if (builder) {
+                builder->newlines += SplitFileSearch::countNewlines(data, count);
+                builder->size += count;
+                builder->lastByte = data[count - 1];
+            }
+            if (!sink(data, count)) {
+                *stopped = true;
+                return true;
+            }
+        }
+
+        // Block boundaries other than after the last block can be restarted from
+        if (builder && (strm.data_type & 128) && !(strm.data_type & 64)) {
+            qint64 lastOut = builder->checkpoints.isEmpty() ? 0 : builder->checkpoints.last().out;
+            if (builder->size - lastOut >= builder->span) {
+                int used = WindowBytes - int(strm.avail_out);
+                QByteArray window = (builder->size >= WindowBytes) ? output.mid(used) + output.left(used)
+                                                                   : output.left(used);
+                Checkpoint checkpoint;
+                checkpoint.in = totalIn;
+                checkpoint.bits = strm.data_type & 7;
+                checkpoint.out = builder->size;
+                checkpoint.newlines = builder->newlines;
+                checkpoint.window = qCompress(window);
+                builder->checkpoints.append(checkpoint);
+            }
+        }
+
+        if (ret == Z_STREAM_END) {
+            if (raw) {
+                // Raw deflate leaves the member's 8 byte trailer
+                uInt trailer = 8;
+                while (trailer > 0) {
+                    if (strm.avail_in == 0) {
+                        qint64 read = file.read(input.data(), InputBytes);
+                        if (read <= 0) {
+                            break;
+                        }
+                        strm.next_in = reinterpret_cast<Bytef*>(input.data());
+                        strm.avail_in = uInt(read);
+                    }
+                    uInt skip = qMin(trailer, strm.avail_in);
+                    strm.next_in += skip;
+                    strm.avail_in -= skip;
+                    totalIn += skip;
+                    trailer -= skip;
+                }
+            }
+            if (strm.avail_in == 0 && file.atEnd()) {
+                break;
+            }
+
+            // Concatenated members (e.g. rotations appended to one archive) - read the next header
+            inflateReset2(&strm, 31);
+            raw = false;
+            memberStart = true;
+        }
+    }
+
+    if (ret != Z_STREAM_END && !memberStart) {
+        LOG_WARNING("CompressedFile: " + filePath + " ends inside its gzip stream (still being written?)");
+    }
+    return true;
+#else
+    Q_UNUSED(from);
+    Q_UNUSED(sink);
+    Q_UNUSED(builder);
+    Q_UNUSED(stopped);
+    *error = "gzip support was not compiled in, cannot read " + filePath;
+    return false;
+#endif
+}
+
+bool CompressedFile::zstdFrom(const QString &filePath, const Checkpoint &from, const Sink &sink,
+                              IndexBuilder *builder, bool *stopped, QString *error)
+{
+#ifdef TOTALSEARCH_HAVE_ZSTD
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = "Cannot open " + filePath + ": " + file.errorString();
+        return false;
+    }
+    if (from.in > 0 && !file.seek(from.in)) {
+        *error = "Cannot seek in " + filePath;
+        return false;
+    }
+
+    ZSTD_DCtx *context = ZSTD_createDCtx();
+    if (!context) {
+        *error = "Cannot create a zstd context for " + filePath;
+        return false;
+    }
+    struct ContextGuard {
+        ZSTD_DCtx *context;
+        ~ContextGuard() { ZSTD_freeDCtx(context); }
+    } guard{context};
+
+    QByteArray input(qint64(ZSTD_DStreamInSize()), Qt::Uninitialized);
+    QByteArray output(qint64(ZSTD_DStreamOutSize()), Qt::Uninitialized);
+    ZSTD_inBuffer in = { input.constData(), 0, 0 };
+
+    qint64 totalIn = from.in;
+    size_t ret = 0;             // 0 between frames
+    bool outputFull = false;
+    forever {
+        if (in.pos == in.size && !outputFull) {
+            qint64 read = file.read(input.data(), input.size());
+            if (read < 0) {
+                *error = "Cannot read " + filePath + ": " + file.errorString();
+                return false;
+            }
+            if (read == 0) {
+                break;
+            }
+            in.src = input.constData();
+            in.size = size_t(read);
+            in.pos = 0;
+        }
+
+        ZSTD_outBuffer out = { output.data(), size_t(output.size()), 0 };
+        size_t inBefore = in.pos;
+        ret = ZSTD_decompressStream(context, &out, &in);
+        if (ZSTD_isError(ret)) {
+            *error = QString("Corrupt zstd data in %1 at byte %2: %3")
+                         .arg(filePath).arg(totalIn).arg(ZSTD_getErrorName(ret));
+            return false;
+        }
+        totalIn += qint64(in.pos - inBefore);
+        outputFull = (out.pos == out.size);
+
+        if (out.pos > 0) {
+            const char *data = output.constData();
+            qint64 count = qint64(out.pos);
+            if (builder) {
+                builder->newlines += SplitFileSearch::countNewlines(data, count);
+                builder->size += count;
+                builder->lastByte = data[count - 1];
+            }
+            if (!sink(data, count)) {
+                *stopped = true;
+                return true;
+            }
+        }
+
+        // A frame ended: the next one decompresses on its own
+        if (ret == 0 && builder) {
+            qint64 lastOut = builder->checkpoints.isEmpty() ? 0 : builder->checkpoints.last().out;
+            if (builder->size - lastOut >= builder->span) {
+                Checkpoint checkpoint;
+                checkpoint.in = totalIn;
+                checkpoint.out = builder->size;
+                checkpoint.newlines = builder->newlines;
+                builder->checkpoints.append(checkpoint);
+            }
+        }
+    }
+
+    if (ret != 0) {
+        LOG_WARNING("CompressedFile: " + filePath + " ends inside a zstd frame (still being written?)");
+    }
+    return true;
+#else
+    Q_UNUSED(from);
+    Q_UNUSED(sink);
+    Q_UNUSED(builder);
+    Q_UNUSED(stopped);
+    *error = "zstd support was not compiled in, cannot read " + filePath;
+    return false;
+#endif
+}
+
+// ===== STORAGE =====
+
+QString CompressedFile::indexPath(const QString &filePath)
+{
+    QString key = QString::fromLatin1(QCryptographicHash::hash(normalizedPath(filePath).toUtf8(),
+                                                               QCryptographicHash::Sha1).toHex().left(16));
+    return QCoreApplication::applicationDirPath() + "/data/zindex/" + key + ".tzi";
+}
+
+qint64 CompressedFile::checkpointBytes()
+{
+    QSettings settings("app.ini", QSettings::IniFormat);
+    settings.beginGroup("RGSearch");
+    qint64 bytes = qMax(1LL, settings.value("CompressedCheckpointMB", 8).toLongLong()) * 1024 * 1024;
+    settings.endGroup();
+    return bytes;
+}
+
+bool CompressedFile::load()
+{
+    QFile file(indexPath(m_filePath));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    qint32 version = 0;
+    QString path;
+    qint32 format = 0;
+    qint64 fileSize = 0;
+    qint64 fileModified = 0;
+    in >> magic >> version >> path >> format >> fileSize >> fileModified;
+    if (magic != IndexMagic || version != IndexVersion || path != normalizedPath(m_filePath) || format != m_format) {
+        return false;
+    }
+    if (fileSize != m_fileSize || fileModified != m_fileModified) {
+        LOG_INFO("CompressedFile: " + m_filePath + " changed since it was indexed");
+        return false;
+    }
+
+    quint32 count = 0;
+    in >> m_size >> m_lineCount >> count;
+    m_checkpoints.resize(count);
+    for (Checkpoint &checkpoint : m_checkpoints) {
+        qint32 bits = 0;
+        in >> checkpoint.in >> bits >> checkpoint.out >> checkpoint.newlines >> checkpoint.window;
+        checkpoint.bits = bits;
+        if (in.status() != QDataStream::Ok) {
+            break;
+        }
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        LOG_WARNING("CompressedFile: Truncated index " + file.fileName());
+        m_checkpoints.clear();
+        return false;
+    }
+    return true;
+}
+
+bool CompressedFile::save() const
+{
+    QDir().mkpath(QCoreApplication::applicationDirPath() + "/data/zindex");
+
+    QSaveFile file(indexPath(m_filePath));
+    if (!file.open(QIODevice::WriteOnly)) {
+        LOG_WARNING("CompressedFile: Cannot write " + file.fileName());
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << IndexMagic << IndexVersion << normalizedPath(m_filePath) << qint32(m_format) << m_fileSize << m_fileModified;
+    out << m_size << m_lineCount << quint32(m_checkpoints.size());
+    for (const Checkpoint &checkpoint : m_checkpoints) {
+        out << checkpoint.in << qint32(checkpoint.bits) << checkpoint.out << checkpoint.newlines << checkpoint.window;
+    }
+
+    return file.commit();
+}
@@ -0,0 +1,109 @@
+#ifndef COMPRESSEDFILE_H
+#define COMPRESSEDFILE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QSharedPointer>
+#include <atomic>
+#include <functional>
+
+// Transparent reading of gzip (.gz) and zstd (.zst) compressed logs. The in-process search
+// engines stream a file's decompressed bytes once with decompress(); the viewer reads a window
+// of lines through a checkpoint index, so a line deep inside a large file only costs
+// decompressing from the checkpoint before it:
+// - gzip: zran-style - at a deflate block boundary every CompressedCheckpointMB of output, the
+//   compressed bit position and the last 32K of output (the window inflate needs to restart)
+// - zstd: frame starts - a file written as one frame (the zstd CLI default) restarts only at 0
+// Each checkpoint also keeps the number of newlines before it. The index is built by the first
+// full pass over a file (a search or opening it) and saved under data/zindex.
+class CompressedFile
+{
+public:
+    enum Format { None, Gzip, Zstd };
+
+    // By file name, like rg --search-zip
+    static Format formatOf(const QString &filePath);
+
+    // Any extension rg --search-zip decompresses: offsets reported for these files are offsets
+    // into the decompressed stream, not into the file
+    static bool isCompressedPath(const QString &filePath);
+
+    // The format's library was compiled in (TOTALSEARCH_HAVE_ZLIB / TOTALSEARCH_HAVE_ZSTD)
+    static bool isSupported(Format format);
+
+    // filePath is compressed in a format read in-process
+    static bool canRead(const QString &filePath) { return isSupported(formatOf(filePath)); }
+
+    // Receives the decompressed stream in order and in pieces - returning false stops the pass
+    using Sink = std::function<bool(const char *data, qint64 size)>;
+
+    // One pass over the whole file, writing its checkpoint index if it has none yet. False with
+    // error set on a read or format error, not when sink stopped the pass.
+    static bool decompress(const QString &filePath, const Sink &sink, QString *error);
+
+    // Checkpoint index of filePath, loaded or built by a full pass (nullptr with error set on
+    // failure or once cancel is set)
+    static QSharedPointer<CompressedFile> open(const QString &filePath, QString *error,
+                                               const std::atomic<bool> *cancel = nullptr);
+
+    QString filePath() const { return m_filePath; }
+    Format format() const { return m_format; }
+    qint64 size() const { return m_size; }              // Decompressed bytes
+    qint64 lineCount() const { return m_lineCount; }
+
+    // False once the file changed since the index was built
+    bool isCurrent() const;
+
+    // Lines [firstLine, firstLine + lines) with their terminators (1-based), decompressed from
+    // the last checkpoint before firstLine
+    QByteArray readLines(qint64 firstLine, qint64 lines, QString *error) const;
+
+private:
+    struct Checkpoint {
+        qint64 in = 0;              // Compressed offset (gzip: of the byte holding the first bit)
+        int bits = 0;               // gzip: bits of the byte before in still to be read
+        qint64 out = 0;             // Decompressed offset
+        qint64 newlines = 0;        // Newlines before out
+        QByteArray window;          // gzip: last 32K of output before out, qCompress'ed
+    };
+
+    // Checkpoints collected by a pass from the start of the file
+    struct IndexBuilder {
+        qint64 span = 0;
+        QVector<Checkpoint> checkpoints;
+        qint64 newlines = 0;
+        qint64 size = 0;
+        char lastByte = '\n';
+    };
+
+    CompressedFile(const QString &filePath, Format format);
+
+    // Take the checkpoints and totals of a complete pass
+    void adopt(const IndexBuilder &builder);
+
+    // Decompress from a checkpoint (a default one is the start of the file) into sink, collecting
+    // checkpoints into builder. stopped is set when sink ended the pass.
+    static bool run(const QString &filePath, Format format, const Checkpoint &from, const Sink &sink,
+                    IndexBuilder *builder, bool *stopped, QString *error);
+    static bool inflateFrom(const QString &filePath, const Checkpoint &from, const Sink &sink,
+                            IndexBuilder *builder, bool *stopped, QString *error);
+    static bool zstdFrom(const QString &filePath, const Checkpoint &from, const Sink &sink,
+                         IndexBuilder *builder, bool *stopped, QString *error);
+
+    // ===== STORAGE =====
+    static QString indexPath(const QString &filePath);
+    static qint64 checkpointBytes();
+    bool load();
+    bool save() const;
+
+    QString m_filePath;
+    Format m_format;
+    qint64 m_fileSize;              // Compressed file when indexed
+    qint64 m_fileModified;
+    qint64 m_size;
+    qint64 m_lineCount;
+    QVector<Checkpoint> m_checkpoints;  // Ascending, not including the start of the file
+};
+
+#endif // COMPRESSEDFILE_H
@@ -0,0 +1,188 @@
+#include "DocumentLoader.h"
+#include "scintillaedit.h"
+#include "ILoader.h"
+#include "logger.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <cstring>
+
+// One load: set up on the UI thread, filled in by its worker, read back on the UI thread once
+// the worker has finished
+struct DocumentLoader::Job {
+    quint64 id = 0;
+    QString filePath;
+    SearchCancelToken token;
+    Scintilla::ILoader *loader = nullptr;
+    QThread *thread = nullptr;
+    QElapsedTimer timer;
+
+    // Results
+    void *document = nullptr;
+    qint64 bytes = 0;
+    QString error;
+};
+
+DocumentLoader::DocumentLoader(ScintillaEdit *view, QObject *parent)
+    : QObject(parent)
+    , m_view(view)
+    , m_nextId(0)
+    , m_currentId(0)
+{
+}
+
+DocumentLoader::~DocumentLoader()
+{
+    for (const QSharedPointer<Job> &job : m_jobs) {
+        job->token.cancel();
+    }
+    for (const QSharedPointer<Job> &job : m_jobs) {
+        job->thread->wait();
+        delete job->thread;
+        if (job->document && m_view) {
+            m_view->send(SCI_RELEASEDOCUMENT, 0, reinterpret_cast<sptr_t>(job->document));
+        }
+    }
+}
+
+quint64 DocumentLoader::load(const QString &filePath)
+{
+    cancel();
+
+    QSharedPointer<Job> job(new Job);
+    job->id = ++m_nextId;
+    job->filePath = filePath;
+    job->token = SearchCancelToken::create(job->id);
+    job->timer.start();
+
+    // The loader is created by the view on this thread and only used by the worker after that.
+    // A document without styles holds one byte per character; text past 2 GB needs the large
+    // document layout.
+    qint64 sizeHint = qMax<qint64>(0, QFileInfo(filePath).size());
+    int options = SC_DOCUMENTOPTION_STYLES_NONE;
+    if (sizeHint >= 0x7fffffffLL) {
+        options |= SC_DOCUMENTOPTION_TEXT_LARGE;
+    }
+    job->loader = reinterpret_cast<Scintilla::ILoader*>(m_view->send(SCI_CREATELOADER, uptr_t(sizeHint), options));
+    if (!job->loader) {
+        LOG_ERROR("DocumentLoader: Scintilla could not create a loader for " + filePath);
+        emit failed(job->id, filePath, "out of memory");
+        return job->id;
+    }
+
+    Job *raw = job.data();
+    job->thread = QThread::create([raw]() { runJob(raw); });
+    connect(job->thread, &QThread::finished, this, [this, job]() { finishJob(job); });
+    m_jobs.append(job);
+    m_currentId = job->id;
+    m_filePath = filePath;
+    m_token = job->token;
+    job->thread->start();
+
+    LOG_INFO("DocumentLoader: Load " + QString::number(job->id) + " started - " + filePath + " (" +
+             QString::number(sizeHint / (1024 * 1024)) + " MB)");
+    return job->id;
+}
+
+void DocumentLoader::cancel()
+{
+    if (!isLoading()) {
+        return;
+    }
+    LOG_INFO("DocumentLoader: Load " + QString::number(m_currentId) + " cancelled - " + m_filePath);
+    m_token.cancel();
+    m_token = SearchCancelToken();
+    m_filePath.clear();
+    m_currentId = 0;
+}
+
+void DocumentLoader::runJob(Job *job)
+{
+    LOG_INFO("===THREAD=== DocumentLoader <<<<<STARTed<<<<< " + job->filePath);
+
+    QFile file(job->filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        job->error = "cannot open the file: " + file.errorString();
+    } else {
+        qint64 size = file.size();
+        const char *data = size > 0 ? reinterpret_cast<const char*>(file.map(0, size)) : nullptr;
+        if (!data && size > 0) {
+            LOG_WARNING("DocumentLoader: Memory mapping failed, reading " + job->filePath);
+        }
+
+        // Blocks without NUL go to the loader straight from the mapping; the others are copied
+        // once to replace them
+        QByteArray block;
+        qint64 offset = 0;
+        while (offset < size && job->error.isEmpty() && !job->token.isCancelled()) {
+            qint64 length = qMin(LoadBlockBytes, size - offset);
+            const char *bytes = data ? data + offset : nullptr;
+            if (!data) {
+                block = file.read(length);
+                if (block.isEmpty()) {
+                    job->error = "cannot read the file: " + file.errorString();
+                    break;
+                }
+                length = block.size();
+                block.replace('\0', ' ');
+                bytes = block.constData();
+            } else if (memchr(bytes, '\0', size_t(length))) {
+                block = QByteArray(bytes, length);
+                block.replace('\0', ' ');
+                bytes = block.constData();
+            }
+
+            if (job->loader->AddData(bytes, Sci_Position(length)) != SC_STATUS_OK) {
+                job->error = "out of memory";
+            }
+            offset += length;
+        }
+        job->bytes = offset;
+
+        if (data) {
+            file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(data)));
+        }
+        file.close();
+    }
+
+    if (job->error.isEmpty() && !job->token.isCancelled()) {
+        job->document = job->loader->ConvertToDocument();
+    } else {
+        job->loader->Release();
+    }
+    job->loader = nullptr;
+
+    LOG_INFO("===THREAD=== DocumentLoader >>>>>ENDed>>>>> " + QString::number(job->bytes / (1024 * 1024)) + " MB in " +
+             QString::number(job->timer.elapsed()) + " ms" +
+             (job->token.isCancelled() ? " (cancelled)" : job->error.isEmpty() ? "" : " (" + job->error + ")"));
+}
+
+void DocumentLoader::finishJob(const QSharedPointer<Job> &job)
+{
+    m_jobs.removeOne(job);
+    job->thread->deleteLater();
+
+    if (job->id != m_currentId || job->token.isCancelled()) {
+        // Superseded: the view moved on
+        if (job->document && m_view) {
+            m_view->send(SCI_RELEASEDOCUMENT, 0, reinterpret_cast<sptr_t>(job->document));
+        }
+        return;
+    }
+    m_currentId = 0;
+    m_filePath.clear();
+    m_token = SearchCancelToken();
+
+    if (!job->document || !m_view) {
+        LOG_ERROR("DocumentLoader: Load " + QString::number(job->id) + " failed - " + job->error);
+        emit failed(job->id, job->filePath, job->error);
+        return;
+    }
+
+    m_view->attachDocument(job->document);
+    qint64 elapsed = job->timer.elapsed();
+    LOG_INFO("DocumentLoader: Load " + QString::number(job->id) + " shown - " + QString::number(job->bytes) +
+             " bytes in " + QString::number(elapsed) + " ms");
+    emit loaded(job->id, job->filePath, job->bytes, elapsed);
+}
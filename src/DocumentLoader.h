@@ -0,0 +1,57 @@
+#ifndef DOCUMENTLOADER_H
+#define DOCUMENTLOADER_H
+
+#include <QObject>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QList>
+#include <QString>
+#include "SearchCancelToken.h"
+
+class QThread;
+class ScintillaEdit;
+
+// Files read into a Scintilla document off the UI thread, through Scintilla's ILoader
+// (SCI_CREATELOADER). A worker thread maps the file and adds it block by block - NULs replaced
+// by spaces - so the UI thread only creates the loader and, once the document is complete,
+// swaps it into the view in one step (ScintillaEdit::attachDocument). The view keeps showing
+// what it showed until then. One load counts at a time: starting another cancels the one in
+// flight, whose worker stops at the next block and drops its document.
+class DocumentLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DocumentLoader(ScintillaEdit *view, QObject *parent = nullptr);
+    ~DocumentLoader();
+
+    // Start loading filePath into the view; the id is the one loaded / failed report
+    quint64 load(const QString &filePath);
+    void cancel();
+
+    // A load is in flight, and the file it is for
+    bool isLoading() const { return !m_filePath.isEmpty(); }
+    QString filePath() const { return m_filePath; }
+
+signals:
+    // The document is shown in the view
+    void loaded(quint64 loadId, const QString &filePath, qint64 bytes, qint64 elapsedMs);
+    void failed(quint64 loadId, const QString &filePath, const QString &error);
+
+private:
+    struct Job;
+
+    static void runJob(Job *job);               // Worker thread
+    void finishJob(const QSharedPointer<Job> &job);
+
+    QPointer<ScintillaEdit> m_view;
+    QList<QSharedPointer<Job>> m_jobs;          // Running, the cancelled ones included
+    quint64 m_nextId;
+    quint64 m_currentId;
+    QString m_filePath;                         // Empty when no load is in flight
+    SearchCancelToken m_token;
+
+    static constexpr qint64 LoadBlockBytes = 4 * 1024 * 1024;
+};
+
+#endif // DOCUMENTLOADER_H
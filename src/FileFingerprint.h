@@ -0,0 +1,21 @@
+#ifndef FILEFINGERPRINT_H
+#define FILEFINGERPRINT_H
+
+#include <QtGlobal>
+
+// Identity of a file's contents on disk - fileId is the inode / NTFS file index. Taken with
+// CachedFileSearcher::fingerprint; kept apart so the result store can hold one per file.
+struct FileFingerprint {
+    qint64 size = -1;
+    qint64 modified = 0;        // Last write time, ns (Unix) or 100 ns units (Windows)
+    quint64 fileId = 0;
+
+    bool isValid() const { return size >= 0; }
+    bool operator==(const FileFingerprint &other) const
+    {
+        return size == other.size && modified == other.modified && fileId == other.fileId;
+    }
+    bool operator!=(const FileFingerprint &other) const { return !(*this == other); }
+};
+
+#endif // FILEFINGERPRINT_H
@@ -0,0 +1,525 @@
+#include "HeadlessSearch.h"
+#include "JsonParseWorker.h"
+#include "filesearcher.h"
+#include "BatchFileSearcher.h"
+#include "TimeRangeFileSearcher.h"
+#include "SearchFlowControl.h"
+#include "logger.h"
+#include <QCommandLineParser>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSettings>
+#include <QTimer>
+#include <QDir>
+#include <QFileInfo>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+bool HeadlessSearch::isRequested(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int HeadlessSearch::run(QCoreApplication &app)
+{
+#ifdef Q_OS_WIN
+    // The GUI subsystem executable has no console of its own - write to the one it was started from
+    if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+        freopen("CONOUT$", "w", stdout);
+        freopen("CONOUT$", "w", stderr);
+    }
+#else
+    // A closed pipe (e.g. into head) is a failed write, not the end of the process
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+    QString logDir = QCoreApplication::applicationDirPath() + "/data/logs";
+    QDir().mkpath(logDir);
+    Logger::instance().setConsoleStream(nullptr);
+    Logger::instance().initialize(nullptr, logDir + "/totalsearch-headless.log");
+    LOG_INFO("TotalSearch headless search started");
+
+    HeadlessSearch search;
+    if (!search.parseArguments(app.arguments())) {
+        return search.exitCode();
+    }
+    QTimer::singleShot(0, &search, &HeadlessSearch::start);
+    return app.exec();
+}
+
+HeadlessSearch::HeadlessSearch(QObject *parent)
+    : QObject(parent)
+    , m_format(JsonLines)
+    , m_maxResults(-1)
+    , m_maxCount(-1)
+    , m_countOnly(false)
+    , m_searchBun(nullptr)
+    , m_parseThread(nullptr)
+    , m_parseWorker(nullptr)
+    , m_searchExitCode(0)
+    , m_budgetReached(false)
+    , m_exitCode(ExitError)
+    , m_firstResultMs(-1)
+    , m_searchMs(0)
+    , m_parseMs(0)
+    , m_storeMs(0)
+    , m_outputMs(0)
+{
+}
+
+HeadlessSearch::~HeadlessSearch()
+{
+    if (m_parseThread) {
+        m_token.cancel();
+        m_parseThread->quit();
+        m_parseThread->wait();
+        delete m_parseWorker;
+        delete m_parseThread;
+    }
+}
+
+bool HeadlessSearch::parseArguments(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("TotalSearch headless search: results as JSON Lines or a summary on stdout.\n"
+                                     "Exit codes: 0 matches found, 1 no matches, 2 error.");
+    QCommandLineOption helpOption = parser.addHelpOption();
+    QCommandLineOption versionOption = parser.addVersionOption();
+
+    QCommandLineOption headlessOption("headless", "Search without the user interface.");
+    QCommandLineOption patternOption({"e", "pattern"}, "Pattern to search for (a regex unless --fixed-strings).", "pattern");
+    QCommandLineOption patternsFileOption("patterns-file", "Search for every pattern of a list in one pass, a \"name<TAB>pattern\" or bare pattern per line.", "file");
+    QCommandLineOption andOption("and", "Only files that also contain pattern (repeatable).", "pattern");
+    QCommandLineOption withinOption("within", "With --and: all patterns within n lines, 0 = anywhere in the file.", "n", "0");
+    QCommandLineOption orderedOption("ordered", "With --and: the patterns in the order given.");
+    QCommandLineOption fromOption("from", "Only lines timestamped at or after time, e.g. 14:02 or \"2026-10-17 14:02\".", "time");
+    QCommandLineOption toOption("to", "Only lines timestamped up to time (14:10 = up to 14:10:59).", "time");
+    QCommandLineOption pathOption({"p", "path"}, "Directory or file to search.", "path");
+    QCommandLineOption fixedOption({"F", "fixed-strings"}, "Treat the pattern as literal text.");
+    QCommandLineOption ignoreCaseOption({"i", "ignore-case"}, "Case insensitive search.");
+    QCommandLineOption smartCaseOption({"S", "smart-case"}, "Case insensitive unless the pattern has upper case letters.");
+    QCommandLineOption globOption({"g", "glob"}, "Include files matching glob, exclude them with a leading '!' (repeatable).", "glob");
+    QCommandLineOption engineOption("engine", "Search backend: ripgrep, builtin or hyperscan (default: App.ini searchEngine).", "engine");
+    QCommandLineOption maxResultsOption("max-results", "Stop after n matches, 0 = no limit (default: [RGSearch] MaxTotalMatches).", "n");
+    QCommandLineOption maxCountOption({"m", "max-count"}, "Matches reported per file, 0 = all (default: [RGSearch] MaxMatchesPerFile).", "n");
+    QCommandLineOption countOption({"c", "count"}, "Only count the matches of each file.");
+    QCommandLineOption formatOption("format", "Output: jsonl (a record per match, then a summary record) or summary.", "format", "jsonl");
+    QCommandLineOption verboseOption("verbose", "Also write the log to stderr.");
+    parser.addOptions({headlessOption, patternOption, patternsFileOption, andOption, withinOption, orderedOption, fromOption, toOption, pathOption, fixedOption, ignoreCaseOption, smartCaseOption,
+                       globOption, engineOption, maxResultsOption, maxCountOption, countOption, formatOption,
+                       verboseOption});
+
+    // QCommandLineParser::process would exit() - errors and help go out here instead
+    if (!parser.parse(arguments)) {
+        std::cerr << parser.errorText().toStdString() << std::endl;
+        m_exitCode = ExitError;
+        return false;
+    }
+    if (parser.isSet(helpOption)) {
+        std::cout << parser.helpText().toStdString();
+        m_exitCode = ExitMatches;
+        return false;
+    }
+    if (parser.isSet(versionOption)) {
+        std::cout << (QCoreApplication::applicationName() + " " + QCoreApplication::applicationVersion()).toStdString() << std::endl;
+        m_exitCode = ExitMatches;
+        return false;
+    }
+    if (parser.isSet(verboseOption)) {
+        Logger::instance().setConsoleStream(&std::cerr);
+    }
+
+    // A pattern and path may also be given as positional arguments, like rg PATTERN PATH
+    QStringList positional = parser.positionalArguments();
+    bool patternGiven = parser.isSet(patternOption) || parser.isSet(patternsFileOption);
+    m_params.pattern = parser.isSet(patternOption) ? parser.value(patternOption)
+                                                   : (patternGiven ? QString() : positional.value(0));
+    m_params.path = parser.isSet(pathOption) ? parser.value(pathOption)
+                                             : positional.value(patternGiven ? 0 : 1);
+    if (parser.isSet(patternsFileOption)) {
+        QString error;
+        if (!BatchFileSearcher::loadPatternList(parser.value(patternsFileOption), &m_batchPatterns, &error)) {
+            std::cerr << ("TotalSearch --headless: " + error).toStdString() << std::endl;
+            m_exitCode = ExitError;
+            return false;
+        }
+        m_params.pattern = BatchFileSearcher::combinedPattern(m_batchPatterns, parser.isSet(fixedOption));
+    }
+    if (parser.isSet(andOption)) {
+        bool withinOk = false;
+        m_proximity.withinLines = parser.value(withinOption).toInt(&withinOk);
+        m_proximity.ordered = parser.isSet(orderedOption);
+        if (!m_batchPatterns.isEmpty() || !withinOk || m_proximity.withinLines < 0) {
+            std::cerr << "TotalSearch --headless: --and takes --within lines and cannot be combined with --patterns-file" << std::endl;
+            m_exitCode = ExitError;
+            return false;
+        }
+        if (!m_params.pattern.isEmpty()) {
+            m_proximity.terms.append({m_params.pattern, m_params.pattern});
+        }
+        for (const QString &term : parser.values(andOption)) {
+            m_proximity.terms.append({term, term});
+        }
+    }
+    if (m_params.pattern.isEmpty() || m_params.path.isEmpty()) {
+        std::cerr << "TotalSearch --headless: a --pattern (or --patterns-file) and a --path are required (see --help)" << std::endl;
+        m_exitCode = ExitError;
+        return false;
+    }
+    if (!QFileInfo::exists(m_params.path)) {
+        std::cerr << ("TotalSearch --headless: no such file or directory: " + m_params.path).toStdString() << std::endl;
+        m_exitCode = ExitError;
+        return false;
+    }
+
+    m_params.fixed_string = parser.isSet(fixedOption);
+    m_params.ignore_case = parser.isSet(ignoreCaseOption);
+    m_params.smart_case = parser.isSet(smartCaseOption);
+    m_params.case_sensitive = !m_params.ignore_case && !m_params.smart_case;
+    m_params.incl_exclude = parser.values(globOption).join(',');
+    m_params.time_from = parser.value(fromOption).trimmed();
+    m_params.time_to = parser.value(toOption).trimmed();
+    TimeRangeFileSearcher::Stamp bound;
+    if ((!m_params.time_from.isEmpty() && !TimeRangeFileSearcher::parseBound(m_params.time_from, false, &bound)) ||
+        (!m_params.time_to.isEmpty() && !TimeRangeFileSearcher::parseBound(m_params.time_to, true, &bound))) {
+        std::cerr << "TotalSearch --headless: --from and --to take a time such as 14:02 or \"2026-10-17 14:02:30\"" << std::endl;
+        m_exitCode = ExitError;
+        return false;
+    }
+    // Batch and proximity lines are attributed and time windows filter lines, never only counted
+    m_countOnly = parser.isSet(countOption) && m_batchPatterns.isEmpty() && m_proximity.terms.isEmpty() &&
+                  !TimeRangeFileSearcher::isActive(m_params);
+
+    bool ok = true;
+    if (parser.isSet(maxResultsOption)) {
+        m_maxResults = parser.value(maxResultsOption).toInt(&ok);
+        ok = ok && m_maxResults >= 0;
+    }
+    if (ok && parser.isSet(maxCountOption)) {
+        m_maxCount = parser.value(maxCountOption).toInt(&ok);
+        ok = ok && m_maxCount >= 0;
+    }
+    if (!ok) {
+        std::cerr << "TotalSearch --headless: --max-results and --max-count take a number of matches" << std::endl;
+        m_exitCode = ExitError;
+        return false;
+    }
+
+    QString format = parser.value(formatOption);
+    if (format == "jsonl") {
+        m_format = JsonLines;
+    } else if (format == "summary") {
+        m_format = Summary;
+    } else {
+        std::cerr << ("TotalSearch --headless: unknown --format: " + format).toStdString() << std::endl;
+        m_exitCode = ExitError;
+        return false;
+    }
+
+    if (parser.isSet(engineOption)) {
+        m_engine = parser.value(engineOption);
+    } else {
+        // Same backend as the user interface
+        QSettings settings(QCoreApplication::applicationDirPath() + "/App.ini", QSettings::IniFormat);
+        settings.beginGroup("Configuration");
+        m_engine = settings.value("searchEngine", "ripgrep").toString();
+        settings.endGroup();
+    }
+    if (!FileSearcher::isEngineAvailable(m_engine)) {
+        std::cerr << ("TotalSearch --headless: search engine '" + m_engine + "' is not available in this build").toStdString() << std::endl;
+        m_exitCode = ExitError;
+        return false;
+    }
+
+    LOG_INFO("HeadlessSearch: pattern '" + m_params.pattern + "' in " + m_params.path + " with " + m_engine +
+             " (max results " + QString::number(m_maxResults) + ", max count " + QString::number(m_maxCount) +
+             ", " + (m_countOnly ? "count only" : "matches") + ", " + format + ")");
+    return true;
+}
+
+void HeadlessSearch::start()
+{
+    LOG_INFO("HeadlessSearch: ===THREAD=== search <<<<<STARTed<<<<<");
+    m_timer.start();
+
+    if (!m_out.open(stdout, QIODevice::WriteOnly)) {
+        std::cerr << "TotalSearch --headless: cannot write to stdout" << std::endl;
+        finish(ExitError);
+        return;
+    }
+
+    try {
+        m_searchBun = new KSearchBun(this);
+        if (m_maxResults >= 0 || m_maxCount >= 0) {
+            m_searchBun->setResultBudgets(m_maxCount >= 0 ? m_maxCount : m_searchBun->maxMatchesPerFile(),
+                                          m_maxResults >= 0 ? m_maxResults : m_searchBun->maxTotalMatches());
+        }
+        m_searchBun->setCountOnlyFirst(m_countOnly);
+        m_searchBun->updateSearchParams(m_params);
+
+        // Parser on its own thread, as behind the results view
+        m_parseThread = new QThread();
+        m_parseWorker = new JsonParseWorker();
+        m_parseWorker->moveToThread(m_parseThread);
+        connect(m_parseWorker, &JsonParseWorker::resultBatchReady,
+                this, &HeadlessSearch::onResultBatch, Qt::QueuedConnection);
+        connect(m_parseWorker, &JsonParseWorker::parsingCompleted,
+                this, &HeadlessSearch::onParsingCompleted, Qt::QueuedConnection);
+        connect(m_parseWorker, &JsonParseWorker::parsingError, this, [this](const QString &error) {
+            LOG_ERROR("HeadlessSearch: Parse error: " + error);
+            m_error = error;
+        }, Qt::QueuedConnection);
+        m_parseThread->start();
+
+        // Search output goes straight to the parser thread, whichever thread it is emitted on
+        connect(m_searchBun, &KSearchBun::searchOutputChunk,
+                m_parseWorker, &JsonParseWorker::parseJsonChunk, Qt::QueuedConnection);
+        connect(m_searchBun, &KSearchBun::searchStreamFinished, this, &HeadlessSearch::onSearchFinished);
+        connect(m_searchBun, &KSearchBun::searchBudgetReached, this, [this](int matches) {
+            LOG_INFO("HeadlessSearch: Result limit of " + QString::number(matches) + " matches reached");
+            m_budgetReached = true;
+        });
+
+        m_token = SearchCancelToken::create(1);
+        QMetaObject::invokeMethod(m_parseWorker, "beginStream", Qt::QueuedConnection,
+                                  Q_ARG(QString, m_params.pattern),
+                                  Q_ARG(QString, m_params.path),
+                                  Q_ARG(SearchCancelToken, m_token));
+        if (!m_batchPatterns.isEmpty()) {
+            m_searchBun->K_FSresults_batch(m_params, m_batchPatterns, m_engine, m_token);
+        } else if (!m_proximity.terms.isEmpty()) {
+            m_searchBun->K_FSresults_proximity(m_params, m_proximity, m_engine, m_token);
+        } else {
+            m_searchBun->K_FSresults_stream(m_params, m_engine, m_token);
+        }
+        m_flowControl = m_searchBun->streamFlowControl();
+
+    } catch (const std::exception &e) {
+        LOG_ERROR("HeadlessSearch: Exception in start: " + QString(e.what()));
+        m_error = e.what();
+        finish(ExitError);
+    } catch (...) {
+        LOG_ERROR("HeadlessSearch: Unknown exception in start");
+        m_error = "Unknown exception";
+        finish(ExitError);
+    }
+}
+
+void HeadlessSearch::onResultBatch(const SearchResultBatchPtr &batch)
+{
+    // Written out below, so the search may go on
+    if (m_flowControl) {
+        m_flowControl->consumed(batch->streamBytes);
+    }
+    if (batch->isEmpty()) {
+        return;
+    }
+
+    if (m_firstResultMs < 0) {
+        m_firstResultMs = m_timer.elapsed();
+    }
+
+    QElapsedTimer stageTimer;
+    stageTimer.start();
+    int firstRow = m_store.matchCount();
+    m_store.appendBatch(*batch);
+    m_storeMs += stageTimer.elapsed();
+
+    if (m_format == JsonLines) {
+        stageTimer.restart();
+        writeMatches(firstRow, *batch);
+        m_outputMs += stageTimer.elapsed();
+    }
+}
+
+void HeadlessSearch::onSearchFinished(int exitCode)
+{
+    m_searchMs = m_timer.elapsed();
+    m_searchExitCode = exitCode;
+    LOG_INFO("HeadlessSearch: Search finished (exit code " + QString::number(exitCode) + ") after " +
+             QString::number(m_searchMs) + " ms");
+
+    // Queued behind the remaining chunks, so parsingCompleted arrives after the last match
+    QMetaObject::invokeMethod(m_parseWorker, "endStream", Qt::QueuedConnection);
+}
+
+void HeadlessSearch::onParsingCompleted(int totalMatches, int totalFiles)
+{
+    m_parseMs = m_timer.elapsed();
+    LOG_INFO("HeadlessSearch: Parsing completed - " + QString::number(totalMatches) + " matches in " +
+             QString::number(totalFiles) + " files after " + QString::number(m_parseMs) + " ms");
+
+    int matches = 0;
+    for (int fileId = 0; fileId < m_store.fileCount(); ++fileId) {
+        matches += m_countOnly ? m_store.fileMatchedLines(fileId) : m_store.fileMatchCount(fileId);
+    }
+
+    // Like rg: an error wins over the matches found before it
+    if (m_searchExitCode == ExitError || !m_error.isEmpty()) {
+        finish(ExitError);
+    } else {
+        finish(matches > 0 ? ExitMatches : ExitNoMatches);
+    }
+}
+
+void HeadlessSearch::finish(int exitCode)
+{
+    m_exitCode = exitCode;
+
+    if (m_out.isOpen()) {
+        QElapsedTimer stageTimer;
+        stageTimer.start();
+        writeSummary();
+        m_out.flush();
+        m_outputMs += stageTimer.elapsed();
+    }
+
+    LOG_INFO("HeadlessSearch: ===THREAD=== search >>>>>ENDed>>>>> exit code " + QString::number(m_exitCode) +
+             " after " + QString::number(m_timer.elapsed()) + " ms");
+    QCoreApplication::exit(m_exitCode);
+}
+
+// ===== OUTPUT =====
+
+void HeadlessSearch::writeMatches(int firstRow, const SearchResultBatch &batch)
+{
+    QByteArray out;
+
+    for (int row = firstRow; row < m_store.matchCount(); ++row) {
+        QJsonObject match;
+        match["type"] = "match";
+        match["path"] = m_store.filePath(m_store.matchFileId(row));
+        match["line"] = m_store.lineNumber(row);
+        match["column"] = m_store.column(row);
+        match["offset"] = m_store.byteOffset(row);
+        match["text"] = m_store.lineText(row);
+        if (!m_batchPatterns.isEmpty()) {
+            QJsonArray patterns;
+            quint64 mask = m_store.patternMask(row);
+            for (int i = 0; i < m_batchPatterns.size(); ++i) {
+                if (mask & (quint64(1) << i)) {
+                    patterns.append(m_batchPatterns[i].name);
+                }
+            }
+            match["patterns"] = patterns;
+        }
+        out += QJsonDocument(match).toJson(QJsonDocument::Compact);
+        out += '\n';
+    }
+
+    // Counted files have no match records - their totals come with the end record
+    if (m_countOnly) {
+        for (int i = 0; i < batch.filePaths.size(); ++i) {
+            if (batch.fileEnded[i] && batch.fileMatchedLines[i] > 0) {
+                QJsonObject file;
+                file["type"] = "count";
+                file["path"] = batch.filePaths[i];
+                file["matches"] = batch.fileMatchedLines[i];
+                out += QJsonDocument(file).toJson(QJsonDocument::Compact);
+                out += '\n';
+            }
+        }
+    }
+
+    writeOut(out);
+}
+
+void HeadlessSearch::writeSummary()
+{
+    int matches = 0;
+    int filesWithMatches = 0;
+    for (int fileId = 0; fileId < m_store.fileCount(); ++fileId) {
+        int fileMatches = m_countOnly ? m_store.fileMatchedLines(fileId) : m_store.fileMatchCount(fileId);
+        matches += fileMatches;
+        filesWithMatches += (fileMatches > 0) ? 1 : 0;
+    }
+    qint64 totalMs = m_timer.elapsed();
+
+    // Matched lines per pattern of a batch search
+    QVector<int> patternLines(m_batchPatterns.size(), 0);
+    for (int row = 0; row < m_store.matchCount() && !m_batchPatterns.isEmpty(); ++row) {
+        quint64 mask = m_store.patternMask(row);
+        for (int i = 0; mask != 0 && i < m_batchPatterns.size(); ++i) {
+            if (mask & (quint64(1) << i)) {
+                patternLines[i]++;
+            }
+        }
+    }
+
+    if (m_format == JsonLines) {
+        QJsonObject timings;
+        timings["first_result_ms"] = m_firstResultMs;
+        timings["search_ms"] = m_searchMs;
+        timings["parse_ms"] = m_parseMs;
+        timings["store_ms"] = m_storeMs;
+        timings["output_ms"] = m_outputMs;
+        timings["total_ms"] = totalMs;
+
+        QJsonObject summary;
+        summary["type"] = "summary";
+        summary["pattern"] = m_params.pattern;
+        summary["path"] = m_params.path;
+        summary["engine"] = m_engine;
+        summary["matches"] = matches;
+        summary["files"] = filesWithMatches;
+        summary["truncated"] = m_budgetReached;
+        summary["store_bytes"] = m_store.memoryUsage();
+        summary["exit_code"] = m_exitCode;
+        if (!m_error.isEmpty()) {
+            summary["error"] = m_error;
+        }
+        if (!m_batchPatterns.isEmpty()) {
+            QJsonObject patterns;
+            for (int i = 0; i < m_batchPatterns.size(); ++i) {
+                patterns[m_batchPatterns[i].name] = patternLines[i];
+            }
+            summary["patterns"] = patterns;
+        }
+        summary["timings"] = timings;
+        writeOut(QJsonDocument(summary).toJson(QJsonDocument::Compact) + '\n');
+        return;
+    }
+
+    QString text;
+    text += QString("Pattern:  %1\n").arg(m_params.pattern);
+    text += QString("Path:     %1\n").arg(m_params.path);
+    text += QString("Engine:   %1\n").arg(m_engine);
+    text += QString("Matches:  %1 in %2 files%3\n").arg(matches).arg(filesWithMatches)
+                .arg(m_budgetReached ? " (stopped at the result limit)" : "");
+    for (int i = 0; i < m_batchPatterns.size(); ++i) {
+        text += QString("  %1: %2 lines\n").arg(m_batchPatterns[i].name).arg(patternLines[i]);
+    }
+    text += QString("Store:    %1 KB\n").arg(m_store.memoryUsage() / 1024);
+    text += QString("Timings:  first result %1 ms, search %2 ms, parse %3 ms, store %4 ms, output %5 ms, total %6 ms\n")
+                .arg(m_firstResultMs).arg(m_searchMs).arg(m_parseMs).arg(m_storeMs).arg(m_outputMs).arg(totalMs);
+    if (!m_error.isEmpty()) {
+        text += QString("Error:    %1\n").arg(m_error);
+    }
+    text += QString("Exit:     %1\n").arg(m_exitCode);
+    writeOut(text.toUtf8());
+}
+
+void HeadlessSearch::writeOut(const QByteArray &data)
+{
+    if (!m_out.isOpen()) {
+        return;
+    }
+    if (!data.isEmpty() && m_out.write(data) != data.size()) {
+        // Reader went away (e.g. piped into head) - nothing more to write
+        LOG_WARNING("HeadlessSearch: stdout closed, stopping the search");
+        m_out.close();
+        m_token.cancel();
+        m_searchBun->stopStreamSearch();
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef HEADLESSSEARCH_H
+#define HEADLESSSEARCH_H
+
+#include <QObject>
+#include <QCoreApplication>
+#include <QString>
+#include <QStringList>
+#include <QFile>
+#include <QThread>
+#include <QElapsedTimer>
+#include "KSearchBun.h"
+#include "SearchResultStore.h"
+#include "SearchCancelToken.h"
+
+class JsonParseWorker;
+class SearchFlowControl;
+
+// TotalSearch --headless: one search through the same pipeline as the GUI (KSearchBun streaming
+// search -> JsonParseWorker on its own thread -> SearchResultStore) on a QCoreApplication, so it
+// runs without a display or GUI platform plugin. Matches are written to stdout as JSON Lines or
+// as a summary, both with the time taken by each stage. Exit codes follow ripgrep: 0 matches
+// found, 1 no matches, 2 error. Log lines go to data/logs/totalsearch-headless.log (and stderr
+// with --verbose), never to stdout.
+class HeadlessSearch : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum ExitCode { ExitMatches = 0, ExitNoMatches = 1, ExitError = 2 };
+
+    // --headless is among the arguments (checked before any application object exists)
+    static bool isRequested(int argc, char *argv[]);
+
+    // Run the search on app and return the exit code
+    static int run(QCoreApplication &app);
+
+    explicit HeadlessSearch(QObject *parent = nullptr);
+    ~HeadlessSearch();
+
+    // False with the exit code set when there is nothing to search (help, version, bad options)
+    bool parseArguments(const QStringList &arguments);
+    int exitCode() const { return m_exitCode; }
+
+public slots:
+    // Quits the application with the exit code once the results are written
+    void start();
+
+private:
+    enum OutputFormat { JsonLines, Summary };
+
+    void onResultBatch(const SearchResultBatchPtr &batch);
+    void onSearchFinished(int exitCode);
+    void onParsingCompleted(int totalMatches, int totalFiles);
+    void finish(int exitCode);
+
+    // ===== OUTPUT =====
+    void writeMatches(int firstRow, const SearchResultBatch &batch);
+    void writeSummary();
+    void writeOut(const QByteArray &data);
+
+    // ===== OPTIONS =====
+    RGSearchParams m_params;
+    QVector<NamedSearchPattern> m_batchPatterns;    // --patterns-file
+    ProximityQuery m_proximity;                     // --pattern --and ... [--within] [--ordered]
+    QString m_engine;
+    OutputFormat m_format;
+    int m_maxResults;               // -1 = [RGSearch] MaxTotalMatches
+    int m_maxCount;                 // -1 = [RGSearch] MaxMatchesPerFile
+    bool m_countOnly;
+
+    // ===== PIPELINE =====
+    KSearchBun *m_searchBun;
+    QThread *m_parseThread;
+    JsonParseWorker *m_parseWorker;
+    SearchResultStore m_store;
+    SearchCancelToken m_token;
+    QSharedPointer<SearchFlowControl> m_flowControl;
+    QFile m_out;
+
+    // ===== RESULT =====
+    int m_searchExitCode;
+    bool m_budgetReached;
+    QString m_error;
+    int m_exitCode;
+
+    // ===== STAGE TIMINGS (ms) =====
+    // The stages overlap: search and parse are the time until the stage finished, store and
+    // output the time spent in them
+    QElapsedTimer m_timer;
+    qint64 m_firstResultMs;
+    qint64 m_searchMs;
+    qint64 m_parseMs;
+    qint64 m_storeMs;
+    qint64 m_outputMs;
+};
+
+#endif // HEADLESSSEARCH_H
@@ -0,0 +1,319 @@
+#include "HyperscanFileSearcher.h"
+#include "logger.h"
+#include <QRegularExpression>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QPair>
+#include <cstring>
+
+#ifdef TOTALSEARCH_HAVE_HYPERSCAN
+#include <hs/hs.h>
+#endif
+
+namespace {
+
+#ifdef TOTALSEARCH_HAVE_HYPERSCAN
+
+// hs_scan takes an unsigned int length, so large files are scanned in newline-aligned blocks
+constexpr qint64 HS_SCAN_BLOCK_SIZE = 256LL * 1024 * 1024;
+
+// State for one file while hs_scan reports matches (matches arrive ordered by end offset)
+struct LineMatchContext {
+    const HyperscanFileSearcher *owner = nullptr;
+    const QString *filePath = nullptr;
+    FileSearchRecordWriter *writer = nullptr;
+    const char *data = nullptr;
+    qint64 size = 0;
+    qint64 blockBase = 0;           // Offset of the block currently being scanned
+    bool somAvailable = true;       // Start offsets are reported (HS_FLAG_SOM_LEFTMOST)
+
+    // Line counting - newlines are counted once, forward only
+    qint64 countedPos = 0;
+    qint64 countedLineStart = 0;
+    qint64 countedLineNumber = 1;
+
+    // Matched line waiting to be written (lineStart < 0 = none)
+    qint64 lineStart = -1;
+    qint64 lineEnd = -1;
+    qint64 lineNumber = 0;
+    QVector<QPair<qint64, qint64>> submatches;  // Absolute [from, to)
+
+    int matchedLines = 0;
+    int matches = 0;
+};
+
+void flushPendingLine(LineMatchContext *c)
+{
+    if (c->lineStart < 0) {
+        return;
+    }
+
+    // rg includes the line terminator in lines.text
+    qint64 textEnd = (c->lineEnd < c->size) ? c->lineEnd + 1 : c->lineEnd;
+    QByteArray lineBytes = QByteArray::fromRawData(c->data + c->lineStart, int(textEnd - c->lineStart));
+
+    QVector<QPair<qint64, qint64>> relative;
+    relative.reserve(c->submatches.size());
+    for (const QPair<qint64, qint64> &sm : c->submatches) {
+        relative.append(qMakePair(sm.first - c->lineStart, sm.second - c->lineStart));
+    }
+    if (c->writer->match(*c->filePath, c->lineNumber, c->lineStart, lineBytes, relative)) {
+        c->matchedLines++;
+        c->matches += c->submatches.size();
+    }
+    c->lineStart = -1;
+    c->submatches.clear();
+}
+
+int HS_CDECL onHyperscanMatch(unsigned int id, unsigned long long from, unsigned long long to,
+                              unsigned int flags, void *context)
+{
+    Q_UNUSED(id)
+    Q_UNUSED(flags)
+
+    LineMatchContext *c = static_cast<LineMatchContext*>(context);
+    if (c->owner->isCancelled() || c->writer->fileFull()) {
+        return 1;  // Stop scanning
+    }
+
+    qint64 absTo = c->blockBase + qint64(to);
+    qint64 absFrom = c->somAvailable ? c->blockBase + qint64(from) : absTo;
+
+    // Another match on the line already pending
+    if (c->lineStart >= 0 && absFrom >= c->lineStart && absFrom <= c->lineEnd) {
+        absTo = qMin(absTo, c->lineEnd);
+        if (!c->submatches.isEmpty() && absFrom < c->submatches.last().second) {
+            // Overlapping report of the same match - keep the longest one
+            if (absFrom == c->submatches.last().first && absTo > c->submatches.last().second) {
+                c->submatches.last().second = absTo;
+            }
+            return 0;
+        }
+        c->submatches.append(qMakePair(absFrom, absTo));
+        return 0;
+    }
+
+    // Overlapping report reaching back into an already written line
+    if (absFrom < c->countedPos) {
+        return 0;
+    }
+
+    flushPendingLine(c);
+
+    // Count newlines up to the start of the match
+    const char *p = c->data + c->countedPos;
+    const char *end = c->data + absFrom;
+    while (p < end) {
+        const void *nl = memchr(p, '\n', size_t(end - p));
+        if (!nl) {
+            break;
+        }
+        p = static_cast<const char*>(nl) + 1;
+        c->countedLineNumber++;
+        c->countedLineStart = p - c->data;
+    }
+    c->countedPos = absFrom;
+
+    const void *nl = memchr(c->data + absFrom, '\n', size_t(c->size - absFrom));
+    c->lineStart = c->countedLineStart;
+    c->lineEnd = nl ? static_cast<const char*>(nl) - c->data : c->size;
+    c->lineNumber = c->countedLineNumber;
+    c->submatches.append(qMakePair(absFrom, qMin(absTo, c->lineEnd)));
+    return 0;
+}
+
+#endif // TOTALSEARCH_HAVE_HYPERSCAN
+
+} // namespace
+
+HyperscanFileSearcher::HyperscanFileSearcher(QObject *parent)
+    : MappedFileSearcher(parent)
+    , m_database(nullptr)
+    , m_prototypeScratch(nullptr)
+    , m_somAvailable(true)
+{
+}
+
+HyperscanFileSearcher::~HyperscanFileSearcher()
+{
+    release();
+}
+
+bool HyperscanFileSearcher::isCompiledIn()
+{
+#ifdef TOTALSEARCH_HAVE_HYPERSCAN
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool HyperscanFileSearcher::prepare(const RGSearchParams &params, QString *error)
+{
+#ifndef TOTALSEARCH_HAVE_HYPERSCAN
+    Q_UNUSED(params)
+    LOG_ERROR("HyperscanFileSearcher: Built without Hyperscan support (configure with -DTOTALSEARCH_WITH_HYPERSCAN=ON)");
+    *error = "Hyperscan support is not available in this build";
+    return false;
+#else
+    QElapsedTimer compileTimer;
+    compileTimer.start();
+
+    // Compile pattern and add_pattern into one database
+    QStringList patterns;
+    patterns << params.pattern;
+    if (!params.add_pattern.isEmpty()) {
+        patterns << params.add_pattern;
+    }
+
+    // Smart case: case-insensitive unless the pattern contains an uppercase letter
+    bool caseless = false;
+    if (params.case_sensitive) {
+        caseless = false;
+    } else if (params.ignore_case) {
+        caseless = true;
+    } else if (params.smart_case) {
+        caseless = (params.pattern + params.add_pattern).toLower() == (params.pattern + params.add_pattern);
+    }
+
+    QList<QByteArray> expressionData;
+    QVector<const char*> expressions;
+    QVector<unsigned int> flags;
+    QVector<unsigned int> ids;
+    for (int i = 0; i < patterns.size(); ++i) {
+        QString expression = params.fixed_string ? QRegularExpression::escape(patterns[i]) : patterns[i];
+        expressionData.append(expression.toUtf8());
+        // MULTILINE makes ^ and $ match at line boundaries like ripgrep; the data is
+        // scanned as bytes (no HS_FLAG_UTF8) because logs may contain invalid UTF-8
+        unsigned int f = HS_FLAG_MULTILINE | HS_FLAG_SOM_LEFTMOST;
+        if (caseless) {
+            f |= HS_FLAG_CASELESS;
+        }
+        flags.append(f);
+        ids.append(unsigned(i));
+    }
+    for (const QByteArray &e : expressionData) {
+        expressions.append(e.constData());
+    }
+
+    hs_compile_error_t *compileError = nullptr;
+    m_somAvailable = true;
+    if (hs_compile_multi(expressions.constData(), flags.constData(), ids.constData(), unsigned(expressions.size()),
+                         HS_MODE_BLOCK, nullptr, &m_database, &compileError) != HS_SUCCESS) {
+        LOG_WARNING("HyperscanFileSearcher: Compile with start-of-match failed (" + QString(compileError->message) + "), retrying without");
+        hs_free_compile_error(compileError);
+        compileError = nullptr;
+
+        m_somAvailable = false;
+        for (unsigned int &f : flags) {
+            f &= ~HS_FLAG_SOM_LEFTMOST;
+        }
+        if (hs_compile_multi(expressions.constData(), flags.constData(), ids.constData(), unsigned(expressions.size()),
+                             HS_MODE_BLOCK, nullptr, &m_database, &compileError) != HS_SUCCESS) {
+            *error = QString("Hyperscan compile error: %1").arg(compileError->message);
+            hs_free_compile_error(compileError);
+            m_database = nullptr;
+            return false;
+        }
+    }
+
+    if (hs_alloc_scratch(m_database, &m_prototypeScratch) != HS_SUCCESS) {
+        release();
+        *error = "Hyperscan: failed to allocate scratch space";
+        return false;
+    }
+
+    LOG_INFO("HyperscanFileSearcher: Compiled " + QString::number(expressions.size()) + " expression(s) in " +
+             QString::number(compileTimer.elapsed()) + " ms (start offsets: " + QString(m_somAvailable ? "yes" : "no") + ")");
+    return true;
+#endif
+}
+
+void HyperscanFileSearcher::release()
+{
+#ifdef TOTALSEARCH_HAVE_HYPERSCAN
+    if (m_prototypeScratch) {
+        hs_free_scratch(m_prototypeScratch);
+        m_prototypeScratch = nullptr;
+    }
+    if (m_database) {
+        hs_free_database(m_database);
+        m_database = nullptr;
+    }
+#endif
+}
+
+void *HyperscanFileSearcher::createThreadState()
+{
+#ifdef TOTALSEARCH_HAVE_HYPERSCAN
+    hs_scratch_t *scratch = nullptr;
+    if (hs_clone_scratch(m_prototypeScratch, &scratch) != HS_SUCCESS) {
+        LOG_ERROR("HyperscanFileSearcher: Failed to clone scratch space");
+        return nullptr;
+    }
+    return scratch;
+#else
+    return nullptr;
+#endif
+}
+
+void HyperscanFileSearcher::destroyThreadState(void *state)
+{
+#ifdef TOTALSEARCH_HAVE_HYPERSCAN
+    if (state) {
+        hs_free_scratch(static_cast<hs_scratch_t*>(state));
+    }
+#else
+    Q_UNUSED(state)
+#endif
+}
+
+MappedFileSearcher::FileScanResult HyperscanFileSearcher::scanFile(const QString &filePath, const char *data, qint64 size,
+                                                                   FileSearchRecordWriter &writer, void *threadState)
+{
+    FileScanResult result;
+
+#ifdef TOTALSEARCH_HAVE_HYPERSCAN
+    hs_scratch_t *scratch = static_cast<hs_scratch_t*>(threadState);
+    if (!scratch) {
+        return result;
+    }
+
+    LineMatchContext context;
+    context.owner = this;
+    context.filePath = &filePath;
+    context.writer = &writer;
+    context.data = data;
+    context.size = size;
+    context.somAvailable = m_somAvailable;
+
+    for (qint64 blockStart = 0; blockStart < size && !isCancelled() && !writer.fileFull(); ) {
+        qint64 blockEnd = qMin(size, blockStart + HS_SCAN_BLOCK_SIZE);
+        if (blockEnd < size) {
+            const void *nl = memchr(data + blockEnd, '\n', size_t(size - blockEnd));
+            blockEnd = nl ? (static_cast<const char*>(nl) - data) + 1 : size;
+        }
+
+        context.blockBase = blockStart;
+        hs_error_t scanResult = hs_scan(m_database, data + blockStart, unsigned(blockEnd - blockStart), 0,
+                                        scratch, onHyperscanMatch, &context);
+        if (scanResult != HS_SUCCESS && scanResult != HS_SCAN_TERMINATED) {
+            LOG_WARNING("HyperscanFileSearcher: hs_scan failed for " + filePath + " (" + QString::number(scanResult) + ")");
+            break;
+        }
+        blockStart = blockEnd;
+    }
+    flushPendingLine(&context);
+
+    result.matchedLines = context.matchedLines;
+    result.matches = context.matches;
+#else
+    Q_UNUSED(filePath)
+    Q_UNUSED(data)
+    Q_UNUSED(size)
+    Q_UNUSED(writer)
+    Q_UNUSED(threadState)
+#endif
+
+    return result;
+}
@@ -0,0 +1,42 @@
+#ifndef HYPERSCANFILESEARCHER_H
+#define HYPERSCANFILESEARCHER_H
+
+#include "filesearcher.h"
+
+struct hs_database;
+struct hs_scratch;
+
+// In-process search backend built on the vendored Hyperscan headers (include/hs).
+// pattern and add_pattern are compiled into one hs_database_t and every file is scanned
+// from a memory mapping with per-thread scratch space.
+//
+// The real implementation is only compiled when CMake finds libhs
+// (-DTOTALSEARCH_WITH_HYPERSCAN=ON defines TOTALSEARCH_HAVE_HYPERSCAN).
+class HyperscanFileSearcher : public MappedFileSearcher
+{
+    Q_OBJECT
+
+public:
+    explicit HyperscanFileSearcher(QObject *parent = nullptr);
+    ~HyperscanFileSearcher();
+
+    QString engineName() const override { return "hyperscan"; }
+
+    // True when the binary was built with Hyperscan support
+    static bool isCompiledIn();
+
+protected:
+    bool prepare(const RGSearchParams &params, QString *error) override;
+    void release() override;
+    void *createThreadState() override;
+    void destroyThreadState(void *state) override;
+    FileScanResult scanFile(const QString &filePath, const char *data, qint64 size,
+                            FileSearchRecordWriter &writer, void *threadState) override;
+
+private:
+    hs_database *m_database;
+    hs_scratch *m_prototypeScratch;   // Cloned once per worker thread
+    bool m_somAvailable;              // Start offsets are reported (HS_FLAG_SOM_LEFTMOST)
+};
+
+#endif // HYPERSCANFILESEARCHER_H
@@ -0,0 +1,244 @@
+#include "IndexedFileSearcher.h"
+#include "CachedFileSearcher.h"
+#include "CompressedFile.h"
+#include "logger.h"
+#include <QFileInfo>
+#include <QThread>
+
+IndexedFileSearcher::IndexedFileSearcher(FileSearcher *engine, QObject *parent)
+    : FileSearcher(parent)
+    , m_engine(engine)
+    , m_fullSearch(false)
+    , m_candidateCount(0)
+{
+    m_engine->setParent(this);
+
+    connect(m_engine, &FileSearcher::outputChunk, this, &FileSearcher::outputChunk, Qt::DirectConnection);
+    connect(m_engine, &FileSearcher::finished, this, [this](int exitCode) {
+        finishRun(exitCode);
+    });
+    connect(m_engine, &FileSearcher::errorOccurred, this, &FileSearcher::errorOccurred, Qt::DirectConnection);
+    connect(m_engine, &FileSearcher::fileSearched, this, &FileSearcher::fileSearched, Qt::DirectConnection);
+}
+
+IndexedFileSearcher::~IndexedFileSearcher()
+{
+}
+
+QString IndexedFileSearcher::engineName() const
+{
+    return m_engine->engineName();
+}
+
+bool IndexedFileSearcher::canSearchTargets(const QVector<SearchTarget> &targets) const
+{
+    return m_engine->canSearchTargets(targets);
+}
+
+QStringList IndexedFileSearcher::candidateFiles(const RGSearchParams &params) const
+{
+    return m_engine->candidateFiles(params);
+}
+
+void IndexedFileSearcher::start(const RGSearchParams &params)
+{
+    m_cancelled.store(false);
+    m_engine->setCancelToken(m_cancelToken);
+    m_engine->setFlowControl(m_flowControl);
+    m_params = params;
+    m_index = TrigramIndex::forRoot(params.path);
+    m_engineTargets.clear();
+    m_staleFiles.clear();
+    m_skippedFiles.clear();
+    m_fullSearch = false;
+    m_candidateCount = 0;
+
+    m_timer.start();
+
+    // Listing and looking up every file runs off the UI thread
+    QThread *thread = QThread::create([this]() {
+        prepareRun();
+    });
+    connect(thread, &QThread::finished, this, [this, thread]() {
+        thread->deleteLater();
+        startEngine();
+    });
+    thread->start();
+}
+
+void IndexedFileSearcher::cancel()
+{
+    FileSearcher::cancel();
+    m_engine->cancel();
+}
+
+void IndexedFileSearcher::prepareRun()
+{
+    LOG_INFO("IndexedFileSearcher: ===THREAD=== prepareRun for path: " + m_params.path + " <<<<<STARTed<<<<<");
+
+    try {
+        // ===== STEP 1: CANDIDATE FILES =====
+        QVector<SearchTarget> candidates = m_targets;
+        if (!m_hasTargets) {
+            for (const QString &filePath : m_engine->candidateFiles(m_params)) {
+                SearchTarget target;
+                target.filePath = filePath;
+                candidates.append(target);
+            }
+        }
+        m_candidateCount = candidates.size();
+
+        TrigramIndex::Query query = TrigramIndex::buildQuery(m_params);
+        if (!query.isUsable()) {
+            LOG_INFO("IndexedFileSearcher: No required literal in '" + m_params.pattern + "', full scan");
+        }
+
+        // Block ranges are only worth asking for if the engine can search them
+        SearchTarget rangeProbe;
+        rangeProbe.ranges.append(SearchRange());
+        bool engineTakesRanges = m_engine->canSearchTargets({rangeProbe});
+
+        // ===== STEP 2: LOOK UP EVERY CANDIDATE =====
+        int prunedFiles = 0;
+        int prunedBlocks = 0;
+        qint64 prunedBytes = 0;
+        for (SearchTarget &target : candidates) {
+            if (isCancelled()) {
+                return;
+            }
+
+            // Trigrams of compressed bytes say nothing about the text - always searched, never indexed
+            if (m_params.search_compressed && CompressedFile::isCompressedPath(target.filePath)) {
+                m_engineTargets.append(target);
+                continue;
+            }
+
+            CachedFileSearcher::Fingerprint current = CachedFileSearcher::fingerprint(target.filePath);
+            if (!current.isValid()) {
+                m_skippedFiles << target.filePath;
+                continue;
+            }
+
+            QVector<SearchRange> ranges;
+            int blockCount = 0;
+            if (!m_index->candidateRanges(target.filePath, current.size, current.modified, query, &ranges, &blockCount)) {
+                m_staleFiles << target.filePath;
+                m_engineTargets.append(target);
+                continue;
+            }
+            if (!query.isUsable()) {
+                m_engineTargets.append(target);
+                continue;
+            }
+
+            // Blocks before the target's start were searched already (tail of a grown file)
+            if (target.startOffset > 0) {
+                QVector<SearchRange> tail;
+                for (const SearchRange &range : ranges) {
+                    if (range.end <= target.startOffset) {
+                        continue;
+                    }
+                    SearchRange clipped = range;
+                    if (clipped.start < target.startOffset) {
+                        clipped.start = target.startOffset;
+                        clipped.startLine = target.startLine;
+                    }
+                    tail.append(clipped);
+                }
+                ranges = tail;
+            }
+
+            qint64 candidateBytes = 0;
+            for (const SearchRange &range : ranges) {
+                candidateBytes += range.end - range.start;
+            }
+
+            if (ranges.isEmpty()) {
+                prunedFiles++;
+                prunedBytes += current.size - target.startOffset;
+                m_skippedFiles << target.filePath;
+                continue;
+            }
+
+            // Whole file (or tail) if nothing was pruned or the engine cannot search ranges
+            bool pruned = candidateBytes < current.size - target.startOffset;
+            if (pruned && engineTakesRanges) {
+                target.ranges = ranges;
+                prunedBlocks++;
+                prunedBytes += current.size - target.startOffset - candidateBytes;
+            }
+            m_engineTargets.append(target);
+        }
+
+        // ===== STEP 3: DECIDE WHAT THE ENGINE SEARCHES =====
+        if (m_engineTargets.size() == candidates.size() && prunedBlocks == 0) {
+            m_fullSearch = true;
+        } else if (!m_engine->canSearchTargets(m_engineTargets)) {
+            // e.g. the tail of a grown file for an engine that cannot start at an offset
+            m_fullSearch = true;
+        }
+
+        LOG_INFO("IndexedFileSearcher: " + QString::number(candidates.size()) + " candidate files, " +
+                 QString::number(m_staleFiles.size()) + " not indexed, " + QString::number(prunedFiles) +
+                 " skipped, " + QString::number(prunedBlocks) + " searched in blocks, " +
+                 QString::number(prunedBytes / (1024 * 1024)) + " MB pruned" +
+                 (m_fullSearch ? " - full " + engineName() + " search" : "") + " after " +
+                 QString::number(m_timer.elapsed()) + " ms");
+
+    } catch (const std::exception &e) {
+        LOG_ERROR("IndexedFileSearcher: Exception in prepareRun: " + QString(e.what()));
+        m_fullSearch = true;
+    } catch (...) {
+        LOG_ERROR("IndexedFileSearcher: Unknown exception in prepareRun");
+        m_fullSearch = true;
+    }
+
+    LOG_INFO("IndexedFileSearcher: ===THREAD=== prepareRun for path: " + m_params.path + " >>>>>ENDed>>>>>");
+}
+
+void IndexedFileSearcher::startEngine()
+{
+    if (isCancelled()) {
+        finishRun(1);
+        return;
+    }
+
+    if (m_fullSearch) {
+        if (m_hasTargets) {
+            m_engine->setTargets(m_targets);
+        } else {
+            m_engine->clearTargets();
+        }
+        m_engine->start(m_params);
+        return;
+    }
+
+    // Nothing to search in these - done before the engine starts
+    for (const QString &filePath : m_skippedFiles) {
+        emit fileSearched(filePath);
+    }
+
+    if (m_engineTargets.isEmpty()) {
+        LOG_INFO("IndexedFileSearcher: The index rules out every file");
+        FileSearchRecordWriter writer(this);
+        writer.summary(0, 0, m_candidateCount, 0, 0, m_timer.nsecsElapsed());
+        writer.flush();
+        finishRun(1);
+        return;
+    }
+
+    m_engine->setTargets(m_engineTargets);
+    m_engine->start(m_params);
+}
+
+void IndexedFileSearcher::finishRun(int engineExitCode)
+{
+    // Files searched whole this time are indexed for the next search
+    if (!m_staleFiles.isEmpty() && !isCancelled()) {
+        TrigramIndex::scheduleUpdate(m_index, m_staleFiles);
+    }
+    m_staleFiles.clear();
+
+    LOG_INFO("IndexedFileSearcher: " + engineName() + " search done after " + QString::number(m_timer.elapsed()) + " ms");
+    emit finished(engineExitCode);
+}
@@ -0,0 +1,49 @@
+#ifndef INDEXEDFILESEARCHER_H
+#define INDEXEDFILESEARCHER_H
+
+#include <QSharedPointer>
+#include <QStringList>
+#include <QElapsedTimer>
+#include "filesearcher.h"
+#include "TrigramIndex.h"
+
+// Trigram index in front of a search backend. Files indexed at their current size and
+// modification time are searched only where the index says a match is possible - whole files
+// are skipped, and engines that search ranges get only the candidate blocks of large files.
+// Files not indexed yet are searched whole and indexed in the background afterwards.
+class IndexedFileSearcher : public FileSearcher
+{
+    Q_OBJECT
+
+public:
+    // Takes ownership of engine
+    explicit IndexedFileSearcher(FileSearcher *engine, QObject *parent = nullptr);
+    ~IndexedFileSearcher();
+
+    QString engineName() const override;
+
+    void start(const RGSearchParams &params) override;
+    void cancel() override;
+
+    bool canSearchTargets(const QVector<SearchTarget> &targets) const override;
+    QStringList candidateFiles(const RGSearchParams &params) const override;
+
+private:
+    void prepareRun();                  // Search thread: look up every candidate in the index
+    void startEngine();
+    void finishRun(int engineExitCode);
+
+    FileSearcher *m_engine;
+    RGSearchParams m_params;
+    QSharedPointer<TrigramIndex> m_index;
+    QElapsedTimer m_timer;
+
+    // Set up by prepareRun before the engine starts
+    QVector<SearchTarget> m_engineTargets;
+    QStringList m_staleFiles;           // Not indexed at their current size and time
+    QStringList m_skippedFiles;         // Ruled out by the index or gone - reported searched
+    bool m_fullSearch;                  // Nothing could be pruned, the engine searches as asked
+    int m_candidateCount;
+};
+
+#endif // INDEXEDFILESEARCHER_H
@@ -1,22 +1,64 @@
 #include "JsonParseWorker.h"
 #include "logger.h"
-#include "KSearch.h"
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
-#include <QJsonParseError>
+#include "RgJsonParser.h"
+#include "CompressedFile.h"
+#include "CachedFileSearcher.h"
 #include <QElapsedTimer>
-#include <QApplication>
+#include <QCoreApplication>
+#ifdef Q_OS_WIN
 #include <windows.h>
 #include <psapi.h>
-#include <QFileInfo>
+#else
+#include <QFile>
+#include <unistd.h>
+#endif
+#include <QThread>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <QScopedArrayPointer>
+#include <QTimer>
+#include <QSettings>
+#include <QVector>
+#include <QPair>
+#include <cstring>
 
 JsonParseWorker::JsonParseWorker(QObject *parent)
     : QObject(parent)
+    , m_totalMatches(0)
+    , m_filesWithMatches(0)
+    , m_streamActive(false)
+    , m_streamBytes(0)
+    , m_unbatchedBytes(0)
+    , m_streamParseTimer(new QTimer(this))
+    , m_batchTimer(new QTimer(this))
+    , m_batchSize(DEFAULT_RESULT_BATCH_SIZE)
+    , m_batchIntervalMs(DEFAULT_RESULT_BATCH_INTERVAL_MS)
 {
+    // Batches cross threads through queued connections
+    qRegisterMetaType<SearchResultBatchPtr>("SearchResultBatchPtr");
+    qRegisterMetaType<SearchCancelToken>("SearchCancelToken");
+    
+    // Child of the worker, so it moves to the parse thread together with it
+    m_batchTimer->setSingleShot(true);
+    connect(m_batchTimer, &QTimer::timeout, this, &JsonParseWorker::flushBatch);
+    m_streamParseTimer->setSingleShot(true);
+    connect(m_streamParseTimer, &QTimer::timeout, this, &JsonParseWorker::parseStreamBuffer);
+}
+
+void JsonParseWorker::loadBatchSettings()
+{
+    QSettings settings("app.ini", QSettings::IniFormat);
+    settings.beginGroup("RGSearch");
+    m_batchSize = qBound(1, settings.value("ResultBatchSize", DEFAULT_RESULT_BATCH_SIZE).toInt(), 100000);
+    m_batchIntervalMs = qBound(1, settings.value("ResultBatchIntervalMs", DEFAULT_RESULT_BATCH_INTERVAL_MS).toInt(), 10000);
+    settings.endGroup();
+    
+    LOG_INFO("JsonParseWorker: Result batches of " + QString::number(m_batchSize) + " matches or " +
+             QString::number(m_batchIntervalMs) + " ms");
 }
 
-void JsonParseWorker::parseJsonData(const QString &pattern, const QString &jsonData, const QString &searchPath)
+void JsonParseWorker::parseJsonData(const QString &pattern, const QString &jsonData, const QString &searchPath,
+                                    const SearchCancelToken &token)
 {
     LOG_INFO("JsonParseWorker: START - parseJsonData");
     QElapsedTimer functionTimer;
@@ -25,37 +67,32 @@ void JsonParseWorker::parseJsonData(const QString &pattern, const QString &jsonD
     logMemoryUsage("parseJsonData - start");
     
     try {
+        m_cancelToken = token;
+        loadBatchSettings();
+        m_batch.reset();
         emit parsingStarted();
         
-        // Split JSON data once at the top level
-        QElapsedTimer splitTimer;
-        splitTimer.start();
+        // Convert once to UTF-8 - lines are parsed in place from this buffer
+        QElapsedTimer convertTimer;
+        convertTimer.start();
         
-        QStringList lines = jsonData.split('\n', Qt::SkipEmptyParts);
+        QByteArray data = jsonData.toUtf8();
         
-        qint64 splitTime = splitTimer.elapsed();
-        LOG_INFO("JsonParseWorker: Top-level split time: " + QString::number(splitTime) + " ms for " + QString::number(lines.size()) + " lines");
+        qint64 convertTime = convertTimer.elapsed();
+        LOG_INFO("JsonParseWorker: UTF-8 conversion time: " + QString::number(convertTime) + " ms for " + QString::number(data.size()) + " bytes");
         
-        // Parse RG summary first to get summary data and match count (pass split lines)
+        // Parse RG summary first to get summary data and match count
         LOG_INFO("JsonParseWorker: About to call parseRGSummary");
         int totalMatchedLines = 0;
-        QString summaryText = parseRGSummary(lines, &totalMatchedLines);
+        QString summaryText = parseRGSummary(data, &totalMatchedLines);
         LOG_INFO("JsonParseWorker: parseRGSummary completed successfully");
         LOG_INFO("JsonParseWorker: Total matched lines: " + QString::number(totalMatchedLines));
         
         // Emit summary parsed signal
         emit summaryParsed(summaryText, totalMatchedLines);
         
-                // Parse the actual JSON data (pass split lines)
-        parseJsonDataInternal(lines, pattern, totalMatchedLines);
-        
-        // Explicit QStringList cleanup to force memory deallocation
-        LOG_INFO("JsonParseWorker: Starting explicit QStringList cleanup");
-        logMemoryUsage("Before QStringList cleanup");
-        lines.clear();
-        lines.squeeze();  // Qt equivalent of shrink_to_fit()
-        logMemoryUsage("After QStringList cleanup");
-        LOG_INFO("JsonParseWorker: QStringList cleanup completed");
+        // Parse the actual JSON data
+        parseJsonDataInternal(data, pattern, totalMatchedLines);
         
         LOG_INFO("JsonParseWorker: parseJsonData completed successfully");
         LOG_INFO("JsonParseWorker: Total function time: " + QString::number(functionTimer.elapsed()) + " ms");
@@ -83,6 +120,7 @@ void JsonParseWorker::logMemoryUsage(const QString& stage)
 
 qint64 JsonParseWorker::getCurrentMemoryUsage() const
 {
+#ifdef Q_OS_WIN
     // Get process memory usage on Windows
     HANDLE process = GetCurrentProcess();
     PROCESS_MEMORY_COUNTERS_EX pmc;
@@ -90,72 +128,61 @@ qint64 JsonParseWorker::getCurrentMemoryUsage() const
         return pmc.WorkingSetSize;
     }
     return 0;
+#else
+    // Resident pages from /proc/self/statm
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    QList<QByteArray> fields = statm.readAll().split(' ');
+    return (fields.size() > 1) ? fields[1].toLongLong() * sysconf(_SC_PAGESIZE) : 0;
+#endif
 }
 
-QString JsonParseWorker::parseRGSummary(const QStringList &lines, int* outMatchedLines)
+QString JsonParseWorker::parseRGSummary(const QByteArray &data, int* outMatchedLines)
 {
     LOG_INFO("JsonParseWorker: START - parseRGSummary");
     QElapsedTimer functionTimer;
     functionTimer.start();
     
     try {
-        // Get the last non-empty line from the pre-split data
+        // Get the last non-empty line without splitting the data
         QElapsedTimer lastLineTimer;
         lastLineTimer.start();
         
-        QString lastLine;
-        
-        if (!lines.isEmpty()) {
-            lastLine = lines.last().trimmed();
+        qsizetype lineEnd = data.size();
+        while (lineEnd > 0 && (data[lineEnd - 1] == '\n' || data[lineEnd - 1] == '\r')) {
+            --lineEnd;
         }
+        qsizetype lineStart = (lineEnd > 0) ? data.lastIndexOf('\n', lineEnd - 1) + 1 : 0;
+        QByteArrayView lastLine(data.constData() + lineStart, lineEnd - lineStart);
         
         qint64 lastLineTime = lastLineTimer.elapsed();
         LOG_INFO("JsonParseWorker: Last line extraction time: " + QString::number(lastLineTime) + " ms");
-        LOG_INFO("JsonParseWorker: Last line length: " + QString::number(lastLine.length()) + " characters");
+        LOG_INFO("JsonParseWorker: Last line length: " + QString::number(lastLine.size()) + " bytes");
         
         QString summaryText;
         int totalMatchedLines = 0;
         
         if (!lastLine.isEmpty()) {
-            LOG_INFO("JsonParseWorker: Last line: " + lastLine);
-
-   
-
-            if (!lastLine.isEmpty()) {
-                QJsonParseError parseError;
-                QJsonDocument doc = QJsonDocument::fromJson(lastLine.toUtf8(), &parseError);
-                
-                if (parseError.error == QJsonParseError::NoError) {
-                    QJsonObject obj = doc.object();
-                    QString type = obj[QString("type")].toString();
+            LOG_INFO("JsonParseWorker: Last line: " + QString::fromUtf8(lastLine.data(), lastLine.size()));
+            
+            RgJsonRecord record;
+            if (RgJsonParser::parseLine(lastLine, &record)) {
+                if (record.type == RgJsonRecord::Summary) {
+                    totalMatchedLines = int(record.matchedLines);
                     
-                    if (type == "summary") {
-                        QJsonObject dataObj = obj["data"].toObject();
-                
-                        // Extract summary information
-                        QJsonObject elapsedTotalObj = dataObj["elapsed_total"].toObject();
-                        QString elapsedTotalStr = elapsedTotalObj["human"].toString();
-                        
-                        QJsonObject statsObj = dataObj["stats"].toObject();
-                        int matchedLines = statsObj["matched_lines"].toInt();
-                        int searchesWithMatch = statsObj["searches_with_match"].toInt();
-                                
-                        totalMatchedLines = matchedLines;
-                        
-                        summaryText = QString("📊 Found %1 matches ( files: %2,  duration: %3 )")
-                            .arg(matchedLines)
-                            .arg(searchesWithMatch)
-                            .arg(elapsedTotalStr);
-                        
-                        LOG_INFO("JsonParseWorker: Summary processed - " + summaryText);
-                    } else {
-                        LOG_WARNING("JsonParseWorker: Last line is not a summary, type: " + type);
-                    }
+                    summaryText = QString("📊 Found %1 matches ( files: %2,  duration: %3 )")
+                        .arg(record.matchedLines)
+                        .arg(record.searchesWithMatch)
+                        .arg(record.elapsedTotalHuman.toString());
+                    
+                    LOG_INFO("JsonParseWorker: Summary processed - " + summaryText);
                 } else {
-                    LOG_WARNING("JsonParseWorker: JSON parse error in last line: " + parseError.errorString());
+                    LOG_WARNING("JsonParseWorker: Last line is not a summary record");
                 }
             } else {
-                LOG_WARNING("JsonParseWorker: Last line is empty");
+                LOG_WARNING("JsonParseWorker: JSON parse error in last line");
             }
         } else {
             LOG_WARNING("JsonParseWorker: Last line is empty or no valid JSON found");
@@ -181,7 +208,7 @@ QString JsonParseWorker::parseRGSummary(const QStringList &lines, int* outMatche
     LOG_INFO("JsonParseWorker: END - parseRGSummary");
 }
 
-void JsonParseWorker::parseJsonDataInternal(const QStringList &lines, const QString &pattern, int totalMatchedLines)
+void JsonParseWorker::parseJsonDataInternal(const QByteArray &data, const QString &pattern, int totalMatchedLines)
 {
     LOG_INFO("JsonParseWorker: START - parseJsonDataInternal");
     QElapsedTimer functionTimer;
@@ -190,141 +217,476 @@ void JsonParseWorker::parseJsonDataInternal(const QStringList &lines, const QStr
     logMemoryUsage("parseJsonDataInternal - start");
     
     try {
-        LOG_INFO("JsonParseWorker: Processing " + QString::number(lines.size()) + " JSON lines");
+        LOG_INFO("JsonParseWorker: Processing " + QString::number(data.size()) + " bytes of JSON lines");
         
-        int totalMatches = 0;
-        int filesWithMatches = 0;
-        int lineNumberCounter = 0;
+        m_totalMatches = 0;
+        m_filesWithMatches = 0;
         int lastProgressUpdate = 0;
         
-        QMap<QString, QPair<QString, int>> fileStats; // filePath -> (elapsed_time, matched_lines)
-        QMap<QString, QString> fileDisplayTexts; // filePath -> displayText
+        if (!parseJsonLines(data, totalMatchedLines, &lastProgressUpdate)) {
+            LOG_INFO("JsonParseWorker: Stopping parsing");
+        }
+        
+        int totalMatches = m_totalMatches;
+        int filesWithMatches = m_filesWithMatches;
         
-        for (int i = 0; i < lines.size(); ++i) {
+        LOG_INFO("JsonParseWorker: Processing completed - " + QString::number(totalMatches) + " matches in " + QString::number(filesWithMatches) + " files");
+        LOG_INFO("JsonParseWorker: Total function time: " + QString::number(functionTimer.elapsed()) + " ms");
+        
+        logMemoryUsage("parseJsonDataInternal - end");
+        
+        // Process any pending Qt events to help with memory cleanup
+        QCoreApplication::processEvents();
+        logMemoryUsage("After processEvents");
+        
+        // Emit completion signal after the last results
+        flushBatch();
+        emit parsingCompleted(totalMatches, filesWithMatches);
+        
+    } catch (const std::exception &e) {
+        LOG_ERROR("JsonParseWorker: Exception in parseJsonDataInternal: " + QString(e.what()));
+        throw;
+    } catch (...) {
+        LOG_ERROR("JsonParseWorker: Unknown exception in parseJsonDataInternal");
+        throw;
+    }
+    
+    LOG_INFO("JsonParseWorker: END - parseJsonDataInternal");
+}
 
-            if (g_currentSearchState == SearchState::STOP) {
-                LOG_INFO("JsonParseWorker: Stopping parsing");
-                break;
-            }
+bool JsonParseWorker::LineDecoder::decode(const char *begin, const char *end, ParsedJsonLine *out)
+{
+    // Fields are read in place from the line bytes, strings are only decoded when needed
+    if (!RgJsonParser::parseLine(begin, end, &record)) {
+        return false;
+    }
+    
+    out->type = record.type;
+    if (record.type == RgJsonRecord::Begin || record.type == RgJsonRecord::Match || record.type == RgJsonRecord::End) {
+        // Consecutive records of one file share the decoded path
+        if (record.path.raw != QByteArrayView(lastPathRaw) || lastPath.isNull()) {
+            lastPathRaw = record.path.raw.toByteArray();
+            lastPath = record.path.toString();
+            lastPathCompressed = CompressedFile::isCompressedPath(lastPath);
+        }
+        out->filePath = lastPath;
+    }
+    
+    if (record.type == RgJsonRecord::Match) {
+        out->lineNumber = int(record.lineNumber);
+        out->column = record.submatches.isEmpty() ? 0 : int(record.submatches.first().start) + 1;
+        // The text is read back from the file when displayed; keep it only if it cannot be
+        // (a decompressed file's offset does not point into the file)
+        out->byteOffset = lastPathCompressed ? -1 : record.absoluteOffset;
+        out->lineLength = int(record.lines.lineByteLength());
+        out->lineText = (out->byteOffset < 0) ? record.lines.toLineBytes() : QByteArray();
+        out->patternMask = record.patternMask;
+    } else if (record.type == RgJsonRecord::End) {
+        out->text = record.statsElapsedHuman.toString();
+        out->matchedLines = int(record.matchedLines);
+    } else if (record.type == RgJsonRecord::Summary) {
+        out->text = record.elapsedTotalHuman.toString();
+        out->matchedLines = int(record.matchedLines);
+        out->searchesWithMatch = int(record.searchesWithMatch);
+        out->bytesSearched = record.bytesSearched;
+    }
+    
+    return true;
+}
 
-            const QString &line = lines[i];
-            if (line.trimmed().isEmpty()) continue;
-            
-            QJsonParseError parseError;
-            QJsonDocument doc = QJsonDocument::fromJson(line.toUtf8(), &parseError);
+bool JsonParseWorker::processJsonLine(const QByteArray &line)
+{
+    ParsedJsonLine parsed;
+    if (!m_decoder.decode(line.constData(), line.constData() + line.size(), &parsed)) {
+        return false;
+    }
+    
+    emitParsedLine(parsed);
+    return true;
+}
+
+void JsonParseWorker::emitParsedLine(const ParsedJsonLine &line)
+{
+    if (line.type == RgJsonRecord::Begin) {
+        m_filesWithMatches++;
+        addToBatch(line);
+        
+    } else if (line.type == RgJsonRecord::Match) {
+        m_totalMatches++;
+        addToBatch(line);
+        
+    } else if (line.type == RgJsonRecord::End) {
+        LOG_INFO("JsonParseWorker: End stats - " + line.filePath + " has " + QString::number(line.matchedLines) + " matches in " + line.text);
+        addToBatch(line);
+        
+    } else if (line.type == RgJsonRecord::Summary && m_streamActive) {
+        // In streaming mode the summary is the last line of the stream, not read up front
+        QString summaryText = QString("📊 Found %1 matches ( files: %2,  scanned: %3 MB,  duration: %4 )")
+            .arg(line.matchedLines)
+            .arg(line.searchesWithMatch)
+            .arg(line.bytesSearched / (1024 * 1024))
+            .arg(line.text);
+        
+        LOG_INFO("JsonParseWorker: Stream summary processed - " + summaryText);
+        flushBatch();
+        emit summaryParsed(summaryText, line.matchedLines);
+    }
+}
+
+void JsonParseWorker::addToBatch(const ParsedJsonLine &line)
+{
+    if (!m_batch) {
+        m_batch.reset(new SearchResultBatch());
+        m_batchAge.start();
+    }
+    
+    int file = m_batch->addFile(line.filePath);
+    if (line.type == RgJsonRecord::Begin) {
+        m_batch->fileBegun[file] = true;
+        // The version of the file being searched - line offsets of the results hold for it only
+        m_batch->fileFingerprint[file] = CachedFileSearcher::fingerprint(line.filePath);
+    } else if (line.type == RgJsonRecord::Match) {
+        m_batch->appendMatch(file, line.lineNumber, line.column, line.byteOffset, line.lineLength, line.lineText,
+                             line.patternMask);
+    } else if (line.type == RgJsonRecord::End) {
+        m_batch->fileEnded[file] = true;
+        m_batch->fileElapsed[file] = line.text;
+        m_batch->fileMatchedLines[file] = line.matchedLines;
+    }
+    
+    // The age check covers long synchronous parses where the timer cannot fire
+    if (m_batch->matchCount() >= m_batchSize || m_batchAge.elapsed() >= m_batchIntervalMs) {
+        flushBatch();
+    } else if (!m_batchTimer->isActive()) {
+        m_batchTimer->start(m_batchIntervalMs);
+    }
+}
+
+void JsonParseWorker::flushBatch()
+{
+    m_batchTimer->stop();
+    if (!m_batch) {
+        return;
+    }
+    
+    // One queued call per block; the receiver only reads it
+    // The stream bytes parsed into it go along for the receiver's backlog
+    m_batch->streamBytes = m_unbatchedBytes;
+    m_unbatchedBytes = 0;
+    SearchResultBatchPtr batch = m_batch;
+    m_batch.reset();
+    emit resultBatchReady(batch);
+}
+
+void JsonParseWorker::updateProgress(int totalMatchedLines, int *lastProgressUpdate)
+{
+    // Update progress every 5% (0, 5, 10, 15, ..., 95, 100)
+    if (totalMatchedLines > 0 && lastProgressUpdate) {
+        int currentProgress = int((qint64(m_totalMatches) * 100) / totalMatchedLines);
+        int progressStep = (currentProgress / 5) * 5;  // Round down to nearest 5%
+        
+        if (progressStep > *lastProgressUpdate) {
+            *lastProgressUpdate = progressStep;
+            // Send progress percentage (0-100) instead of raw counts
+            emit parsingProgress(progressStep, m_filesWithMatches);
+        }
+    }
+}
+
+bool JsonParseWorker::parseJsonLines(const QByteArray &data, int totalMatchedLines, int *lastProgressUpdate)
+{
+    int threadCount = QThread::idealThreadCount();
+    
+    // ===== SMALL INPUT: ONE PASS ON THIS THREAD =====
+    if (data.size() < PARALLEL_PARSE_MIN_BYTES || threadCount < 2) {
+        int parseErrors = 0;
+        for (qsizetype lineStart = 0; lineStart < data.size(); ) {
+            if (m_cancelToken.isCancelled()) {
+                return false;
+            }
             
-            if (parseError.error != QJsonParseError::NoError) {
-                LOG_WARNING("JsonParseWorker: JSON parse error in line " + QString::number(i) + ": " + parseError.errorString());
-                // Explicit cleanup for malformed JSON
-                doc = QJsonDocument();
-                continue;
+            qsizetype lineEnd = data.indexOf('\n', lineStart);
+            if (lineEnd < 0) {
+                lineEnd = data.size();
             }
+            QByteArray line = QByteArray::fromRawData(data.constData() + lineStart, lineEnd - lineStart);
+            lineStart = lineEnd + 1;
             
-            QJsonObject obj = doc.object();
-            QString type = obj[QString("type")].toString();
+            if (line.trimmed().isEmpty()) continue;
             
-            if (type == "begin") {
-                QString filePath = obj[QString("data")][QString("path")][QString("text")].toString();
-                double elapsedTime = obj[QString("data")][QString("elapsed_total_s")].toDouble();
-                
-                // Initialize file stats
-                fileStats[filePath] = qMakePair(QString::number(elapsedTime, 'f', 3), 0);
-                filesWithMatches++;
-                
-                // Create file display text
-                QString displayText = createFileDisplayText(filePath, QString::number(elapsedTime, 'f', 3), 0);
-                fileDisplayTexts[filePath] = displayText;
-                
-                // Emit file item created signal
-                emit fileItemCreated(filePath, displayText);
-                
-            } else if (type == "match") {
-                QString filePath = obj[QString("data")][QString("path")][QString("text")].toString();
-                int lineNumber = obj[QString("data")][QString("line_number")].toInt();
-                QString lineText = obj[QString("data")][QString("lines")][QString("text")].toString().trimmed();
-                
-                totalMatches++;
-                lineNumberCounter++;
-                
-                // Update file stats
-                if (fileStats.contains(filePath)) {
-                    fileStats[filePath].second++;
+            if (!processJsonLine(line)) {
+                parseErrors++;
+                continue;
+            }
+            updateProgress(totalMatchedLines, lastProgressUpdate);
+        }
+        if (parseErrors > 0) {
+            LOG_WARNING("JsonParseWorker: " + QString::number(parseErrors) + " JSON lines could not be parsed");
+        }
+        return true;
+    }
+    
+    // ===== LARGE INPUT: PARSE NEWLINE-ALIGNED CHUNKS ON ALL CORES =====
+    // Chunks are decoded in parallel but emitted strictly in chunk order, so begin/match/end
+    // groups reach the results tree in exactly the order ripgrep wrote them. Only
+    // threadCount chunks are in flight at a time to bound the memory of decoded lines.
+    QElapsedTimer timer;
+    timer.start();
+    
+    qsizetype chunkSize = qBound<qsizetype>(PARALLEL_PARSE_MIN_CHUNK, data.size() / (qsizetype(threadCount) * 4),
+                                            PARALLEL_PARSE_MAX_CHUNK);
+    QVector<QPair<qsizetype, qsizetype>> chunks;
+    for (qsizetype chunkStart = 0; chunkStart < data.size(); ) {
+        qsizetype chunkEnd = qMin(data.size(), chunkStart + chunkSize);
+        if (chunkEnd < data.size()) {
+            qsizetype newline = data.indexOf('\n', chunkEnd);
+            chunkEnd = (newline < 0) ? data.size() : newline + 1;
+        }
+        chunks.append(qMakePair(chunkStart, chunkEnd));
+        chunkStart = chunkEnd;
+    }
+    
+    QVector<QVector<ParsedJsonLine>> parsed(chunks.size());
+    QVector<int> parseErrors(chunks.size(), 0);
+    QVector<bool> started(chunks.size(), false);
+    QScopedArrayPointer<QSemaphore> decoded(new QSemaphore[chunks.size()]);
+    
+    // Pooled threads - a stream parses many small inputs, a thread each would cost more than the work
+    QThreadPool *pool = QThreadPool::globalInstance();
+    SearchCancelToken token = m_cancelToken;
+    auto startChunk = [&](int index) {
+        const char *chunkBegin = data.constData() + chunks[index].first;
+        const char *chunkEnd = data.constData() + chunks[index].second;
+        QVector<ParsedJsonLine> *out = &parsed[index];
+        int *errors = &parseErrors[index];
+        QSemaphore *done = &decoded[index];
+        started[index] = true;
+        pool->start([chunkBegin, chunkEnd, out, errors, token, done]() {
+            LineDecoder decoder;
+            int linesSinceCheck = 0;
+            for (const char *lineStart = chunkBegin; lineStart < chunkEnd; ) {
+                if (++linesSinceCheck == 4096) {
+                    linesSinceCheck = 0;
+                    if (token.isCancelled()) {
+                        break;
+                    }
                 }
                 
-                // Create match display text
-                QString matchDisplayText = createMatchDisplayText(filePath, lineNumber, lineText);
-                
-                // Emit match item created signal
-                emit matchItemCreated(filePath, lineNumber, lineText);
+                const char *newline = static_cast<const char*>(memchr(lineStart, '\n', size_t(chunkEnd - lineStart)));
+                const char *lineEnd = newline ? newline : chunkEnd;
                 
-                // Update progress every 5% (0, 5, 10, 15, ..., 95, 100)
-                if (totalMatchedLines > 0) {
-                    int currentProgress = (lineNumberCounter * 100) / totalMatchedLines;
-                    int progressStep = (currentProgress / 5) * 5;  // Round down to nearest 5%
-                    
-                    if (progressStep > lastProgressUpdate) {
-                        lastProgressUpdate = progressStep;
-                        // Send progress percentage (0-100) instead of raw counts
-                        emit parsingProgress(progressStep, filesWithMatches);
+                const char *first = lineStart;
+                while (first < lineEnd && (*first == ' ' || *first == '\t' || *first == '\r')) {
+                    ++first;
+                }
+                if (first < lineEnd) {
+                    ParsedJsonLine line;
+                    if (decoder.decode(lineStart, lineEnd, &line)) {
+                        if (line.type != RgJsonRecord::Unknown && line.type != RgJsonRecord::Context) {
+                            out->append(line);
+                        }
+                    } else {
+                        (*errors)++;
                     }
                 }
-                
-            } else if (type == "end") {
-                QString filePath = obj[QString("data")][QString("path")][QString("text")].toString();
-                
-                LOG_INFO("JsonParseWorker: Processing 'end' type for file: " + filePath);
-                
-                // Extract elapsed time and matched lines from "end" type JSON
-                QJsonObject statsObj = obj[QString("data")][QString("stats")].toObject();
-                QString elapsedTime = statsObj[QString("elapsed")][QString("human")].toString();
-                int matchedLines = statsObj[QString("matched_lines")].toInt();
-                
-                LOG_INFO("JsonParseWorker: End stats - " + filePath + " has " + QString::number(matchedLines) + " matches in " + elapsedTime);
-                
-                // Emit file stats updated signal with correct data from "end" type
-                emit fileStatsUpdated(filePath, elapsedTime, matchedLines);
+                lineStart = lineEnd + 1;
             }
-            
-            // Explicit JSON object cleanup after processing each line
-            obj = QJsonObject();
-            doc = QJsonDocument();
+            done->release();
+        });
+    };
+    
+    int inFlight = qMin(threadCount, int(chunks.size()));
+    for (int i = 0; i < inFlight; ++i) {
+        startChunk(i);
+    }
+    
+    bool stopped = false;
+    int totalErrors = 0;
+    for (int i = 0; i < chunks.size(); ++i) {
+        if (!started[i]) {
+            continue;  // Not started - the session was cancelled
         }
+        decoded[i].acquire();
         
-        LOG_INFO("JsonParseWorker: Processing completed - " + QString::number(totalMatches) + " matches in " + QString::number(filesWithMatches) + " files");
-        LOG_INFO("JsonParseWorker: Total function time: " + QString::number(functionTimer.elapsed()) + " ms");
-        
-        logMemoryUsage("parseJsonDataInternal - end");
+        if (i + inFlight < chunks.size() && !stopped) {
+            startChunk(i + inFlight);
+        }
         
-        // Process any pending Qt events to help with memory cleanup
-        QApplication::processEvents();
-        logMemoryUsage("After processEvents");
+        if (!stopped && token.isCancelled()) {
+            stopped = true;
+        }
+        if (!stopped) {
+            for (const ParsedJsonLine &line : parsed[i]) {
+                emitParsedLine(line);
+                updateProgress(totalMatchedLines, lastProgressUpdate);
+            }
+        }
+        totalErrors += parseErrors[i];
+        parsed[i] = QVector<ParsedJsonLine>();
+    }
+    
+    if (totalErrors > 0) {
+        LOG_WARNING("JsonParseWorker: " + QString::number(totalErrors) + " JSON lines could not be parsed");
+    }
+    LOG_INFO("JsonParseWorker: Parallel parse of " + QString::number(data.size()) + " bytes in " + QString::number(chunks.size()) +
+             " chunks on " + QString::number(inFlight) + " pooled threads took " + QString::number(timer.elapsed()) + " ms");
+    
+    return !stopped;
+}
+
+void JsonParseWorker::beginStream(const QString &pattern, const QString &searchPath, const SearchCancelToken &token)
+{
+    LOG_INFO("JsonParseWorker: START - beginStream for pattern '" + pattern + "' in " + searchPath +
+             " (session " + QString::number(token.session()) + ")");
+    
+    m_cancelToken = token;
+    m_totalMatches = 0;
+    m_filesWithMatches = 0;
+    m_streamBytes = 0;
+    m_unbatchedBytes = 0;
+    m_streamBuffer.clear();
+    m_streamParseTimer->stop();
+    m_streamActive = true;
+    m_streamTimer.start();
+    
+    loadBatchSettings();
+    m_batch.reset();
+    
+    logMemoryUsage("beginStream");
+    
+    emit parsingStarted();
+}
+
+void JsonParseWorker::parseJsonChunk(const QByteArray &jsonLines)
+{
+    if (!m_streamActive) {
+        return;  // Late chunk after endStream
+    }
+    
+    if (m_cancelToken.isCancelled()) {
+        return;  // Drop output until the stream is closed
+    }
+    
+    m_streamBytes += jsonLines.size();
+    m_unbatchedBytes += jsonLines.size();
+    
+    // Chunks always end on a line boundary (search backends keep partial lines back), so they
+    // can be joined. The timer fires once the chunks queued behind this one are gathered.
+    if (m_streamBuffer.isEmpty()) {
+        m_streamBuffer = jsonLines;
+    } else {
+        m_streamBuffer.append(jsonLines);
+    }
+    if (m_streamBuffer.size() >= STREAM_PARSE_MAX_BYTES) {
+        parseStreamBuffer();
+    } else if (!m_streamParseTimer->isActive()) {
+        m_streamParseTimer->start(0);
+    }
+}
+
+void JsonParseWorker::parseStreamBuffer()
+{
+    m_streamParseTimer->stop();
+    if (m_streamBuffer.isEmpty()) {
+        return;
+    }
+    QByteArray data;
+    data.swap(m_streamBuffer);
+    
+    if (m_cancelToken.isCancelled()) {
+        return;
+    }
+    
+    try {
+        parseJsonLines(data, 0, nullptr);
         
-        // Emit completion signal
-        emit parsingCompleted(totalMatches, filesWithMatches);
+        // Nothing to show in it (e.g. only the summary): the receiver still has to count it consumed
+        if (!m_batch && m_unbatchedBytes > 0) {
+            QSharedPointer<SearchResultBatch> empty(new SearchResultBatch());
+            empty->streamBytes = m_unbatchedBytes;
+            m_unbatchedBytes = 0;
+            emit resultBatchReady(empty);
+        }
         
     } catch (const std::exception &e) {
-        LOG_ERROR("JsonParseWorker: Exception in parseJsonDataInternal: " + QString(e.what()));
-        throw;
+        LOG_ERROR("JsonParseWorker: Exception in parseStreamBuffer: " + QString(e.what()));
+        emit parsingError(QString("Exception: %1").arg(e.what()));
     } catch (...) {
-        LOG_ERROR("JsonParseWorker: Unknown exception in parseJsonDataInternal");
-        throw;
+        LOG_ERROR("JsonParseWorker: Unknown exception in parseStreamBuffer");
+        emit parsingError("Unknown exception occurred");
+    }
+}
+
+void JsonParseWorker::endStream()
+{
+    if (!m_streamActive) {
+        return;
     }
     
-    LOG_INFO("JsonParseWorker: END - parseJsonDataInternal");
+    // Chunks still gathered go before the end of the stream
+    parseStreamBuffer();
+    m_streamActive = false;
+    
+    LOG_INFO("JsonParseWorker: Stream completed - " + QString::number(m_totalMatches) + " matches in " + QString::number(m_filesWithMatches) +
+             " files, " + QString::number(m_streamBytes) + " bytes in " + QString::number(m_streamTimer.elapsed()) + " ms");
+    logMemoryUsage("endStream");
+    
+    flushBatch();
+    emit parsingCompleted(m_totalMatches, m_filesWithMatches);
+    
+    LOG_INFO("JsonParseWorker: END - endStream");
 }
 
-QString JsonParseWorker::createFileDisplayText(const QString &filePath, const QString &elapsedTime, int matchedLines)
+void JsonParseWorker::parseFileMatches(const QByteArray &jsonLines, const SearchCancelToken &token)
 {
-    QFileInfo fileInfo(filePath);
-    QString fileName = fileInfo.fileName();
-    QString directory = fileInfo.absolutePath();
+    if (token.isCancelled()) {
+        return;
+    }
     
-    QString displayText = QString("📄 %1 (%2 matches, %3s)").arg(fileName).arg(matchedLines).arg(elapsedTime);
-    return displayText;
+    try {
+        // The file row and its counted stats exist already - only the matches are added
+        QSharedPointer<SearchResultBatch> batch(new SearchResultBatch());
+        LineDecoder decoder;
+        ParsedJsonLine parsed;
+        
+        const char *data = jsonLines.constData();
+        const char *end = data + jsonLines.size();
+        for (const char *lineStart = data; lineStart < end; ) {
+            const char *lineEnd = static_cast<const char*>(memchr(lineStart, '\n', size_t(end - lineStart)));
+            if (!lineEnd) {
+                lineEnd = end;
+            }
+            if (decoder.decode(lineStart, lineEnd, &parsed) && parsed.type == RgJsonRecord::Match) {
+                batch->appendMatch(batch->addFile(parsed.filePath), parsed.lineNumber, parsed.column,
+                                   parsed.byteOffset, parsed.lineLength, parsed.lineText, parsed.patternMask);
+            }
+            lineStart = lineEnd + 1;
+        }
+        
+        if (batch->matchCount() > 0) {
+            emit fileBatchReady(batch, token);
+        }
+        
+    } catch (const std::exception &e) {
+        LOG_ERROR("JsonParseWorker: Exception in parseFileMatches: " + QString(e.what()));
+    } catch (...) {
+        LOG_ERROR("JsonParseWorker: Unknown exception in parseFileMatches");
+    }
 }
 
-QString JsonParseWorker::createMatchDisplayText(const QString &filePath, int lineNumber, const QString &lineText)
+void JsonParseWorker::abortStream()
 {
-    QString displayText = QString("Line %1: %2").arg(lineNumber).arg(lineText);
-    return displayText;
+    if (m_streamActive) {
+        LOG_INFO("JsonParseWorker: Stream aborted after " + QString::number(m_totalMatches) + " matches, " +
+                 QString::number(m_streamBytes) + " bytes in " + QString::number(m_streamTimer.elapsed()) + " ms");
+    }
+    
+    m_streamActive = false;
+    m_batchTimer->stop();
+    m_batch.reset();
+    m_unbatchedBytes = 0;
+    m_streamBuffer.clear();
+    m_streamParseTimer->stop();
+    
+    emit streamAborted();
 }
@@ -3,6 +3,14 @@
 
 #include <QObject>
 #include <QString>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QSharedPointer>
+#include "RgJsonParser.h"
+#include "SearchResultStore.h"
+#include "SearchCancelToken.h"
+
+class QTimer;
 
 class JsonParseWorker : public QObject
 {
@@ -12,23 +20,112 @@ public:
     explicit JsonParseWorker(QObject *parent = nullptr);
 
 public slots:
-    void parseJsonData(const QString &pattern, const QString &jsonData, const QString &searchPath);
+    // Parsing stops early once token is cancelled (parsingCompleted is still emitted)
+    void parseJsonData(const QString &pattern, const QString &jsonData, const QString &searchPath,
+                       const SearchCancelToken &token);
+    
+    // Streaming mode: called once per search, then once per block of complete JSON lines, then at the end.
+    // Chunks of a cancelled session are dropped until the stream is closed.
+    void beginStream(const QString &pattern, const QString &searchPath, const SearchCancelToken &token);
+    void parseJsonChunk(const QByteArray &jsonLines);
+    void endStream();
+    
+    // Drop the open stream without completing it (a replaced live search)
+    void abortStream();
+    
+    // Match records of one file searched after its matches were only counted - independent of the
+    // stream, published as one batch through fileBatchReady
+    void parseFileMatches(const QByteArray &jsonLines, const SearchCancelToken &token);
 
 signals:
     void parsingStarted();
     void parsingProgress(int percentage, int files);
     void parsingCompleted(int totalMatches, int totalFiles);
     void parsingError(const QString &error);
-    void fileItemCreated(const QString &filePath, const QString &displayText);
-    void matchItemCreated(const QString &filePath, int lineNumber, const QString &lineText);
-    void fileStatsUpdated(const QString &filePath, const QString &elapsedTime, int matchedLines);
+    // Files, matches and file stats in blocks of up to [RGSearch] ResultBatchSize matches,
+    // published at least every ResultBatchIntervalMs while results arrive
+    void resultBatchReady(const SearchResultBatchPtr &batch);
     void summaryParsed(const QString &summaryText, int totalMatchedLines);
+    // Emitted by abortStream after everything of the aborted stream
+    void streamAborted();
+    void fileBatchReady(const SearchResultBatchPtr &batch, const SearchCancelToken &token);
 
 private:
-    QString parseRGSummary(const QStringList &lines, int* outMatchedLines = nullptr);
-    void parseJsonDataInternal(const QStringList &lines, const QString &pattern, int totalMatchedLines = 0);
-    QString createFileDisplayText(const QString &filePath, const QString &elapsedTime = QString(), int matchedLines = 0);
-    QString createMatchDisplayText(const QString &filePath, int lineNumber, const QString &lineText);
+    QString parseRGSummary(const QByteArray &data, int* outMatchedLines = nullptr);
+    void parseJsonDataInternal(const QByteArray &data, const QString &pattern, int totalMatchedLines = 0);
+    // One decoded ripgrep record, ready to be emitted
+    struct ParsedJsonLine {
+        RgJsonRecord::Type type = RgJsonRecord::Unknown;
+        QString filePath;
+        QString text;               // End: file elapsed, Summary: total elapsed
+        int lineLength = 0;         // Match: bytes of the line without its terminator
+        QByteArray lineText;        // Match: UTF-8 line text, only kept without an absolute offset
+        int lineNumber = 0;
+        int column = 0;             // Match: 1-based byte column of the first submatch
+        qint64 byteOffset = -1;     // Match: offset of the line in the file
+        quint64 patternMask = 0;    // Match: patterns of a batch search that matched the line
+        int matchedLines = 0;
+        int searchesWithMatch = 0;
+        qint64 bytesSearched = 0;   // Summary: bytes scanned in all
+    };
+    
+    // Per-thread decoding state (parser record and the last decoded path)
+    struct LineDecoder {
+        RgJsonRecord record;
+        QByteArray lastPathRaw;
+        QString lastPath;
+        bool lastPathCompressed = false;    // Offsets are into the decompressed stream
+        bool decode(const char *begin, const char *end, ParsedJsonLine *out);
+    };
+    
+    // Handle a single ripgrep JSON line (begin / match / end / summary), returns false on malformed JSON
+    bool processJsonLine(const QByteArray &line);
+    void emitParsedLine(const ParsedJsonLine &line);
+    
+    // Parse and emit all lines of data - large inputs are decoded on all cores and emitted in order.
+    // Returns false when the search was stopped.
+    bool parseJsonLines(const QByteArray &data, int totalMatchedLines, int *lastProgressUpdate);
+    void updateProgress(int totalMatchedLines, int *lastProgressUpdate);
+    
+    static constexpr qsizetype PARALLEL_PARSE_MIN_BYTES = 4 * 1024 * 1024;   // Below this one thread is faster
+    static constexpr qsizetype STREAM_PARSE_MAX_BYTES = 16 * 1024 * 1024;    // Stream bytes gathered at most
+    static constexpr qsizetype PARALLEL_PARSE_MIN_CHUNK = 1 * 1024 * 1024;
+    static constexpr qsizetype PARALLEL_PARSE_MAX_CHUNK = 16 * 1024 * 1024;
+    
+    LineDecoder m_decoder;
+    
+    // Result batching
+    void loadBatchSettings();
+    void addToBatch(const ParsedJsonLine &line);
+    void flushBatch();
+    
+    static constexpr int DEFAULT_RESULT_BATCH_SIZE = 2000;
+    static constexpr int DEFAULT_RESULT_BATCH_INTERVAL_MS = 50;
+    
+    QSharedPointer<SearchResultBatch> m_batch;
+    QElapsedTimer m_batchAge;       // Time since the first record of m_batch
+    QTimer *m_batchTimer;           // Publishes a partial batch when the stream goes quiet
+    int m_batchSize;
+    int m_batchIntervalMs;
+    
+    // Counters shared by the batch and streaming paths
+    int m_totalMatches;
+    int m_filesWithMatches;
+    
+    // Session being parsed
+    SearchCancelToken m_cancelToken;
+    
+    // Streaming state
+    bool m_streamActive;
+    qint64 m_streamBytes;
+    qint64 m_unbatchedBytes;        // Stream bytes parsed since the last batch went out
+    
+    // Chunks not parsed yet: those queued behind each other are parsed in one pass, on all
+    // cores once they reach PARALLEL_PARSE_MIN_BYTES
+    QByteArray m_streamBuffer;
+    QTimer *m_streamParseTimer;     // Parses m_streamBuffer once the queued chunks are in
+    void parseStreamBuffer();
+    QElapsedTimer m_streamTimer;
     
     // Memory tracking
     void logMemoryUsage(const QString& stage);
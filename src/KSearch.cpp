@@ -7,6 +7,9 @@ SearchState g_currentSearchState = SearchState::IDLE;
 #include "KSearchBun.h"
 #include "scintillaedit.h"
 #include "LogDataWorker.h"
+#include "filesearcher.h"
+#include "BatchFileSearcher.h"
+#include "ProximityFileSearcher.h"
 #include <QProcess>
 #include <QThread>
 #include <QElapsedTimer>
@@ -35,7 +38,28 @@ SearchState g_currentSearchState = SearchState::IDLE;
 KSearch::KSearch(MainWindow* mainWindow, QObject* parent)
     : QObject(parent)
     , m_mainSearch(mainWindow)
+    , m_liveSearchTimer(new QTimer(this))
+    , m_liveSearchEnabled(false)
+    , m_liveSearchDelayMs(250)
+    , m_liveSearchMinChars(3)
+    , m_liveSearchRunning(false)
+    , m_streamSession(0)
+    , m_resultsComplete(false)
+    , m_resultsTruncated(false)
+    , m_narrowBaseValid(false)
 {
+    QSettings settings("app.ini", QSettings::IniFormat);
+    settings.beginGroup("RGSearch");
+    m_liveSearchEnabled = settings.value("LiveSearch", false).toBool();
+    m_liveSearchDelayMs = settings.value("LiveSearchDelayMs", 250).toInt();
+    m_liveSearchMinChars = settings.value("LiveSearchMinChars", 3).toInt();
+    settings.endGroup();
+    
+    m_liveSearchTimer->setSingleShot(true);
+    connect(m_liveSearchTimer, &QTimer::timeout, this, &KSearch::KSsearchLive);
+    
+    LOG_INFO("KSearch: Live search " + QString(m_liveSearchEnabled ? "enabled" : "disabled") + " (delay " +
+             QString::number(m_liveSearchDelayMs) + " ms, min " + QString::number(m_liveSearchMinChars) + " chars)");
 }
 
 // Destructor
@@ -55,6 +79,12 @@ void KSearch::KSsearchDo()
         return;
     }
     
+    // An explicit search replaces any pending or running live search
+    m_liveSearchTimer->stop();
+    if (m_liveSearchRunning) {
+        cancelLiveSearch();
+    }
+    
     // Get search parameters
     QString pattern = m_mainSearch->patternEdit->text().trimmed();
     QString path = m_mainSearch->pathEdit->text().trimmed();
@@ -88,7 +118,11 @@ void KSearch::KSsearchDo()
     // Update search state
     updateSearchState(SearchState::SEARCHING);
     
+    // The previous session is over - its stages stop and its late output is dropped
+    m_cancelToken.cancel();
+    
     // Perform cleanup before search
+    m_resultsComplete = false;
     KCompleteCleanUp();
     
     // Add to history
@@ -110,16 +144,32 @@ void KSearch::KSsearchDo()
     QElapsedTimer displayTimer;
     displayTimer.start();
     
+    QString engine = selectedEngine();
+    
+    // Streaming mode: search output is parsed and displayed while the search is still running
+    // (the in-process engines always stream)
+    if ((m_mainSearch->m_searchBun->isStreamingMode() || engine != "ripgrep") && m_mainSearch->collapsibleSearchResults) {
+        startStreamingSearch(params, engine, false);
+        
+        LOG_INFO("KSsearchDo: Streaming search started in " + QString::number(displayTimer.elapsed()) + " ms");
+        qint64 totalTime = m_functionTimer.elapsed();
+        LOG_INFO("KSsearchDo: Total function time: " + QString::number(totalTime) + " ms");
+        logFunctionEnd("KSsearchDo");
+        return;
+    }
+    
     
     // Stage 1: Perform asynch ripgrep search and chain to addSearchResults
+    SearchCancelToken token = newSearchSession();
+    
     // Disconnect any existing connections to prevent multiple calls
     disconnect(m_mainSearch->m_searchBun, &KSearchBun::asyncSearchCompleted, this, nullptr);
     
     connect(m_mainSearch->m_searchBun, &KSearchBun::asyncSearchCompleted, 
-            this, [this, params](const QString &rawOutput) {
+            this, [this, params, token](const QString &rawOutput) {
 
         // Check if search was stopped
-        if (m_mainSearch->m_currentState == SearchState::STOP) {
+        if (token.isCancelled()) {
         updateSearchState(SearchState::IDLE);
             LOG_INFO("KSsearchDo: Search was stopped, not continuing with search results processing");
             qint64 totalTime = m_functionTimer.elapsed();
@@ -134,11 +184,11 @@ void KSearch::KSsearchDo()
             
         // Stage 2: Display JSON results directly
         // Call addSearchResults asynchronously
-        QMetaObject::invokeMethod(this, [this, params, rawOutput]() {
+        QMetaObject::invokeMethod(this, [this, params, rawOutput, token]() {
             if (m_mainSearch->collapsibleSearchResults) {
 
                 // Check if search was stopped before parsing
-                if (m_mainSearch->m_currentState == SearchState::STOP) {
+                if (token.isCancelled()) {
                     LOG_INFO("KSsearchDo: Search was stopped, not continuing with parsing");
                     updateSearchState(SearchState::IDLE);
         return;
@@ -147,7 +197,7 @@ void KSearch::KSsearchDo()
                 LOG_INFO("KSsearchDo: Setting button to Processing");
             	updateSearchState(SearchState::PARSING_MAIN_SEARCH);
             
-                m_mainSearch->collapsibleSearchResults->addSearchResults(params.pattern, rawOutput, params.path);
+                m_mainSearch->collapsibleSearchResults->addSearchResults(params.pattern, rawOutput, params.path, token);
                  // Note: State transition to IDLE will be handled by onParsingCompleted signal
                 LOG_INFO("KSsearchDo: addSearchResults called, waiting for parsing completion signal");
 
@@ -164,7 +214,7 @@ void KSearch::KSsearchDo()
     }, Qt::QueuedConnection);
     
     LOG_INFO("KSsearchDo: About to enter K_RGresults_method3_async at " + QString::number(displayTimer.elapsed()) + " ms");
-    m_mainSearch->m_searchBun->K_RGresults_method3_async(params);
+    m_mainSearch->m_searchBun->K_RGresults_method3_async(params, token);
 
  //   QString rawOutput = m_mainSearch->m_searchBun->K_RGresults_method3(params);
     
@@ -193,6 +243,368 @@ void KSearch::KSsearchDo()
     logFunctionEnd("KSsearchDo");
 }
 
+QString KSearch::selectedEngine() const
+{
+    // Search backend from Preferences -> Search Engine, falls back to ripgrep if not available
+    QString engine = m_mainSearch->m_searchEngine;
+    if (!FileSearcher::isEngineAvailable(engine)) {
+        LOG_WARNING("KSearch: Search engine '" + engine + "' not available in this build, using ripgrep");
+        engine = "ripgrep";
+    }
+    return engine;
+}
+
+void KSearch::KSsearchBatch(const QString &patternFile)
+{
+    m_functionTimer.start();
+    m_totalSearchTimer.start();
+    logFunctionStart("KSsearchBatch");
+    
+    if (!m_mainSearch->pathEdit || !m_mainSearch->collapsibleSearchResults) {
+        LOG_ERROR("KSsearchBatch: UI elements not available");
+        return;
+    }
+    
+    m_liveSearchTimer->stop();
+    if (m_liveSearchRunning) {
+        cancelLiveSearch();
+    }
+    
+    QString path = m_mainSearch->pathEdit->text().trimmed();
+    if (!QDir(path).exists()) {
+        QMessageBox::warning(m_mainSearch, "Warning", "Please select a valid path.");
+        LOG_WARNING("KSsearchBatch: Invalid path: " + path);
+        logFunctionEnd("KSsearchBatch");
+        return;
+    }
+    
+    QVector<NamedSearchPattern> patterns;
+    QString error;
+    if (!BatchFileSearcher::loadPatternList(patternFile, &patterns, &error)) {
+        QMessageBox::warning(m_mainSearch, "Batch Search", error);
+        LOG_WARNING("KSsearchBatch: " + error);
+        logFunctionEnd("KSsearchBatch");
+        return;
+    }
+    
+    if (m_mainSearch->m_currentState == SearchState::ERROR) {
+        LOG_INFO("KSsearchBatch: Resetting ERROR state to IDLE for new search");
+        updateSearchState(SearchState::IDLE);
+    }
+    updateSearchState(SearchState::SEARCHING);
+    
+    m_cancelToken.cancel();
+    m_resultsComplete = false;
+    KCompleteCleanUp();
+    addToPathHistory(path);
+    
+    // The header names the list; the search itself is over the combined pattern
+    RGSearchParams params = m_mainSearch->m_searchBun->getCurrentSearchParams();
+    params.path = path;
+    params.pattern = QFileInfo(patternFile).fileName() + " (" + QString::number(patterns.size()) + " patterns)";
+    m_mainSearch->m_searchBun->updateSearchParams(params);
+    
+    // Batch searches always stream - attribution works on the streamed records
+    startStreamingSearch(params, selectedEngine(), false, patterns);
+    
+    LOG_INFO("KSsearchBatch: " + QString::number(patterns.size()) + " patterns from " + patternFile +
+             " started in " + QString::number(m_functionTimer.elapsed()) + " ms");
+    logFunctionEnd("KSsearchBatch");
+}
+
+void KSearch::KSsearchProximity(const ProximityQuery &query)
+{
+    m_functionTimer.start();
+    m_totalSearchTimer.start();
+    logFunctionStart("KSsearchProximity");
+    
+    if (!m_mainSearch->pathEdit || !m_mainSearch->collapsibleSearchResults) {
+        LOG_ERROR("KSsearchProximity: UI elements not available");
+        return;
+    }
+    
+    m_liveSearchTimer->stop();
+    if (m_liveSearchRunning) {
+        cancelLiveSearch();
+    }
+    
+    QString path = m_mainSearch->pathEdit->text().trimmed();
+    if (!QDir(path).exists()) {
+        QMessageBox::warning(m_mainSearch, "Warning", "Please select a valid path.");
+        LOG_WARNING("KSsearchProximity: Invalid path: " + path);
+        logFunctionEnd("KSsearchProximity");
+        return;
+    }
+    if (query.terms.size() < 2) {
+        QMessageBox::warning(m_mainSearch, "Proximity Search", "Please enter at least two terms.");
+        LOG_WARNING("KSsearchProximity: Fewer than two terms");
+        logFunctionEnd("KSsearchProximity");
+        return;
+    }
+    
+    if (m_mainSearch->m_currentState == SearchState::ERROR) {
+        LOG_INFO("KSsearchProximity: Resetting ERROR state to IDLE for new search");
+        updateSearchState(SearchState::IDLE);
+    }
+    updateSearchState(SearchState::SEARCHING);
+    
+    m_cancelToken.cancel();
+    m_resultsComplete = false;
+    KCompleteCleanUp();
+    addToPathHistory(path);
+    
+    RGSearchParams params = m_mainSearch->m_searchBun->getCurrentSearchParams();
+    params.path = path;
+    params.pattern = ProximityFileSearcher::describe(query);
+    m_mainSearch->m_searchBun->updateSearchParams(params);
+    
+    startStreamingSearch(params, selectedEngine(), false, QVector<NamedSearchPattern>(), query);
+    
+    LOG_INFO("KSsearchProximity: '" + params.pattern + "' started in " + QString::number(m_functionTimer.elapsed()) + " ms");
+    logFunctionEnd("KSsearchProximity");
+}
+
+void KSearch::startStreamingSearch(const RGSearchParams &params, const QString &engine, bool live,
+                                   const QVector<NamedSearchPattern> &batchPatterns, const ProximityQuery &proximity)
+{
+    KSearchBun *searchBun = m_mainSearch->m_searchBun;
+    CollapsibleSearchResults *results = m_mainSearch->collapsibleSearchResults;
+    
+    // The results on screen become the narrowing base before they are cleared
+    if (m_resultsComplete) {
+        captureNarrowBase();
+    }
+    m_resultsComplete = false;
+    bool batch = !batchPatterns.isEmpty();
+    bool near = !proximity.terms.isEmpty();
+    bool refine = live && !batch && !near && m_narrowBaseValid && isNarrowerSearch(m_narrowBaseParams, params);
+    
+    disconnect(searchBun, &KSearchBun::searchOutputChunk, nullptr, nullptr);
+    disconnect(searchBun, &KSearchBun::searchStreamFinished, this, nullptr);
+    disconnect(m_streamCompletedConnection);
+    disconnect(searchBun, &KSearchBun::searchBudgetReached, this, nullptr);
+    disconnect(searchBun, &KSearchBun::fileSearchOutputChunk, nullptr, nullptr);
+    disconnect(results, &CollapsibleSearchResults::fileMatchesRequested, this, nullptr);
+    
+    // Output of a replaced search may still be queued - it carries an older session
+    SearchCancelToken token = newSearchSession();
+    quint64 session = token.session();
+    m_liveSearchRunning = live;
+    
+    connect(searchBun, &KSearchBun::searchOutputChunk, results, [this, results, session](const QByteArray &jsonLines) {
+        if (session == m_streamSession) {
+            results->appendStreamingChunk(jsonLines);
+        }
+    });
+    connect(searchBun, &KSearchBun::searchStreamFinished, this, [this, results, session](int exitCode) {
+        if (session != m_streamSession) {
+            return;
+        }
+        LOG_INFO("KSearch: Search stream finished with exit code " + QString::number(exitCode));
+        
+        // A stopped search still closes the stream - MainWindow::onParsingCompleted returns to IDLE
+        if (m_mainSearch->m_currentState != SearchState::STOP) {
+            updateSearchState(SearchState::PARSING_MAIN_SEARCH);
+        }
+        results->finishStreamingResults();
+    });
+    m_resultsTruncated = false;
+    connect(searchBun, &KSearchBun::searchBudgetReached, this, [this, session](int matches) {
+        if (session != m_streamSession) {
+            return;
+        }
+        m_resultsTruncated = true;
+        LOG_INFO("KSearch: Result budget reached, showing the first " + QString::number(matches) + " matches");
+        m_mainSearch->statusBar()->showMessage(QString("Showing the first %1 matches - search stopped at the result limit").arg(matches), 10000);
+    });
+    
+    // Counted files are searched for their matches when they are expanded
+    connect(results, &CollapsibleSearchResults::fileMatchesRequested, this, [this, token](const QString &filePath) {
+        if (!token.isCancelled()) {
+            m_mainSearch->m_searchBun->K_FSresults_file(filePath, selectedEngine(), token);
+        }
+    });
+    connect(searchBun, &KSearchBun::fileSearchOutputChunk, results, [results](const QByteArray &jsonLines, const SearchCancelToken &fileToken) {
+        results->appendFileMatches(jsonLines, fileToken);
+    });
+    
+    m_streamCompletedConnection = connect(results, &CollapsibleSearchResults::parsingCompleted,
+                                          this, [this, session, token, params, searchBun, batch, near](int totalMatches, int totalFiles) {
+        Q_UNUSED(totalMatches)
+        Q_UNUSED(totalFiles)
+        if (session != m_streamSession) {
+            return;
+        }
+        m_liveSearchRunning = false;
+        // Only complete results can be narrowed later - not counts, nor results cut by a budget
+        m_resultsComplete = !batch && !near && !token.isCancelled() && !m_resultsTruncated && !searchBun->isCountOnlyFirst() &&
+                            searchBun->maxMatchesPerFile() == 0;
+        m_resultsParams = params;
+    });
+    
+    QStringList groupNames;
+    QStringList groupPatterns;
+    for (const NamedSearchPattern &named : batchPatterns) {
+        groupNames << named.name;
+        groupPatterns << named.pattern;
+    }
+    results->setPatternGroups(groupNames, groupPatterns);
+    
+    results->beginStreamingResults(params.pattern, params.path, token);
+    if (batch) {
+        searchBun->K_FSresults_batch(params, batchPatterns, engine, token);
+    } else if (near) {
+        searchBun->K_FSresults_proximity(params, proximity, engine, token);
+    } else if (refine) {
+        LOG_INFO("KSearch: '" + params.pattern + "' narrows '" + m_narrowBaseParams.pattern + "' - searching only its matched lines");
+        searchBun->K_FSresults_refine(params, new RefineFileSearcher(m_narrowBaseLines), token);
+    } else {
+        searchBun->K_FSresults_stream(params, engine, token);
+    }
+    results->setFlowControl(searchBun->streamFlowControl());
+}
+
+void KSearch::onPatternEdited(const QString &text)
+{
+    Q_UNUSED(text)
+    if (!m_liveSearchEnabled) {
+        return;
+    }
+    
+    // The search for the previous text is outdated now
+    if (m_liveSearchRunning) {
+        cancelLiveSearch();
+    }
+    m_liveSearchTimer->start(m_liveSearchDelayMs);
+}
+
+void KSearch::KSsearchLive()
+{
+    if (!m_mainSearch->patternEdit || !m_mainSearch->pathEdit || !m_mainSearch->collapsibleSearchResults) {
+        return;
+    }
+    
+    QString pattern = m_mainSearch->patternEdit->text().trimmed();
+    QString path = m_mainSearch->pathEdit->text().trimmed();
+    if (pattern.size() < m_liveSearchMinChars || !QDir(path).exists()) {
+        LOG_INFO("KSsearchLive: Skipped for pattern '" + pattern + "'");
+        return;
+    }
+    
+    // A search the user started is never replaced by a speculative one
+    if (m_mainSearch->m_isSearching && !m_liveSearchRunning) {
+        LOG_INFO("KSsearchLive: Search in progress, live search skipped");
+        return;
+    }
+    if (m_liveSearchRunning) {
+        cancelLiveSearch();
+    }
+    
+    m_totalSearchTimer.start();
+    LOG_INFO("KSsearchLive: Live search for '" + pattern + "' in " + path);
+    
+    RGSearchParams params = m_mainSearch->m_searchBun->getCurrentSearchParams();
+    params.path = path;
+    params.pattern = pattern;
+    m_mainSearch->m_searchBun->updateSearchParams(params);
+    
+    if (m_mainSearch->m_currentState == SearchState::ERROR) {
+        updateSearchState(SearchState::IDLE);
+    }
+    updateSearchState(SearchState::SEARCHING);
+    
+    startStreamingSearch(params, selectedEngine(), true);
+}
+
+SearchCancelToken KSearch::newSearchSession()
+{
+    m_cancelToken.cancel();
+    m_cancelToken = SearchCancelToken::create(++m_streamSession);
+    return m_cancelToken;
+}
+
+void KSearch::cancelLiveSearch()
+{
+    LOG_INFO("KSearch: Cancelling live search");
+    
+    newSearchSession();
+    m_liveSearchRunning = false;
+    m_resultsComplete = false;
+    disconnect(m_streamCompletedConnection);
+    
+    m_mainSearch->m_searchBun->cancelStreamSearch();
+    if (m_mainSearch->collapsibleSearchResults) {
+        m_mainSearch->collapsibleSearchResults->abortStreamingResults();
+    }
+    updateSearchState(SearchState::IDLE);
+}
+
+bool KSearch::isNarrowerSearch(const RGSearchParams &base, const RGSearchParams &next)
+{
+    if (base.path != next.path || base.incl_exclude != next.incl_exclude ||
+        base.case_sensitive != next.case_sensitive || base.ignore_case != next.ignore_case ||
+        base.smart_case != next.smart_case) {
+        return false;
+    }
+    
+    // Lines of another time window or another set of files (compressed ones) are not in the base
+    if (base.time_from.trimmed() != next.time_from.trimmed() || base.time_to.trimmed() != next.time_to.trimmed() ||
+        base.search_compressed != next.search_compressed) {
+        return false;
+    }
+    
+    // add_pattern is OR'ed in, so its matches would not narrow
+    if (!base.add_pattern.isEmpty() || !next.add_pattern.isEmpty()) {
+        return false;
+    }
+    
+    static const QRegularExpression regexSyntax("[\\\\.^$|?*+()\\[\\]{}]");
+    auto isLiteral = [](const RGSearchParams &params) {
+        return params.fixed_string || !params.pattern.contains(regexSyntax);
+    };
+    if (!isLiteral(base) || !isLiteral(next)) {
+        return false;
+    }
+    
+    // With smart case an uppercase letter added to a lowercase pattern only makes next stricter
+    bool caseless = !base.case_sensitive &&
+                    (base.ignore_case || (base.smart_case && base.pattern.toLower() == base.pattern));
+    return next.pattern.contains(base.pattern, caseless ? Qt::CaseInsensitive : Qt::CaseSensitive);
+}
+
+void KSearch::captureNarrowBase()
+{
+    m_narrowBaseValid = false;
+    m_narrowBaseLines.clear();
+    
+    const SearchResultStore &store = m_mainSearch->collapsibleSearchResults->resultStore();
+    if (store.matchCount() > LIVE_NARROW_MAX_LINES) {
+        LOG_INFO("KSearch: " + QString::number(store.matchCount()) + " results are too many to narrow live searches to");
+        return;
+    }
+    
+    for (int fileId = 0; fileId < store.fileCount(); ++fileId) {
+        QVector<RefineFileSearcher::PreviousLine> lines;
+        lines.reserve(store.fileMatchCount(fileId));
+        for (int index = 0; index < store.fileMatchCount(fileId); ++index) {
+            int row = store.fileMatchRow(fileId, index);
+            if (store.byteOffset(row) < 0) {
+                m_narrowBaseLines.clear();  // Lines without an offset cannot be read back
+                return;
+            }
+            RefineFileSearcher::PreviousLine line;
+            line.offset = store.byteOffset(row);
+            line.length = store.lineLength(row);
+            line.lineNumber = store.lineNumber(row);
+            lines.append(line);
+        }
+        m_narrowBaseLines.insert(store.filePath(fileId), lines);
+    }
+    
+    m_narrowBaseParams = m_resultsParams;
+    m_narrowBaseValid = true;
+}
+
 void KSearch::setSearchButton(SearchButtonState state)
 {
     m_functionTimer.start();
@@ -1174,56 +1586,42 @@ void KSearch::stopSearch()
         // Set search state to STOP
         LOG_INFO("stopSearch: Setting search state to STOP");
         updateSearchState(SearchState::STOP);
-
-
+        
+        // ===== CANCEL THE SESSION =====
+        // Search, parse and map stages stop at their next check - nothing here waits for them.
+        // A stopped search leaves incomplete results, and no live search may start from a pending edit.
+        m_cancelToken.cancel();
+        m_liveSearchTimer->stop();
         
         // ===== STATUS UPDATES =====
         // Update status file to "STOP" state
         LOG_INFO("stopSearch: Updating status file to STOP state");
         m_mainSearch->writeStatusFile("STOP", 0, "Search stopped by user");
         
- //       setSearchButton(SearchButtonState::IDLE);
-        
         // Update status bar
         m_mainSearch->statusBar()->showMessage("Search stopped", 3000);
-
- /*       
+        
         // Stop background highlighting via fileContentView
         if (m_mainSearch->fileContentView) {
-            LOG_INFO("stopSearch: Stopping file highlighting via fileContentView->stopBackgroundHighlighting()");
             m_mainSearch->fileContentView->stopBackgroundHighlighting();
         }
-       
-
-
-        // Stop any running worker threads
-        LOG_INFO("stopSearch: Stopping any running worker threads");
-        // TODO: Implement worker thread cleanup
-        // This will stop LogDataWorker and other background threads
-        
-*/         
-        // ===== TERMINATE RIPGREP PROCESSES =====
-        // Kill search process through KSearchBun
-        LOG_INFO("KSearch: stopSearch - Terminating running ripgrep processes");
-
-        // Kill search process using dedicated function if the process exists
-        KKillProcess(m_mainSearch->m_searchBun->m_currentSearchProcess, "Search Process");
-  /*      
-        // Kill parse thread using dedicated function if it exists
-        if (m_mainSearch->collapsibleSearchResults) {
-            QThread* parseThread = m_mainSearch->collapsibleSearchResults->getParseThread();
-            if (parseThread) {
-                KKillThread(parseThread, "Parse Thread");
-                m_mainSearch->collapsibleSearchResults->resetParseThread();
-                LOG_INFO("KSearch: Parse thread and worker killed");
-            }
-        }
-*/
         
-
-        LOG_INFO("KSearch: stopSearch - All processes terminated");
-    
-
+        // ===== DETACH RUNNING SEARCHES =====
+        // Streaming searches are cancelled and detached (rg is killed, in-process engines return at
+        // their next check and delete themselves); method3 and KMap rg processes are killed
+        LOG_INFO("KSearch: stopSearch - Cancelling running searches");
+        m_mainSearch->m_searchBun->cancelStreamSearch();
+        m_mainSearch->m_searchBun->killSearchProcesses();
+        
+        // ===== BACK TO IDLE =====
+        // An open results stream is closed right away: the parser drops the rest of the session and
+        // parsingCompleted returns the window to IDLE. Without one there is nothing left to wait for.
+        CollapsibleSearchResults *results = m_mainSearch->collapsibleSearchResults;
+        if (results && results->isParsing()) {
+            results->finishStreamingResults();
+        } else {
+            updateSearchState(SearchState::IDLE);
+        }
         
         LOG_INFO("stopSearch: Comprehensive cleanup completed successfully");
         
@@ -29,7 +29,10 @@
 #include <QRegularExpressionMatch>
 #include <QMetaObject>
 #include <QMutexLocker>
+#include <QTimer>
+#include <atomic>
 #include "KSearchBun.h"  // For RGSearchParams
+#include "RefineFileSearcher.h"
 #include "highlightdialog.h"  // For HighlightRule
 
 // Forward declarations
@@ -76,6 +79,17 @@ public:
 
     // Main search workflow functions
     void KSsearchDo();
+    
+    // Search the path for every pattern of a list file in one pass, results grouped by pattern
+    void KSsearchBatch(const QString &patternFile);
+    
+    // Files where all terms of query occur (within N lines / in order), only their clusters shown
+    void KSsearchProximity(const ProximityQuery &query);
+    
+    // Search-as-you-type ([RGSearch] LiveSearch): pattern edits are debounced by LiveSearchDelayMs,
+    // the search is started speculatively and cancelled again by the next edit
+    void onPatternEdited(const QString &text);
+    void KSsearchLive();
 
     // Button and UI state management
     void setSearchButton(SearchButtonState state);
@@ -128,9 +142,54 @@ public:
 
 
 private:
+    // Search backend from Preferences, ripgrep if the selected one is not available
+    QString selectedEngine() const;
+    
+    // Streaming search into the results tree; live searches narrow the last complete results when they can
+    // (batch searches are grouped by pattern; batch and proximity searches are never narrowed)
+    void startStreamingSearch(const RGSearchParams &params, const QString &engine, bool live,
+                              const QVector<NamedSearchPattern> &batchPatterns = QVector<NamedSearchPattern>(),
+                              const ProximityQuery &proximity = ProximityQuery());
+    void cancelLiveSearch();
+    
+    // Cancel the current session and start the next one
+    SearchCancelToken newSearchSession();
+    
+    // True when every match of next is on a line that matched base: both are literals with the
+    // same options and next contains base
+    static bool isNarrowerSearch(const RGSearchParams &base, const RGSearchParams &next);
+    
+    // Keep the matched lines of the results on screen for narrowing
+    void captureNarrowBase();
+    
     MainWindow* m_mainSearch;
     QElapsedTimer m_functionTimer;
     QElapsedTimer m_totalSearchTimer;  // Timer for total search duration
+    
+    // ===== LIVE SEARCH =====
+    QTimer *m_liveSearchTimer;         // Debounce of pattern edits
+    bool m_liveSearchEnabled;          // [RGSearch] LiveSearch in app.ini
+    int m_liveSearchDelayMs;           // [RGSearch] LiveSearchDelayMs
+    int m_liveSearchMinChars;          // [RGSearch] LiveSearchMinChars
+    bool m_liveSearchRunning;
+    
+    // Search session - output queued for an older session is dropped, and every stage of the
+    // current one polls m_cancelToken
+    quint64 m_streamSession;
+    SearchCancelToken m_cancelToken;
+    QMetaObject::Connection m_streamCompletedConnection;
+    
+    // The results on screen are complete results of m_resultsParams
+    bool m_resultsComplete;
+    RGSearchParams m_resultsParams;
+    bool m_resultsTruncated;           // The search was stopped at [RGSearch] MaxTotalMatches
+    
+    // Lines later live searches can be narrowed to
+    bool m_narrowBaseValid;
+    RGSearchParams m_narrowBaseParams;
+    RefineFileSearcher::PreviousLines m_narrowBaseLines;
+    
+    static constexpr int LIVE_NARROW_MAX_LINES = 2000000;
 };
 
 #endif // KSEARCH_H
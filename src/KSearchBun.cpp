@@ -1,4 +1,15 @@
 #include "KSearchBun.h"
+#include "filesearcher.h"
+#include "RipgrepFileSearcher.h"
+#include "CachedFileSearcher.h"
+#include "RefineFileSearcher.h"
+#include "IndexedFileSearcher.h"
+#include "OrderedFileSearcher.h"
+#include "BudgetFileSearcher.h"
+#include "BatchFileSearcher.h"
+#include "ProximityFileSearcher.h"
+#include "TimeRangeFileSearcher.h"
+#include "SearchFlowControl.h"
 #include "mainwindow.h"
 #include <QProcess>
 #include <QThread>
@@ -7,6 +18,8 @@
 #include <QRegularExpressionMatch>
 #include <QMetaObject>
 #include <QMutexLocker>
+#include <QEventLoop>
+#include "SplitFileSearch.h"
 #include "logger.h"
 #include <QApplication>
 #include <QTextEdit>
@@ -31,10 +44,10 @@ void KSearchBun::parseRGMainResults_async(const QString &allOutput)
     // Create a worker thread to run the parsing
     QThread *parseThread = QThread::create([this, allOutput]() {
         // Run the synchronous parsing in the background thread
-        QMap<QString, QVector<Match>> results = this->parseRGMainResults(allOutput);
+        int totalMatches = this->parseRGMainResults(allOutput);
         
         // Emit the signal when parsing completes
-        emit this->asyncParseCompleted(results);
+        emit this->asyncParseCompleted(totalMatches);
         
         LOG_INFO("KSearchBun: ===THREAD=== parseRGMainResults_async (Asynchronous) >>>>>ENDed>>>>>");
     });
@@ -44,12 +57,12 @@ void KSearchBun::parseRGMainResults_async(const QString &allOutput)
 }
 
 // Parse ripgrep output into search results
-QMap<QString, QVector<Match>> KSearchBun::parseRGMainResults(const QString &allOutput)
+int KSearchBun::parseRGMainResults(const QString &allOutput)
 {
     LOG_INFO("KSearchBun: ===THREAD=== parseRGMainResults <<<<<STARTed<<<<<");
     
     // Clear previous results
-    results_by_file.clear();
+    m_results.clear();
     found_file_paths.clear();
     
     // ===== STEP 3: SPLIT OUTPUT INTO LINES =====
@@ -58,6 +71,7 @@ QMap<QString, QVector<Match>> KSearchBun::parseRGMainResults(const QString &allO
     
     // ===== STEP 4: PARSE LINES =====
     QString currentFile;
+    int currentFileId = -1;
     
     for (const QString &line : lines) {
         
@@ -65,6 +79,7 @@ QMap<QString, QVector<Match>> KSearchBun::parseRGMainResults(const QString &allO
         if (isFileHeading(line)) {
             // This is a file heading - update current file context
             currentFile = line;
+            currentFileId = m_results.internFile(currentFile);
             found_file_paths.append(currentFile);
             LOG_INFO("KSearchBun: parseRGMainResults - Found file: " + currentFile);
             
@@ -73,17 +88,25 @@ QMap<QString, QVector<Match>> KSearchBun::parseRGMainResults(const QString &allO
             
         } else if (isMatchLine(line) && !currentFile.isEmpty()) {
             // This is a match line - parse the match data
-            Match match = parseMatchLine(line);
-            results_by_file[currentFile].append(match);
+            int lineNumber = 0;
+            int column = 0;
+            qint64 byteOffset = 0;
+            QString lineData;
+            if (parseMatchLine(line, &lineNumber, &column, &byteOffset, &lineData)) {
+                QByteArray lineBytes = lineData.toUtf8();
+                m_results.appendMatch(currentFileId, lineNumber, column, byteOffset, int(lineBytes.size()), lineBytes);
+            }
         }
     }
     
     // ===== STEP 6: DISPLAY RESULTS =====
-    LOG_INFO("KSearchBun: parseRGMainResults - Found matches in " + QString::number(results_by_file.size()) + " files");
+    LOG_INFO("KSearchBun: parseRGMainResults - Found " + QString::number(m_results.matchCount()) + " matches in " +
+             QString::number(m_results.fileCount()) + " files, store uses " +
+             QString::number(m_results.memoryUsage() / 1024) + " KB");
     
     LOG_INFO("KSearchBun: ===THREAD=== parseRGMainResults >>>>>ENDed>>>>>");
     
-    return results_by_file;
+    return m_results.matchCount();
 }
 
 
@@ -108,41 +131,28 @@ bool KSearchBun::isMatchLine(const QString &line)
     return match_regex.match(line).hasMatch();
 }
 
-// Parse a match line into a Match structure
+// Parse a match line into its fields
 // Ripgrep output format: line_number:column:byte_offset:full_line_content
-// Example: "7:52:1071:This is the full line content with the match" -> line=7, column=52, offset=1071, text="match", lineData="This is the full line content with the match"
-Match KSearchBun::parseMatchLine(const QString &line)
+// Example: "7:52:1071:This is the full line content with the match" -> line=7, column=52, offset=1071, lineData="This is the full line content with the match"
+bool KSearchBun::parseMatchLine(const QString &line, int *lineNumber, int *column, qint64 *byteOffset, QString *lineData)
 {
     QRegularExpression match_regex(R"(^(\d+):(\d+):(\d+):(.+)$)");
     QRegularExpressionMatch match = match_regex.match(line);
     
-    Match m;
-    if (match.hasMatch()) {
-        // Group 1: line_number (first number)
-        m.line_number = match.captured(1).toInt();
-        // Group 2: column (second number)  
-        m.column = match.captured(2).toLong();
-        // Group 3: byte_offset (third number)
-        m.byte_offset = match.captured(3).toLong();
-        // Group 4: full line content (everything after third colon)
-        QString fullLineContent = match.captured(4);
-        m.lineData = fullLineContent;
-        
-        // Extract the matched text (this would be the actual match, but since we removed --only-matching,
-        // we'll use a placeholder or the first part of the line)
-        if (!fullLineContent.isEmpty()) {
-            // For now, use the first word or a reasonable portion as the match
-            QStringList words = fullLineContent.split(' ', Qt::SkipEmptyParts);
-            m.match = words.isEmpty() ? fullLineContent.left(20) : words.first();
-        } else {
-            m.match = "No content";
-        }
-        
-    } else {
+    if (!match.hasMatch()) {
         LOG_WARNING("KSearchBun: parseMatchLine - No match for line: '" + line + "'");
+        return false;
     }
     
-    return m;
+    // Group 1: line_number (first number)
+    *lineNumber = match.captured(1).toInt();
+    // Group 2: column (second number)
+    *column = match.captured(2).toInt();
+    // Group 3: byte_offset (third number)
+    *byteOffset = match.captured(3).toLongLong();
+    // Group 4: full line content (everything after third colon)
+    *lineData = match.captured(4);
+    return true;
 }
 
 
@@ -169,6 +179,16 @@ KSearchBun::KSearchBun(QObject *parent)
     , m_currentSearchProcess(nullptr)
     , m_currentMapProcess(nullptr)
     , m_currentSearchThread(nullptr)
+    , m_streamingMode(true)
+    , m_resultCache(true)
+    , m_trigramIndex(false)
+    , m_resultOrder(OrderedFileSearcher::DefaultOrderName)
+    , m_maxMatchesPerFile(0)
+    , m_maxTotalMatches(0)
+    , m_countOnlyFirst(false)
+    , m_searchCompressed(true)
+    , m_fileSearcher(nullptr)
+    , m_syncSearcher(nullptr)
 {
     LOG_INFO("KSearchBun: Constructor called");
     
@@ -190,69 +210,18 @@ void KSearchBun::clearAllData()
         LOG_INFO("KSearchBun: Starting clearAllData");
         
         // Clear data structures
-        results_by_file.clear();
+        m_results.clear();
         found_file_paths.clear();
         file_mappings.clear();
         
         LOG_INFO("KSearchBun: Data structures cleared");
         
-        // Clean up processes with defensive programming
-        QMutexLocker locker(&m_processMutex);
-        
-        // Clean up search process
-        if (m_currentSearchProcess) {
-            try {
-                LOG_INFO("KSearchBun: Cleaning up search process");
-                if (m_currentSearchProcess->state() != QProcess::NotRunning) {
-                    LOG_INFO("KSearchBun: Terminating search process");
-                    m_currentSearchProcess->terminate();
-                    if (!m_currentSearchProcess->waitForFinished(5000)) {
-                        LOG_WARNING("KSearchBun: Force killing search process");
-                        m_currentSearchProcess->kill();
-                        m_currentSearchProcess->waitForFinished(2000);
-                    }
-                }
-                delete m_currentSearchProcess;
-                m_currentSearchProcess = nullptr;
-                LOG_INFO("KSearchBun: Search process cleaned up successfully");
-            } catch (const std::exception& e) {
-                LOG_ERROR("KSearchBun: Exception cleaning up search process: " + QString(e.what()));
-            } catch (...) {
-                LOG_ERROR("KSearchBun: Unknown exception cleaning up search process");
-            }
-        }
-        
-        // Clean up map process
-        if (m_currentMapProcess) {
-            try {
-                LOG_INFO("KSearchBun: Cleaning up map process");
-                if (m_currentMapProcess->state() != QProcess::NotRunning) {
-                    LOG_INFO("KSearchBun: Terminating map process");
-                    m_currentMapProcess->terminate();
-                    if (!m_currentMapProcess->waitForFinished(5000)) {
-                        LOG_WARNING("KSearchBun: Force killing map process");
-                        m_currentMapProcess->kill();
-                        m_currentMapProcess->waitForFinished(2000);
-                    }
-                }
-                delete m_currentMapProcess;
-                m_currentMapProcess = nullptr;
-                LOG_INFO("KSearchBun: Map process cleaned up successfully");
-            } catch (const std::exception& e) {
-                LOG_ERROR("KSearchBun: Exception cleaning up map process: " + QString(e.what()));
-            } catch (...) {
-                LOG_ERROR("KSearchBun: Unknown exception cleaning up map process");
-            }
-        }
+        // Stop and detach a running streaming search
+        cancelStreamSearch();
         
-        // Clean up search thread - SKIP THIS FOR NOW
-        // The thread should have already finished naturally from the previous search
-        // Trying to delete it causes crashes when it's in an invalid state
-        if (m_currentSearchThread) {
-            LOG_INFO("KSearchBun: Skipping search thread cleanup to prevent crash");
-            // Don't delete the thread - let it be cleaned up naturally
-            m_currentSearchThread = nullptr;
-        }
+        // rg processes are killed without waiting - the threads running them return on their own,
+        // and their output is dropped because their session is cancelled
+        killSearchProcesses();
         
         LOG_INFO("KSearchBun: All data cleared successfully");
         
@@ -264,14 +233,14 @@ void KSearchBun::clearAllData()
 }
 
 // KMap function - gets file path and returns list of line offsets
-QVector<long> KSearchBun::KMap(const QString &file_path)
+QVector<qint64> KSearchBun::KMap(const QString &file_path)
 {
     QElapsedTimer timer;
     timer.start();
     
     LOG_INFO("KSearchBun: ===THREAD=== KMap for file: " + file_path + " <<<<<STARTed<<<<<");
     
-    QVector<long> line_offsets;
+    QVector<qint64> line_offsets;
     
     // Check if file exists
     QFileInfo fileInfo(file_path);
@@ -295,33 +264,42 @@ QVector<long> KSearchBun::KMap(const QString &file_path)
     arguments << ".";                     // Search for any character (matches all lines)
     arguments << file_path;               // File to search
     
-    // Create and start process
-    QMutexLocker locker(&m_processMutex);
-    
-    // Clean up any existing mapping process
-    if (m_currentMapProcess) {
-        delete m_currentMapProcess;
+    // Create and start process - published for killSearchProcesses while it runs
+    QProcess mapProcess;
+    {
+        QMutexLocker locker(&m_processMutex);
+        m_currentMapProcess = &mapProcess;
     }
+    mapProcess.start(RipgrepFileSearcher::executable(), arguments);
     
-    m_currentMapProcess = new QProcess();
-    m_currentMapProcess->start("lib\\rg.exe", arguments);
+    bool started = mapProcess.waitForStarted();
+    bool finished = started && mapProcess.waitForFinished(30000); // 30 second timeout
+    if (started && !finished) {
+        mapProcess.kill();
+        mapProcess.waitForFinished(1000);
+    }
+    {
+        QMutexLocker locker(&m_processMutex);
+        m_currentMapProcess = nullptr;
+    }
     
-    if (!m_currentMapProcess->waitForStarted()) {
+    if (!started) {
         LOG_ERROR("KSearchBun: KMap - Failed to start ripgrep process");
         return line_offsets;
     }
-    
-    // Wait for completion
-    if (!m_currentMapProcess->waitForFinished(30000)) { // 30 second timeout
+    if (!finished) {
         LOG_ERROR("KSearchBun: KMap - Process timed out");
-        m_currentMapProcess->kill();
+        return line_offsets;
+    }
+    if (mapProcess.exitStatus() == QProcess::CrashExit) {
+        LOG_INFO("KSearchBun: KMap - Process was killed, no line offsets");
         return line_offsets;
     }
     
     // Get output
-    QByteArray allOutput = m_currentMapProcess->readAllStandardOutput();
-    QByteArray errorOutput = m_currentMapProcess->readAllStandardError();
-    int exitCode = m_currentMapProcess->exitCode();
+    QByteArray allOutput = mapProcess.readAllStandardOutput();
+    QByteArray errorOutput = mapProcess.readAllStandardError();
+    int exitCode = mapProcess.exitCode();
     
     LOG_INFO("KSearchBun: KMap - Ripgrep exit code: " + QString::number(exitCode));
     
@@ -340,7 +318,7 @@ QVector<long> KSearchBun::KMap(const QString &file_path)
     
     for (const QString &part : parts) {
         bool ok;
-        long offset = part.toLong(&ok);
+        qint64 offset = part.toLongLong(&ok);
         if (ok && offset > 0) {
             line_offsets.append(offset);
     } else {
@@ -361,65 +339,13 @@ QString KSearchBun::getFullRipgrepCommand(const RGSearchParams &params) const
     // Update persistent search parameters
     const_cast<KSearchBun*>(this)->updateSearchParams(params);
     
-        QStringList arguments;
-    arguments << "lib\\rg.exe";
-    arguments << "-a";                    // Search binary files
-    arguments << "-n";                    // Show line numbers
-    arguments << "--threads" << "0";      // Use all available threads
-    arguments << "--mmap";                // Use memory-mapped I/O
-    arguments << "--column";              // Show column numbers
-    arguments << "--byte-offset";         // Show byte offsets
-    arguments << "--stats";               // Show statistics
-    arguments << "--heading";             // Show filename as heading
-    arguments << "--json";                // Always output in JSON format
-    
-    // Add pattern flags
-    if (params.fixed_string) {
-        arguments << "-F";                // Fixed string mode
-    }
-    
-    // Add case sensitivity flags (mutually exclusive)
-    if (params.case_sensitive) {
-        arguments << "-s";                // Case sensitive
-    } else if (params.ignore_case) {
-        arguments << "-i";                // Ignore case
-    } else if (params.smart_case) {
-        arguments << "-S";                // Smart case
-    }
-    
-    // Add include/exclude patterns
-    if (!params.incl_exclude.isEmpty()) {
-        QStringList patterns = params.incl_exclude.split(',', Qt::SkipEmptyParts);
-        for (const QString &pattern : patterns) {
-            QString trimmedPattern = pattern.trimmed();
-            if (trimmedPattern.startsWith("!")) {
-                // Exclude pattern (starts with !)
-                arguments << "-g" << QString("!%1").arg(trimmedPattern.mid(1));
-                    } else {
-                // Include pattern
-                arguments << "-g" << trimmedPattern;
-            }
-        }
-    }
-    
-    // Add pattern (combine main pattern with additional pattern using OR operator)
-    arguments << "-e";
-    QString full_pattern = params.pattern;
-    if (!params.add_pattern.isEmpty()) {
-        full_pattern += "|" + params.add_pattern;
-    }
+    QStringList arguments;
+    arguments << RipgrepFileSearcher::executable();
+    arguments << RipgrepFileSearcher::buildArguments(params);
     
     // Update Rule 1 with the combined pattern
     updateRule1WithCombinedPattern(params.pattern, params.add_pattern);
     
-    // Pass pattern directly to ripgrep (no quoting needed for regex patterns)
-    arguments << full_pattern;
-    
-    // Add path
-    arguments << params.path;
-
-
-    
     return arguments.join(' ');
 }
 
@@ -432,6 +358,7 @@ QString KSearchBun::K_RGresults_method3(const RGSearchParams &params)
     
     // Use persistent search parameters instead of passed parameters
     RGSearchParams currentParams = m_currentSearchParams;
+    currentParams.search_compressed = m_searchCompressed;
     
     LOG_INFO("KSearchBun: ===THREAD=== K_RGresults_method3 (Synchronous) for path: " + currentParams.path + " <<<<<STARTed<<<<<");
     LOG_DEBUG("KSearchBun: Method3 - 112 Using persistent RGSearchParams:");
@@ -447,85 +374,66 @@ QString KSearchBun::K_RGresults_method3(const RGSearchParams &params)
     LOG_DEBUG("  highlight_color: " + currentParams.highlight_color.name());
     
     // Clear previous results
-    results_by_file.clear();
+    m_results.clear();
     found_file_paths.clear();
     file_mappings.clear();
         
-        // ===== STEP 1: BUILD RIPGREP COMMAND =====
-    QStringList arguments;
-    arguments << "-a";                    // Search binary files
-    arguments << "-n";                    // Show line numbers
-    arguments << "--threads" << "0";      // Use all available threads
-    arguments << "--mmap";                // Use memory-mapped I/O
-    arguments << "--column";              // Show column numbers
-    arguments << "--byte-offset";         // Show byte offsets
-    arguments << "--stats";               // Show statistics
-    arguments << "--heading";             // Show filename as heading
-    arguments << "--json";                // Always output in JSON format
-    
-    // Add pattern flags
-    if (currentParams.fixed_string) {
-        arguments << "-F";                // Fixed string mode
-    }
-    
-    // Add case sensitivity flags (mutually exclusive)
-    if (currentParams.case_sensitive) {
-        arguments << "-s";                // Case sensitive
-    } else if (currentParams.ignore_case) {
-        arguments << "-i";                // Ignore case
-    } else if (currentParams.smart_case) {
-        arguments << "-S";                // Smart case
-    }
-    
-    // Add include/exclude patterns
-    if (!currentParams.incl_exclude.isEmpty()) {
-        QStringList patterns = currentParams.incl_exclude.split(',', Qt::SkipEmptyParts);
-        for (const QString &pattern : patterns) {
-            QString trimmedPattern = pattern.trimmed();
-            if (trimmedPattern.startsWith("!")) {
-                // Exclude pattern (starts with !)
-                arguments << "-g" << QString("!%1").arg(trimmedPattern.mid(1));
-                // Exclude pattern (starts with !)
-            } else {
-                // Include pattern
-                arguments << "-g" << trimmedPattern;
-            }
-        }
-    }
-    
-    // Add pattern (pass directly to ripgrep)
-    arguments << "-e";
-    QString full_pattern = currentParams.pattern;
-    if (!currentParams.add_pattern.isEmpty()) {
-        full_pattern += "|" + currentParams.add_pattern;
-    }
+    // ===== STEP 1: BUILD RIPGREP COMMAND =====
+    QStringList arguments = RipgrepFileSearcher::buildArguments(currentParams);
     
     // Update Rule 1 with the combined pattern
     updateRule1WithCombinedPattern(currentParams.pattern, currentParams.add_pattern);
     
-    // Pass pattern directly to ripgrep (no quoting needed for regex patterns)
-    arguments << full_pattern;
-    
-    // Add search path
-    arguments << currentParams.path;
+    LOG_INFO("KSearchBun: Method3 - Ripgrep command: " + RipgrepFileSearcher::executable() + " " + arguments.join(' '));
     
-    LOG_INFO("KSearchBun: Method3 - Ripgrep command: lib\\rg.exe " + arguments.join(' '));
+    // ===== STEP 2 (SPLIT MODE): LARGE FILES BY RANGES =====
+    // rg scans each file on one thread - RipgrepFileSearcher searches large files by ranges in
+    // parallel, here on this thread's own event loop
+    if (SplitFileSearch::loadConfig().enabled) {
+        QByteArray output;
+        QMutex outputMutex;
+        RipgrepFileSearcher searcher;
+        QEventLoop loop;
+        
+        // Range records arrive from the range search threads
+        connect(&searcher, &FileSearcher::outputChunk, &searcher, [&output, &outputMutex](const QByteArray &jsonLines) {
+            QMutexLocker outputLocker(&outputMutex);
+            output.append(jsonLines);
+        }, Qt::DirectConnection);
+        connect(&searcher, &FileSearcher::finished, &loop, &QEventLoop::quit);
+        
+        {
+            QMutexLocker searcherLocker(&m_syncSearcherMutex);
+            m_syncSearcher = &searcher;
+        }
+        searcher.start(currentParams);
+        loop.exec();
+        {
+            QMutexLocker searcherLocker(&m_syncSearcherMutex);
+            m_syncSearcher = nullptr;
+        }
+        
+        LOG_INFO("KSearchBun: Method3 ENDed (split mode) - Received " + QString::number(output.size()) + " bytes from ripgrep");
+        return QString::fromUtf8(output);
+    }
     
     // ===== STEP 2: EXECUTE RIPGREP AND GET ALL OUTPUT =====
-    QMutexLocker locker(&m_processMutex);
-    
-    // Clean up any existing process
-    if (m_currentSearchProcess) {
-        delete m_currentSearchProcess;
+    // The process belongs to this thread; killSearchProcesses may kill it from another one
+    QProcess searchProcess;
+    {
+        QMutexLocker locker(&m_processMutex);
+        m_currentSearchProcess = &searchProcess;
+    }
+    searchProcess.start(RipgrepFileSearcher::executable(), arguments);
+    searchProcess.waitForFinished(-1);
+    {
+        QMutexLocker locker(&m_processMutex);
+        m_currentSearchProcess = nullptr;
     }
-    
-    m_currentSearchProcess = new QProcess();
-    m_currentSearchProcess->start("lib\\rg.exe", arguments);
-    m_currentSearchProcess->waitForFinished();
     
     // Get all output as QString
-    QString allOutput = QString::fromUtf8(m_currentSearchProcess->readAllStandardOutput());
-    QString errorOutput = QString::fromUtf8(m_currentSearchProcess->readAllStandardError());
+    QString allOutput = QString::fromUtf8(searchProcess.readAllStandardOutput());
+    QString errorOutput = QString::fromUtf8(searchProcess.readAllStandardError());
     
     if (!errorOutput.isEmpty()) {
         LOG_WARNING("KSearchBun: Method3 - Ripgrep errors: " + errorOutput);
@@ -538,20 +446,28 @@ QString KSearchBun::K_RGresults_method3(const RGSearchParams &params)
 }
 
 // Asynchronous version of method 3
-void KSearchBun::K_RGresults_method3_async(const RGSearchParams &params)
+void KSearchBun::K_RGresults_method3_async(const RGSearchParams &params, const SearchCancelToken &token)
 {
     LOG_INFO("KSearchBun: ===THREAD=== K_RGresults_method3_async (Asynchronous) for path: " + params.path + " <<<<<STARTed<<<<<");
     
-    // Clean up any existing search thread
-    QMutexLocker locker(&m_processMutex);
-    if (m_currentSearchThread) {
-        delete m_currentSearchThread;
+    // A previous search thread is not touched: its session was cancelled, its rg killed, and it
+    // deletes itself when it returns
+    if (m_currentSearchThread && m_currentSearchThread->isRunning()) {
+        LOG_INFO("KSearchBun: Previous method3 thread still returning, its output will be dropped");
     }
     
     // Create a thread to run the synchronous method and ensure it is deleted on finish
-    m_currentSearchThread = QThread::create([this]() {
+    m_currentSearchThread = QThread::create([this, token]() {
         QString rawOutput = this->K_RGresults_method3(m_currentSearchParams);
-        emit this->asyncSearchCompleted(rawOutput);
+        
+        // Checked again on the receiving thread: the session may be cancelled while this is queued
+        QMetaObject::invokeMethod(this, [this, token, rawOutput]() {
+            if (token.isCancelled()) {
+                LOG_INFO("KSearchBun: Method3 session " + QString::number(token.session()) + " was cancelled, output dropped");
+                return;
+            }
+            emit asyncSearchCompleted(rawOutput);
+        }, Qt::QueuedConnection);
     });
     QObject::connect(m_currentSearchThread, &QThread::finished, m_currentSearchThread, &QObject::deleteLater);
     m_currentSearchThread->start();
@@ -560,10 +476,296 @@ void KSearchBun::K_RGresults_method3_async(const RGSearchParams &params)
 }
 
 
+// ===== STREAMING SEARCH =====
+// Runs the selected FileSearcher backend without blocking. Every backend produces ripgrep --json
+// records, which are forwarded through searchOutputChunk as soon as they are available so the
+// parser and the results tree fill in while the search is running.
+void KSearchBun::K_FSresults_stream(const RGSearchParams &params, const QString &engine, const SearchCancelToken &token)
+{
+    LOG_INFO("KSearchBun: ===STREAM=== K_FSresults_stream (" + engine + ") for path: " + params.path + " <<<<<STARTed<<<<<");
+    
+    RGSearchParams currentParams = m_currentSearchParams;
+    updateRule1WithCombinedPattern(currentParams.pattern, currentParams.add_pattern);
+    currentParams.max_count = m_maxMatchesPerFile;
+    // Matches outside a time window are dropped by their records, so they cannot be only counted
+    currentParams.count_only = m_countOnlyFirst && !TimeRangeFileSearcher::isActive(currentParams);
+    currentParams.search_compressed = m_searchCompressed;
+    
+    cancelStreamSearch();
+    
+    FileSearcher *searcher = FileSearcher::create(engine, this);
+    if (!searcher) {
+        LOG_ERROR("KSearchBun: No search backend for engine: " + engine);
+        emit searchStreamFinished(2);
+        return;
+    }
+    if (TimeRangeFileSearcher::isActive(currentParams)) {
+        // Only the slice of each log inside the time window is searched
+        searcher = new TimeRangeFileSearcher(searcher, this);
+    }
+    if (m_trigramIndex) {
+        // Files and blocks the index rules out are not searched
+        searcher = new IndexedFileSearcher(searcher, this);
+    }
+    if (m_resultCache && !currentParams.count_only && currentParams.max_count <= 0) {
+        // Repeated searches only search what changed since the cached run (complete results only)
+        searcher = new CachedFileSearcher(searcher, this);
+    }
+    startStreamSearch(searcher, currentParams, token);
+    
+    LOG_INFO("KSearchBun: ===STREAM=== K_FSresults_stream (" + engine + ") for path: " + params.path + " >>>>>ENDed>>>>> (search started)");
+}
+
+void KSearchBun::K_FSresults_batch(const RGSearchParams &params, const QVector<NamedSearchPattern> &patterns,
+                                   const QString &engine, const SearchCancelToken &token)
+{
+    LOG_INFO("KSearchBun: ===STREAM=== K_FSresults_batch (" + engine + ", " + QString::number(patterns.size()) +
+             " patterns) for path: " + params.path + " <<<<<STARTed<<<<<");
+    
+    RGSearchParams currentParams = m_currentSearchParams;
+    currentParams.max_count = m_maxMatchesPerFile;
+    currentParams.count_only = false;   // Lines are attributed to their patterns, so they are needed
+    currentParams.search_compressed = m_searchCompressed;
+    
+    // Every pattern of the list is highlighted in the viewer
+    updateRule1WithCombinedPattern(BatchFileSearcher::combinedPattern(patterns, currentParams.fixed_string), QString());
+    
+    cancelStreamSearch();
+    
+    FileSearcher *searcher = FileSearcher::create(engine, this);
+    if (!searcher) {
+        LOG_ERROR("KSearchBun: No search backend for engine: " + engine);
+        emit searchStreamFinished(2);
+        return;
+    }
+    if (TimeRangeFileSearcher::isActive(currentParams)) {
+        // Only the slice of each log inside the time window is searched
+        searcher = new TimeRangeFileSearcher(searcher, this);
+    }
+    if (m_trigramIndex) {
+        searcher = new IndexedFileSearcher(searcher, this);
+    }
+    if (m_resultCache && currentParams.max_count <= 0) {
+        // Cached by the combined pattern the engine searches for
+        searcher = new CachedFileSearcher(searcher, this);
+    }
+    searcher = new BatchFileSearcher(searcher, patterns, this);
+    startStreamSearch(searcher, currentParams, token);
+    
+    LOG_INFO("KSearchBun: ===STREAM=== K_FSresults_batch (" + engine + ") for path: " + params.path + " >>>>>ENDed>>>>> (search started)");
+}
+
+void KSearchBun::K_FSresults_proximity(const RGSearchParams &params, const ProximityQuery &query,
+                                       const QString &engine, const SearchCancelToken &token)
+{
+    LOG_INFO("KSearchBun: ===STREAM=== K_FSresults_proximity (" + engine + ", " + ProximityFileSearcher::describe(query) +
+             ") for path: " + params.path + " <<<<<STARTed<<<<<");
+    
+    RGSearchParams currentParams = m_currentSearchParams;
+    currentParams.max_count = 0;        // Every hit of a term can complete a cluster
+    currentParams.count_only = false;
+    currentParams.search_compressed = m_searchCompressed;
+    
+    updateRule1WithCombinedPattern(BatchFileSearcher::combinedPattern(query.terms, currentParams.fixed_string), QString());
+    
+    cancelStreamSearch();
+    
+    FileSearcher *searcher = FileSearcher::create(engine, this);
+    if (!searcher) {
+        LOG_ERROR("KSearchBun: No search backend for engine: " + engine);
+        emit searchStreamFinished(2);
+        return;
+    }
+    if (TimeRangeFileSearcher::isActive(currentParams)) {
+        // Only the slice of each log inside the time window is searched
+        searcher = new TimeRangeFileSearcher(searcher, this);
+    }
+    if (m_trigramIndex) {
+        searcher = new IndexedFileSearcher(searcher, this);
+    }
+    if (m_resultCache) {
+        searcher = new CachedFileSearcher(searcher, this);
+    }
+    searcher = new ProximityFileSearcher(searcher, query, this);
+    startStreamSearch(searcher, currentParams, token);
+    
+    LOG_INFO("KSearchBun: ===STREAM=== K_FSresults_proximity (" + engine + ") for path: " + params.path + " >>>>>ENDed>>>>> (search started)");
+}
+
+void KSearchBun::K_FSresults_refine(const RGSearchParams &params, RefineFileSearcher *searcher, const SearchCancelToken &token)
+{
+    LOG_INFO("KSearchBun: ===STREAM=== K_FSresults_refine for path: " + params.path + " <<<<<STARTed<<<<<");
+    
+    RGSearchParams currentParams = m_currentSearchParams;
+    updateRule1WithCombinedPattern(currentParams.pattern, currentParams.add_pattern);
+    currentParams.max_count = m_maxMatchesPerFile;
+    currentParams.search_compressed = m_searchCompressed;
+    
+    cancelStreamSearch();
+    searcher->setParent(this);
+    startStreamSearch(searcher, currentParams, token);
+    
+    LOG_INFO("KSearchBun: ===STREAM=== K_FSresults_refine for path: " + params.path + " >>>>>ENDed>>>>> (search started)");
+}
+
+void KSearchBun::K_FSresults_file(const QString &filePath, const QString &engine, const SearchCancelToken &token)
+{
+    LOG_INFO("KSearchBun: ===STREAM=== K_FSresults_file (" + engine + ") for file: " + filePath + " <<<<<STARTed<<<<<");
+    
+    // Same search as the counting pass, this time with match records
+    RGSearchParams params = m_currentSearchParams;
+    params.max_count = m_maxMatchesPerFile;
+    params.count_only = false;
+    params.search_compressed = m_searchCompressed;
+    
+    FileSearcher *searcher = FileSearcher::create(engine, this);
+    if (!searcher) {
+        LOG_ERROR("KSearchBun: No search backend for engine: " + engine);
+        emit fileSearchFinished(filePath, 2);
+        return;
+    }
+    searcher = withResultBudgets(searcher);
+    
+    FileSearcher::SearchTarget target;
+    target.filePath = filePath;
+    searcher->setTargets({target});
+    
+    connect(searcher, &FileSearcher::outputChunk, this, [this, token](const QByteArray &jsonLines) {
+        emit fileSearchOutputChunk(jsonLines, token);
+    }, Qt::DirectConnection);
+    connect(searcher, &FileSearcher::finished, this, [this, searcher, filePath](int exitCode) {
+        m_fileMatchSearchers.removeAll(searcher);
+        LOG_INFO("KSearchBun: File search of " + filePath + " finished (exit code " + QString::number(exitCode) + ")");
+        emit fileSearchFinished(filePath, exitCode);
+    });
+    connect(searcher, &FileSearcher::finished, searcher, &QObject::deleteLater);
+    m_fileMatchSearchers.append(searcher);
+    
+    searcher->setCancelToken(token);
+    searcher->start(params);
+    
+    LOG_INFO("KSearchBun: ===STREAM=== K_FSresults_file (" + engine + ") for file: " + filePath + " >>>>>ENDed>>>>> (search started)");
+}
+
+void KSearchBun::setResultBudgets(int maxPerFile, int maxTotal)
+{
+    m_maxMatchesPerFile = qMax(0, maxPerFile);
+    m_maxTotalMatches = qMax(0, maxTotal);
+    LOG_INFO("KSearchBun: Result budgets set to " + QString::number(m_maxMatchesPerFile) + " per file, " +
+             QString::number(m_maxTotalMatches) + " in all");
+}
+
+FileSearcher *KSearchBun::withResultBudgets(FileSearcher *searcher)
+{
+    if (m_maxMatchesPerFile <= 0 && m_maxTotalMatches <= 0) {
+        return searcher;
+    }
+    return new BudgetFileSearcher(searcher, m_maxMatchesPerFile, m_maxTotalMatches, this);
+}
+
+void KSearchBun::startStreamSearch(FileSearcher *searcher, const RGSearchParams &params, const SearchCancelToken &token)
+{
+    // Results beyond the budgets are never shown, so they are not searched for either
+    FileSearcher *budgeted = withResultBudgets(searcher);
+    searcher = budgeted;
+    
+    OrderedFileSearcher::Order order;
+    if (OrderedFileSearcher::orderFromName(m_resultOrder, &order)) {
+        // Same results in the same order on every run, whatever order the engine finishes files in
+        searcher = new OrderedFileSearcher(searcher, order, this);
+    }
+    m_fileSearcher = searcher;
+    
+    if (BudgetFileSearcher *budget = qobject_cast<BudgetFileSearcher*>(budgeted)) {
+        connect(budget, &BudgetFileSearcher::budgetReached, this, [this, searcher](int matches) {
+            if (searcher == m_fileSearcher) {
+                emit searchBudgetReached(matches);
+            }
+        });
+    }
+    
+    // Every stream gets its own backlog, so a replaced search cannot hold back the next one
+    QSharedPointer<SearchFlowControl> flow(new SearchFlowControl, &QObject::deleteLater);
+    m_flowControl = flow;
+    searcher->setFlowControl(flow);
+    
+    // In-process backends emit chunks from their worker threads; receivers on the UI thread get them queued
+    connect(searcher, &FileSearcher::outputChunk, this, [this, flow](const QByteArray &jsonLines) {
+        flow->produced(jsonLines.size());
+        emit searchOutputChunk(jsonLines);
+    }, Qt::DirectConnection);
+    connect(searcher, &FileSearcher::finished, this, [this, searcher](int exitCode) {
+        if (searcher != m_fileSearcher) {
+            return;  // Finished after being replaced by a newer search
+        }
+        m_fileSearcher = nullptr;
+        LOG_INFO("KSearchBun: " + searcher->engineName() + " search finished (exit code " + QString::number(exitCode) + ") after " + QString::number(m_streamTimer.elapsed()) + " ms");
+        emit searchStreamFinished(exitCode);
+    });
+    connect(searcher, &FileSearcher::errorOccurred, this, [](const QString &error) {
+        LOG_ERROR("KSearchBun: Search error: " + error);
+    }, Qt::QueuedConnection);
+    connect(searcher, &FileSearcher::finished, searcher, &QObject::deleteLater);
+    
+    m_streamTimer.start();
+    searcher->setCancelToken(token);
+    searcher->start(params);
+}
+
+void KSearchBun::stopStreamSearch()
+{
+    if (m_fileSearcher) {
+        LOG_INFO("KSearchBun: Stopping " + m_fileSearcher->engineName() + " search");
+        m_fileSearcher->cancel();
+    }
+}
+
+void KSearchBun::killSearchProcesses()
+{
+    // The method3 ripgrep run with split large files is cancelled on its own thread
+    {
+        QMutexLocker searcherLocker(&m_syncSearcherMutex);
+        if (m_syncSearcher) {
+            LOG_INFO("KSearchBun: Stopping method3 ripgrep search");
+            FileSearcher *searcher = m_syncSearcher;
+            QMetaObject::invokeMethod(searcher, [searcher]() { searcher->cancel(); }, Qt::QueuedConnection);
+        }
+    }
+    
+    // QProcess::kill only signals the process; its finished() is handled by the owning thread
+    QMutexLocker locker(&m_processMutex);
+    if (m_currentSearchProcess && m_currentSearchProcess->state() != QProcess::NotRunning) {
+        LOG_INFO("KSearchBun: Killing method3 ripgrep process");
+        m_currentSearchProcess->kill();
+    }
+    if (m_currentMapProcess && m_currentMapProcess->state() != QProcess::NotRunning) {
+        LOG_INFO("KSearchBun: Killing KMap ripgrep process");
+        m_currentMapProcess->kill();
+    }
+}
+
+void KSearchBun::cancelStreamSearch()
+{
+    if (m_fileSearcher) {
+        LOG_INFO("KSearchBun: Cancelling " + m_fileSearcher->engineName() + " search");
+        // Stale output must not reach the parser of the next search
+        m_fileSearcher->disconnect(this);
+        m_fileSearcher->cancel();
+        m_fileSearcher = nullptr;
+    }
+    
+    // Files being searched for the results that are replaced now
+    for (const QPointer<FileSearcher> &searcher : m_fileMatchSearchers) {
+        if (searcher) {
+            searcher->cancel();
+        }
+    }
+}
+
 
 QThread* KSearchBun::getCurrentSearchThread() const
 {
-    return m_currentSearchThread;
+    return m_currentSearchThread.data();
 }
 
 // Persistent search parameters management
@@ -579,6 +781,7 @@ void KSearchBun::updateSearchParams(const RGSearchParams &params)
     LOG_INFO("  Ignore Case: " + QString(params.ignore_case ? "Yes" : "No"));
     LOG_INFO("  Smart Case: " + QString(params.smart_case ? "Yes" : "No"));
     LOG_INFO("  Include/Exclude: " + params.incl_exclude);
+    LOG_INFO("  Time Window: " + params.time_from + " - " + params.time_to);
     LOG_INFO("  Keep Files in Cache: " + QString(params.keep_files_in_cache ? "Yes" : "No"));
     LOG_INFO("  Highlight Color: " + params.highlight_color.name());
 }
@@ -590,6 +793,12 @@ RGSearchParams KSearchBun::getCurrentSearchParams() const
 
 void KSearchBun::updateRule1WithCombinedPattern(const QString &pattern, const QString &addPattern) const
 {
+    // Rule 1 highlights the search in the viewer - a run without the user interface (--headless)
+    // has nothing to highlight and must not change the user's highlight rules
+    if (!m_mainWindow) {
+        return;
+    }
+    
     // Combine pattern and add_pattern with | separator
     QString combinedPattern = pattern;
     if (!addPattern.isEmpty()) {
@@ -641,8 +850,18 @@ void KSearchBun::loadSearchParamsFromIni()
     m_currentSearchParams.ignore_case = settings.value("LastIgnoreCase", false).toBool();
     m_currentSearchParams.smart_case = settings.value("LastSmartCase", false).toBool();
     m_currentSearchParams.incl_exclude = settings.value("LastInclExclude", "").toString();
+    m_currentSearchParams.time_from = settings.value("LastTimeFrom", "").toString();
+    m_currentSearchParams.time_to = settings.value("LastTimeTo", "").toString();
     m_currentSearchParams.keep_files_in_cache = settings.value("LastKeepFilesInCache", false).toBool();
     m_currentSearchParams.highlight_color = settings.value("LastHighlightColor", QColor(130, 130, 130)).value<QColor>();
+    m_streamingMode = settings.value("StreamingMode", true).toBool();
+    m_resultCache = settings.value("ResultCache", true).toBool();
+    m_trigramIndex = settings.value("TrigramIndex", false).toBool();
+    m_resultOrder = settings.value("ResultOrder", OrderedFileSearcher::DefaultOrderName).toString();
+    m_maxMatchesPerFile = qMax(0, settings.value("MaxMatchesPerFile", 0).toInt());
+    m_maxTotalMatches = qMax(0, settings.value("MaxTotalMatches", 0).toInt());
+    m_countOnlyFirst = settings.value("CountOnlyFirst", false).toBool();
+    m_searchCompressed = settings.value("SearchCompressed", true).toBool();
     
     // Set default values for path and pattern (these come from main window UI)
     m_currentSearchParams.path = "";
@@ -657,8 +876,17 @@ void KSearchBun::loadSearchParamsFromIni()
     LOG_INFO("  Ignore Case: " + QString(m_currentSearchParams.ignore_case ? "Yes" : "No"));
     LOG_INFO("  Smart Case: " + QString(m_currentSearchParams.smart_case ? "Yes" : "No"));
     LOG_INFO("  Include/Exclude: " + m_currentSearchParams.incl_exclude);
+    LOG_INFO("  Time Window: " + m_currentSearchParams.time_from + " - " + m_currentSearchParams.time_to);
     LOG_INFO("  Keep Files in Cache: " + QString(m_currentSearchParams.keep_files_in_cache ? "Yes" : "No"));
     LOG_INFO("  Highlight Color: " + m_currentSearchParams.highlight_color.name());
+    LOG_INFO("  Streaming Mode: " + QString(m_streamingMode ? "Yes" : "No"));
+    LOG_INFO("  Result Cache: " + QString(m_resultCache ? "Yes" : "No"));
+    LOG_INFO("  Trigram Index: " + QString(m_trigramIndex ? "Yes" : "No"));
+    LOG_INFO("  Result Order: " + m_resultOrder);
+    LOG_INFO("  Max Matches Per File: " + QString::number(m_maxMatchesPerFile));
+    LOG_INFO("  Max Total Matches: " + QString::number(m_maxTotalMatches));
+    LOG_INFO("  Count Only First: " + QString(m_countOnlyFirst ? "Yes" : "No"));
+    LOG_INFO("  Search Compressed: " + QString(m_searchCompressed ? "Yes" : "No"));
 }
 
 
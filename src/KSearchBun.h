@@ -15,10 +15,16 @@
 #include <QRegularExpression>
 #include <QListWidget>
 #include <QColor>
+#include <QPointer>
+#include <QSharedPointer>
+#include "SearchResultStore.h"
+#include "SearchCancelToken.h"
 
 // Forward declarations
-struct Match;
 struct FileMapping;
+class FileSearcher;
+class RefineFileSearcher;
+class SearchFlowControl;
 
 // Search parameters structure
 struct RGSearchParams {
@@ -32,13 +38,32 @@ struct RGSearchParams {
     QString incl_exclude;   // Include/exclude patterns
     bool keep_files_in_cache; // Keep searched files in memory cache
     QColor highlight_color; // Color to highlight matching text
+    int max_count;          // Matched lines reported per file, 0 = all (rg --max-count)
+    bool count_only;        // Count the matches of every file without reporting them
+    bool search_compressed; // Search .gz/.zst/... files decompressed (rg --search-zip)
+    QString time_from;      // Time window of timestamped log lines, "" = open (TimeRangeFileSearcher)
+    QString time_to;
     
     RGSearchParams() : fixed_string(false), case_sensitive(false), 
                       ignore_case(false), smart_case(false), keep_files_in_cache(false),
-                      highlight_color(Qt::yellow) {}
+                      highlight_color(Qt::yellow), max_count(0), count_only(false),
+                      search_compressed(false) {}
 };
 
 
+// One pattern of a batch search (see BatchFileSearcher)
+struct NamedSearchPattern {
+    QString name;
+    QString pattern;
+};
+
+// Files where all terms occur (see ProximityFileSearcher)
+struct ProximityQuery {
+    QVector<NamedSearchPattern> terms;
+    int withinLines = 0;    // All terms within this many lines, 0 = anywhere in the file
+    bool ordered = false;   // Terms in the given order ("a followed by b")
+};
+
 
 class KSearchBun : public QObject
 {
@@ -53,17 +78,69 @@ public:
     // Method 3: Synchronous implementation (simple and reliable)
     QString K_RGresults_method3(const RGSearchParams &params);
     
-    // Parse ripgrep output into search results
-    QMap<QString, QVector<Match>> parseRGMainResults(const QString &allOutput);
+    // Parse ripgrep output into the result store, returns the number of matches
+    int parseRGMainResults(const QString &allOutput);
+    const SearchResultStore &results() const { return m_results; }
+    
+    // Method 3 Async: Asynchronous version of method 3 - nothing is emitted once token is cancelled
+    void K_RGresults_method3_async(const RGSearchParams &params, const SearchCancelToken &token = SearchCancelToken());
+    
+    // Streaming search through a FileSearcher backend ("ripgrep", "builtin", "hyperscan"):
+    // forwards complete JSON lines while the search is still running
+    void K_FSresults_stream(const RGSearchParams &params, const QString &engine,
+                            const SearchCancelToken &token = SearchCancelToken());
+    bool isStreamingMode() const { return m_streamingMode; }
+    
+    // Streaming batch search: all patterns in one pass, match records carry the ids of the
+    // patterns that matched the line (see BatchFileSearcher)
+    void K_FSresults_batch(const RGSearchParams &params, const QVector<NamedSearchPattern> &patterns,
+                           const QString &engine, const SearchCancelToken &token = SearchCancelToken());
+    
+    // Streaming co-occurrence / proximity search: only files with all terms of query, and only
+    // the line clusters that satisfy it (see ProximityFileSearcher)
+    void K_FSresults_proximity(const RGSearchParams &params, const ProximityQuery &query,
+                               const QString &engine, const SearchCancelToken &token = SearchCancelToken());
+    
+    // Streaming search of only the lines a previous search matched (live search narrowing),
+    // takes ownership of searcher
+    void K_FSresults_refine(const RGSearchParams &params, RefineFileSearcher *searcher,
+                            const SearchCancelToken &token = SearchCancelToken());
+    
+    // Search one file of the current results for its match records (a counted file being expanded).
+    // Runs next to the streaming search; its output arrives through fileSearchOutputChunk.
+    void K_FSresults_file(const QString &filePath, const QString &engine,
+                          const SearchCancelToken &token = SearchCancelToken());
+    
+    // [RGSearch] CountOnlyFirst: streaming searches count the matches of each file, matches are
+    // searched per file when the file is expanded
+    bool isCountOnlyFirst() const { return m_countOnlyFirst; }
+    int maxMatchesPerFile() const { return m_maxMatchesPerFile; }
+    int maxTotalMatches() const { return m_maxTotalMatches; }
     
-    // Method 3 Async: Asynchronous version of method 3
-    void K_RGresults_method3_async(const RGSearchParams &params);
+    // Replace the app.ini result budgets and count-only mode for the following streaming searches
+    // (the headless command line), 0 = no limit
+    void setResultBudgets(int maxPerFile, int maxTotal);
+    void setCountOnlyFirst(bool countOnly) { m_countOnlyFirst = countOnly; }
+    
+    // Stop a running streaming search - the stream still closes normally
+    void stopStreamSearch();
+    
+    // Cancel and detach a running streaming search so none of its output is delivered
+    void cancelStreamSearch();
+    
+    // Backlog of the last streaming search: searchOutputChunk bytes not taken into a results
+    // model yet. The receiver reports what it consumed; above the cap the search holds back.
+    QSharedPointer<SearchFlowControl> streamFlowControl() const { return m_flowControl; }
+    
+    // Kill the rg processes of method3 and KMap without waiting for them - the threads running
+    // them return on their own and clean up after themselves
+    void killSearchProcesses();
     
     // Parse Async: Asynchronous version of parse function
     void parseRGMainResults_async(const QString &allOutput);
     
     // KMap function - gets file path and returns list of line offsets
-    QVector<long> KMap(const QString &file_path);
+    QVector<qint64> KMap(const QString &file_path);
     
     // Set main window reference for accessing UI components
     void setMainWindow(QWidget *mainWindow);
@@ -89,7 +166,7 @@ public:
 
 private:
     // ===== DATA STRUCTURES =====
-    QMap<QString, QVector<Match>> results_by_file;
+    SearchResultStore m_results;      // Matches of the last parsed search
     QMap<QString, FileMapping> file_mappings;
     QStringList found_file_paths;
     
@@ -100,15 +177,34 @@ private:
     QWidget *m_mainWindow;
     
     // ===== PROCESS MANAGEMENT =====
-    QProcess *m_currentSearchProcess;  // Current ripgrep search process
-    QProcess *m_currentMapProcess;     // Current ripgrep mapping process
-    QThread *m_currentSearchThread;    // Current search thread for method3_async
-    QMutex m_processMutex;            // Protect process access
+    QProcess *m_currentSearchProcess;  // Current ripgrep search process (owned by the method3 thread)
+    QProcess *m_currentMapProcess;     // Current ripgrep mapping process (owned by the KMap caller)
+    QPointer<QThread> m_currentSearchThread;  // Current search thread for method3_async (deletes itself)
+    QMutex m_processMutex;            // Protect the process pointers - never held while a process runs
+    
+    // ===== STREAMING SEARCH STATE =====
+    bool m_streamingMode;              // [RGSearch] StreamingMode in app.ini
+    bool m_resultCache;                // [RGSearch] ResultCache in app.ini
+    bool m_trigramIndex;               // [RGSearch] TrigramIndex in app.ini
+    QString m_resultOrder;             // [RGSearch] ResultOrder in app.ini ("path", "mtime" or "none")
+    int m_maxMatchesPerFile;           // [RGSearch] MaxMatchesPerFile in app.ini (0 = no limit)
+    int m_maxTotalMatches;             // [RGSearch] MaxTotalMatches in app.ini (0 = no limit)
+    bool m_countOnlyFirst;             // [RGSearch] CountOnlyFirst in app.ini
+    bool m_searchCompressed;           // [RGSearch] SearchCompressed in app.ini
+    QElapsedTimer m_streamTimer;       // Time since the streaming search was started
+    FileSearcher *m_fileSearcher;      // Current streaming search (deletes itself when finished)
+    QSharedPointer<SearchFlowControl> m_flowControl;  // Backlog of the last streaming search
+    FileSearcher *m_syncSearcher;      // ripgrep run of K_RGresults_method3 with large files split
+    QList<QPointer<FileSearcher>> m_fileMatchSearchers;  // Running K_FSresults_file searches
+    QMutex m_syncSearcherMutex;        // Protect m_syncSearcher (method3 runs on its own thread)
+    
+    // Connect and start a streaming search backend
+    void startStreamSearch(FileSearcher *searcher, const RGSearchParams &params, const SearchCancelToken &token);
+    
+    // searcher behind the [RGSearch] MaxMatchesPerFile / MaxTotalMatches budgets, if any are set
+    FileSearcher *withResultBudgets(FileSearcher *searcher);
     
     // ===== HELPER FUNCTIONS =====
-    // Parse ripgrep output line and extract match data
-    void parseStreamingLine(const QByteArray &line, QString *current_file, QMap<QString, QVector<Match>> *results);
-    
     // Check if a line is a file heading (e.g., "C:/file.txt")
     bool isFileHeading(const QString &line);
     
@@ -116,37 +212,40 @@ private:
     bool isMatchLine(const QString &line);
     
     // Parse a match line and extract line, column, offset, and text
-    Match parseMatchLine(const QString &line);
+    bool parseMatchLine(const QString &line, int *lineNumber, int *column, qint64 *byteOffset, QString *lineData);
 
 signals:
     // Signal emitted when async search completes with raw output
     void asyncSearchCompleted(const QString &rawOutput);
     
+    // Streaming search: a block of complete JSON lines, and end of the search output
+    void searchOutputChunk(const QByteArray &jsonLines);
+    void searchStreamFinished(int exitCode);
+    
+    // The streaming search reached MaxTotalMatches and was stopped
+    void searchBudgetReached(int matches);
+    
+    // K_FSresults_file: JSON lines of the file's matches (token of the requesting session), and its end
+    void fileSearchOutputChunk(const QByteArray &jsonLines, const SearchCancelToken &token);
+    void fileSearchFinished(const QString &filePath, int exitCode);
+    
     // Signal emitted when async parsing completes
-    void asyncParseCompleted(const QMap<QString, QVector<Match>> &results);
+    void asyncParseCompleted(int totalMatches);
 };
 
 // Data structures
-struct Match {
-    long byte_offset;
-    int line_number;
-    long column;
-    QString match;
-    QString lineData;  // Full line content captured from ripgrep
-};
-
 struct FileMapping {
     QString file_path;
-    QVector<long> line_offsets;
+    QVector<qint64> line_offsets;
 };
 
 // Structure for search result display
 struct SearchResult {
     QString file_path;
     int line_number;
-    long column_offset;
-    long line_start_offset;
-    long line_end_offset;
+    qint64 column_offset;
+    qint64 line_start_offset;
+    qint64 line_end_offset;
     QString line_content;
     QString matched_text;
 };
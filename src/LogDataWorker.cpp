@@ -1,6 +1,7 @@
 #include "LogDataWorker.h"
 #include "logger.h"
 #include "mainwindow.h"
+#include "RipgrepFileSearcher.h"
 #include <QDebug>
 #include <QElapsedTimer>
 #include <QIODevice>
@@ -312,8 +313,8 @@ void LogDataWorker::searchInFileSync(const QString& pattern, bool caseSensitive,
     arguments << fileName_;
     
     // Execute ripgrep synchronously
-    process->start("rg", arguments);
-    LOG_INFO("Amir: ripgrep started with command: rg " + arguments.join(" "));
+    process->start(RipgrepFileSearcher::executable(), arguments);
+    LOG_INFO("Amir: ripgrep started with command: " + RipgrepFileSearcher::executable() + " " + arguments.join(" "));
     process->waitForFinished();
     
     QString output = QString::fromUtf8(process->readAllStandardOutput());
@@ -502,7 +503,7 @@ void LogDataWorker::doIndexing()
         
         chunkNumber++;
         
-        QByteArray block = buffer.left(static_cast<int>(bytesRead));
+        QByteArray block = buffer.left(bytesRead);
         parseDataBlock(pos, block);
         
         pos += bytesRead;
@@ -575,11 +576,11 @@ void LogDataWorker::doIndexing()
 
 void LogDataWorker::parseDataBlock(qint64 blockBeginning, const QByteArray& block)
 {
-    int posWithinBlock = 0;
+    qsizetype posWithinBlock = 0;
     int linesFoundInBlock = 0;
     
     while (posWithinBlock < block.size() && !interruptRequest_) {
-        int nextLinePos = findNextLineFeed(block, posWithinBlock);
+        qsizetype nextLinePos = findNextLineFeed(block, posWithinBlock);
         
         if (nextLinePos == -1) {
             // No more line feeds in this block
@@ -599,12 +600,12 @@ void LogDataWorker::parseDataBlock(qint64 blockBeginning, const QByteArray& bloc
 //    }
 }
 
-int LogDataWorker::findNextLineFeed(const QByteArray& block, int posWithinBlock)
+qsizetype LogDataWorker::findNextLineFeed(const QByteArray& block, qsizetype posWithinBlock)
 {
     // Simple implementation: find next '\n' character
     // KLOGG has more sophisticated handling for different encodings
     
-    for (int i = posWithinBlock; i < block.size(); ++i) {
+    for (qsizetype i = posWithinBlock; i < block.size(); ++i) {
         if (block[i] == '\n') {
             return i;
         }
@@ -85,7 +85,7 @@ private:
     void parseDataBlock(qint64 blockBeginning, const QByteArray& block);
     
     // Find next line feed in the data
-    int findNextLineFeed(const QByteArray& block, int posWithinBlock);
+    qsizetype findNextLineFeed(const QByteArray& block, qsizetype posWithinBlock);
     
     // Load line content using line offsets
     QString loadLineContent(int lineIndex);
@@ -0,0 +1,345 @@
+#include "MappedLineFile.h"
+#include "CachedFileSearcher.h"
+#include "logger.h"
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QThread>
+#include <algorithm>
+#include <cstring>
+
+MappedLineFile::MappedLineFile(const QString &filePath)
+    : m_filePath(filePath)
+    , m_file(filePath)
+    , m_data(nullptr)
+    , m_size(0)
+    , m_indexedBytes(0)
+    , m_indexedNewlines(0)
+    , m_indexed(false)
+    , m_cancel(false)
+    , m_indexThread(nullptr)
+{
+    m_checkpoints.append(0);
+}
+
+MappedLineFile::~MappedLineFile()
+{
+    if (m_indexThread) {
+        m_cancel.store(true);
+        m_indexThread->wait();
+        delete m_indexThread;
+    }
+    if (m_data) {
+        m_file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(m_data)));
+    }
+    m_file.close();
+}
+
+QSharedPointer<MappedLineFile> MappedLineFile::open(const QString &filePath, QString *error)
+{
+    QSharedPointer<MappedLineFile> file(new MappedLineFile(filePath));
+
+    CachedFileSearcher::Fingerprint fingerprint = CachedFileSearcher::fingerprint(filePath);
+    if (!fingerprint.isValid() || !file->m_file.open(QIODevice::ReadOnly)) {
+        *error = "cannot open the file: " + file->m_file.errorString();
+        return QSharedPointer<MappedLineFile>();
+    }
+    file->m_size = file->m_file.size();
+    file->m_fingerprint = fingerprint;
+
+    if (file->m_size > 0) {
+        file->m_data = reinterpret_cast<const char*>(file->m_file.map(0, file->m_size));
+        if (!file->m_data) {
+            *error = "cannot map the file: " + file->m_file.errorString();
+            return QSharedPointer<MappedLineFile>();
+        }
+    }
+
+    // The index thread only reads the mapping, which lives as long as the object
+    MappedLineFile *raw = file.data();
+    file->m_indexThread = QThread::create([raw]() { raw->buildIndex(); });
+    file->m_indexThread->start(QThread::LowPriority);
+
+    LOG_INFO("MappedLineFile: Mapped " + filePath + " (" + QString::number(file->m_size / (1024 * 1024)) + " MB), indexing lines");
+    return file;
+}
+
+bool MappedLineFile::isCurrent() const
+{
+    return CachedFileSearcher::fingerprint(m_filePath) == m_fingerprint;
+}
+
+void MappedLineFile::buildIndex()
+{
+    LOG_INFO("===THREAD=== MappedLineFile index <<<<<STARTed<<<<< " + m_filePath);
+    QElapsedTimer timer;
+    timer.start();
+
+    QVector<qint64> found;
+    qint64 newlines = 0;
+    qint64 offset = 0;
+    while (offset < m_size && !m_cancel.load()) {
+        qint64 end = qMin(m_size, offset + IndexPublishBytes);
+        const char *p = m_data + offset;
+        const char *stop = m_data + end;
+        while (p < stop) {
+            const char *newline = static_cast<const char*>(memchr(p, '\n', size_t(stop - p)));
+            if (!newline) {
+                break;
+            }
+            p = newline + 1;
+            if (++newlines % LineIndexStride == 0) {
+                found.append(p - m_data);
+            }
+        }
+        offset = end;
+
+        QMutexLocker locker(&m_mutex);
+        m_checkpoints += found;
+        m_indexedBytes = offset;
+        m_indexedNewlines = newlines;
+        found.clear();
+
+        // Estimated line starts the index has reached are found exactly from now on
+        for (QMap<qint64, qint64>::iterator it = m_estimates.begin(); it != m_estimates.end(); ) {
+            if (it.value() < offset) {
+                it = m_estimates.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    if (!m_cancel.load()) {
+        QMutexLocker locker(&m_mutex);
+        m_estimates.clear();
+        m_indexed.store(true);
+    }
+    LOG_INFO("===THREAD=== MappedLineFile index >>>>>ENDed>>>>> " + QString::number(lineCount()) + " lines in " +
+             QString::number(timer.elapsed()) + " ms" + (m_cancel.load() ? " (cancelled)" : ""));
+}
+
+qint64 MappedLineFile::lineCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_indexed.load()) {
+        bool unterminated = m_size > 0 && m_data[m_size - 1] != '\n';
+        return m_indexedNewlines + (unterminated ? 1 : 0);
+    }
+    if (m_indexedBytes == 0) {
+        return 1;
+    }
+    return qMax<qint64>(1, qint64(double(m_indexedNewlines) * double(m_size) / double(m_indexedBytes)));
+}
+
+qint64 MappedLineFile::skipLines(qint64 offset, qint64 lines) const
+{
+    const char *p = m_data + offset;
+    const char *end = m_data + m_size;
+    for (qint64 i = 0; i < lines; ++i) {
+        const char *newline = p < end ? static_cast<const char*>(memchr(p, '\n', size_t(end - p))) : nullptr;
+        if (!newline) {
+            return m_size;
+        }
+        p = newline + 1;
+    }
+    return p - m_data;
+}
+
+qint64 MappedLineFile::skipLinesBack(qint64 offset, qint64 lines) const
+{
+    qint64 start = offset;
+    for (qint64 i = 0; i < lines && start > 0; ++i) {
+        // Back over the newline ending the previous line to the one before it
+        --start;
+        while (start > 0 && m_data[start - 1] != '\n') {
+            --start;
+        }
+    }
+    return start;
+}
+
+qint64 MappedLineFile::nextLineStart(qint64 offset) const
+{
+    if (offset <= 0) {
+        return 0;
+    }
+    if (offset >= m_size) {
+        return m_size;
+    }
+    if (m_data[offset - 1] == '\n') {
+        return offset;
+    }
+    const char *newline = static_cast<const char*>(memchr(m_data + offset, '\n', size_t(m_size - offset)));
+    return newline ? (newline + 1 - m_data) : m_size;
+}
+
+qint64 MappedLineFile::sampleBytesPerLine() const
+{
+    qint64 bytes = qMin(m_size, EstimateSampleBytes);
+    qint64 newlines = 0;
+    const char *p = m_data;
+    const char *end = m_data + bytes;
+    while (p < end) {
+        const char *newline = static_cast<const char*>(memchr(p, '\n', size_t(end - p)));
+        if (!newline) {
+            break;
+        }
+        ++newlines;
+        p = newline + 1;
+    }
+    return qMax<qint64>(1, bytes / qMax<qint64>(1, newlines));
+}
+
+qint64 MappedLineFile::lineOffset(qint64 line, bool *estimated) const
+{
+    if (estimated) {
+        *estimated = false;
+    }
+    if (line <= 1 || m_size == 0) {
+        return 0;
+    }
+
+    qint64 from;
+    qint64 skip;
+    bool back = false;
+    bool fromEstimate = false;
+    qint64 bytesPerLine = 0;
+    bool estimate;
+    {
+        QMutexLocker locker(&m_mutex);
+        qint64 checkpoint = qMin<qint64>((line - 1) / LineIndexStride, m_checkpoints.size() - 1);
+        from = m_checkpoints[checkpoint];
+        skip = (line - 1) - checkpoint * LineIndexStride;
+
+        // A hint or an earlier estimate nearer than the checkpoint, after the line or before it
+        auto nearer = [&](const QMap<qint64, qint64> &anchors, bool isEstimate) {
+            QMap<qint64, qint64>::const_iterator anchor = anchors.lowerBound(line);
+            if (anchor != anchors.constEnd() && anchor.key() - line < skip) {
+                from = anchor.value();
+                skip = anchor.key() - line;
+                back = true;
+                fromEstimate = isEstimate;
+            }
+            if (anchor != anchors.constBegin()) {
+                --anchor;
+                if (line - anchor.key() < skip) {
+                    from = anchor.value();
+                    skip = line - anchor.key();
+                    back = false;
+                    fromEstimate = isEstimate;
+                }
+            }
+        };
+        nearer(m_hints, false);
+        nearer(m_estimates, true);
+
+        estimate = skip > LineIndexStride && !m_indexed.load();
+        if (estimate && m_indexedNewlines > 0) {
+            bytesPerLine = qMax<qint64>(1, m_indexedBytes / m_indexedNewlines);
+        }
+    }
+
+    if (!estimate) {
+        if (estimated) {
+            *estimated = fromEstimate;
+        }
+        return back ? skipLinesBack(from, skip) : skipLines(from, skip);
+    }
+
+    // Scanning that far past the index would stall the caller: project the offset from the bytes
+    // per line seen so far and take the next line start. Lines near it are counted from it until
+    // the index gets there.
+    if (bytesPerLine <= 0) {
+        bytesPerLine = sampleBytesPerLine();
+    }
+    qint64 distance = skip * bytesPerLine;
+    qint64 offset = back ? nextLineStart(qMax<qint64>(0, from - distance)) : nextLineStart(qMin(m_size, from + distance));
+    if (back) {
+        offset = qMin(offset, from);
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_estimates.size() >= MaxLineHints) {
+            m_estimates.clear();
+        }
+        m_estimates.insert(line, offset);
+    }
+    if (estimated) {
+        *estimated = true;
+    }
+    return offset;
+}
+
+qint64 MappedLineFile::lineAt(qint64 offset) const
+{
+    qint64 from;
+    qint64 line;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_indexed.load() && offset > m_indexedBytes) {
+            return -1;
+        }
+        qint64 checkpoint = (std::upper_bound(m_checkpoints.constBegin(), m_checkpoints.constEnd(), offset) -
+                             m_checkpoints.constBegin()) - 1;
+        from = m_checkpoints[checkpoint];
+        line = checkpoint * LineIndexStride + 1;
+    }
+
+    // At most LineIndexStride newlines to the checkpoint
+    const char *p = m_data + from;
+    const char *end = m_data + qMin(offset, m_size);
+    while (p < end) {
+        const char *newline = static_cast<const char*>(memchr(p, '\n', size_t(end - p)));
+        if (!newline) {
+            break;
+        }
+        ++line;
+        p = newline + 1;
+    }
+    return line;
+}
+
+void MappedLineFile::addLineHint(qint64 line, qint64 offset, const FileFingerprint &source)
+{
+    // An offset from another version of the file may land on any line start
+    if (!source.isValid() || source != m_fingerprint) {
+        LOG_INFO("MappedLineFile: Hint for line " + QString::number(line) + " of " + m_filePath +
+                 " is from " + (source.isValid() ? "another version of the file" : "an unknown version of the file") +
+                 " - ignored");
+        return;
+    }
+    if (line < 1 || offset < 0 || offset > m_size || (offset > 0 && m_data[offset - 1] != '\n')) {
+        LOG_WARNING("MappedLineFile: Offset " + QString::number(offset) + " given for line " + QString::number(line) +
+                    " of " + m_filePath + " does not start a line - ignored");
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_hints.size() >= MaxLineHints) {
+        m_hints.clear();
+    }
+    m_hints.insert(line, offset);
+}
+
+QByteArray MappedLineFile::readLines(qint64 firstLine, qint64 lines, qint64 maxBytes, qint64 *startOffset,
+                                     bool *estimated) const
+{
+    qint64 start = lineOffset(firstLine, estimated);
+    if (startOffset) {
+        *startOffset = start;
+    }
+    qint64 end = skipLines(start, lines);
+    if (end - start > maxBytes) {
+        // Whole lines up to maxBytes, or the start of a line longer than that
+        qint64 cut = start + maxBytes;
+        while (cut > start && m_data[cut - 1] != '\n') {
+            --cut;
+        }
+        end = cut > start ? cut : start + maxBytes;
+    }
+
+    QByteArray text(m_data + start, int(end - start));
+    text.replace('\0', ' ');
+    return text;
+}
@@ -0,0 +1,105 @@
+#ifndef MAPPEDLINEFILE_H
+#define MAPPEDLINEFILE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QMap>
+#include <QFile>
+#include <QMutex>
+#include <QSharedPointer>
+#include <atomic>
+#include "FileFingerprint.h"
+
+class QThread;
+
+// A plain file mapped once and shared by the viewer. Lines are found through a sparse line index
+// - the offset of every LineIndexStride-th line - that a worker thread builds from the mapping,
+// so the first lines of a file can be shown as soon as it is mapped, whatever its size. A line
+// costs at most skipping LineIndexStride lines from its checkpoint. Line offsets known from
+// elsewhere - ripgrep's absolute_offset of a match - are kept as hints, so the lines around a
+// match are found at once however far the index is behind. A line beyond the indexed part and
+// far from any hint is not scanned for: its offset is estimated from the bytes per line indexed
+// so far, and lines near it are counted from that estimate until the index gets there. Only the
+// lines asked for are copied.
+class MappedLineFile
+{
+public:
+    // Mapped file with its index being built; nullptr with error set if it cannot be mapped
+    static QSharedPointer<MappedLineFile> open(const QString &filePath, QString *error);
+    ~MappedLineFile();
+
+    QString filePath() const { return m_filePath; }
+    qint64 size() const { return m_size; }
+
+    // False once the file changed since it was mapped
+    bool isCurrent() const;
+
+    // Version of the file that is mapped
+    FileFingerprint fingerprint() const { return m_fingerprint; }
+
+    // Line index complete: lineCount() is exact
+    bool isIndexed() const { return m_indexed.load(); }
+
+    // Lines of the file; while it is still indexed, projected from the part indexed so far
+    qint64 lineCount() const;
+
+    // Offset of the start of line (1-based), size() past the last line. *estimated is set when
+    // the index has not reached the line yet and the offset is the start of a line near it.
+    qint64 lineOffset(qint64 line, bool *estimated = nullptr) const;
+
+    // Number of the line starting at offset, -1 while the index has not reached it
+    qint64 lineAt(qint64 offset) const;
+    
+    // Offset of line (1-based) known from elsewhere; lines near it are found from there, before
+    // or after it. source is the version of the file the offset was found in: the hint is
+    // ignored unless that is the mapped one, or if offset does not start a line.
+    void addLineHint(qint64 line, qint64 offset, const FileFingerprint &source);
+
+    // Lines [firstLine, firstLine + lines) with their terminators and NULs as spaces, at most
+    // maxBytes of them (the last line is cut if a single line is longer); their file offset in
+    // *startOffset; *estimated as for lineOffset
+    QByteArray readLines(qint64 firstLine, qint64 lines, qint64 maxBytes, qint64 *startOffset = nullptr,
+                         bool *estimated = nullptr) const;
+
+private:
+    explicit MappedLineFile(const QString &filePath);
+
+    void buildIndex();              // Index thread
+
+    // Offset after the next lines newlines from offset, size() if there are fewer
+    qint64 skipLines(qint64 offset, qint64 lines) const;
+    
+    // Start of the line lines lines before the one starting at offset, 0 if there are fewer
+    qint64 skipLinesBack(qint64 offset, qint64 lines) const;
+
+    // offset if it starts a line, else the start of the next line
+    qint64 nextLineStart(qint64 offset) const;
+
+    // Bytes per line at the start of the file, for estimates before the index published any
+    qint64 sampleBytesPerLine() const;
+
+    QString m_filePath;
+    QFile m_file;
+    const char *m_data;
+    qint64 m_size;
+    FileFingerprint m_fingerprint;
+
+    // Published by the index thread in steps of IndexPublishBytes
+    mutable QMutex m_mutex;
+    QVector<qint64> m_checkpoints;  // Offset of line i * LineIndexStride + 1
+    QMap<qint64, qint64> m_hints;   // Offset by line, from addLineHint
+    mutable QMap<qint64, qint64> m_estimates;   // Estimated offset by line, until the index reaches it
+    qint64 m_indexedBytes;
+    qint64 m_indexedNewlines;
+    std::atomic<bool> m_indexed;
+    std::atomic<bool> m_cancel;
+    QThread *m_indexThread;
+
+    static constexpr qint64 LineIndexStride = 1024;
+    static constexpr qint64 IndexPublishBytes = 16 * 1024 * 1024;
+    static constexpr int MaxLineHints = 4096;
+    static constexpr qint64 EstimateSampleBytes = 1024 * 1024;
+};
+
+#endif // MAPPEDLINEFILE_H
@@ -0,0 +1,231 @@
+#include "NativeFileSearcher.h"
+#include "logger.h"
+#include <QVector>
+#include <QPair>
+#include <cstring>
+
+namespace {
+
+// Regular expressions run over decoded blocks of about this size, cut at a newline
+constexpr qint64 NATIVE_REGEX_BLOCK_SIZE = 4LL * 1024 * 1024;
+
+// Groups matches (reported in ascending order) into matched lines and writes one
+// match record per line
+struct LineCollector {
+    const QString *filePath = nullptr;
+    FileSearchRecordWriter *writer = nullptr;
+    const char *data = nullptr;
+    qint64 size = 0;
+
+    // Line counting - newlines are counted once, forward only
+    qint64 countedPos = 0;
+    qint64 countedLineStart = 0;
+    qint64 countedLineNumber = 1;
+
+    // Matched line waiting to be written (lineStart < 0 = none)
+    qint64 lineStart = -1;
+    qint64 lineEnd = -1;
+    qint64 lineNumber = 0;
+    QVector<QPair<qint64, qint64>> submatches;  // Relative to lineStart
+
+    int matchedLines = 0;
+    int matches = 0;
+
+    void flush()
+    {
+        if (lineStart < 0) {
+            return;
+        }
+
+        // rg includes the line terminator in lines.text
+        qint64 textEnd = (lineEnd < size) ? lineEnd + 1 : lineEnd;
+        QByteArray lineBytes = QByteArray::fromRawData(data + lineStart, int(textEnd - lineStart));
+        if (writer->match(*filePath, lineNumber, lineStart, lineBytes, submatches)) {
+            matchedLines++;
+            matches += submatches.size();
+        }
+        lineStart = -1;
+        submatches.clear();
+    }
+
+    void add(qint64 from, qint64 to)
+    {
+        if (lineStart >= 0 && from <= lineEnd) {
+            submatches.append(qMakePair(from - lineStart, qMin(to, lineEnd) - lineStart));
+            return;
+        }
+
+        flush();
+
+        // Count newlines up to the start of the match
+        const char *p = data + countedPos;
+        const char *end = data + from;
+        while (p < end) {
+            const void *nl = memchr(p, '\n', size_t(end - p));
+            if (!nl) {
+                break;
+            }
+            p = static_cast<const char*>(nl) + 1;
+            countedLineNumber++;
+            countedLineStart = p - data;
+        }
+        countedPos = from;
+
+        const void *nl = memchr(data + from, '\n', size_t(size - from));
+        lineStart = countedLineStart;
+        lineEnd = nl ? static_cast<const char*>(nl) - data : size;
+        lineNumber = countedLineNumber;
+        submatches.append(qMakePair(from - lineStart, qMin(to, lineEnd) - lineStart));
+    }
+};
+
+// Maps UTF-16 positions of a decoded block back to UTF-8 byte positions, moving forward only
+struct Utf16ToByteCursor {
+    const QString *text = nullptr;
+    qsizetype charPos = 0;
+    qint64 bytePos = 0;
+
+    qint64 advanceTo(qsizetype target)
+    {
+        while (charPos < target) {
+            ushort c = text->at(charPos).unicode();
+            if (QChar::isHighSurrogate(c) && charPos + 1 < text->size()) {
+                bytePos += 4;
+                charPos += 2;
+            } else {
+                bytePos += (c < 0x80) ? 1 : (c < 0x800) ? 2 : 3;
+                charPos++;
+            }
+        }
+        return bytePos;
+    }
+};
+
+} // namespace
+
+NativeFileSearcher::NativeFileSearcher(QObject *parent)
+    : MappedFileSearcher(parent)
+    , m_useLiteral(false)
+    , m_regexOptions(QRegularExpression::NoPatternOption)
+{
+}
+
+NativeFileSearcher::~NativeFileSearcher()
+{
+}
+
+bool NativeFileSearcher::prepare(const RGSearchParams &params, QString *error)
+{
+    // Smart case: case-insensitive unless the pattern contains an uppercase letter
+    bool caseless = false;
+    if (params.case_sensitive) {
+        caseless = false;
+    } else if (params.ignore_case) {
+        caseless = true;
+    } else if (params.smart_case) {
+        caseless = (params.pattern + params.add_pattern).toLower() == (params.pattern + params.add_pattern);
+    }
+
+    m_useLiteral = params.fixed_string && !caseless && params.add_pattern.isEmpty();
+    if (m_useLiteral) {
+        m_literal.setPattern(params.pattern.toUtf8());
+        LOG_INFO("NativeFileSearcher: Literal byte search for: " + params.pattern);
+        return true;
+    }
+
+    QStringList alternatives;
+    alternatives << params.pattern;
+    if (!params.add_pattern.isEmpty()) {
+        alternatives << params.add_pattern;
+    }
+    for (QString &alternative : alternatives) {
+        alternative = "(?:" + (params.fixed_string ? QRegularExpression::escape(alternative) : alternative) + ")";
+    }
+
+    // MultilineOption makes ^ and $ match at line boundaries like ripgrep
+    m_regexPattern = alternatives.join('|');
+    m_regexOptions = QRegularExpression::MultilineOption;
+    if (caseless) {
+        m_regexOptions |= QRegularExpression::CaseInsensitiveOption;
+    }
+
+    QRegularExpression regex(m_regexPattern, m_regexOptions);
+    if (!regex.isValid()) {
+        *error = QString("Invalid regular expression: %1").arg(regex.errorString());
+        return false;
+    }
+
+    LOG_INFO("NativeFileSearcher: Regular expression search for: " + m_regexPattern +
+             (caseless ? " (case insensitive)" : ""));
+    return true;
+}
+
+void *NativeFileSearcher::createThreadState()
+{
+    if (m_useLiteral) {
+        return nullptr;
+    }
+
+    // Each worker gets its own compiled expression
+    QRegularExpression *regex = new QRegularExpression(m_regexPattern, m_regexOptions);
+    regex->optimize();
+    return regex;
+}
+
+void NativeFileSearcher::destroyThreadState(void *state)
+{
+    delete static_cast<QRegularExpression*>(state);
+}
+
+MappedFileSearcher::FileScanResult NativeFileSearcher::scanFile(const QString &filePath, const char *data, qint64 size,
+                                                                FileSearchRecordWriter &writer, void *threadState)
+{
+    LineCollector lines;
+    lines.filePath = &filePath;
+    lines.writer = &writer;
+    lines.data = data;
+    lines.size = size;
+
+    if (m_useLiteral) {
+        qsizetype patternLength = m_literal.pattern().size();
+        for (qsizetype pos = m_literal.indexIn(data, size, 0); pos >= 0 && !isCancelled() && !writer.fileFull();
+             pos = m_literal.indexIn(data, size, pos + qMax<qsizetype>(1, patternLength))) {
+            lines.add(pos, pos + patternLength);
+        }
+    } else {
+        const QRegularExpression *regex = static_cast<const QRegularExpression*>(threadState);
+        for (qint64 blockStart = 0; blockStart < size && !isCancelled() && !writer.fileFull(); ) {
+            qint64 blockEnd = qMin(size, blockStart + NATIVE_REGEX_BLOCK_SIZE);
+            if (blockEnd < size) {
+                const void *nl = memchr(data + blockEnd, '\n', size_t(size - blockEnd));
+                blockEnd = nl ? (static_cast<const char*>(nl) - data) + 1 : size;
+            }
+
+            QString text = QString::fromUtf8(data + blockStart, qsizetype(blockEnd - blockStart));
+            // Same length means one QChar per byte, so positions need no conversion
+            bool sameOffsets = (text.size() == blockEnd - blockStart);
+            Utf16ToByteCursor cursor;
+            cursor.text = &text;
+
+            QRegularExpressionMatchIterator it = regex->globalMatch(text);
+            while (it.hasNext() && !isCancelled() && !writer.fileFull()) {
+                QRegularExpressionMatch match = it.next();
+                qint64 from = match.capturedStart();
+                qint64 to = match.capturedEnd();
+                if (!sameOffsets) {
+                    from = cursor.advanceTo(match.capturedStart());
+                    Utf16ToByteCursor endCursor = cursor;
+                    to = endCursor.advanceTo(match.capturedEnd());
+                }
+                lines.add(blockStart + from, blockStart + to);
+            }
+            blockStart = blockEnd;
+        }
+    }
+    lines.flush();
+
+    FileScanResult result;
+    result.matchedLines = lines.matchedLines;
+    result.matches = lines.matches;
+    return result;
+}
@@ -0,0 +1,35 @@
+#ifndef NATIVEFILESEARCHER_H
+#define NATIVEFILESEARCHER_H
+
+#include <QRegularExpression>
+#include <QByteArrayMatcher>
+#include "filesearcher.h"
+
+// Built-in search backend without external tools ("builtin" in Preferences).
+// Literal case-sensitive searches use QByteArrayMatcher directly on the mapped bytes,
+// everything else runs QRegularExpression over newline-aligned decoded blocks.
+class NativeFileSearcher : public MappedFileSearcher
+{
+    Q_OBJECT
+
+public:
+    explicit NativeFileSearcher(QObject *parent = nullptr);
+    ~NativeFileSearcher();
+
+    QString engineName() const override { return "builtin"; }
+
+protected:
+    bool prepare(const RGSearchParams &params, QString *error) override;
+    void *createThreadState() override;
+    void destroyThreadState(void *state) override;
+    FileScanResult scanFile(const QString &filePath, const char *data, qint64 size,
+                            FileSearchRecordWriter &writer, void *threadState) override;
+
+private:
+    bool m_useLiteral;                       // Byte search instead of a regular expression
+    QByteArrayMatcher m_literal;
+    QString m_regexPattern;
+    QRegularExpression::PatternOptions m_regexOptions;
+};
+
+#endif // NATIVEFILESEARCHER_H
@@ -0,0 +1,327 @@
+#include "OrderedFileSearcher.h"
+#include "CachedFileSearcher.h"
+#include "RgJsonParser.h"
+#include "logger.h"
+#include <QDir>
+#include <QSettings>
+#include <QThread>
+#include <algorithm>
+#include <cstring>
+
+OrderedFileSearcher::OrderedFileSearcher(FileSearcher *engine, Order order, QObject *parent)
+    : FileSearcher(parent)
+    , m_engine(engine)
+    , m_order(order)
+    , m_windowBytes(64LL * 1024 * 1024)
+    , m_head(0)
+    , m_heldBytes(0)
+    , m_peakHeldBytes(0)
+    , m_earlyReleases(0)
+{
+    m_engine->setParent(this);
+
+    QSettings settings("app.ini", QSettings::IniFormat);
+    settings.beginGroup("RGSearch");
+    m_windowBytes = qMax(1LL, settings.value("ReorderWindowMB", 64).toLongLong()) * 1024 * 1024;
+    settings.endGroup();
+
+    // Engine output is held back and released in order
+    connect(m_engine, &FileSearcher::outputChunk, this, [this](const QByteArray &jsonLines) {
+        filterEngineChunk(jsonLines);
+    }, Qt::DirectConnection);
+    connect(m_engine, &FileSearcher::fileSearched, this, [this](const QString &filePath) {
+        fileDone(filePath);
+    }, Qt::DirectConnection);
+    connect(m_engine, &FileSearcher::finished, this, [this](int exitCode) {
+        finishRun(exitCode);
+    });
+    connect(m_engine, &FileSearcher::errorOccurred, this, &FileSearcher::errorOccurred, Qt::DirectConnection);
+}
+
+OrderedFileSearcher::~OrderedFileSearcher()
+{
+}
+
+bool OrderedFileSearcher::orderFromName(const QString &name, Order *order)
+{
+    if (name.compare("path", Qt::CaseInsensitive) == 0) {
+        *order = PathOrder;
+        return true;
+    }
+    if (name.compare("mtime", Qt::CaseInsensitive) == 0) {
+        *order = ModifiedOrder;
+        return true;
+    }
+    return false;
+}
+
+QString OrderedFileSearcher::engineName() const
+{
+    return m_engine->engineName();
+}
+
+bool OrderedFileSearcher::canSearchTargets(const QVector<SearchTarget> &targets) const
+{
+    return m_engine->canSearchTargets(targets);
+}
+
+QStringList OrderedFileSearcher::candidateFiles(const RGSearchParams &params) const
+{
+    return m_engine->candidateFiles(params);
+}
+
+void OrderedFileSearcher::start(const RGSearchParams &params)
+{
+    m_cancelled.store(false);
+    m_engine->setCancelToken(m_cancelToken);
+    m_engine->setFlowControl(m_flowControl);
+    m_params = params;
+    m_sortedTargets.clear();
+    m_positions.clear();
+    {
+        QMutexLocker locker(&m_mutex);
+        m_rawPositions.clear();
+        m_done.clear();
+        m_head = 0;
+        m_held.clear();
+        m_heldBytes = 0;
+        m_peakHeldBytes = 0;
+        m_lateFiles.clear();
+        m_earlyReleases = 0;
+        m_summary.clear();
+    }
+    m_timer.start();
+
+    // Listing and sorting every file runs off the UI thread
+    QThread *thread = QThread::create([this]() {
+        prepareRun();
+    });
+    connect(thread, &QThread::finished, this, [this, thread]() {
+        thread->deleteLater();
+        startEngine();
+    });
+    thread->start();
+}
+
+void OrderedFileSearcher::cancel()
+{
+    FileSearcher::cancel();
+    m_engine->cancel();
+}
+
+QString OrderedFileSearcher::sortKey(const QString &filePath) const
+{
+    QString pathKey = QDir::fromNativeSeparators(filePath).toLower();
+    if (m_order == PathOrder) {
+        return pathKey;
+    }
+
+    // Zero padded so the string order is the time order
+    qint64 modified = qMax<qint64>(0, CachedFileSearcher::fingerprint(filePath).modified);
+    return QString("%1|").arg(modified, 20, 10, QChar('0')) + pathKey;
+}
+
+QString OrderedFileSearcher::lookupKey(const QString &filePath)
+{
+    return QDir::cleanPath(QDir::fromNativeSeparators(filePath));
+}
+
+void OrderedFileSearcher::prepareRun()
+{
+    LOG_INFO("OrderedFileSearcher: ===THREAD=== prepareRun for path: " + m_params.path + " <<<<<STARTed<<<<<");
+
+    try {
+        // ===== STEP 1: CANDIDATE FILES =====
+        // Targets set on the engine itself (e.g. a refine search) are its candidates
+        QVector<SearchTarget> candidates = m_targets;
+        if (!m_hasTargets) {
+            for (const QString &filePath : m_engine->candidateFiles(m_params)) {
+                SearchTarget target;
+                target.filePath = filePath;
+                candidates.append(target);
+            }
+        }
+
+        // ===== STEP 2: SORT THEM =====
+        QVector<QPair<QString, int>> keys;
+        keys.reserve(candidates.size());
+        for (int i = 0; i < candidates.size(); ++i) {
+            if (isCancelled()) {
+                return;
+            }
+            keys.append(qMakePair(sortKey(candidates[i].filePath), i));
+        }
+        std::stable_sort(keys.begin(), keys.end(), [](const QPair<QString, int> &a, const QPair<QString, int> &b) {
+            return a.first < b.first;
+        });
+
+        m_sortedTargets.reserve(keys.size());
+        for (const QPair<QString, int> &key : keys) {
+            m_positions.insert(lookupKey(candidates[key.second].filePath), m_sortedTargets.size());
+            m_sortedTargets.append(candidates[key.second]);
+        }
+
+        LOG_INFO("OrderedFileSearcher: " + QString::number(m_sortedTargets.size()) + " files sorted by " +
+                 (m_order == PathOrder ? "path" : "modification time") + " after " +
+                 QString::number(m_timer.elapsed()) + " ms");
+
+    } catch (const std::exception &e) {
+        LOG_ERROR("OrderedFileSearcher: Exception in prepareRun: " + QString(e.what()));
+    } catch (...) {
+        LOG_ERROR("OrderedFileSearcher: Unknown exception in prepareRun");
+    }
+
+    LOG_INFO("OrderedFileSearcher: ===THREAD=== prepareRun for path: " + m_params.path + " >>>>>ENDed>>>>>");
+}
+
+void OrderedFileSearcher::startEngine()
+{
+    if (isCancelled()) {
+        finishRun(1);
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_done = QVector<bool>(m_sortedTargets.size(), false);
+    }
+
+    // The engine takes the files in this order, so the head is usually among the first it finishes
+    m_engine->setTargets(m_sortedTargets);
+    m_engine->start(m_params);
+}
+
+void OrderedFileSearcher::filterEngineChunk(const QByteArray &jsonLines)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // Records of the head file and of files the head has passed go out at once, with anything
+    // the head moving on releases
+    QByteArray output;
+
+    RgJsonRecord record;
+    const char *data = jsonLines.constData();
+    const char *end = data + jsonLines.size();
+    for (const char *lineStart = data; lineStart < end; ) {
+        const char *lineEnd = static_cast<const char*>(memchr(lineStart, '\n', size_t(end - lineStart)));
+        const char *next = lineEnd ? lineEnd + 1 : end;
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+        QByteArrayView line(lineStart, lineEnd - lineStart);
+        lineStart = next;
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        if (!RgJsonParser::parseLine(line, &record) || record.path.isNull()) {
+            if (record.type == RgJsonRecord::Summary) {
+                m_summary = line.toByteArray() + '\n';
+            } else {
+                output.append(line.data(), line.size());
+                output.append('\n');
+            }
+            continue;
+        }
+
+        // Consecutive records mostly share a file - the decoded path is looked up once per file
+        QByteArray rawPath = record.path.raw.toByteArray();
+        auto positionIt = m_rawPositions.constFind(rawPath);
+        if (positionIt == m_rawPositions.constEnd()) {
+            positionIt = m_rawPositions.insert(rawPath, m_positions.value(lookupKey(record.path.toString()), -1));
+        }
+        int position = positionIt.value();
+
+        if (position < 0 || position <= m_head) {
+            if (position >= 0 && position < m_head) {
+                m_lateFiles.insert(position);
+            }
+            output.append(line.data(), line.size());
+            output.append('\n');
+            continue;
+        }
+
+        QByteArray &held = m_held[position];
+        held.append(line.data(), line.size());
+        held.append('\n');
+        m_heldBytes += line.size() + 1;
+    }
+
+    // Over the cap the first held file goes out early - files before it that are not done are late
+    m_peakHeldBytes = qMax(m_peakHeldBytes, m_heldBytes);
+    while (m_heldBytes > m_windowBytes && !m_held.isEmpty()) {
+        m_head = m_held.firstKey();
+        m_earlyReleases++;
+        advance(&output);
+    }
+
+    // Emitted while locked so chunks reach the parser in release order
+    if (!output.isEmpty()) {
+        emit outputChunk(output);
+    }
+}
+
+void OrderedFileSearcher::fileDone(const QString &filePath)
+{
+    QMutexLocker locker(&m_mutex);
+
+    int position = m_positions.value(lookupKey(filePath), -1);
+    if (position < 0 || position >= m_done.size()) {
+        return;
+    }
+    m_done[position] = true;
+    if (position != m_head) {
+        return;
+    }
+
+    QByteArray output;
+    advance(&output);
+    if (!output.isEmpty()) {
+        emit outputChunk(output);
+    }
+}
+
+void OrderedFileSearcher::advance(QByteArray *output)
+{
+    while (m_head < m_done.size()) {
+        auto it = m_held.find(m_head);
+        if (it != m_held.end()) {
+            output->append(it.value());
+            m_heldBytes -= it.value().size();
+            m_held.erase(it);
+        }
+        if (!m_done[m_head]) {
+            break;
+        }
+        m_head++;
+    }
+}
+
+void OrderedFileSearcher::finishRun(int engineExitCode)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+
+        // Files a cancel left out (or that were never reported) still go out in order
+        QByteArray output;
+        for (const QByteArray &held : m_held) {
+            output.append(held);
+        }
+        m_held.clear();
+        m_heldBytes = 0;
+        output.append(m_summary);
+        m_summary.clear();
+        if (!output.isEmpty()) {
+            emit outputChunk(output);
+        }
+
+        LOG_INFO("OrderedFileSearcher: " + QString::number(m_head) + " of " + QString::number(m_done.size()) +
+                 " files released in " + (m_order == PathOrder ? "path" : "modification time") + " order, " +
+                 QString::number(m_lateFiles.size()) + " late after " + QString::number(m_earlyReleases) +
+                 " early releases (cap " + QString::number(m_windowBytes / (1024 * 1024)) + " MB, peak " +
+                 QString::number(m_peakHeldBytes / 1024) + " KB held) after " +
+                 QString::number(m_timer.elapsed()) + " ms");
+    }
+
+    emit finished(engineExitCode);
+}
@@ -0,0 +1,84 @@
+#ifndef ORDEREDFILESEARCHER_H
+#define ORDEREDFILESEARCHER_H
+
+#include <QMutex>
+#include <QMap>
+#include <QHash>
+#include <QSet>
+#include <QElapsedTimer>
+#include "filesearcher.h"
+
+// Deterministic result order in front of a search backend that reports files in completion order.
+// The candidate files (the targets, else the engine's candidateFiles) are sorted by path or
+// modification time before the search and handed to the engine in that order. Records of the
+// first file not reported searched yet go out as they arrive; those of later files are held until
+// every file before them is done (fileSearched, sent for files without a match too), so identical
+// searches fill the results tree the same way while the results still stream. Held records are
+// capped at [RGSearch] ReorderWindowMB: above it the first held file goes out early, and records of
+// files it overtook are passed on at once and counted as late.
+class OrderedFileSearcher : public FileSearcher
+{
+    Q_OBJECT
+
+public:
+    enum Order {
+        PathOrder,          // Case-insensitive path
+        ModifiedOrder       // Last write time, oldest first
+    };
+
+    // Takes ownership of engine
+    OrderedFileSearcher(FileSearcher *engine, Order order, QObject *parent = nullptr);
+    ~OrderedFileSearcher();
+
+    // "path" or "mtime" ([RGSearch] ResultOrder in app.ini), false for anything else
+    static bool orderFromName(const QString &name, Order *order);
+
+    // ResultOrder when app.ini has none
+    static constexpr const char *DefaultOrderName = "path";
+
+    QString engineName() const override;
+
+    void start(const RGSearchParams &params) override;
+    void cancel() override;
+
+    bool canSearchTargets(const QVector<SearchTarget> &targets) const override;
+    QStringList candidateFiles(const RGSearchParams &params) const override;
+
+private:
+    // ===== RUN STAGES =====
+    void prepareRun();                                  // Search thread: list and sort the files
+    void startEngine();
+    void filterEngineChunk(const QByteArray &jsonLines);
+    void fileDone(const QString &filePath);
+    void finishRun(int engineExitCode);
+
+    // Hand on the held records of the head file and move the head past the files that are done
+    void advance(QByteArray *output);
+
+    QString sortKey(const QString &filePath) const;
+    static QString lookupKey(const QString &filePath);
+
+    FileSearcher *m_engine;
+    Order m_order;
+    qint64 m_windowBytes;
+    RGSearchParams m_params;
+    QElapsedTimer m_timer;
+
+    // Set up by prepareRun before the engine starts
+    QVector<SearchTarget> m_sortedTargets;
+    QHash<QString, int> m_positions;        // lookupKey -> position in m_sortedTargets
+
+    // Engine output arrives from its worker threads
+    QMutex m_mutex;
+    QHash<QByteArray, int> m_rawPositions;  // data.path as the engine wrote it -> position, -1 unknown
+    QVector<bool> m_done;
+    int m_head;                             // First file not done - its records go out directly
+    QMap<int, QByteArray> m_held;           // Records of later files by position
+    qint64 m_heldBytes;
+    qint64 m_peakHeldBytes;
+    QSet<int> m_lateFiles;                  // Records arrived after the head had passed the file
+    int m_earlyReleases;
+    QByteArray m_summary;                   // Sent after the last file
+};
+
+#endif // ORDEREDFILESEARCHER_H
@@ -0,0 +1,277 @@
+#include "ProximityFileSearcher.h"
+#include "BatchFileSearcher.h"
+#include "RgJsonParser.h"
+#include "logger.h"
+#include <QStringList>
+#include <cstring>
+#include <limits>
+
+ProximityFileSearcher::ProximityFileSearcher(FileSearcher *engine, const ProximityQuery &query, QObject *parent)
+    : FileSearcher(parent)
+    , m_batch(nullptr)
+    , m_query(query)
+    , m_qualifiedFiles(0)
+    , m_droppedFiles(0)
+{
+    m_query.terms = m_query.terms.mid(0, BatchFileSearcher::MaxPatterns);
+    m_batch = new BatchFileSearcher(engine, m_query.terms, this);
+
+    connect(m_batch, &FileSearcher::outputChunk, this, [this](const QByteArray &jsonLines) {
+        filterBatchChunk(jsonLines);
+    }, Qt::DirectConnection);
+    connect(m_batch, &FileSearcher::finished, this, [this](int exitCode) {
+        finishRun(exitCode);
+    });
+    connect(m_batch, &FileSearcher::errorOccurred, this, &FileSearcher::errorOccurred, Qt::DirectConnection);
+    connect(m_batch, &FileSearcher::fileSearched, this, &FileSearcher::fileSearched, Qt::DirectConnection);
+}
+
+ProximityFileSearcher::~ProximityFileSearcher()
+{
+}
+
+QString ProximityFileSearcher::describe(const ProximityQuery &query)
+{
+    QStringList names;
+    for (const NamedSearchPattern &term : query.terms) {
+        names << term.name;
+    }
+    QString text = names.join(query.ordered ? " THEN " : " AND ");
+    if (query.withinLines > 0) {
+        text += QString(" within %1 lines").arg(query.withinLines);
+    } else {
+        text += " in the same file";
+    }
+    return text;
+}
+
+QString ProximityFileSearcher::engineName() const
+{
+    return m_batch->engineName();
+}
+
+bool ProximityFileSearcher::canSearchTargets(const QVector<SearchTarget> &targets) const
+{
+    return m_batch->canSearchTargets(targets);
+}
+
+QStringList ProximityFileSearcher::candidateFiles(const RGSearchParams &params) const
+{
+    return m_batch->candidateFiles(params);
+}
+
+void ProximityFileSearcher::start(const RGSearchParams &params)
+{
+    m_cancelled.store(false);
+    m_batch->setCancelToken(m_cancelToken);
+    m_batch->setFlowControl(m_flowControl);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_files.clear();
+        m_qualifiedFiles = 0;
+        m_droppedFiles = 0;
+    }
+    m_timer.start();
+
+    LOG_INFO("ProximityFileSearcher: " + describe(m_query));
+
+    if (m_hasTargets) {
+        m_batch->setTargets(m_targets);
+    }
+    m_batch->start(params);
+}
+
+void ProximityFileSearcher::cancel()
+{
+    FileSearcher::cancel();
+    m_batch->cancel();
+}
+
+bool ProximityFileSearcher::addHit(FileState &file, const Hit &hit, qint64 *clusterStart)
+{
+    int terms = m_query.terms.size();
+    qint64 line = hit.lineNumber;
+
+    if (m_query.ordered) {
+        // Chains are extended in term order, so the terms may follow each other on one line
+        bool complete = false;
+        for (int term = 0; term < terms; ++term) {
+            if (!(hit.mask & (quint64(1) << term))) {
+                continue;
+            }
+            if (term == 0) {
+                file.termLine[0] = line;
+            } else if (file.termLine[term - 1] >= 0 &&
+                       (wholeFile() || line - file.termLine[term - 1] <= m_query.withinLines)) {
+                file.termLine[term] = file.termLine[term - 1];
+            } else {
+                continue;
+            }
+            if (term == terms - 1) {
+                *clusterStart = file.termLine[term];
+                complete = true;
+            }
+        }
+        return complete;
+    }
+
+    for (int term = 0; term < terms; ++term) {
+        if (hit.mask & (quint64(1) << term)) {
+            file.termLine[term] = line;
+        }
+    }
+    qint64 start = line;
+    for (int term = 0; term < terms; ++term) {
+        if (file.termLine[term] < 0) {
+            return false;
+        }
+        start = qMin(start, file.termLine[term]);
+    }
+    if (!wholeFile() && line - start > m_query.withinLines) {
+        return false;
+    }
+    *clusterStart = start;
+    return true;
+}
+
+void ProximityFileSearcher::emitHit(FileState &file, const Hit &hit, QByteArray *output)
+{
+    if (!file.begun) {
+        output->append(file.beginRecord);
+        file.begun = true;
+    }
+    output->append(hit.record);
+    file.emittedLines++;
+}
+
+void ProximityFileSearcher::releaseHits(FileState &file, qint64 keepFrom, QByteArray *output)
+{
+    while (!file.hits.isEmpty() && (file.hits.first().inCluster || file.hits.first().lineNumber < keepFrom)) {
+        Hit hit = file.hits.takeFirst();
+        if (hit.inCluster) {
+            emitHit(file, hit, output);
+        }
+    }
+}
+
+void ProximityFileSearcher::filterBatchChunk(const QByteArray &jsonLines)
+{
+    QMutexLocker locker(&m_mutex);
+
+    QByteArray output;
+    RgJsonRecord record;
+    const char *data = jsonLines.constData();
+    const char *end = data + jsonLines.size();
+    for (const char *lineStart = data; lineStart < end; ) {
+        const char *lineEnd = static_cast<const char*>(memchr(lineStart, '\n', size_t(end - lineStart)));
+        const char *next = lineEnd ? lineEnd + 1 : end;
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+        QByteArrayView line(lineStart, lineEnd - lineStart);
+        lineStart = next;
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        // The summary and anything unparsable pass through
+        if (!RgJsonParser::parseLine(line, &record) || record.path.isNull()) {
+            output.append(line.data(), line.size());
+            output.append('\n');
+            continue;
+        }
+
+        QByteArray rawPath = record.path.raw.toByteArray();
+        FileState &file = m_files[rawPath];
+        if (file.termLine.isEmpty()) {
+            file.termLine = QVector<qint64>(m_query.terms.size(), -1);
+        }
+
+        switch (record.type) {
+        case RgJsonRecord::Begin:
+            file.beginRecord = line.toByteArray() + '\n';
+            break;
+
+        case RgJsonRecord::Match: {
+            Hit hit;
+            hit.lineNumber = record.lineNumber;
+            hit.mask = record.patternMask;
+            hit.record = line.toByteArray() + '\n';
+            if (file.qualified) {
+                emitHit(file, hit, &output);
+                break;
+            }
+
+            qint64 clusterStart = 0;
+            bool complete = addHit(file, hit, &clusterStart);
+            file.hits.append(hit);
+            if (complete) {
+                // The whole file qualifies, or the lines from the cluster's first term on
+                for (int i = file.hits.size() - 1; i >= 0; --i) {
+                    if (!wholeFile() && file.hits[i].lineNumber < clusterStart) {
+                        break;
+                    }
+                    file.hits[i].inCluster = true;
+                }
+                file.qualified = wholeFile();
+            }
+            if (!wholeFile()) {
+                // Hits further back than the window cannot join a later cluster
+                releaseHits(file, hit.lineNumber - m_query.withinLines, &output);
+            } else if (file.qualified) {
+                releaseHits(file, std::numeric_limits<qint64>::max(), &output);
+            }
+            break;
+        }
+
+        case RgJsonRecord::End:
+            if (!wholeFile() || file.qualified) {
+                releaseHits(file, std::numeric_limits<qint64>::max(), &output);
+            }
+            if (file.begun) {
+                output.append(FileSearchRecordWriter::withMatchedLines(line, file.emittedLines));
+                output.append('\n');
+                m_qualifiedFiles++;
+            } else {
+                m_droppedFiles++;
+            }
+            m_files.remove(rawPath);
+            break;
+
+        default:
+            // Context lines are not part of a cluster
+            break;
+        }
+    }
+
+    if (!output.isEmpty()) {
+        emit outputChunk(output);
+    }
+}
+
+void ProximityFileSearcher::finishRun(int engineExitCode)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+
+        // Files the engine never ended (stopped search) keep what already qualified
+        if (!isCancelled() && !m_files.isEmpty()) {
+            QByteArray output;
+            for (auto it = m_files.begin(); it != m_files.end(); ++it) {
+                if (!wholeFile() || it->qualified) {
+                    releaseHits(*it, std::numeric_limits<qint64>::max(), &output);
+                }
+            }
+            if (!output.isEmpty()) {
+                emit outputChunk(output);
+            }
+        }
+        m_files.clear();
+
+        LOG_INFO("ProximityFileSearcher: " + describe(m_query) + " - " + QString::number(m_qualifiedFiles) +
+                 " files qualified, " + QString::number(m_droppedFiles) + " files with only some terms dropped after " +
+                 QString::number(m_timer.elapsed()) + " ms");
+    }
+
+    emit finished(engineExitCode);
+}
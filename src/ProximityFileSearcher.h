@@ -0,0 +1,79 @@
+#ifndef PROXIMITYFILESEARCHER_H
+#define PROXIMITYFILESEARCHER_H
+
+#include <QMutex>
+#include <QHash>
+#include <QList>
+#include <QElapsedTimer>
+#include "filesearcher.h"
+
+class BatchFileSearcher;
+
+// Co-occurrence and proximity queries: files containing all terms of a ProximityQuery, or the
+// clusters of lines where all of them occur within N lines (in the given order if asked). The
+// terms are searched in one pass as a batch search (see BatchFileSearcher); the hits of each
+// file are then walked once in line order, keeping per term the last line it was seen on, so
+// only lines within the window are held. Only qualifying files and the lines of their clusters
+// are passed on - the end record of a file counts those lines.
+class ProximityFileSearcher : public FileSearcher
+{
+    Q_OBJECT
+
+public:
+    // Takes ownership of engine
+    ProximityFileSearcher(FileSearcher *engine, const ProximityQuery &query, QObject *parent = nullptr);
+    ~ProximityFileSearcher();
+
+    // "a AND b within 50 lines", "a THEN b", ...
+    static QString describe(const ProximityQuery &query);
+
+    QString engineName() const override;
+
+    void start(const RGSearchParams &params) override;
+    void cancel() override;
+
+    bool canSearchTargets(const QVector<SearchTarget> &targets) const override;
+    QStringList candidateFiles(const RGSearchParams &params) const override;
+
+private:
+    struct Hit {
+        qint64 lineNumber = -1;
+        quint64 mask = 0;               // Terms found on the line
+        QByteArray record;              // Match record with its newline
+        bool inCluster = false;
+    };
+
+    struct FileState {
+        QByteArray beginRecord;
+        bool begun = false;             // Begin record passed on
+        bool qualified = false;         // Whole-file query satisfied - hits go out directly
+        QList<Hit> hits;                // Held hits in line order
+        QVector<qint64> termLine;       // Any order: last line of each term; in order: start
+                                        // line of the latest chain ending with the term
+        int emittedLines = 0;
+    };
+
+    void filterBatchChunk(const QByteArray &jsonLines);
+    void finishRun(int engineExitCode);
+
+    // First line of the cluster hit completes, false if it completes none
+    bool addHit(FileState &file, const Hit &hit, qint64 *clusterStart);
+    void emitHit(FileState &file, const Hit &hit, QByteArray *output);
+
+    // Pass on clustered hits and drop the rest of those before line keepFrom
+    void releaseHits(FileState &file, qint64 keepFrom, QByteArray *output);
+
+    bool wholeFile() const { return m_query.withinLines <= 0; }
+
+    BatchFileSearcher *m_batch;
+    ProximityQuery m_query;
+    QElapsedTimer m_timer;
+
+    // Batch output arrives from the engine's worker threads
+    QMutex m_mutex;
+    QHash<QByteArray, FileState> m_files;   // By data.path as the engine wrote it
+    int m_qualifiedFiles;
+    int m_droppedFiles;
+};
+
+#endif // PROXIMITYFILESEARCHER_H
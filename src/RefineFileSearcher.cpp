@@ -0,0 +1,118 @@
+#include "RefineFileSearcher.h"
+#include "logger.h"
+#include <QVector>
+#include <QPair>
+
+RefineFileSearcher::RefineFileSearcher(const PreviousLines &lines, QObject *parent)
+    : MappedFileSearcher(parent)
+    , m_lines(lines)
+    , m_caseless(false)
+{
+    QVector<SearchTarget> targets;
+    for (auto it = m_lines.constBegin(); it != m_lines.constEnd(); ++it) {
+        SearchTarget target;
+        target.filePath = it.key();
+        targets.append(target);
+    }
+    setTargets(targets);
+}
+
+RefineFileSearcher::~RefineFileSearcher()
+{
+}
+
+QStringList RefineFileSearcher::candidateFiles(const RGSearchParams &params) const
+{
+    Q_UNUSED(params)
+    return m_lines.keys();
+}
+
+bool RefineFileSearcher::prepare(const RGSearchParams &params, QString *error)
+{
+    if (params.pattern.isEmpty()) {
+        *error = "Empty refine pattern";
+        return false;
+    }
+
+    // Same case rules as the other engines: -s, then -i, then smart case
+    if (params.case_sensitive) {
+        m_caseless = false;
+    } else if (params.ignore_case) {
+        m_caseless = true;
+    } else if (params.smart_case) {
+        m_caseless = (params.pattern.toLower() == params.pattern);
+    } else {
+        m_caseless = false;
+    }
+
+    m_literal.setPattern(params.pattern.toUtf8());
+    m_literalText = params.pattern;
+
+    qint64 lineCount = 0;
+    for (const QVector<PreviousLine> &lines : m_lines) {
+        lineCount += lines.size();
+    }
+    LOG_INFO("RefineFileSearcher: Literal '" + params.pattern + "'" + (m_caseless ? " (case insensitive)" : "") +
+             " on " + QString::number(lineCount) + " earlier matched lines in " + QString::number(m_lines.size()) + " files");
+    return true;
+}
+
+MappedFileSearcher::FileScanResult RefineFileSearcher::scanFile(const QString &filePath, const char *data, qint64 size,
+                                                                FileSearchRecordWriter &writer, void *threadState)
+{
+    Q_UNUSED(threadState)
+
+    FileScanResult result;
+    const QVector<PreviousLine> lines = m_lines.value(filePath);
+    QVector<QPair<qint64, qint64>> submatches;
+
+    for (const PreviousLine &line : lines) {
+        if (isCancelled() || writer.fileFull()) {
+            break;
+        }
+        // The file may have been truncated since the earlier search
+        if (line.offset < 0 || line.offset + line.length > size) {
+            continue;
+        }
+
+        const char *lineData = data + line.offset;
+        submatches.clear();
+
+        if (!m_caseless) {
+            qsizetype patternLength = m_literal.pattern().size();
+            for (qsizetype pos = m_literal.indexIn(lineData, line.length, 0); pos >= 0;
+                 pos = m_literal.indexIn(lineData, line.length, pos + qMax<qsizetype>(1, patternLength))) {
+                submatches.append(qMakePair(qint64(pos), qint64(pos + patternLength)));
+            }
+        } else {
+            QString text = QString::fromUtf8(lineData, line.length);
+            for (qsizetype pos = text.indexOf(m_literalText, 0, Qt::CaseInsensitive); pos >= 0;
+                 pos = text.indexOf(m_literalText, pos + qMax<qsizetype>(1, m_literalText.size()), Qt::CaseInsensitive)) {
+                // Submatches are byte offsets into the line
+                qint64 from = QStringView(text).left(pos).toUtf8().size();
+                qint64 to = from + QStringView(text).mid(pos, m_literalText.size()).toUtf8().size();
+                submatches.append(qMakePair(from, to));
+            }
+        }
+
+        if (submatches.isEmpty()) {
+            continue;
+        }
+
+        // rg includes the line terminator in lines.text
+        qint64 textEnd = line.offset + line.length;
+        if (textEnd < size && data[textEnd] == '\r') {
+            textEnd++;
+        }
+        if (textEnd < size && data[textEnd] == '\n') {
+            textEnd++;
+        }
+        QByteArray lineBytes = QByteArray::fromRawData(lineData, int(textEnd - line.offset));
+        if (writer.match(filePath, line.lineNumber, line.offset, lineBytes, submatches)) {
+            result.matchedLines++;
+            result.matches += submatches.size();
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,47 @@
+#ifndef REFINEFILESEARCHER_H
+#define REFINEFILESEARCHER_H
+
+#include <QHash>
+#include <QByteArrayMatcher>
+#include "filesearcher.h"
+
+// Searches only the lines an earlier search matched. Live search uses it when the new pattern
+// is a literal containing the earlier literal, so every new match lies on one of those lines:
+// only the matched files are mapped and only the matched lines are tested.
+class RefineFileSearcher : public MappedFileSearcher
+{
+    Q_OBJECT
+
+public:
+    // A matched line of the earlier search (length without the line terminator)
+    struct PreviousLine {
+        qint64 offset = 0;
+        qint32 length = 0;
+        qint32 lineNumber = 0;
+    };
+    using PreviousLines = QHash<QString, QVector<PreviousLine>>;   // By file path
+
+    explicit RefineFileSearcher(const PreviousLines &lines, QObject *parent = nullptr);
+    ~RefineFileSearcher();
+
+    QString engineName() const override { return "refine"; }
+
+    // The files the earlier search matched in
+    QStringList candidateFiles(const RGSearchParams &params) const override;
+
+protected:
+    bool prepare(const RGSearchParams &params, QString *error) override;
+    FileScanResult scanFile(const QString &filePath, const char *data, qint64 size,
+                            FileSearchRecordWriter &writer, void *threadState) override;
+
+    // Earlier lines are looked up by their offset from the start of the file
+    bool canSplitFiles() const override { return false; }
+
+private:
+    PreviousLines m_lines;
+    bool m_caseless;
+    QByteArrayMatcher m_literal;        // Case-sensitive search on the line bytes
+    QString m_literalText;              // Caseless search on the decoded line
+};
+
+#endif // REFINEFILESEARCHER_H
@@ -0,0 +1,133 @@
+#include "RegexLiterals.h"
+#include <cctype>
+
+QVector<QByteArray> RegexLiterals::requiredLiterals(const QString &regex)
+{
+    QVector<QByteArray> literals;
+    QString current;
+
+    auto endRun = [&]() {
+        if (current.size() >= 3) {
+            literals.append(current.toUtf8());
+        }
+        current.clear();
+    };
+
+    for (int i = 0; i < regex.size(); ++i) {
+        QChar c = regex[i];
+
+        if (c == '\\' && i + 1 < regex.size()) {
+            QChar next = regex[++i];
+            if (!next.isLetterOrNumber()) {
+                current += next;                    // Escaped punctuation is itself
+            } else if (next == 't') {
+                current += '\t';
+            } else {
+                // \d \w \s \b \x.. \p{..} and back references
+                endRun();
+                if (i + 1 < regex.size() && regex[i + 1] == '{') {
+                    int close = regex.indexOf('}', i + 1);
+                    i = (close < 0) ? regex.size() : close;
+                } else if (next == 'x' || next == 'u' || next == 'U') {
+                    // \xHH \uHHHH \UHHHHHHHH - the digits are part of the escape, not literal text
+                    int digits = (next == 'x') ? 2 : (next == 'u') ? 4 : 8;
+                    while (digits-- > 0 && i + 1 < regex.size() && regex[i + 1].unicode() < 0x80 &&
+                           isxdigit(regex[i + 1].unicode())) {
+                        i++;
+                    }
+                } else if ((next == 'p' || next == 'P') && i + 1 < regex.size()) {
+                    i++;                                // One-letter class name as in \pL
+                }
+            }
+        } else if (c == '[') {
+            endRun();
+            int j = i + 1;
+            if (j < regex.size() && regex[j] == '^') {
+                j++;
+            }
+            if (j < regex.size() && regex[j] == ']') {
+                j++;                                // "[]...]" starts with a literal ']'
+            }
+            int depth = 1;
+            for (; j < regex.size() && depth > 0; ++j) {
+                if (regex[j] == '\\') {
+                    j++;
+                } else if (regex[j] == '[') {
+                    depth++;                        // Nested classes like [[:alpha:]]
+                } else if (regex[j] == ']') {
+                    depth--;
+                }
+            }
+            i = j - 1;
+        } else if (c == '(') {
+            endRun();
+            int depth = 1;
+            int j = i + 1;
+            for (; j < regex.size() && depth > 0; ++j) {
+                if (regex[j] == '\\') {
+                    j++;
+                } else if (regex[j] == '(') {
+                    depth++;
+                } else if (regex[j] == ')') {
+                    depth--;
+                }
+            }
+            i = j - 1;
+        } else if (c == '?' || c == '*') {
+            // The character before is optional
+            if (!current.isEmpty()) {
+                current.chop(1);
+            }
+            endRun();
+        } else if (c == '{') {
+            // {0,n} makes the character before optional, {n} with n > 0 keeps it once
+            int close = regex.indexOf('}', i);
+            if (close < 0) {
+                endRun();
+                break;
+            }
+            if (regex.mid(i + 1, close - i - 1).section(',', 0, 0).trimmed().toInt() == 0 && !current.isEmpty()) {
+                current.chop(1);
+            }
+            endRun();
+            i = close;
+        } else if (c == '+' || c == '.' || c == '^' || c == '$') {
+            endRun();
+        } else {
+            current += c;
+        }
+    }
+    endRun();
+
+    return literals;
+}
+
+QStringList RegexLiterals::splitAlternatives(const QString &regex)
+{
+    QStringList alternatives;
+    int depth = 0;
+    bool inClass = false;
+    int start = 0;
+    for (int i = 0; i < regex.size(); ++i) {
+        QChar c = regex[i];
+        if (c == '\\') {
+            i++;
+        } else if (inClass) {
+            inClass = (c != ']');
+        } else if (c == '[') {
+            inClass = true;
+            if (i + 1 < regex.size() && regex[i + 1] == ']') {
+                i++;
+            }
+        } else if (c == '(') {
+            depth++;
+        } else if (c == ')') {
+            depth--;
+        } else if (c == '|' && depth == 0) {
+            alternatives << regex.mid(start, i - start);
+            start = i + 1;
+        }
+    }
+    alternatives << regex.mid(start);
+    return alternatives;
+}
@@ -0,0 +1,22 @@
+#ifndef REGEXLITERALS_H
+#define REGEXLITERALS_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+
+// Literal text every match of a regex contains, for the trigram index to prune files and
+// blocks with. Deliberately conservative: a literal too many prunes blocks that do match.
+class RegexLiterals
+{
+public:
+    // Literal runs of at least 3 characters. Anything that is optional, repeated from zero or
+    // not a plain character ends the current run; groups and classes are skipped whole.
+    static QVector<QByteArray> requiredLiterals(const QString &regex);
+
+    // Top-level alternatives of a regex (not inside groups or classes)
+    static QStringList splitAlternatives(const QString &regex);
+};
+
+#endif // REGEXLITERALS_H
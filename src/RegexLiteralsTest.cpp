@@ -0,0 +1,66 @@
+#include <QtTest>
+#include "RegexLiterals.h"
+
+// The literals the trigram index prunes with: one too many drops blocks that do match, so every
+// escape form is covered
+class RegexLiteralsTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void requiredLiterals_data();
+    void requiredLiterals();
+    void splitAlternatives_data();
+    void splitAlternatives();
+};
+
+void RegexLiteralsTest::requiredLiterals_data()
+{
+    QTest::addColumn<QString>("regex");
+    QTest::addColumn<QVector<QByteArray>>("literals");
+
+    QTest::newRow("class escape") << "error\\d+code" << QVector<QByteArray>{"error", "code"};
+    QTest::newRow("escaped dot") << "abc\\.def" << QVector<QByteArray>{"abc.def"};
+    QTest::newRow("hex escape") << "\\x41BCD" << QVector<QByteArray>{"BCD"};
+    QTest::newRow("braced hex escape") << "\\x{41}BCD" << QVector<QByteArray>{"BCD"};
+    QTest::newRow("short hex escape") << "\\x4" << QVector<QByteArray>{};
+    QTest::newRow("\\u escape") << "\\u00e9abc" << QVector<QByteArray>{"abc"};
+    QTest::newRow("\\U escape") << "\\U0001F600xyz" << QVector<QByteArray>{"xyz"};
+    QTest::newRow("one-letter property") << "\\pLfoo" << QVector<QByteArray>{"foo"};
+    QTest::newRow("negated property") << "\\PNbar1" << QVector<QByteArray>{"bar1"};
+    QTest::newRow("braced property") << "\\p{Greek}foo" << QVector<QByteArray>{"foo"};
+    QTest::newRow("optional character") << "colou?r" << QVector<QByteArray>{"colo"};
+    QTest::newRow("class and group") << "[abc]def(gh|ij)klm" << QVector<QByteArray>{"def", "klm"};
+    QTest::newRow("repeat from zero") << "ab{0,2}cde" << QVector<QByteArray>{"cde"};
+}
+
+void RegexLiteralsTest::requiredLiterals()
+{
+    QFETCH(QString, regex);
+    QFETCH(QVector<QByteArray>, literals);
+
+    QCOMPARE(RegexLiterals::requiredLiterals(regex), literals);
+}
+
+void RegexLiteralsTest::splitAlternatives_data()
+{
+    QTest::addColumn<QString>("regex");
+    QTest::addColumn<QStringList>("alternatives");
+
+    QTest::newRow("single") << "abc" << QStringList{"abc"};
+    QTest::newRow("top level") << "foo|bar" << QStringList{"foo", "bar"};
+    QTest::newRow("in group") << "x(a|b)y|z" << QStringList{"x(a|b)y", "z"};
+    QTest::newRow("in class") << "[|]a|b" << QStringList{"[|]a", "b"};
+    QTest::newRow("escaped bar") << "a\\|b|c" << QStringList{"a\\|b", "c"};
+}
+
+void RegexLiteralsTest::splitAlternatives()
+{
+    QFETCH(QString, regex);
+    QFETCH(QStringList, alternatives);
+
+    QCOMPARE(RegexLiterals::splitAlternatives(regex), alternatives);
+}
+
+QTEST_APPLESS_MAIN(RegexLiteralsTest)
+#include "RegexLiteralsTest.moc"
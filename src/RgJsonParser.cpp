@@ -0,0 +1,554 @@
+#include "RgJsonParser.h"
+#include <cstring>
+
+namespace {
+
+struct Cursor {
+    const char *p;
+    const char *end;
+
+    void skipWhitespace()
+    {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+            ++p;
+        }
+    }
+
+    bool consume(char c)
+    {
+        skipWhitespace();
+        if (p < end && *p == c) {
+            ++p;
+            return true;
+        }
+        return false;
+    }
+
+    char peek()
+    {
+        skipWhitespace();
+        return p < end ? *p : '\0';
+    }
+};
+
+// String contents between the quotes; only looks for the closing quote, escapes are left alone
+bool parseString(Cursor &c, RgJsonText *text)
+{
+    if (!c.consume('"')) {
+        return false;
+    }
+
+    const char *start = c.p;
+    const char *search = c.p;
+    for (;;) {
+        const char *quote = static_cast<const char*>(memchr(search, '"', size_t(c.end - search)));
+        if (!quote) {
+            return false;
+        }
+
+        // A quote preceded by an odd number of backslashes is part of the string
+        const char *back = quote;
+        while (back > start && back[-1] == '\\') {
+            --back;
+        }
+        if ((quote - back) % 2 == 0) {
+            if (text) {
+                text->raw = QByteArrayView(start, quote - start);
+                text->escaped = memchr(start, '\\', size_t(quote - start)) != nullptr;
+                text->base64 = false;
+            }
+            c.p = quote + 1;
+            return true;
+        }
+        search = quote + 1;
+    }
+}
+
+// Integer value, fractions and exponents are accepted and truncated
+bool parseInteger(Cursor &c, qint64 *value)
+{
+    c.skipWhitespace();
+    bool negative = false;
+    if (c.p < c.end && *c.p == '-') {
+        negative = true;
+        ++c.p;
+    }
+    if (c.p >= c.end || *c.p < '0' || *c.p > '9') {
+        return false;
+    }
+
+    qint64 result = 0;
+    while (c.p < c.end && *c.p >= '0' && *c.p <= '9') {
+        result = result * 10 + (*c.p - '0');
+        ++c.p;
+    }
+    while (c.p < c.end && (*c.p == '.' || *c.p == 'e' || *c.p == 'E' || *c.p == '+' || *c.p == '-' ||
+                           (*c.p >= '0' && *c.p <= '9'))) {
+        ++c.p;
+    }
+
+    *value = negative ? -result : result;
+    return true;
+}
+
+bool skipLiteral(Cursor &c, const char *literal)
+{
+    size_t length = strlen(literal);
+    if (size_t(c.end - c.p) < length || memcmp(c.p, literal, length) != 0) {
+        return false;
+    }
+    c.p += length;
+    return true;
+}
+
+bool skipValue(Cursor &c);
+
+// Calls member(key, cursor) for every member; member must consume the value
+template <typename MemberFn>
+bool parseObject(Cursor &c, MemberFn member)
+{
+    if (!c.consume('{')) {
+        return false;
+    }
+    if (c.consume('}')) {
+        return true;
+    }
+
+    for (;;) {
+        RgJsonText key;
+        if (!parseString(c, &key) || !c.consume(':')) {
+            return false;
+        }
+        if (!member(key.raw, c)) {
+            return false;
+        }
+        if (c.consume(',')) {
+            continue;
+        }
+        return c.consume('}');
+    }
+}
+
+template <typename ElementFn>
+bool parseArray(Cursor &c, ElementFn element)
+{
+    if (!c.consume('[')) {
+        return false;
+    }
+    if (c.consume(']')) {
+        return true;
+    }
+
+    for (;;) {
+        if (!element(c)) {
+            return false;
+        }
+        if (c.consume(',')) {
+            continue;
+        }
+        return c.consume(']');
+    }
+}
+
+bool skipValue(Cursor &c)
+{
+    switch (c.peek()) {
+    case '"':
+        return parseString(c, nullptr);
+    case '{':
+        return parseObject(c, [](QByteArrayView, Cursor &inner) { return skipValue(inner); });
+    case '[':
+        return parseArray(c, [](Cursor &inner) { return skipValue(inner); });
+    case 't':
+        return skipLiteral(c, "true");
+    case 'f':
+        return skipLiteral(c, "false");
+    case 'n':
+        return skipLiteral(c, "null");
+    default: {
+        qint64 ignored;
+        return parseInteger(c, &ignored);
+    }
+    }
+}
+
+// Integer or null (line_number is null for multiline matches in some modes)
+bool parseOptionalInteger(Cursor &c, qint64 *value)
+{
+    if (c.peek() == 'n') {
+        return skipLiteral(c, "null");
+    }
+    return parseInteger(c, value);
+}
+
+// {"text": "..."} or {"bytes": "<base64>"}, null is accepted as missing
+bool parseTextObject(Cursor &c, RgJsonText *text)
+{
+    if (c.peek() == 'n') {
+        return skipLiteral(c, "null");
+    }
+    return parseObject(c, [text](QByteArrayView key, Cursor &inner) {
+        if (key == "text") {
+            return parseString(inner, text);
+        }
+        if (key == "bytes") {
+            if (!parseString(inner, text)) {
+                return false;
+            }
+            text->base64 = true;
+            return true;
+        }
+        return skipValue(inner);
+    });
+}
+
+// {"secs": .., "nanos": .., "human": "..."} - only human is kept
+bool parseElapsed(Cursor &c, RgJsonText *human)
+{
+    return parseObject(c, [human](QByteArrayView key, Cursor &inner) {
+        if (key == "human") {
+            return parseString(inner, human);
+        }
+        return skipValue(inner);
+    });
+}
+
+bool parseStats(Cursor &c, RgJsonRecord *record)
+{
+    return parseObject(c, [record](QByteArrayView key, Cursor &inner) {
+        if (key == "elapsed") {
+            return parseElapsed(inner, &record->statsElapsedHuman);
+        }
+        if (key == "matched_lines") {
+            return parseInteger(inner, &record->matchedLines);
+        }
+        if (key == "matches") {
+            return parseInteger(inner, &record->matches);
+        }
+        if (key == "searches_with_match") {
+            return parseInteger(inner, &record->searchesWithMatch);
+        }
+        if (key == "bytes_searched") {
+            return parseInteger(inner, &record->bytesSearched);
+        }
+        return skipValue(inner);
+    });
+}
+
+bool parseSubmatch(Cursor &c, RgJsonRecord *record)
+{
+    RgJsonSubmatch submatch;
+    bool ok = parseObject(c, [&submatch](QByteArrayView key, Cursor &inner) {
+        if (key == "match") {
+            return parseTextObject(inner, &submatch.text);
+        }
+        if (key == "start") {
+            return parseInteger(inner, &submatch.start);
+        }
+        if (key == "end") {
+            return parseInteger(inner, &submatch.end);
+        }
+        return skipValue(inner);
+    });
+    if (ok) {
+        record->submatches.append(submatch);
+    }
+    return ok;
+}
+
+bool parseData(Cursor &c, RgJsonRecord *record)
+{
+    return parseObject(c, [record](QByteArrayView key, Cursor &inner) {
+        if (key == "path") {
+            return parseTextObject(inner, &record->path);
+        }
+        if (key == "lines") {
+            return parseTextObject(inner, &record->lines);
+        }
+        if (key == "line_number") {
+            return parseOptionalInteger(inner, &record->lineNumber);
+        }
+        if (key == "absolute_offset") {
+            return parseOptionalInteger(inner, &record->absoluteOffset);
+        }
+        if (key == "submatches") {
+            return parseArray(inner, [record](Cursor &element) { return parseSubmatch(element, record); });
+        }
+        if (key == "patterns") {
+            return parseArray(inner, [record](Cursor &element) {
+                qint64 id = 0;
+                if (!parseInteger(element, &id)) {
+                    return false;
+                }
+                if (id >= 0 && id < 64) {
+                    record->patternMask |= quint64(1) << id;
+                }
+                return true;
+            });
+        }
+        if (key == "stats") {
+            return parseStats(inner, record);
+        }
+        if (key == "elapsed_total") {
+            return parseElapsed(inner, &record->elapsedTotalHuman);
+        }
+        return skipValue(inner);
+    });
+}
+
+RgJsonRecord::Type recordType(QByteArrayView type)
+{
+    if (type == "match") {
+        return RgJsonRecord::Match;
+    }
+    if (type == "begin") {
+        return RgJsonRecord::Begin;
+    }
+    if (type == "end") {
+        return RgJsonRecord::End;
+    }
+    if (type == "context") {
+        return RgJsonRecord::Context;
+    }
+    if (type == "summary") {
+        return RgJsonRecord::Summary;
+    }
+    return RgJsonRecord::Unknown;
+}
+
+int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+uint parseHex4(const char *p, const char *end)
+{
+    if (end - p < 4) {
+        return 0xFFFD;
+    }
+    uint value = 0;
+    for (int i = 0; i < 4; ++i) {
+        int digit = hexValue(p[i]);
+        if (digit < 0) {
+            return 0xFFFD;
+        }
+        value = (value << 4) | uint(digit);
+    }
+    return value;
+}
+
+void appendUtf8(QByteArray &out, uint codePoint)
+{
+    if (codePoint < 0x80) {
+        out.append(char(codePoint));
+    } else if (codePoint < 0x800) {
+        out.append(char(0xC0 | (codePoint >> 6)));
+        out.append(char(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint < 0x10000) {
+        out.append(char(0xE0 | (codePoint >> 12)));
+        out.append(char(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.append(char(0x80 | (codePoint & 0x3F)));
+    } else {
+        out.append(char(0xF0 | (codePoint >> 18)));
+        out.append(char(0x80 | ((codePoint >> 12) & 0x3F)));
+        out.append(char(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.append(char(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+QByteArray unescape(QByteArrayView raw)
+{
+    QByteArray out;
+    out.reserve(raw.size());
+
+    const char *p = raw.data();
+    const char *end = p + raw.size();
+    while (p < end) {
+        const char *backslash = static_cast<const char*>(memchr(p, '\\', size_t(end - p)));
+        if (!backslash) {
+            out.append(p, end - p);
+            break;
+        }
+        out.append(p, backslash - p);
+        p = backslash + 1;
+        if (p >= end) {
+            break;
+        }
+
+        char escape = *p++;
+        switch (escape) {
+        case 'n': out.append('\n'); break;
+        case 't': out.append('\t'); break;
+        case 'r': out.append('\r'); break;
+        case 'b': out.append('\b'); break;
+        case 'f': out.append('\f'); break;
+        case 'u': {
+            uint codePoint = parseHex4(p, end);
+            p += qMin<qsizetype>(4, end - p);
+            // Surrogate pair written as two escapes
+            if (codePoint >= 0xD800 && codePoint <= 0xDBFF && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                uint low = parseHex4(p + 2, end);
+                if (low >= 0xDC00 && low <= 0xDFFF) {
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    p += 6;
+                }
+            }
+            if (codePoint >= 0xD800 && codePoint <= 0xDFFF) {
+                codePoint = 0xFFFD;  // Lone surrogate
+            }
+            appendUtf8(out, codePoint);
+            break;
+        }
+        default:
+            out.append(escape);   // \" \\ \/
+            break;
+        }
+    }
+    return out;
+}
+
+// Drop an escaped "\n" / "\r\n" line terminator from the end of raw string content.
+// The backslash must not itself be escaped ("\\n" is a backslash followed by 'n').
+QByteArrayView chopEscapedTerminator(QByteArrayView content)
+{
+    auto endsWithEscape = [](QByteArrayView text, char escape) {
+        if (text.size() < 2 || text.back() != escape) {
+            return false;
+        }
+        qsizetype backslashes = 0;
+        for (qsizetype i = text.size() - 2; i >= 0 && text[i] == '\\'; --i) {
+            backslashes++;
+        }
+        return (backslashes % 2) == 1;
+    };
+
+    if (endsWithEscape(content, 'n')) {
+        content.chop(2);
+        if (endsWithEscape(content, 'r')) {
+            content.chop(2);
+        }
+    }
+    return content;
+}
+
+} // namespace
+
+QByteArray RgJsonText::toBytes() const
+{
+    if (isNull()) {
+        return QByteArray();
+    }
+    if (base64) {
+        return QByteArray::fromBase64(raw.toByteArray());
+    }
+    if (!escaped) {
+        return raw.toByteArray();
+    }
+    return unescape(raw);
+}
+
+QString RgJsonText::toString() const
+{
+    if (isNull()) {
+        return QString();
+    }
+    if (!base64 && !escaped) {
+        return QString::fromUtf8(raw.data(), raw.size());
+    }
+    return QString::fromUtf8(toBytes());
+}
+
+QString RgJsonText::toLineString() const
+{
+    if (isNull()) {
+        return QString();
+    }
+
+    if (!base64 && escaped) {
+        QByteArrayView content = chopEscapedTerminator(raw);
+        if (!memchr(content.data(), '\\', size_t(content.size()))) {
+            return QString::fromUtf8(content.data(), content.size());
+        }
+    }
+
+    QString text = toString();
+    if (text.endsWith('\n')) {
+        text.chop(1);
+        if (text.endsWith('\r')) {
+            text.chop(1);
+        }
+    }
+    return text;
+}
+
+QByteArray RgJsonText::toLineBytes() const
+{
+    if (isNull()) {
+        return QByteArray();
+    }
+
+    if (!base64 && escaped) {
+        QByteArrayView content = chopEscapedTerminator(raw);
+        if (!memchr(content.data(), '\\', size_t(content.size()))) {
+            return content.toByteArray();
+        }
+        return unescape(content);
+    }
+
+    QByteArray bytes = toBytes();
+    if (bytes.endsWith('\n')) {
+        bytes.chop(1);
+        if (bytes.endsWith('\r')) {
+            bytes.chop(1);
+        }
+    }
+    return bytes;
+}
+
+qsizetype RgJsonText::lineByteLength() const
+{
+    if (isNull()) {
+        return 0;
+    }
+    if (!base64 && !escaped) {
+        return raw.size();
+    }
+    if (!base64) {
+        QByteArrayView content = chopEscapedTerminator(raw);
+        if (!memchr(content.data(), '\\', size_t(content.size()))) {
+            return content.size();
+        }
+    }
+    return toLineBytes().size();
+}
+
+void RgJsonRecord::clear()
+{
+    *this = RgJsonRecord();
+}
+
+bool RgJsonParser::parseLine(const char *begin, const char *end, RgJsonRecord *record)
+{
+    record->clear();
+
+    Cursor c{begin, end};
+    bool ok = parseObject(c, [record](QByteArrayView key, Cursor &inner) {
+        if (key == "type") {
+            RgJsonText type;
+            if (!parseString(inner, &type)) {
+                return false;
+            }
+            record->type = recordType(type.raw);
+            return true;
+        }
+        if (key == "data") {
+            return parseData(inner, record);
+        }
+        return skipValue(inner);
+    });
+
+    return ok;
+}
@@ -0,0 +1,71 @@
+#ifndef RGJSONPARSER_H
+#define RGJSONPARSER_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QString>
+#include <QVarLengthArray>
+
+// A string value of a ripgrep --json record, pointing into the parsed line.
+// ripgrep writes {"text": "..."} for valid UTF-8 and {"bytes": "<base64>"} otherwise;
+// escape sequences and base64 are only decoded when the value is converted.
+struct RgJsonText {
+    QByteArrayView raw;     // Between the quotes, still escaped / base64 encoded
+    bool escaped = false;   // raw contains backslash escapes
+    bool base64 = false;    // Value came from a "bytes" member
+
+    bool isNull() const { return raw.data() == nullptr; }
+
+    QByteArray toBytes() const;
+    QString toString() const;
+
+    // Line content without its trailing "\n" / "\r\n" - the usual case where the
+    // terminator is the only escape needs no unescaping at all
+    QString toLineString() const;
+    QByteArray toLineBytes() const;         // Same, as UTF-8 bytes
+    qsizetype lineByteLength() const;       // Size of toLineBytes(), mostly without decoding
+};
+
+struct RgJsonSubmatch {
+    RgJsonText text;
+    qint64 start = 0;       // Byte offsets into lines.text
+    qint64 end = 0;
+};
+
+// Fields TotalSearch uses from one ripgrep --json line (begin / match / end / summary).
+// Valid only as long as the buffer holding the line is alive and unchanged.
+struct RgJsonRecord {
+    enum Type { Unknown, Begin, Match, Context, End, Summary };
+
+    Type type = Unknown;
+    RgJsonText path;                        // data.path
+    RgJsonText lines;                       // data.lines
+    qint64 lineNumber = -1;                 // data.line_number
+    qint64 absoluteOffset = -1;             // data.absolute_offset
+    QVarLengthArray<RgJsonSubmatch, 4> submatches;
+    quint64 patternMask = 0;                // data.patterns of a batch search: bit i = pattern i
+
+    RgJsonText statsElapsedHuman;           // data.stats.elapsed.human
+    RgJsonText elapsedTotalHuman;           // data.elapsed_total.human
+    qint64 matchedLines = 0;                // data.stats.matched_lines
+    qint64 matches = 0;                     // data.stats.matches
+    qint64 searchesWithMatch = 0;           // data.stats.searches_with_match
+    qint64 bytesSearched = 0;               // data.stats.bytes_searched
+
+    void clear();
+};
+
+// Single pass parser for ripgrep --json lines working directly on the bytes.
+// Members outside the fields above are skipped without being decoded.
+class RgJsonParser
+{
+public:
+    // Parse one line (without the newline), returns false on malformed JSON
+    static bool parseLine(const char *begin, const char *end, RgJsonRecord *record);
+    static bool parseLine(QByteArrayView line, RgJsonRecord *record)
+    {
+        return parseLine(line.data(), line.data() + line.size(), record);
+    }
+};
+
+#endif // RGJSONPARSER_H
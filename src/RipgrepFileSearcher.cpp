@@ -0,0 +1,824 @@
+#include "RipgrepFileSearcher.h"
+#include "CompressedFile.h"
+#include "SearchFlowControl.h"
+#include "logger.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSharedPointer>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <tlhelp32.h>
+#else
+#include <signal.h>
+#endif
+
+// Stop or continue every thread of the process pid. QProcess keeps reading the pipe into its own
+// buffer, so rg itself has to stop: SIGSTOP / SIGCONT, on Windows SuspendThread / ResumeThread
+// on the threads of the process (there is no process-wide call).
+static void setProcessStopped(qint64 pid, bool stopped)
+{
+#ifdef Q_OS_WIN
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+    if (snapshot == INVALID_HANDLE_VALUE) {
+        LOG_WARNING("RipgrepFileSearcher: Cannot list the threads of ripgrep - its output is not held back");
+        return;
+    }
+    THREADENTRY32 entry;
+    entry.dwSize = sizeof(entry);
+    for (BOOL more = Thread32First(snapshot, &entry); more; more = Thread32Next(snapshot, &entry)) {
+        if (entry.th32OwnerProcessID != DWORD(pid)) {
+            continue;
+        }
+        HANDLE thread = OpenThread(THREAD_SUSPEND_RESUME, FALSE, entry.th32ThreadID);
+        if (thread) {
+            if (stopped) {
+                SuspendThread(thread);
+            } else {
+                ResumeThread(thread);
+            }
+            CloseHandle(thread);
+        }
+    }
+    CloseHandle(snapshot);
+#else
+    ::kill(pid_t(pid), stopped ? SIGSTOP : SIGCONT);
+#endif
+}
+
+RipgrepFileSearcher::RipgrepFileSearcher(QObject *parent)
+    : FileSearcher(parent)
+    , m_process(nullptr)
+    , m_splitThread(nullptr)
+    , m_processRunning(false)
+    , m_outputPaused(false)
+    , m_pauses(0)
+    , m_processExitCode(1)
+    , m_mergeSummaries(false)
+    , m_batchFiles(FirstBatchFiles)
+    , m_processRuns(0)
+    , m_splitFiles(0)
+    , m_splitFilesWithMatch(0)
+    , m_splitMatchedLines(0)
+    , m_splitMatches(0)
+    , m_splitBytes(0)
+    , m_splitError(false)
+    , m_countOnly(false)
+    , m_countFiles(0)
+    , m_countLines(0)
+    , m_countBytes(0)
+    , m_bytesForwarded(0)
+    , m_firstChunkSent(false)
+{
+    m_split.enabled = false;
+}
+
+RipgrepFileSearcher::~RipgrepFileSearcher()
+{
+    if (m_splitThread) {
+        m_splitThread->disconnect(this);
+        m_cancelled.store(true);
+        m_splitThread->wait();
+        delete m_splitThread;
+    }
+    if (m_process) {
+        m_process->disconnect(this);
+        if (m_process->state() != QProcess::NotRunning) {
+            m_process->kill();
+            m_process->waitForFinished(2000);
+        }
+    }
+}
+
+QString RipgrepFileSearcher::executable()
+{
+#ifdef Q_OS_WIN
+    return "lib\\rg.exe";
+#else
+    return "rg";
+#endif
+}
+
+// Build ripgrep arguments from search parameters (shared by all ripgrep searches)
+QStringList RipgrepFileSearcher::buildArguments(const RGSearchParams &params)
+{
+    QStringList arguments;
+    arguments << "-a";                    // Search binary files
+    arguments << "--threads" << "0";      // Use all available threads
+    arguments << "--mmap";                // Use memory-mapped I/O
+    if (params.count_only) {
+        // --json has no count mode: "path\0count" lines, turned into records by countRecords
+        arguments << "--count";           // Matched lines per file
+        arguments << "--with-filename";   // Also for a single file
+        arguments << "--null";            // NUL after the path instead of ':'
+    } else {
+        arguments << "-n";                // Show line numbers
+        arguments << "--column";          // Show column numbers
+        arguments << "--byte-offset";     // Show byte offsets
+        arguments << "--stats";           // Show statistics
+        arguments << "--heading";         // Show filename as heading
+        arguments << "--json";            // Always output in JSON format
+    }
+
+    // Decompress .gz/.zst/.xz/... files (rg runs the gzip, zstd, ... tools found on PATH)
+    if (params.search_compressed) {
+        arguments << "--search-zip";
+    }
+
+    // Stop each file after this many matched lines
+    if (params.max_count > 0) {
+        arguments << "--max-count" << QString::number(params.max_count);
+    }
+
+    // Add pattern flags
+    if (params.fixed_string) {
+        arguments << "-F";                // Fixed string mode
+    }
+
+    // Add case sensitivity flags (mutually exclusive)
+    if (params.case_sensitive) {
+        arguments << "-s";                // Case sensitive
+    } else if (params.ignore_case) {
+        arguments << "-i";                // Ignore case
+    } else if (params.smart_case) {
+        arguments << "-S";                // Smart case
+    }
+
+    // Add include/exclude patterns
+    arguments << globArguments(params);
+
+    // Add pattern, and the additional pattern as a second alternative - its own -e, so with -F
+    // both stay literal instead of one literal containing '|'
+    arguments << "-e" << params.pattern;
+    if (!params.add_pattern.isEmpty()) {
+        arguments << "-e" << params.add_pattern;
+    }
+
+    // Add search path
+    arguments << params.path;
+
+    return arguments;
+}
+
+QStringList RipgrepFileSearcher::globArguments(const RGSearchParams &params)
+{
+    QStringList arguments;
+    QStringList patterns = params.incl_exclude.split(',', Qt::SkipEmptyParts);
+    for (const QString &pattern : patterns) {
+        QString trimmedPattern = pattern.trimmed();
+        if (trimmedPattern.startsWith("!")) {
+            // Exclude pattern (starts with !)
+            arguments << "-g" << QString("!%1").arg(trimmedPattern.mid(1));
+        } else {
+            // Include pattern
+            arguments << "-g" << trimmedPattern;
+        }
+    }
+    return arguments;
+}
+
+QStringList RipgrepFileSearcher::candidateFiles(const RGSearchParams &params) const
+{
+    QStringList arguments;
+    arguments << "--files" << globArguments(params) << params.path;
+
+    QProcess process;
+    process.start(executable(), arguments);
+    if (!process.waitForStarted()) {
+        LOG_WARNING("RipgrepFileSearcher: Cannot start " + executable() + " --files, walking " + params.path + " instead");
+        return collectFiles(params);
+    }
+
+    QByteArray output;
+    while (process.state() != QProcess::NotRunning) {
+        if (isCancelled()) {
+            process.kill();
+        }
+        process.waitForFinished(100);
+        output.append(process.readAllStandardOutput());
+    }
+    output.append(process.readAllStandardOutput());
+
+    QStringList files;
+    for (const QByteArray &line : output.split('\n')) {
+        QByteArray path = line.endsWith('\r') ? line.chopped(1) : line;
+        if (!path.isEmpty()) {
+            files.append(QString::fromUtf8(path));
+        }
+    }
+    LOG_INFO("RipgrepFileSearcher: rg --files listed " + QString::number(files.size()) + " candidate files under " + params.path);
+    return files;
+}
+
+bool RipgrepFileSearcher::canSearchTargets(const QVector<SearchTarget> &targets) const
+{
+    for (const SearchTarget &target : targets) {
+        if (target.startOffset != 0 || !target.ranges.isEmpty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void RipgrepFileSearcher::start(const RGSearchParams &params)
+{
+    m_split = SplitFileSearch::loadConfig();
+
+    // Range searches report match records; with a match limit or only counts each file is one rg search
+    m_split.enabled = m_split.enabled && !params.count_only && params.max_count <= 0;
+    m_countOnly = params.count_only;
+
+    // Explicit files replace the search path
+    QStringList paths;
+    if (m_hasTargets) {
+        for (const SearchTarget &target : m_targets) {
+            paths << target.filePath;
+        }
+    } else {
+        paths << params.path;
+    }
+
+    // rg searches files named on the command line whatever their size, so large ones are taken
+    // out here; inside directories --max-filesize leaves them to the range search
+    QStringList largeFiles;
+    bool walkPath = false;
+    if (m_split.enabled) {
+        QStringList smallPaths;
+        for (const QString &path : paths) {
+            QFileInfo info(path);
+            // Compressed bytes cannot be cut into line ranges - named ones stay with the main rg
+            bool decompressed = params.search_compressed && CompressedFile::isCompressedPath(path);
+            if (info.isFile() && info.size() >= m_split.thresholdBytes && !decompressed) {
+                largeFiles << path;
+            } else {
+                smallPaths << path;
+                walkPath = walkPath || info.isDir();
+            }
+        }
+        paths = smallPaths;
+    }
+
+    QStringList arguments = buildArguments(params);
+    arguments.removeLast();
+    if (m_split.enabled) {
+        arguments << "--max-filesize" << QString::number(m_split.thresholdBytes - 1);
+    }
+    m_baseArguments = arguments;
+    m_batchPaths = paths;
+    m_runPaths.clear();
+    m_batchFiles = FirstBatchFiles;
+    m_processRuns = 0;
+
+    m_cancelled.store(false);
+    m_buffer.clear();
+    m_bytesForwarded = 0;
+    m_firstChunkSent = false;
+    m_processExitCode = 1;
+    m_processSummaries.clear();
+    m_mergeSummaries = !m_countOnly && (m_split.enabled || m_hasTargets);
+    m_splitFiles = 0;
+    m_splitFilesWithMatch = 0;
+    m_splitMatchedLines = 0;
+    m_splitMatches = 0;
+    m_splitBytes = 0;
+    m_splitError = false;
+    m_countFiles = 0;
+    m_countLines = 0;
+    m_countBytes = 0;
+    m_outputPaused = false;
+    m_pauses = 0;
+
+    if (m_flowControl) {
+        connect(m_flowControl.data(), &SearchFlowControl::roomAvailable,
+                this, &RipgrepFileSearcher::resumeOutput, Qt::UniqueConnection);
+    }
+
+    if (m_process) {
+        m_process->disconnect(this);
+        delete m_process;
+        m_process = nullptr;
+    }
+
+    m_timer.start();
+
+    // ===== MAIN RG RUN =====
+    m_processRunning = !paths.isEmpty();
+    if (m_processRunning) {
+        startProcess();
+    }
+
+    // ===== LARGE FILES BY RANGES =====
+    if (!largeFiles.isEmpty() || walkPath) {
+        m_splitThread = QThread::create([this, params, largeFiles, walkPath]() {
+            searchLargeFiles(params, largeFiles, walkPath);
+        });
+        connect(m_splitThread, &QThread::finished, this, [this]() {
+            m_splitThread->deleteLater();
+            m_splitThread = nullptr;
+            finishIfDone();
+        });
+        m_splitThread->start();
+    }
+
+    if (!m_processRunning && !m_splitThread) {
+        // Nothing to search - finished() still arrives asynchronously
+        QMetaObject::invokeMethod(this, [this]() { finishIfDone(); }, Qt::QueuedConnection);
+    }
+}
+
+void RipgrepFileSearcher::startProcess()
+{
+    // Without targets the one path is walked by a single rg
+    QStringList batch;
+    if (!m_hasTargets) {
+        batch = m_batchPaths;
+        m_batchPaths.clear();
+    } else {
+        qsizetype chars = 0;
+        while (!m_batchPaths.isEmpty() && batch.size() < m_batchFiles) {
+            chars += m_batchPaths.first().size() + 3;  // Quotes and separator
+            if (!batch.isEmpty() && chars > MaxTargetChars) {
+                break;
+            }
+            batch << m_batchPaths.takeFirst();
+        }
+        m_batchFiles = qMin(m_batchFiles * 2, MaxTargetChars);
+    }
+    m_runPaths = batch;
+    m_processRuns++;
+    m_outputPaused = false;
+
+    QStringList arguments = m_baseArguments;
+    arguments << batch;
+    if (m_processRuns == 1) {
+        LOG_INFO("RipgrepFileSearcher: Ripgrep command: " + executable() + " " + arguments.join(' '));
+    } else {
+        LOG_INFO("RipgrepFileSearcher: Ripgrep run " + QString::number(m_processRuns) + " on " +
+                 QString::number(batch.size()) + " files, " + QString::number(m_batchPaths.size()) + " left");
+    }
+
+    if (m_process) {
+        // Called from the last process's finished() - it is deleted once that returns
+        m_process->disconnect(this);
+        m_process->deleteLater();
+    }
+    m_process = new QProcess(this);
+    connect(m_process, &QProcess::readyReadStandardOutput,
+            this, &RipgrepFileSearcher::onReadyRead);
+    connect(m_process, &QProcess::finished,
+            this, &RipgrepFileSearcher::onProcessFinished);
+    m_process->start(executable(), arguments);
+}
+
+void RipgrepFileSearcher::cancel()
+{
+    FileSearcher::cancel();
+    if (m_process && m_process->state() != QProcess::NotRunning) {
+        LOG_INFO("RipgrepFileSearcher: Killing ripgrep process");
+        m_process->kill();  // finished() still arrives through onProcessFinished
+    }
+}
+
+void RipgrepFileSearcher::onReadyRead()
+{
+    // Results backlog full: stop rg until the model has taken some of it (resumeOutput)
+    if (m_flowControl && m_flowControl->isFull()) {
+        pauseOutput();
+        return;
+    }
+
+    m_buffer.append(m_process->readAllStandardOutput());
+
+    // Forward everything up to the last newline, keep the partial line for the next read
+    qsizetype lastNewline = m_buffer.lastIndexOf('\n');
+    if (lastNewline < 0) {
+        return;
+    }
+
+    QByteArray completeLines = m_countOnly ? countRecords(m_buffer.left(lastNewline + 1))
+                                           : takeSummary(m_buffer.left(lastNewline + 1));
+    m_buffer.remove(0, lastNewline + 1);
+    if (completeLines.isEmpty()) {
+        return;
+    }
+    m_bytesForwarded += completeLines.size();
+
+    if (!m_firstChunkSent) {
+        m_firstChunkSent = true;
+        LOG_INFO("RipgrepFileSearcher: First chunk after " + QString::number(m_timer.elapsed()) + " ms (" + QString::number(completeLines.size()) + " bytes)");
+    }
+
+    emit outputChunk(completeLines);
+}
+
+void RipgrepFileSearcher::pauseOutput()
+{
+    if (m_outputPaused || !m_process || m_process->state() != QProcess::Running) {
+        return;
+    }
+    m_outputPaused = true;
+    m_pauses++;
+    setProcessStopped(m_process->processId(), true);
+}
+
+void RipgrepFileSearcher::resumeOutput()
+{
+    if (!m_outputPaused) {
+        return;
+    }
+    m_outputPaused = false;
+
+    if (m_process && m_process->state() == QProcess::Running) {
+        setProcessStopped(m_process->processId(), false);
+    }
+
+    // Output read before the pause is still waiting in the process buffer
+    if (m_process) {
+        onReadyRead();
+    }
+}
+
+void RipgrepFileSearcher::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    // Pick up anything still buffered in the process and a final line without '\n'
+    m_buffer.append(m_process->readAllStandardOutput());
+    if (!m_buffer.isEmpty() && !m_buffer.endsWith('\n')) {
+        m_buffer.append('\n');
+    }
+    QByteArray lastLines = m_countOnly ? countRecords(m_buffer) : takeSummary(m_buffer);
+    m_buffer.clear();
+    if (!lastLines.isEmpty()) {
+        m_bytesForwarded += lastLines.size();
+        emit outputChunk(lastLines);
+    }
+
+    QString errorOutput = QString::fromUtf8(m_process->readAllStandardError());
+    if (!errorOutput.isEmpty()) {
+        LOG_WARNING("RipgrepFileSearcher: Ripgrep errors: " + errorOutput);
+        if (exitCode == 2) {
+            emit errorOccurred(errorOutput);
+        }
+    }
+
+    LOG_INFO("RipgrepFileSearcher: Ripgrep finished (exit code " + QString::number(exitCode) +
+             (exitStatus == QProcess::CrashExit ? ", crashed/killed" : "") + ") after " +
+             QString::number(m_timer.elapsed()) + " ms, forwarded " + QString::number(m_bytesForwarded) + " bytes" +
+             (m_pauses > 0 ? ", paused " + QString::number(m_pauses) + " times for the results backlog" : ""));
+    m_outputPaused = false;
+
+    // Every target of this run is done, matched or not
+    bool completed = !isCancelled() && exitStatus == QProcess::NormalExit;
+    if (completed && m_hasTargets) {
+        for (const QString &filePath : m_runPaths) {
+            emit fileSearched(filePath);
+        }
+    }
+    m_runPaths.clear();
+
+    // An error in any run stays, else a match in any run
+    if (m_processRuns == 1 || exitCode == 2 || exitStatus == QProcess::CrashExit) {
+        m_processExitCode = exitCode;
+    } else if (exitCode == 0 && m_processExitCode == 1) {
+        m_processExitCode = 0;
+    }
+
+    if (completed && !m_batchPaths.isEmpty()) {
+        startProcess();
+        return;
+    }
+
+    m_processRunning = false;
+    finishIfDone();
+}
+
+QByteArray RipgrepFileSearcher::takeSummary(const QByteArray &completeLines)
+{
+    if (!m_mergeSummaries) {
+        return completeLines;
+    }
+
+    qsizetype summaryStart = completeLines.indexOf("{\"type\":\"summary\"");
+    if (summaryStart < 0 || (summaryStart > 0 && completeLines[summaryStart - 1] != '\n')) {
+        return completeLines;
+    }
+    qsizetype summaryEnd = completeLines.indexOf('\n', summaryStart);
+    summaryEnd = (summaryEnd < 0) ? completeLines.size() : summaryEnd + 1;
+
+    m_processSummaries.append(completeLines.mid(summaryStart, summaryEnd - summaryStart));
+    QByteArray rest = completeLines;
+    rest.remove(summaryStart, summaryEnd - summaryStart);
+    return rest;
+}
+
+QByteArray RipgrepFileSearcher::countRecords(const QByteArray &completeLines)
+{
+    QByteArray records;
+    FileSearchRecordWriter writer(&records);
+
+    qsizetype lineStart = 0;
+    while (lineStart < completeLines.size()) {
+        qsizetype lineEnd = completeLines.indexOf('\n', lineStart);
+        if (lineEnd < 0) {
+            lineEnd = completeLines.size();
+        }
+        qsizetype pathEnd = completeLines.indexOf('\0', lineStart);
+        if (pathEnd > lineStart && pathEnd < lineEnd) {
+            QString filePath = QString::fromUtf8(completeLines.constData() + lineStart, pathEnd - lineStart);
+            int matchedLines = completeLines.mid(pathEnd + 1, lineEnd - pathEnd - 1).trimmed().toInt();
+            if (matchedLines > 0) {
+                // rg reads a counted file whole; --count gives no per-file time or match count
+                qint64 fileBytes = QFileInfo(filePath).size();
+                writer.beginFile(filePath);
+                writer.endFile(filePath, matchedLines, matchedLines, fileBytes, 0);
+                m_countFiles++;
+                m_countLines += matchedLines;
+                m_countBytes += fileBytes;
+            }
+        }
+        lineStart = lineEnd + 1;
+    }
+
+    writer.flush();
+    return records;
+}
+
+void RipgrepFileSearcher::finishIfDone()
+{
+    if (m_processRunning || m_splitThread) {
+        return;
+    }
+
+    int exitCode = m_processExitCode;
+    if (m_mergeSummaries) {
+        // ===== MERGED SUMMARY =====
+        int matchedLines = m_splitMatchedLines.load();
+        int matches = m_splitMatches.load();
+        int searches = m_splitFiles.load();
+        int searchesWithMatch = m_splitFilesWithMatch.load();
+        qint64 bytesSearched = m_splitBytes.load();
+        for (const QByteArray &summary : m_processSummaries) {
+            QJsonObject stats = QJsonDocument::fromJson(summary).object()["data"].toObject()["stats"].toObject();
+            matchedLines += stats["matched_lines"].toInt();
+            matches += stats["matches"].toInt();
+            searches += stats["searches"].toInt();
+            searchesWithMatch += stats["searches_with_match"].toInt();
+            bytesSearched += stats["bytes_searched"].toInteger();
+        }
+
+        FileSearchRecordWriter writer(this);
+        writer.summary(matchedLines, matches, searches, searchesWithMatch, bytesSearched, m_timer.nsecsElapsed());
+        writer.flush();
+
+        if (m_splitError.load()) {
+            exitCode = 2;
+        } else if (exitCode == 0 || exitCode == 1) {
+            exitCode = matchedLines > 0 ? 0 : 1;
+        }
+
+        LOG_INFO("RipgrepFileSearcher: " + QString::number(matchedLines) + " matched lines in " +
+                 QString::number(m_processRuns) + " rg runs, " +
+                 QString::number(m_splitFiles.load()) + " large files searched by ranges, done after " +
+                 QString::number(m_timer.elapsed()) + " ms");
+    } else if (m_countOnly) {
+        // ===== SUMMARY OF THE COUNTS (files without a match are not listed by rg) =====
+        FileSearchRecordWriter writer(this);
+        writer.summary(m_countLines, m_countLines, m_countFiles, m_countFiles, m_countBytes, m_timer.nsecsElapsed());
+        writer.flush();
+
+        LOG_INFO("RipgrepFileSearcher: Counted " + QString::number(m_countLines) + " matched lines in " +
+                 QString::number(m_countFiles) + " files after " + QString::number(m_timer.elapsed()) + " ms");
+    }
+
+    emit finished(exitCode);
+}
+
+void RipgrepFileSearcher::searchLargeFiles(const RGSearchParams &params, QStringList largeFiles, bool walkPath)
+{
+    LOG_INFO("RipgrepFileSearcher: ===THREAD=== Large file search for path: " + params.path + " <<<<<STARTed<<<<<");
+
+    try {
+        // ===== STEP 1: FIND LARGE FILES =====
+        if (walkPath) {
+            // rg's own walk and globs, so the ignore files count as in the main run; keeps what
+            // --max-filesize leaves out
+            for (const QString &filePath : candidateFiles(params)) {
+                if (QFileInfo(filePath).size() >= m_split.thresholdBytes) {
+                    largeFiles << filePath;
+                }
+            }
+        }
+        m_splitFiles = largeFiles.size();
+
+        // ===== STEP 2: CUT THEM INTO RANGES =====
+        // Large compressed files are one task each: an rg decompressing the whole file
+        struct RangeTask {
+            QSharedPointer<SplitFileSearch> file;
+            int index = 0;
+            QString wholeFile;
+        };
+        QVector<RangeTask> tasks;
+        for (const QString &filePath : largeFiles) {
+            if (params.search_compressed && CompressedFile::isCompressedPath(filePath)) {
+                RangeTask task;
+                task.wholeFile = filePath;
+                tasks.append(task);
+                continue;
+            }
+
+            QFile file(filePath);
+            if (!file.open(QIODevice::ReadOnly)) {
+                LOG_WARNING("RipgrepFileSearcher: Cannot open " + filePath);
+                m_splitError = true;
+                continue;
+            }
+            QSharedPointer<SplitFileSearch> splitFile(
+                new SplitFileSearch(filePath, SplitFileSearch::splitFile(file, 0, m_split.rangeBytes), 1));
+            for (int i = 0; i < splitFile->rangeCount(); ++i) {
+                RangeTask task;
+                task.file = splitFile;
+                task.index = i;
+                tasks.append(task);
+            }
+        }
+
+        // ===== STEP 3: ONE RG PER RANGE, AS MANY AT A TIME AS THERE ARE CORES =====
+        QStringList arguments = buildArguments(params);
+        arguments.removeLast();
+        arguments << "-";
+
+        std::atomic<int> nextTask(0);
+        auto worker = [&]() {
+            FileSearchRecordWriter writer(this);
+            writer.setWaitForRoom(true);
+
+            for (int i = nextTask.fetch_add(1); i < tasks.size() && !isCancelled(); i = nextTask.fetch_add(1)) {
+                // No new rg while the results backlog is full
+                waitForOutputRoom();
+                const RangeTask &task = tasks[i];
+                if (!task.wholeFile.isEmpty()) {
+                    searchWholeFile(arguments, task.wholeFile, writer);
+                    continue;
+                }
+                const SplitFileSearch::Range &range = task.file->range(task.index);
+                qint64 rangeSize = range.end - range.start;
+                QByteArray records;
+                qint64 newlines = 0;
+
+                QFile file(task.file->filePath());
+                uchar *mapped = file.open(QIODevice::ReadOnly) ? file.map(range.start, rangeSize) : nullptr;
+                if (!mapped) {
+                    LOG_WARNING("RipgrepFileSearcher: Cannot map range " + QString::number(task.index) + " of " +
+                                task.file->filePath() + ", later line numbers of this file are off");
+                    m_splitError = true;
+                } else {
+                    const char *data = reinterpret_cast<const char*>(mapped);
+                    if (!searchRange(arguments, data, rangeSize, &records, &newlines)) {
+                        if (isCancelled()) {
+                            break;
+                        }
+                        m_splitError = true;
+                        newlines = SplitFileSearch::countNewlines(data, rangeSize);
+                    }
+                    file.unmap(mapped);
+                    m_splitBytes += rangeSize;
+                }
+
+                int matchedLines = 0;
+                int matches = 0;
+                rangeCounts(records, &matchedLines, &matches);
+                if (task.file->rangeDone(task.index, records, newlines, matchedLines, matches, writer)) {
+                    if (task.file->matchedLines() > 0) {
+                        m_splitFilesWithMatch++;
+                        m_splitMatchedLines += task.file->matchedLines();
+                        m_splitMatches += task.file->matches();
+                    }
+                    emit fileSearched(task.file->filePath());
+                }
+            }
+        };
+
+        int threadCount = qBound(1, QThread::idealThreadCount(), qMax(1, int(tasks.size())));
+        QList<QThread*> threads;
+        for (int i = 0; i < threadCount && !tasks.isEmpty(); ++i) {
+            QThread *thread = QThread::create(worker);
+            threads.append(thread);
+            thread->start();
+        }
+        for (QThread *thread : threads) {
+            thread->wait();
+            delete thread;
+        }
+
+        LOG_INFO("RipgrepFileSearcher: " + QString::number(largeFiles.size()) + " large files, " +
+                 QString::number(tasks.size()) + " ranges with " + QString::number(threads.size()) + " rg at a time" +
+                 (isCancelled() ? " (cancelled)" : ""));
+
+    } catch (const std::exception &e) {
+        LOG_ERROR("RipgrepFileSearcher: Exception in large file search: " + QString(e.what()));
+        m_splitError = true;
+    } catch (...) {
+        LOG_ERROR("RipgrepFileSearcher: Unknown exception in large file search");
+        m_splitError = true;
+    }
+
+    LOG_INFO("RipgrepFileSearcher: ===THREAD=== Large file search for path: " + params.path + " >>>>>ENDed>>>>>");
+}
+
+void RipgrepFileSearcher::searchWholeFile(const QStringList &rangeArguments, const QString &filePath,
+                                          FileSearchRecordWriter &writer)
+{
+    // The range arguments read stdin ("-") - this rg opens and decompresses the file itself
+    QStringList arguments = rangeArguments;
+    arguments.removeLast();
+    arguments << filePath;
+
+    QByteArray records;
+    qint64 newlines = 0;
+    if (!searchRange(arguments, nullptr, 0, &records, &newlines)) {
+        if (isCancelled()) {
+            return;
+        }
+        m_splitError = true;
+    }
+
+    int matchedLines = 0;
+    int matches = 0;
+    rangeCounts(records, &matchedLines, &matches);
+    qsizetype summaryStart = records.lastIndexOf("{\"type\":\"summary\"");
+    if (summaryStart >= 0) {
+        records.truncate(summaryStart);
+    }
+
+    // Complete records of one file, after what this thread wrote before
+    writer.flush();
+    if (!records.isEmpty()) {
+        emit outputChunk(records);
+    }
+
+    m_splitBytes += QFileInfo(filePath).size();
+    if (matchedLines > 0) {
+        m_splitFilesWithMatch++;
+        m_splitMatchedLines += matchedLines;
+        m_splitMatches += matches;
+    }
+    emit fileSearched(filePath);
+}
+
+void RipgrepFileSearcher::rangeCounts(const QByteArray &records, int *matchedLines, int *matches)
+{
+    qsizetype summaryStart = records.lastIndexOf("{\"type\":\"summary\"");
+    if (summaryStart < 0) {
+        return;
+    }
+    qsizetype summaryEnd = records.indexOf('\n', summaryStart);
+    summaryEnd = (summaryEnd < 0) ? records.size() : summaryEnd;
+
+    QJsonObject stats = QJsonDocument::fromJson(records.mid(summaryStart, summaryEnd - summaryStart))
+                            .object()["data"].toObject()["stats"].toObject();
+    *matchedLines = stats["matched_lines"].toInt();
+    *matches = stats["matches"].toInt();
+}
+
+bool RipgrepFileSearcher::searchRange(const QStringList &arguments, const char *data, qint64 size,
+                                      QByteArray *records, qint64 *newlines)
+{
+    // Blocking QProcess on this thread - waitForBytesWritten also reads rg's output, so a full
+    // stdout pipe never stalls rg while it is being fed
+    QProcess process;
+    process.start(executable(), arguments);
+    if (!process.waitForStarted()) {
+        LOG_WARNING("RipgrepFileSearcher: Cannot start " + executable() + " for a range");
+        return false;
+    }
+
+    for (qint64 written = 0; written < size && !isCancelled(); ) {
+        qint64 piece = qMin(RangePipeBytes, size - written);
+        process.write(data + written, piece);
+        *newlines += SplitFileSearch::countNewlines(data + written, piece);
+        written += piece;
+
+        while (process.bytesToWrite() > 0 && process.state() == QProcess::Running && !isCancelled()) {
+            process.waitForBytesWritten(100);
+            records->append(process.readAllStandardOutput());
+        }
+    }
+    process.closeWriteChannel();
+
+    while (process.state() != QProcess::NotRunning) {
+        if (isCancelled()) {
+            process.kill();
+        }
+        process.waitForFinished(100);
+        records->append(process.readAllStandardOutput());
+    }
+    records->append(process.readAllStandardOutput());
+
+    QString errorOutput = QString::fromUtf8(process.readAllStandardError());
+    if (!errorOutput.isEmpty()) {
+        LOG_WARNING("RipgrepFileSearcher: Ripgrep errors on a range: " + errorOutput);
+    }
+
+    return !isCancelled() && process.exitStatus() == QProcess::NormalExit && process.exitCode() != 2;
+}
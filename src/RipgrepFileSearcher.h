@@ -0,0 +1,137 @@
+#ifndef RIPGREPFILESEARCHER_H
+#define RIPGREPFILESEARCHER_H
+
+#include <QProcess>
+#include <QElapsedTimer>
+#include <QThread>
+#include "filesearcher.h"
+#include "SplitFileSearch.h"
+
+// Search backend running the bundled ripgrep with --json. Output is forwarded in blocks of
+// complete JSON lines while rg is running - only the trailing partial line is kept here.
+// rg searches each file on one thread, so files from the split size on are left out of the main
+// rg run (--max-filesize) and searched by ranges instead: one rg per range reading it on stdin,
+// several at a time, re-sequenced by SplitFileSearch. The summaries are merged into one. Large
+// compressed files cannot be cut and get one rg each.
+// Targets are searched by consecutive rg runs over batches of the list, in list order: the first
+// batch is small and each one doubles, up to what fits on a command line. rg does not say when a
+// file without a match is done, so a batch's files are reported searched when its rg exits.
+// While the results backlog (setFlowControl) is full the main rg is stopped (SIGSTOP; on Windows
+// its threads are suspended) and no new range rg is started. What rg wrote before that waits in
+// the pipe and the QProcess buffer.
+class RipgrepFileSearcher : public FileSearcher
+{
+    Q_OBJECT
+
+public:
+    explicit RipgrepFileSearcher(QObject *parent = nullptr);
+    ~RipgrepFileSearcher();
+
+    QString engineName() const override { return "ripgrep"; }
+
+    void start(const RGSearchParams &params) override;
+
+    // Kills the rg process - call from the thread this object lives in (range searches stop too)
+    void cancel() override;
+
+    // Whole files passed on the command line (in batches) - rg cannot start a file at an offset
+    bool canSearchTargets(const QVector<SearchTarget> &targets) const override;
+
+    // rg --files with the same globs: rg applies no ignore files (.gitignore, .ignore, .rgignore)
+    // to paths named on its command line, so a list handed back to it must be its own walk
+    QStringList candidateFiles(const RGSearchParams &params) const override;
+
+    // Longest target path list passed on one command line (Windows allows 32K characters)
+    static constexpr int MaxTargetChars = 24000;
+
+    // Targets of the first rg run - later runs take twice as many as the one before
+    static constexpr int FirstBatchFiles = 16;
+
+    // Path of the ripgrep executable shipped with the application
+    static QString executable();
+
+    // ripgrep arguments (without the executable) for a --json search, or a --count search for
+    // params.count_only
+    static QStringList buildArguments(const RGSearchParams &params);
+
+    // -g arguments for the comma separated include/exclude globs of params
+    static QStringList globArguments(const RGSearchParams &params);
+
+    // Bytes written to a range's rg at a time
+    static constexpr qint64 RangePipeBytes = 4 * 1024 * 1024;
+
+private slots:
+    void onReadyRead();
+    void onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+    // The results backlog dropped below its cap: let rg go on and forward what it wrote
+    void resumeOutput();
+
+private:
+    // ===== LARGE FILES BY RANGES =====
+    // Search thread: find the large files (walking params.path if walkPath), search their ranges
+    void searchLargeFiles(const RGSearchParams &params, QStringList largeFiles, bool walkPath);
+
+    // Run one rg over data on stdin, collect its records, false on error or cancellation
+    bool searchRange(const QStringList &arguments, const char *data, qint64 size,
+                     QByteArray *records, qint64 *newlines);
+
+    // One rg over a whole large compressed file (--search-zip), its records written as they are
+    void searchWholeFile(const QStringList &rangeArguments, const QString &filePath, FileSearchRecordWriter &writer);
+
+    // Match counts of a range from the summary record of its rg
+    static void rangeCounts(const QByteArray &records, int *matchedLines, int *matches);
+
+    // Keep the main rg's summary back for the merged one
+    QByteArray takeSummary(const QByteArray &completeLines);
+
+    // Begin and end records for the "path\0count" lines of a count-only rg
+    QByteArray countRecords(const QByteArray &completeLines);
+
+    // Merged summary and finished() once the main rg and the range searches are both done
+    void finishIfDone();
+
+    // Start the main rg on the next batch of m_batchPaths (all of them without targets)
+    void startProcess();
+
+    // Stop reading the main rg (and stop rg) until resumeOutput
+    void pauseOutput();
+
+    QProcess *m_process;
+    QThread *m_splitThread;         // Range searches of large files, nullptr when done
+    SplitFileSearch::Config m_split;
+    bool m_processRunning;
+    bool m_outputPaused;            // Main rg stopped for the results backlog
+    int m_pauses;
+    int m_processExitCode;
+    QList<QByteArray> m_processSummaries;   // Summary records of the main rg runs
+    bool m_mergeSummaries;          // Range searches or several main rg runs
+
+    // Main rg runs: arguments without paths, paths not started yet and those of the running rg
+    QStringList m_baseArguments;
+    QStringList m_batchPaths;
+    QStringList m_runPaths;
+    int m_batchFiles;               // Targets the next run may take
+    int m_processRuns;
+
+    // Range search totals, written by the split thread
+    std::atomic<int> m_splitFiles;
+    std::atomic<int> m_splitFilesWithMatch;
+    std::atomic<int> m_splitMatchedLines;
+    std::atomic<int> m_splitMatches;
+    std::atomic<qint64> m_splitBytes;
+    std::atomic<bool> m_splitError;
+
+    // Count-only search totals (params.count_only)
+    bool m_countOnly;
+    int m_countFiles;
+    int m_countLines;
+    qint64 m_countBytes;
+
+    QByteArray m_buffer;        // Trailing partial line from the last read
+    qint64 m_bytesForwarded;    // Bytes forwarded to the parser so far
+    bool m_firstChunkSent;      // First chunk timing is logged once per search
+    QElapsedTimer m_timer;      // Time since the process was started
+};
+
+#endif // RIPGREPFILESEARCHER_H
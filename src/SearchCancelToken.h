@@ -0,0 +1,51 @@
+#ifndef SEARCHCANCELTOKEN_H
+#define SEARCHCANCELTOKEN_H
+
+#include <QSharedPointer>
+#include <QMetaType>
+#include <atomic>
+
+// Cancellation of one search session. The token is handed to every stage working for the session
+// (search, parse, map, highlight); copies share one flag, so a stage polls it wherever it already
+// checks for a stop and nobody has to wait for anybody else. cancel() is safe from any thread.
+// A default constructed token belongs to no session and is never cancelled.
+class SearchCancelToken
+{
+public:
+    SearchCancelToken() = default;
+
+    static SearchCancelToken create(quint64 session)
+    {
+        SearchCancelToken token;
+        token.d = QSharedPointer<State>::create();
+        token.d->session = session;
+        return token;
+    }
+
+    void cancel() const
+    {
+        if (d) {
+            d->cancelled.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    bool isCancelled() const
+    {
+        return d && d->cancelled.load(std::memory_order_relaxed);
+    }
+
+    // Output tagged with an older session than the current one is stale
+    quint64 session() const { return d ? d->session : 0; }
+
+private:
+    struct State {
+        std::atomic<bool> cancelled{false};
+        quint64 session = 0;
+    };
+
+    QSharedPointer<State> d;
+};
+
+Q_DECLARE_METATYPE(SearchCancelToken)
+
+#endif // SEARCHCANCELTOKEN_H
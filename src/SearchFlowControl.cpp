@@ -0,0 +1,79 @@
+#include "SearchFlowControl.h"
+#include "logger.h"
+#include <QSettings>
+#include <QThread>
+
+SearchFlowControl::SearchFlowControl(QObject *parent)
+    : QObject(parent)
+    , m_inFlight(0)
+    , m_peakInFlight(0)
+    , m_totalBytes(0)
+    , m_waits(0)
+{
+    QSettings settings("app.ini", QSettings::IniFormat);
+    settings.beginGroup("RGSearch");
+    m_capBytes = qMax(1LL, settings.value("StreamBacklogMB", 64).toLongLong()) * 1024 * 1024;
+    settings.endGroup();
+}
+
+SearchFlowControl::~SearchFlowControl()
+{
+    LOG_INFO("SearchFlowControl: " + QString::number(m_totalBytes / 1024) + " KB streamed, peak backlog " +
+             QString::number(m_peakInFlight / 1024) + " KB of " + QString::number(m_capBytes / (1024 * 1024)) +
+             " MB, producers held back " + QString::number(m_waits) + " times");
+}
+
+void SearchFlowControl::produced(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_inFlight += bytes;
+    m_totalBytes += bytes;
+    m_peakInFlight = qMax(m_peakInFlight, m_inFlight);
+}
+
+void SearchFlowControl::consumed(qint64 bytes)
+{
+    if (bytes <= 0) {
+        return;
+    }
+
+    bool wasFull;
+    bool full;
+    {
+        QMutexLocker locker(&m_mutex);
+        wasFull = m_inFlight >= m_capBytes;
+        m_inFlight = qMax(0LL, m_inFlight - bytes);
+        full = m_inFlight >= m_capBytes;
+        if (!full) {
+            m_room.wakeAll();
+        }
+    }
+
+    if (wasFull && !full) {
+        emit roomAvailable();
+    }
+}
+
+bool SearchFlowControl::isFull() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_inFlight >= m_capBytes;
+}
+
+void SearchFlowControl::waitForRoom(const std::function<bool()> &stop)
+{
+    if (QThread::currentThread() == thread()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_inFlight < m_capBytes) {
+        return;
+    }
+    m_waits++;
+
+    // Short slices, so a cancelled search does not wait for a consumer that has moved on
+    while (m_inFlight >= m_capBytes && !stop()) {
+        m_room.wait(&m_mutex, 100);
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef SEARCHFLOWCONTROL_H
+#define SEARCHFLOWCONTROL_H
+
+#include <QObject>
+#include <QMutex>
+#include <QWaitCondition>
+#include <functional>
+
+// Backpressure between a streaming search and whoever shows its results. The search side counts
+// the record bytes it hands out (produced), the results side the bytes whose batch it has taken
+// into its model (consumed). Above [RGSearch] StreamBacklogMB in flight the producers stop: the
+// in-process engines block their worker threads in waitForRoom, ripgrep's output is no longer
+// read. roomAvailable is sent once the backlog drops below the cap again. One per stream, shared
+// by both sides; created on the consumer's thread.
+class SearchFlowControl : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SearchFlowControl(QObject *parent = nullptr);
+    ~SearchFlowControl();
+
+    // Safe to call from any thread
+    void produced(qint64 bytes);
+    void consumed(qint64 bytes);
+    bool isFull() const;
+
+    // Block the calling thread while the backlog is full, until stop() returns true. Returns at
+    // once on the consumer's thread, which would otherwise wait for itself.
+    void waitForRoom(const std::function<bool()> &stop);
+
+    qint64 capBytes() const { return m_capBytes; }
+
+signals:
+    // The backlog dropped below the cap - emitted on the thread that consumed
+    void roomAvailable();
+
+private:
+    mutable QMutex m_mutex;
+    QWaitCondition m_room;
+    qint64 m_capBytes;
+    qint64 m_inFlight;
+    qint64 m_peakInFlight;
+    qint64 m_totalBytes;
+    int m_waits;                    // Times a producer found the backlog full
+};
+
+#endif // SEARCHFLOWCONTROL_H
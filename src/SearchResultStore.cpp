@@ -0,0 +1,182 @@
+#include "SearchResultStore.h"
+
+SearchResultStore::SearchResultStore()
+{
+}
+
+void SearchResultStore::clear()
+{
+    // Assign empty containers so the memory is actually released
+    m_filePaths = QVector<QString>();
+    m_fileIds = QHash<QString, int>();
+    m_fileElapsed = QVector<QString>();
+    m_fileMatchedLines = QVector<int>();
+    m_fileFingerprints = QVector<FileFingerprint>();
+    m_fileRows = QVector<QVector<int>>();
+
+    m_matchFileId = QVector<qint32>();
+    m_lineNumber = QVector<qint32>();
+    m_column = QVector<qint32>();
+    m_byteOffset = QVector<qint64>();
+    m_lineLength = QVector<qint32>();
+    m_patternMask = QVector<quint64>();
+
+    m_inlineText = QHash<int, QByteArray>();
+    m_lineCache.clear();
+}
+
+int SearchResultStore::internFile(const QString &filePath)
+{
+    auto it = m_fileIds.constFind(filePath);
+    if (it != m_fileIds.constEnd()) {
+        return it.value();
+    }
+
+    int id = m_filePaths.size();
+    m_filePaths.append(filePath);
+    m_fileIds.insert(filePath, id);
+    m_fileElapsed.append(QString());
+    m_fileMatchedLines.append(0);
+    m_fileFingerprints.append(FileFingerprint());
+    m_fileRows.append(QVector<int>());
+    return id;
+}
+
+int SearchResultStore::fileId(const QString &filePath) const
+{
+    return m_fileIds.value(filePath, -1);
+}
+
+void SearchResultStore::setFileStats(int fileId, const QString &elapsed, int matchedLines)
+{
+    if (fileId < 0 || fileId >= m_filePaths.size()) {
+        return;
+    }
+    m_fileElapsed[fileId] = elapsed;
+    m_fileMatchedLines[fileId] = matchedLines;
+}
+
+void SearchResultStore::setFileFingerprint(int fileId, const FileFingerprint &fingerprint)
+{
+    if (fileId < 0 || fileId >= m_filePaths.size() || !fingerprint.isValid() || m_fileFingerprints[fileId].isValid()) {
+        return;
+    }
+    m_fileFingerprints[fileId] = fingerprint;
+}
+
+int SearchResultStore::fileMatchCount(int fileId) const
+{
+    if (fileId < 0 || fileId >= m_fileRows.size()) {
+        return 0;
+    }
+    return m_fileRows[fileId].size();
+}
+
+int SearchResultStore::appendMatch(int fileId, int lineNumber, int column, qint64 byteOffset, int lineLength,
+                                   QByteArrayView inlineText, quint64 patternMask)
+{
+    if (fileId < 0 || fileId >= m_filePaths.size()) {
+        return -1;
+    }
+
+    int row = m_matchFileId.size();
+    m_matchFileId.append(fileId);
+    m_lineNumber.append(lineNumber);
+    m_column.append(column);
+    m_byteOffset.append(byteOffset);
+    m_lineLength.append(lineLength);
+
+    // Plain searches never pay for the column
+    if (patternMask != 0) {
+        m_patternMask.resize(row);
+        m_patternMask.append(patternMask);
+    }
+
+    if (byteOffset < 0) {
+        qsizetype length = qMin<qsizetype>(inlineText.size(), MaxStoredLineBytes);
+        m_inlineText.insert(row, QByteArray(inlineText.data(), length));
+    }
+
+    m_fileRows[fileId].append(row);
+    return row;
+}
+
+void SearchResultStore::appendBatch(const SearchResultBatch &batch)
+{
+    QVector<int> fileIds(batch.filePaths.size());
+    for (int i = 0; i < batch.filePaths.size(); ++i) {
+        fileIds[i] = internFile(batch.filePaths[i]);
+        setFileFingerprint(fileIds[i], batch.fileFingerprint[i]);
+    }
+    for (int i = 0; i < batch.matchCount(); ++i) {
+        appendMatch(fileIds[batch.matchFile[i]], batch.lineNumber[i], batch.column[i], batch.byteOffset[i],
+                    batch.lineLength[i], batch.lineTextBytes(i), batch.patternMask[i]);
+    }
+    for (int i = 0; i < batch.filePaths.size(); ++i) {
+        if (batch.fileEnded[i]) {
+            setFileStats(fileIds[i], batch.fileElapsed[i], batch.fileMatchedLines[i]);
+        }
+    }
+}
+
+QString SearchResultStore::lineText(int row) const
+{
+    if (m_byteOffset[row] < 0) {
+        return QString::fromUtf8(m_inlineText.value(row)).trimmed();
+    }
+    int fileId = m_matchFileId[row];
+    return m_lineCache.lineText(row, fileId, m_filePaths[fileId], m_fileFingerprints[fileId], m_byteOffset[row],
+                                m_lineLength[row]);
+}
+
+qint64 SearchResultStore::memoryUsage() const
+{
+    qint64 bytes = qint64(m_matchFileId.capacity()) * sizeof(qint32);
+    bytes += qint64(m_lineNumber.capacity()) * sizeof(qint32);
+    bytes += qint64(m_column.capacity()) * sizeof(qint32);
+    bytes += qint64(m_byteOffset.capacity()) * sizeof(qint64);
+    bytes += qint64(m_lineLength.capacity()) * sizeof(qint32);
+    bytes += qint64(m_patternMask.capacity()) * sizeof(quint64);
+    for (auto it = m_inlineText.constBegin(); it != m_inlineText.constEnd(); ++it) {
+        bytes += it.value().capacity();
+    }
+    for (int i = 0; i < m_filePaths.size(); ++i) {
+        bytes += m_filePaths[i].capacity() * 2 * 2;  // Path in the table and as hash key
+        bytes += qint64(m_fileRows[i].capacity()) * sizeof(int);
+    }
+    bytes += qint64(m_fileFingerprints.capacity()) * sizeof(FileFingerprint);
+    return bytes;
+}
+
+int SearchResultBatch::addFile(const QString &filePath)
+{
+    // Records of one file arrive together, so comparing with the last file is enough
+    if (!filePaths.isEmpty() && filePaths.last() == filePath) {
+        return filePaths.size() - 1;
+    }
+
+    filePaths.append(filePath);
+    fileBegun.append(false);
+    fileEnded.append(false);
+    fileElapsed.append(QString());
+    fileMatchedLines.append(0);
+    fileFingerprint.append(FileFingerprint());
+    return filePaths.size() - 1;
+}
+
+void SearchResultBatch::appendMatch(int file, int lineNumber, int column, qint64 byteOffset, int lineLength,
+                                    QByteArrayView inlineText, quint64 patternMask)
+{
+    matchFile.append(file);
+    this->lineNumber.append(lineNumber);
+    this->column.append(column);
+    this->byteOffset.append(byteOffset);
+    this->lineLength.append(lineLength);
+    this->patternMask.append(patternMask);
+
+    // Lines with a known offset are read back from the file when displayed
+    if (byteOffset < 0) {
+        text.append(inlineText.data(), qMin<qsizetype>(inlineText.size(), SearchResultStore::MaxStoredLineBytes));
+    }
+    textEnd.append(qint32(text.size()));
+}
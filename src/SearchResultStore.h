@@ -0,0 +1,141 @@
+#ifndef SEARCHRESULTSTORE_H
+#define SEARCHRESULTSTORE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QVector>
+#include <QHash>
+#include <QSharedPointer>
+#include <QMetaType>
+#include "SourceLineCache.h"
+#include "FileFingerprint.h"
+
+struct SearchResultBatch;
+
+// Columnar storage for the matches of one search session.
+// File paths are interned once in a file table; every match is one row in parallel arrays
+// (file id, line number, column, byte offset, line length). Line texts are not stored:
+// they are read back from the searched file when a row is displayed, so a match costs
+// about 28 bytes however long its line is. Only matches without a byte offset keep
+// their text inline.
+class SearchResultStore
+{
+public:
+    SearchResultStore();
+
+    void clear();
+
+    // ===== FILE TABLE =====
+    // Returns the id of filePath, adding it on first use
+    int internFile(const QString &filePath);
+    int fileId(const QString &filePath) const;  // -1 if unknown
+    int fileCount() const { return m_filePaths.size(); }
+    QString filePath(int fileId) const { return m_filePaths.value(fileId); }
+
+    // Per-file statistics from the search tool's "end" record
+    void setFileStats(int fileId, const QString &elapsed, int matchedLines);
+    QString fileElapsed(int fileId) const { return m_fileElapsed.value(fileId); }
+    int fileMatchedLines(int fileId) const { return m_fileMatchedLines.value(fileId); }
+
+    // Version of the file the search read, taken when its begin record was parsed. The first
+    // valid one is kept; invalid if the file was never fingerprinted.
+    void setFileFingerprint(int fileId, const FileFingerprint &fingerprint);
+    FileFingerprint fileFingerprint(int fileId) const { return m_fileFingerprints.value(fileId); }
+
+    // Matches of one file in arrival order
+    int fileMatchCount(int fileId) const;
+    int fileMatchRow(int fileId, int index) const { return m_fileRows[fileId][index]; }
+
+    // ===== MATCHES =====
+    // lineLength is the byte length of the line without its terminator. inlineText is
+    // only kept when byteOffset < 0 (cut at MaxStoredLineBytes). patternMask is set by
+    // batch searches: bit i = pattern i matched the line.
+    int appendMatch(int fileId, int lineNumber, int column, qint64 byteOffset, int lineLength,
+                    QByteArrayView inlineText = QByteArrayView(), quint64 patternMask = 0);
+
+    // All files, matches and file stats of a parser batch (without a view to notify)
+    void appendBatch(const SearchResultBatch &batch);
+
+    int matchCount() const { return m_matchFileId.size(); }
+    int matchFileId(int row) const { return m_matchFileId[row]; }
+    int lineNumber(int row) const { return m_lineNumber[row]; }
+    int column(int row) const { return m_column[row]; }             // 1-based, 0 if unknown
+    qint64 byteOffset(int row) const { return m_byteOffset[row]; }  // Offset of the line start, -1 if unknown
+    int lineLength(int row) const { return m_lineLength[row]; }
+    quint64 patternMask(int row) const { return (row < m_patternMask.size()) ? m_patternMask[row] : 0; }
+
+    // Trimmed line text, read from the source file on demand (recent lines are cached)
+    QString lineText(int row) const;
+
+    // Approximate heap size of the store
+    qint64 memoryUsage() const;
+
+    static constexpr int MaxStoredLineBytes = 4096;
+
+private:
+    // File table
+    QVector<QString> m_filePaths;
+    QHash<QString, int> m_fileIds;
+    QVector<QString> m_fileElapsed;
+    QVector<int> m_fileMatchedLines;
+    QVector<FileFingerprint> m_fileFingerprints;
+    QVector<QVector<int>> m_fileRows;
+
+    // Match columns (one entry per match)
+    QVector<qint32> m_matchFileId;
+    QVector<qint32> m_lineNumber;
+    QVector<qint32> m_column;
+    QVector<qint64> m_byteOffset;
+    QVector<qint32> m_lineLength;
+    QVector<quint64> m_patternMask;     // Only filled up to the last row of a batch search
+
+    // Text of the rows that cannot be read back from their file
+    QHash<int, QByteArray> m_inlineText;
+
+    mutable SourceLineCache m_lineCache;
+};
+
+// A block of parsed results handed from the parser thread to the UI in one queued call.
+// Built by the parser, then shared read-only; begin/end records are folded into the
+// per-file columns, matches use the same columnar layout as SearchResultStore.
+struct SearchResultBatch {
+    // Files referenced by this batch - matches point into these by index
+    QVector<QString> filePaths;
+    QVector<bool> fileBegun;            // The file's begin record is part of this batch
+    QVector<bool> fileEnded;            // The file's end record is part of this batch
+    QVector<QString> fileElapsed;       // From the end record
+    QVector<qint32> fileMatchedLines;
+    QVector<FileFingerprint> fileFingerprint;   // Taken at the begin record, invalid otherwise
+
+    // Matches in arrival order
+    QVector<qint32> matchFile;
+    QVector<qint32> lineNumber;
+    QVector<qint32> column;
+    QVector<qint64> byteOffset;
+    QVector<qint32> lineLength;
+    QVector<quint64> patternMask;       // Batch search: bit i = pattern i matched the line
+    QVector<qint32> textEnd;            // End of the match's inline text in text
+    QByteArray text;                    // Only for matches without a byte offset
+    
+    // Search output parsed into this batch - reported consumed once the batch is taken in
+    qint64 streamBytes = 0;
+
+    // Index of filePath in this batch, added if it is not the most recent file
+    int addFile(const QString &filePath);
+    void appendMatch(int file, int lineNumber, int column, qint64 byteOffset, int lineLength,
+                     QByteArrayView inlineText, quint64 patternMask = 0);
+
+    int matchCount() const { return matchFile.size(); }
+    bool isEmpty() const { return filePaths.isEmpty(); }
+    QByteArrayView lineTextBytes(int index) const
+    {
+        qint32 start = (index > 0) ? textEnd[index - 1] : 0;
+        return QByteArrayView(text.constData() + start, textEnd[index] - start);
+    }
+};
+
+using SearchResultBatchPtr = QSharedPointer<const SearchResultBatch>;
+Q_DECLARE_METATYPE(SearchResultBatchPtr)
+
+#endif // SEARCHRESULTSTORE_H
@@ -0,0 +1,485 @@
+#include "SearchResultsModel.h"
+#include "logger.h"
+#include <QApplication>
+#include <QStyle>
+#include <QColor>
+#include <QHash>
+#include <QStringList>
+
+SearchResultsModel::SearchResultsModel(QObject *parent)
+    : QAbstractItemModel(parent)
+    , m_statusKind(NoStatus)
+{
+    m_fileFont.setBold(true);
+    m_fileFont.setPointSize(10);
+    m_statusFont = QFont("Arial", 12, QFont::Bold);
+    m_openIcon = QApplication::style()->standardIcon(QStyle::SP_DirOpenIcon);
+    m_closedIcon = QApplication::style()->standardIcon(QStyle::SP_DirClosedIcon);
+}
+
+SearchResultsModel::~SearchResultsModel()
+{
+}
+
+void SearchResultsModel::clear()
+{
+    // A reset drops all view state at once instead of removing rows one by one
+    beginResetModel();
+    m_store.clear();
+    m_fileExpanded = QVector<bool>();
+    m_matchesRequested = QVector<bool>();
+    m_statusKind = NoStatus;
+    m_statusText.clear();
+    resetGroups();
+    endResetModel();
+}
+
+void SearchResultsModel::setPatternGroups(const QStringList &names, const QStringList &patterns)
+{
+    beginResetModel();
+    m_store.clear();
+    m_matchesRequested = QVector<bool>();
+    m_statusKind = NoStatus;
+    m_statusText.clear();
+    m_groupNames = names;
+    m_groupPatterns = patterns;
+    resetGroups();
+    endResetModel();
+}
+
+void SearchResultsModel::resetGroups()
+{
+    m_groupRows = QVector<QVector<int>>(m_groupNames.size());
+    m_groupFiles = QVector<QSet<int>>(m_groupNames.size());
+    m_fileExpanded = QVector<bool>(m_groupNames.size(), false);
+}
+
+void SearchResultsModel::appendBatch(const SearchResultBatch &batch)
+{
+    if (batch.isEmpty()) {
+        return;
+    }
+
+    if (m_statusKind == SearchingStatus) {
+        setStatus(NoStatus, QString());
+    }
+
+    if (isGroupedByPattern()) {
+        appendBatchByPattern(batch);
+        return;
+    }
+
+    // ===== FILES: NEW ONES ARE APPENDED AS ONE BLOCK OF TOP-LEVEL ROWS =====
+    QVector<int> fileIds(batch.filePaths.size(), -1);
+    QStringList newPaths;
+    QHash<QString, int> newPathIndex;
+    for (int i = 0; i < batch.filePaths.size(); ++i) {
+        const QString &filePath = batch.filePaths[i];
+        fileIds[i] = m_store.fileId(filePath);
+        if (fileIds[i] < 0 && !newPathIndex.contains(filePath)) {
+            newPathIndex.insert(filePath, newPaths.size());
+            newPaths.append(filePath);
+        }
+    }
+
+    if (!newPaths.isEmpty()) {
+        int first = m_store.fileCount();
+        beginInsertRows(QModelIndex(), first, first + newPaths.size() - 1);
+        for (const QString &filePath : newPaths) {
+            m_store.internFile(filePath);
+            m_fileExpanded.append(false);
+            m_matchesRequested.append(false);
+        }
+        endInsertRows();
+
+        for (int i = 0; i < batch.filePaths.size(); ++i) {
+            if (fileIds[i] < 0) {
+                fileIds[i] = m_store.fileId(batch.filePaths[i]);
+            }
+        }
+    }
+    for (int i = 0; i < batch.filePaths.size(); ++i) {
+        m_store.setFileFingerprint(fileIds[i], batch.fileFingerprint[i]);
+    }
+
+    // ===== MATCHES: ONE INSERT PER RUN OF MATCHES OF THE SAME FILE =====
+    for (int runStart = 0; runStart < batch.matchCount(); ) {
+        int file = batch.matchFile[runStart];
+        int runEnd = runStart + 1;
+        while (runEnd < batch.matchCount() && batch.matchFile[runEnd] == file) {
+            ++runEnd;
+        }
+
+        int fileId = fileIds[file];
+        int first = m_store.fileMatchCount(fileId);
+        beginInsertRows(fileIndex(fileId), first, first + (runEnd - runStart) - 1);
+        for (int i = runStart; i < runEnd; ++i) {
+            m_store.appendMatch(fileId, batch.lineNumber[i], batch.column[i], batch.byteOffset[i],
+                                batch.lineLength[i], batch.lineTextBytes(i), batch.patternMask[i]);
+        }
+        endInsertRows();
+
+        runStart = runEnd;
+    }
+
+    // ===== FILE STATS FROM END RECORDS =====
+    for (int i = 0; i < batch.filePaths.size(); ++i) {
+        if (batch.fileEnded[i]) {
+            m_store.setFileStats(fileIds[i], batch.fileElapsed[i], batch.fileMatchedLines[i]);
+            QModelIndex index = fileIndex(fileIds[i]);
+            emit dataChanged(index, index, {Qt::DisplayRole});
+        }
+    }
+}
+
+void SearchResultsModel::appendBatchByPattern(const SearchResultBatch &batch)
+{
+    // Files only go into the store - they have no rows of their own
+    QVector<int> fileIds(batch.filePaths.size());
+    for (int i = 0; i < batch.filePaths.size(); ++i) {
+        fileIds[i] = m_store.internFile(batch.filePaths[i]);
+        m_store.setFileFingerprint(fileIds[i], batch.fileFingerprint[i]);
+    }
+
+    // ===== MATCHES: STORED ONCE, LISTED UNDER EVERY PATTERN THAT MATCHED THE LINE =====
+    int patterns = m_groupNames.size();
+    QVector<QVector<int>> newRows(patterns + 1);
+    for (int i = 0; i < batch.matchCount(); ++i) {
+        quint64 mask = batch.patternMask[i];
+        int row = m_store.appendMatch(fileIds[batch.matchFile[i]], batch.lineNumber[i], batch.column[i],
+                                      batch.byteOffset[i], batch.lineLength[i], batch.lineTextBytes(i), mask);
+        if (mask == 0) {
+            newRows[patterns].append(row);
+        }
+        for (int group = 0; mask != 0 && group < patterns; ++group) {
+            if (mask & (quint64(1) << group)) {
+                newRows[group].append(row);
+            }
+        }
+    }
+
+    // Lines none of the patterns matched alone get a group of their own once there are any
+    if (!newRows[patterns].isEmpty() && m_groupRows.size() == patterns) {
+        beginInsertRows(QModelIndex(), patterns, patterns);
+        m_groupRows.append(QVector<int>());
+        m_groupFiles.append(QSet<int>());
+        m_fileExpanded.append(false);
+        endInsertRows();
+    }
+
+    for (int group = 0; group < m_groupRows.size(); ++group) {
+        const QVector<int> &rows = newRows[group];
+        if (rows.isEmpty()) {
+            continue;
+        }
+        QModelIndex groupIndex = createIndex(group, 0, TopLevelId);
+        int first = m_groupRows[group].size();
+        beginInsertRows(groupIndex, first, first + rows.size() - 1);
+        m_groupRows[group].append(rows);
+        for (int row : rows) {
+            m_groupFiles[group].insert(m_store.matchFileId(row));
+        }
+        endInsertRows();
+        emit dataChanged(groupIndex, groupIndex, {Qt::DisplayRole});
+    }
+
+    // ===== FILE STATS FROM END RECORDS =====
+    for (int i = 0; i < batch.filePaths.size(); ++i) {
+        if (batch.fileEnded[i]) {
+            m_store.setFileStats(fileIds[i], batch.fileElapsed[i], batch.fileMatchedLines[i]);
+        }
+    }
+}
+
+void SearchResultsModel::setStatus(StatusKind kind, const QString &text)
+{
+    int row = topLevelCount();
+    bool hadStatus = (m_statusKind != NoStatus);
+    bool hasStatus = (kind != NoStatus);
+
+    if (hadStatus && !hasStatus) {
+        beginRemoveRows(QModelIndex(), row, row);
+        m_statusKind = NoStatus;
+        m_statusText.clear();
+        endRemoveRows();
+    } else if (!hadStatus && hasStatus) {
+        beginInsertRows(QModelIndex(), row, row);
+        m_statusKind = kind;
+        m_statusText = text;
+        endInsertRows();
+    } else if (hasStatus) {
+        m_statusKind = kind;
+        m_statusText = text;
+        QModelIndex statusIndex = createIndex(row, 0, TopLevelId);
+        emit dataChanged(statusIndex, statusIndex);
+    }
+}
+
+void SearchResultsModel::setHeaderText(const QString &text)
+{
+    m_headerText = text;
+    emit headerDataChanged(Qt::Horizontal, 0, 0);
+}
+
+void SearchResultsModel::setFileExpanded(const QModelIndex &index, bool expanded)
+{
+    if (!isFileIndex(index)) {
+        return;
+    }
+    m_fileExpanded[index.row()] = expanded;
+    emit dataChanged(index, index, {Qt::DecorationRole});
+}
+
+void SearchResultsModel::setAllFilesExpanded(bool expanded)
+{
+    if (m_fileExpanded.isEmpty()) {
+        return;
+    }
+    m_fileExpanded.fill(expanded);
+    emit dataChanged(createIndex(0, 0, TopLevelId), createIndex(m_fileExpanded.size() - 1, 0, TopLevelId),
+                     {Qt::DecorationRole});
+}
+
+int SearchResultsModel::topLevelCount() const
+{
+    return isGroupedByPattern() ? m_groupRows.size() : m_store.fileCount();
+}
+
+int SearchResultsModel::childCount(int topRow) const
+{
+    if (isGroupedByPattern()) {
+        return (topRow >= 0 && topRow < m_groupRows.size()) ? m_groupRows[topRow].size() : 0;
+    }
+    return m_store.fileMatchCount(topRow);
+}
+
+int SearchResultsModel::childMatchRow(int topRow, int index) const
+{
+    if (index < 0 || index >= childCount(topRow)) {
+        return -1;
+    }
+    return isGroupedByPattern() ? m_groupRows[topRow][index] : m_store.fileMatchRow(topRow, index);
+}
+
+QModelIndex SearchResultsModel::fileIndex(int fileId) const
+{
+    if (isGroupedByPattern() || fileId < 0 || fileId >= m_store.fileCount()) {
+        return QModelIndex();
+    }
+    return createIndex(fileId, 0, TopLevelId);
+}
+
+bool SearchResultsModel::isFileIndex(const QModelIndex &index) const
+{
+    return index.isValid() && index.internalId() == TopLevelId && index.row() < topLevelCount();
+}
+
+int SearchResultsModel::fileIdOf(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return -1;
+    }
+    if (index.internalId() == TopLevelId) {
+        return (!isGroupedByPattern() && index.row() < m_store.fileCount()) ? index.row() : -1;
+    }
+    if (isGroupedByPattern()) {
+        int row = matchRowOf(index);
+        return (row >= 0) ? m_store.matchFileId(row) : -1;
+    }
+    return int(index.internalId() - 1);
+}
+
+int SearchResultsModel::matchRowOf(const QModelIndex &index) const
+{
+    if (!index.isValid() || index.internalId() == TopLevelId) {
+        return -1;
+    }
+    return childMatchRow(int(index.internalId() - 1), index.row());
+}
+
+QModelIndex SearchResultsModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (row < 0 || column != 0) {
+        return QModelIndex();
+    }
+
+    if (!parent.isValid()) {
+        return (row < rowCount()) ? createIndex(row, 0, TopLevelId) : QModelIndex();
+    }
+
+    if (!isFileIndex(parent) || row >= childCount(parent.row())) {
+        return QModelIndex();
+    }
+    return createIndex(row, 0, quintptr(parent.row()) + 1);
+}
+
+QModelIndex SearchResultsModel::parent(const QModelIndex &child) const
+{
+    if (!child.isValid() || child.internalId() == TopLevelId) {
+        return QModelIndex();
+    }
+    return createIndex(int(child.internalId() - 1), 0, TopLevelId);
+}
+
+int SearchResultsModel::rowCount(const QModelIndex &parent) const
+{
+    if (!parent.isValid()) {
+        return topLevelCount() + (m_statusKind != NoStatus ? 1 : 0);
+    }
+    if (parent.column() != 0 || !isFileIndex(parent)) {
+        return 0;
+    }
+    return childCount(parent.row());
+}
+
+int SearchResultsModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent)
+    return 1;
+}
+
+bool SearchResultsModel::hasChildren(const QModelIndex &parent) const
+{
+    return rowCount(parent) > 0 || (isFileIndex(parent) && isCountedFile(parent.row()));
+}
+
+bool SearchResultsModel::isCountedFile(int fileId) const
+{
+    return !isGroupedByPattern() && m_store.fileMatchCount(fileId) == 0 && m_store.fileMatchedLines(fileId) > 0;
+}
+
+bool SearchResultsModel::canFetchMore(const QModelIndex &parent) const
+{
+    return isFileIndex(parent) && isCountedFile(parent.row()) && !m_matchesRequested[parent.row()];
+}
+
+void SearchResultsModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent)) {
+        return;
+    }
+    m_matchesRequested[parent.row()] = true;
+    LOG_INFO("SearchResultsModel: Matches of " + m_store.filePath(parent.row()) + " requested (" +
+             QString::number(m_store.fileMatchedLines(parent.row())) + " counted lines)");
+    emit fileMatchesRequested(m_store.filePath(parent.row()));
+}
+
+QVariant SearchResultsModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+
+    if (index.internalId() == TopLevelId) {
+        if (index.row() < topLevelCount()) {
+            return isGroupedByPattern() ? groupData(index.row(), role) : fileData(index.row(), role);
+        }
+        return statusData(role);
+    }
+
+    return matchData(int(index.internalId() - 1), index.row(), role);
+}
+
+QVariant SearchResultsModel::fileData(int fileId, int role) const
+{
+    switch (role) {
+    case Qt::DisplayRole: {
+        QString elapsed = m_store.fileElapsed(fileId);
+        if (elapsed.isEmpty()) {
+            return QString("📁 %1").arg(m_store.filePath(fileId));
+        }
+        return QString("📁 %1 (%2, %3 lines)").arg(m_store.filePath(fileId)).arg(elapsed).arg(m_store.fileMatchedLines(fileId));
+    }
+    case Qt::BackgroundRole:
+        return QColor(240, 240, 240);
+    case Qt::FontRole:
+        return m_fileFont;
+    case Qt::DecorationRole:
+        return m_fileExpanded[fileId] ? m_openIcon : m_closedIcon;
+    default:
+        return QVariant();
+    }
+}
+
+QVariant SearchResultsModel::groupData(int group, int role) const
+{
+    bool other = (group >= m_groupNames.size());
+
+    switch (role) {
+    case Qt::DisplayRole:
+        return QString("🔎 %1 (%2 lines in %3 files)")
+            .arg(other ? QString("Matched by none of the patterns alone") : m_groupNames[group])
+            .arg(m_groupRows[group].size())
+            .arg(m_groupFiles[group].size());
+    case Qt::ToolTipRole:
+        return other ? QVariant() : QVariant(m_groupPatterns.value(group));
+    case Qt::BackgroundRole:
+        return QColor(240, 240, 240);
+    case Qt::FontRole:
+        return m_fileFont;
+    case Qt::DecorationRole:
+        return m_fileExpanded[group] ? m_openIcon : m_closedIcon;
+    default:
+        return QVariant();
+    }
+}
+
+QVariant SearchResultsModel::matchData(int topRow, int matchIndex, int role) const
+{
+    int row = childMatchRow(topRow, matchIndex);
+    if (row < 0) {
+        return QVariant();
+    }
+
+    switch (role) {
+    case Qt::DisplayRole:
+        // Formatted only for rows the view is painting
+        if (isGroupedByPattern()) {
+            return QString("  %1:%2: %3").arg(m_store.filePath(m_store.matchFileId(row)))
+                .arg(m_store.lineNumber(row)).arg(m_store.lineText(row));
+        }
+        return QString("  Line %1: %2").arg(m_store.lineNumber(row)).arg(m_store.lineText(row));
+    case MatchRowRole:
+        return row;
+    default:
+        return QVariant();
+    }
+}
+
+QVariant SearchResultsModel::statusData(int role) const
+{
+    bool searching = (m_statusKind == SearchingStatus);
+
+    switch (role) {
+    case Qt::DisplayRole:
+        return m_statusText;
+    case Qt::BackgroundRole:
+        return searching ? QColor(240, 240, 240) : QColor(100, 255, 100);
+    case Qt::ForegroundRole:
+        return searching ? QVariant(QColor(102, 102, 102)) : QVariant();
+    case Qt::FontRole:
+        return searching ? m_statusFont : m_fileFont;
+    default:
+        return QVariant();
+    }
+}
+
+QVariant SearchResultsModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (section == 0 && orientation == Qt::Horizontal && role == Qt::DisplayRole) {
+        return m_headerText;
+    }
+    return QVariant();
+}
+
+Qt::ItemFlags SearchResultsModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return Qt::NoItemFlags;
+    }
+    // Only matches can be selected
+    if (index.internalId() == TopLevelId) {
+        return Qt::ItemIsEnabled;
+    }
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+}
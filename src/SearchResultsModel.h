@@ -0,0 +1,119 @@
+#ifndef SEARCHRESULTSMODEL_H
+#define SEARCHRESULTSMODEL_H
+
+#include <QAbstractItemModel>
+#include <QString>
+#include <QVector>
+#include <QSet>
+#include <QStringList>
+#include <QIcon>
+#include <QFont>
+#include "SearchResultStore.h"
+
+// Two-level tree model over a SearchResultStore: one top-level row per file, one child
+// row per match, plus an optional status row ("Searching...", summary) after the files.
+// No per-row objects exist - match rows are store rows reached through the store's
+// per-file index, and their text is formatted in data() when the view asks for it.
+// Files of a count-only search carry a matched line count but no matches yet; they are
+// fetched on demand (fileMatchesRequested) when the view expands the file.
+// Results of a batch search can be grouped by pattern instead: top-level rows are then the
+// patterns, each with the matches whose line it matched (by the store's pattern mask).
+class SearchResultsModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    // Store row of a match index (int), invalid for file and status rows
+    static constexpr int MatchRowRole = Qt::UserRole;
+
+    enum StatusKind { NoStatus, SearchingStatus, SummaryStatus };
+
+    explicit SearchResultsModel(QObject *parent = nullptr);
+    ~SearchResultsModel();
+
+    void clear();
+
+    // Add the files, matches and file stats of one parser batch
+    void appendBatch(const SearchResultBatch &batch);
+
+    // Status row shown after the files
+    void setStatus(StatusKind kind, const QString &text);
+    
+    // Group the following results by these patterns (names shown, patterns as tool tips), an
+    // empty list groups them by file again. Clears the model.
+    void setPatternGroups(const QStringList &names, const QStringList &patterns);
+    bool isGroupedByPattern() const { return !m_groupNames.isEmpty(); }
+
+    void setHeaderText(const QString &text);
+
+    // Icon state of a file row, set from the view's expanded/collapsed signals
+    void setFileExpanded(const QModelIndex &index, bool expanded);
+    void setAllFilesExpanded(bool expanded);   // QTreeView::expandAll/collapseAll emit no signals
+
+    const SearchResultStore &store() const { return m_store; }
+    int fileCount() const { return m_store.fileCount(); }
+
+    // Index helpers - file rows are pattern rows when grouped by pattern
+    QModelIndex fileIndex(int fileId) const;           // Invalid when grouped by pattern
+    bool isFileIndex(const QModelIndex &index) const;
+    int fileIdOf(const QModelIndex &index) const;      // File of a file or match row, -1 otherwise
+    int matchRowOf(const QModelIndex &index) const;    // Store row of a match, -1 otherwise
+
+    // QAbstractItemModel
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+signals:
+    // A counted file was expanded - its matches are to be searched and added with appendBatch
+    void fileMatchesRequested(const QString &filePath);
+
+private:
+    // Matched lines known from the file's stats, but none of its matches stored
+    bool isCountedFile(int fileId) const;
+
+    // internalId of top-level rows; match rows carry the row of their file (or pattern) + 1
+    static constexpr quintptr TopLevelId = 0;
+
+    // File or pattern rows, and the store row of a match under one
+    int topLevelCount() const;
+    int childCount(int topRow) const;
+    int childMatchRow(int topRow, int index) const;
+
+    void appendBatchByPattern(const SearchResultBatch &batch);
+    void resetGroups();
+
+    QVariant fileData(int fileId, int role) const;
+    QVariant groupData(int group, int role) const;
+    QVariant matchData(int topRow, int matchIndex, int role) const;
+    QVariant statusData(int role) const;
+
+    SearchResultStore m_store;
+    QVector<bool> m_fileExpanded;           // Per top-level row
+    QVector<bool> m_matchesRequested;      // fileMatchesRequested emitted for the file
+
+    // ===== PATTERN GROUPS =====
+    QStringList m_groupNames;
+    QStringList m_groupPatterns;
+    QVector<QVector<int>> m_groupRows;     // Store rows per pattern, then lines none matched alone
+    QVector<QSet<int>> m_groupFiles;       // Files with matches per group
+
+    StatusKind m_statusKind;
+    QString m_statusText;
+    QString m_headerText;
+
+    // Shared by all rows
+    QFont m_fileFont;
+    QFont m_statusFont;
+    QIcon m_openIcon;
+    QIcon m_closedIcon;
+};
+
+#endif // SEARCHRESULTSMODEL_H
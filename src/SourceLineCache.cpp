@@ -0,0 +1,90 @@
+#include "SourceLineCache.h"
+#include "CachedFileSearcher.h"
+#include "logger.h"
+
+SourceLineCache::SourceLineCache()
+    : m_files(MaxMappedFiles)
+    , m_lines(MaxCachedLines)
+{
+}
+
+SourceLineCache::~SourceLineCache()
+{
+}
+
+void SourceLineCache::clear()
+{
+    // Deleting a MappedFile closes its QFile, which unmaps it
+    m_lines.clear();
+    m_files.clear();
+}
+
+void SourceLineCache::release(MappedFile *mapped)
+{
+    if (mapped->data) {
+        mapped->file.unmap(const_cast<uchar*>(mapped->data));
+    }
+    mapped->file.close();
+    mapped->data = nullptr;
+    mapped->size = 0;
+}
+
+const SourceLineCache::MappedFile *SourceLineCache::mappedFile(int fileId, const QString &filePath,
+                                                               const FileFingerprint &searched)
+{
+    if (MappedFile *cached = m_files.object(fileId)) {
+        // A file rewritten or replaced while its results are listed is let go of
+        if (cached->data && searched.isValid() && cached->checked.elapsed() >= FingerprintCheckMs) {
+            cached->checked.start();
+            if (CachedFileSearcher::fingerprint(filePath) != searched) {
+                LOG_WARNING("SourceLineCache: " + filePath + " changed since it was searched - its result lines are not shown");
+                release(cached);
+            }
+        }
+        return cached;
+    }
+
+    // Failed files are cached too, so an unreadable file is not retried on every paint
+    MappedFile *mapped = new MappedFile();
+    mapped->checked.start();
+    mapped->file.setFileName(filePath);
+    if (searched.isValid() && CachedFileSearcher::fingerprint(filePath) != searched) {
+        LOG_WARNING("SourceLineCache: " + filePath + " changed since it was searched - its result lines are not shown");
+    } else {
+        if (mapped->file.open(QIODevice::ReadOnly)) {
+            mapped->size = mapped->file.size();
+            if (mapped->size > 0) {
+                mapped->data = mapped->file.map(0, mapped->size);
+            }
+        }
+        if (!mapped->data) {
+            LOG_WARNING("SourceLineCache: Cannot map " + filePath + " for result lines: " + mapped->file.errorString());
+            mapped->size = 0;
+        }
+    }
+
+    m_files.insert(fileId, mapped);
+    return m_files.object(fileId);
+}
+
+QString SourceLineCache::lineText(int row, int fileId, const QString &filePath, const FileFingerprint &searched,
+                                  qint64 offset, int length)
+{
+    // The file is looked at first, so lines decoded before it changed are not shown either
+    const MappedFile *mapped = mappedFile(fileId, filePath, searched);
+    if (!mapped || !mapped->data) {
+        return QString();
+    }
+    if (QString *cached = m_lines.object(row)) {
+        return *cached;
+    }
+
+    QString text;
+    if (offset >= 0 && length >= 0 && offset + length <= mapped->size) {
+        int bytes = qMin(length, MaxLineBytes);
+        text = QString::fromUtf8(reinterpret_cast<const char*>(mapped->data + offset), bytes).trimmed();
+    }
+
+    m_lines.insert(row, new QString(text));
+    return text;
+}
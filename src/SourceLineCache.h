@@ -0,0 +1,52 @@
+#ifndef SOURCELINECACHE_H
+#define SOURCELINECACHE_H
+
+#include <QString>
+#include <QFile>
+#include <QCache>
+#include <QElapsedTimer>
+#include "FileFingerprint.h"
+
+// Reads result line texts on demand from read-only mappings of the searched files.
+// Both the mappings and the decoded lines are kept in small LRU caches, so painting a
+// screen of results touches a handful of files and decodes each visible line once.
+// Mappings hold the files open - clear() releases them (on Windows a mapped log
+// file cannot be rotated or deleted). A file whose fingerprint no longer matches the
+// one taken when it was searched shows empty lines: its offsets point elsewhere now.
+class SourceLineCache
+{
+public:
+    SourceLineCache();
+    ~SourceLineCache();
+
+    void clear();
+
+    // Trimmed text of the line at [offset, offset + length) in filePath, keyed by the
+    // caller's row id. Empty when the file is gone, no longer covers the line or is not
+    // the searched version any more (an invalid searched fingerprint is not checked).
+    QString lineText(int row, int fileId, const QString &filePath, const FileFingerprint &searched,
+                     qint64 offset, int length);
+
+    // Longest line prefix decoded for display
+    static constexpr int MaxLineBytes = 4096;
+
+private:
+    struct MappedFile {
+        QFile file;
+        const uchar *data = nullptr;   // nullptr if the file could not be mapped or changed
+        qint64 size = 0;
+        QElapsedTimer checked;         // Since the fingerprint was last compared
+    };
+
+    const MappedFile *mappedFile(int fileId, const QString &filePath, const FileFingerprint &searched);
+    static void release(MappedFile *mapped);
+
+    static constexpr int MaxMappedFiles = 16;
+    static constexpr int MaxCachedLines = 2000;
+    static constexpr qint64 FingerprintCheckMs = 1000;     // A file is stat'ed at most this often
+
+    QCache<int, MappedFile> m_files;   // By file id
+    QCache<int, QString> m_lines;      // By row id
+};
+
+#endif // SOURCELINECACHE_H
@@ -0,0 +1,253 @@
+#include "SplitFileSearch.h"
+#include "filesearcher.h"
+#include "RgJsonParser.h"
+#include "logger.h"
+#include <QFile>
+#include <QSettings>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <cstring>
+
+SplitFileSearch::Config SplitFileSearch::loadConfig()
+{
+    Config config;
+    QSettings settings("app.ini", QSettings::IniFormat);
+    settings.beginGroup("RGSearch");
+    config.enabled = settings.value("SplitLargeFiles", true).toBool();
+    config.thresholdBytes = qMax(1LL, settings.value("SplitFileMB", 512).toLongLong()) * 1024 * 1024;
+    config.rangeBytes = qMax(1LL, settings.value("SplitRangeMB", 128).toLongLong()) * 1024 * 1024;
+    settings.endGroup();
+    return config;
+}
+
+QVector<SplitFileSearch::Range> SplitFileSearch::splitFile(QFile &file, qint64 start, qint64 rangeBytes)
+{
+    QVector<Range> ranges;
+    qint64 size = file.size();
+    QByteArray block;
+
+    for (qint64 rangeStart = start; rangeStart < size; ) {
+        qint64 rangeEnd = rangeStart + rangeBytes;
+
+        // Move the cut behind the next '\n' so no line is split between two ranges
+        while (rangeEnd < size) {
+            if (!file.seek(rangeEnd)) {
+                rangeEnd = size;
+                break;
+            }
+            block = file.read(64 * 1024);
+            if (block.isEmpty()) {
+                rangeEnd = size;
+                break;
+            }
+            qsizetype newline = block.indexOf('\n');
+            if (newline >= 0) {
+                rangeEnd += newline + 1;
+                break;
+            }
+            rangeEnd += block.size();
+        }
+        rangeEnd = qMin(rangeEnd, size);
+
+        Range range;
+        range.start = rangeStart;
+        range.end = rangeEnd;
+        ranges.append(range);
+        rangeStart = rangeEnd;
+    }
+
+    return ranges;
+}
+
+qint64 SplitFileSearch::countNewlines(const char *data, qint64 size)
+{
+    qint64 count = 0;
+    const char *end = data + size;
+    for (const char *p = data; p < end; ++p) {
+        const void *newline = memchr(p, '\n', size_t(end - p));
+        if (!newline) {
+            break;
+        }
+        p = static_cast<const char*>(newline);
+        ++count;
+    }
+    return count;
+}
+
+SplitFileSearch::SplitFileSearch(const QString &filePath, const QVector<Range> &ranges, qint64 startLine)
+    : m_filePath(filePath)
+    , m_ranges(ranges)
+    , m_results(ranges.size())
+    , m_nextRange(0)
+    , m_writing(false)
+    , m_endWritten(false)
+    , m_lineBase(startLine)
+    , m_matchedLines(0)
+    , m_matches(0)
+{
+    QJsonObject path;
+    path["text"] = filePath;
+    m_pathObject = QJsonDocument(path).toJson(QJsonDocument::Compact);
+    m_timer.start();
+    LOG_INFO("SplitFileSearch: " + filePath + " split into " + QString::number(ranges.size()) + " ranges");
+}
+
+SplitFileSearch::~SplitFileSearch()
+{
+}
+
+bool SplitFileSearch::rangeDone(int index, const QByteArray &records, qint64 newlines, int matchedLines, int matches,
+                                FileSearchRecordWriter &writer)
+{
+    QMutexLocker locker(&m_mutex);
+
+    RangeResult &result = m_results[index];
+    result.done = true;
+    result.records = records;
+    result.newlines = newlines;
+    result.matchedLines = matchedLines;
+    result.matches = matches;
+
+    // Queue every range whose predecessors are all queued - their newline counts give its first line
+    while (m_nextRange < m_results.size() && m_results[m_nextRange].done) {
+        RangeResult &next = m_results[m_nextRange];
+        if (!next.records.isEmpty()) {
+            QueuedRange queued;
+            queued.records = next.records;
+            queued.offsetBase = m_ranges[m_nextRange].start;
+            queued.lineBase = m_lineBase;
+            m_queue.append(queued);
+        }
+
+        m_matchedLines += next.matchedLines;
+        m_matches += next.matches;
+        m_lineBase += next.newlines;
+        next.records = QByteArray();
+        m_nextRange++;
+    }
+
+    // The caller writing the queue keeps the file order - the others leave their ranges to it
+    if (m_writing) {
+        return false;
+    }
+    m_writing = true;
+
+    bool complete = false;
+    for (;;) {
+        QVector<QueuedRange> queue;
+        queue.swap(m_queue);
+        bool last = (m_nextRange == m_results.size() && !m_endWritten);
+        if (queue.isEmpty() && !last) {
+            break;
+        }
+        m_endWritten = m_endWritten || last;
+        int fileMatchedLines = m_matchedLines;
+        int fileMatches = m_matches;
+
+        // Unlocked: the writer can wait for the results backlog, the other ranges go on meanwhile
+        locker.unlock();
+        for (const QueuedRange &queued : queue) {
+            QByteArray rebased = rebaseRecords(queued.records, queued.offsetBase, queued.lineBase);
+            if (!rebased.isEmpty()) {
+                writer.appendRecords(m_filePath, rebased);
+            }
+        }
+        if (last && fileMatchedLines > 0) {
+            qint64 bytes = m_ranges.last().end - m_ranges.first().start;
+            writer.endFile(m_filePath, fileMatchedLines, fileMatches, bytes, m_timer.nsecsElapsed());
+            LOG_INFO("SplitFileSearch: " + m_filePath + " done, " + QString::number(fileMatchedLines) +
+                     " matched lines in " + QString::number(m_timer.elapsed()) + " ms");
+        }
+        writer.flush();
+        complete = complete || last;
+        locker.relock();
+    }
+
+    m_writing = false;
+    return complete;
+}
+
+// Value of the number member key ("name":) in a record line, its bytes in [*start, *end)
+static bool findNumber(QByteArrayView line, QByteArrayView key, qsizetype *start, qsizetype *end)
+{
+    // Quotes inside JSON strings are escaped, so the quoted key only matches the member itself
+    qsizetype at = line.indexOf(key);
+    if (at < 0) {
+        return false;
+    }
+    qsizetype p = at + key.size();
+    while (p < line.size() && line[p] == ' ') {
+        ++p;
+    }
+    qsizetype q = p;
+    while (q < line.size() && line[q] >= '0' && line[q] <= '9') {
+        ++q;
+    }
+    *start = p;
+    *end = q;
+    return q > p;
+}
+
+QByteArray SplitFileSearch::rebaseRecords(const QByteArray &records, qint64 offsetBase, qint64 lineBase) const
+{
+    static const QByteArray lineNumberKey = "\"line_number\":";
+    static const QByteArray offsetKey = "\"absolute_offset\":";
+
+    QByteArray rebased;
+    rebased.reserve(records.size() + records.size() / 8);
+
+    struct Splice {
+        qsizetype start;
+        qsizetype end;
+        QByteArray bytes;
+    };
+
+    RgJsonRecord record;
+    const char *data = records.constData();
+    const char *end = data + records.size();
+    for (const char *lineStart = data; lineStart < end; ) {
+        const char *lineEnd = static_cast<const char*>(memchr(lineStart, '\n', size_t(end - lineStart)));
+        const char *next = lineEnd ? lineEnd + 1 : end;
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+        QByteArrayView line(lineStart, lineEnd - lineStart);
+        const char *current = lineStart;
+        lineStart = next;
+
+        // begin, end and summary records of the range are dropped
+        if (!RgJsonParser::parseLine(line, &record) || record.type != RgJsonRecord::Match || record.path.isNull()) {
+            continue;
+        }
+
+        // The path object spans from the '{' after "path": to the '}' after its value
+        qsizetype valueEnd = (record.path.raw.data() + record.path.raw.size()) - current;
+        qsizetype pathEnd = line.indexOf('}', valueEnd);
+        qsizetype pathStart = line.lastIndexOf('{', record.path.raw.data() - current);
+        qsizetype lineNumberStart, lineNumberEnd, offsetStart, offsetEnd;
+        if (pathStart < 0 || pathEnd < 0 || !findNumber(line, lineNumberKey, &lineNumberStart, &lineNumberEnd) ||
+            !findNumber(line, offsetKey, &offsetStart, &offsetEnd)) {
+            LOG_WARNING("SplitFileSearch: Unexpected match record in " + m_filePath + " - dropped");
+            continue;
+        }
+
+        Splice splices[3] = {
+            {pathStart, pathEnd + 1, m_pathObject},
+            {lineNumberStart, lineNumberEnd, QByteArray::number(record.lineNumber + lineBase - 1)},
+            {offsetStart, offsetEnd, QByteArray::number(record.absoluteOffset + offsetBase)},
+        };
+        std::sort(splices, splices + 3, [](const Splice &a, const Splice &b) { return a.start < b.start; });
+
+        qsizetype copied = 0;
+        for (const Splice &splice : splices) {
+            rebased.append(line.data() + copied, splice.start - copied);
+            rebased.append(splice.bytes);
+            copied = splice.end;
+        }
+        rebased.append(line.data() + copied, line.size() - copied);
+        rebased.append('\n');
+    }
+
+    return rebased;
+}
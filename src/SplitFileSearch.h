@@ -0,0 +1,93 @@
+#ifndef SPLITFILESEARCH_H
+#define SPLITFILESEARCH_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QMutex>
+#include <QElapsedTimer>
+
+class QFile;
+class FileSearchRecordWriter;
+
+// Intra-file parallel search of one large file. The file is cut into line-aligned byte ranges
+// that are searched concurrently; each range's match records are collected with line numbers
+// counted from 1 and offsets from 0 at the range start. Finished ranges are written in file
+// order, re-based with the newline counts of all ranges before them.
+class SplitFileSearch
+{
+public:
+    // [RGSearch] SplitLargeFiles, SplitFileMB and SplitRangeMB in app.ini
+    struct Config {
+        bool enabled = true;
+        qint64 thresholdBytes = 0;      // Files from this size on are split
+        qint64 rangeBytes = 0;          // Approximate size of one range
+    };
+    static Config loadConfig();
+
+    struct Range {
+        qint64 start = 0;               // Start of a line
+        qint64 end = 0;                 // Start of the line after the range (or the file size)
+    };
+
+    // Cut [start, file size) into ranges of about rangeBytes that end after a '\n'
+    static QVector<Range> splitFile(QFile &file, qint64 start, qint64 rangeBytes);
+
+    static qint64 countNewlines(const char *data, qint64 size);
+
+    // startLine is the line number at ranges.first().start
+    SplitFileSearch(const QString &filePath, const QVector<Range> &ranges, qint64 startLine);
+    ~SplitFileSearch();
+
+    const QString &filePath() const { return m_filePath; }
+    int rangeCount() const { return m_ranges.size(); }
+    const Range &range(int index) const { return m_ranges[index]; }
+
+    // Hand in the records, newline count and match counts of a searched range - any thread, each
+    // range once. Ranges that are now in order are queued; one caller at a time writes the queue
+    // through its writer and flushes it, without the lock (the writer may wait for room in the
+    // results backlog), followed by the end record after the last range. Returns true for the call
+    // that wrote the last range.
+    bool rangeDone(int index, const QByteArray &records, qint64 newlines, int matchedLines, int matches,
+                   FileSearchRecordWriter &writer);
+
+    // Totals of the file, final once rangeDone returned true
+    int matchedLines() const { return m_matchedLines; }
+    int matches() const { return m_matches; }
+
+private:
+    struct RangeResult {
+        bool done = false;
+        QByteArray records;
+        qint64 newlines = 0;
+        int matchedLines = 0;       // Counted by the scan - a count-only range has no records
+        int matches = 0;
+    };
+
+    // Range records in file order, waiting to be re-based and written
+    struct QueuedRange {
+        QByteArray records;
+        qint64 offsetBase = 0;
+        qint64 lineBase = 1;
+    };
+
+    // Match records of a range with the file's path, line numbers and offsets (other records
+    // dropped). The numbers are replaced in the record bytes, nothing else is re-encoded.
+    QByteArray rebaseRecords(const QByteArray &records, qint64 offsetBase, qint64 lineBase) const;
+
+    QString m_filePath;
+    QVector<Range> m_ranges;
+    QVector<RangeResult> m_results;
+    int m_nextRange;                    // First range not queued yet
+    QVector<QueuedRange> m_queue;
+    bool m_writing;                     // A caller is writing the queue - others leave theirs to it
+    bool m_endWritten;
+    QByteArray m_pathObject;            // {"text": file path} as JSON
+    qint64 m_lineBase;                  // Line number at the start of m_nextRange
+    int m_matchedLines;
+    int m_matches;
+    QElapsedTimer m_timer;
+    QMutex m_mutex;
+};
+
+#endif // SPLITFILESEARCH_H
@@ -0,0 +1,638 @@
+#include "TimeRangeFileSearcher.h"
+#include "CompressedFile.h"
+#include "SplitFileSearch.h"
+#include "RgJsonParser.h"
+#include "logger.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <QThread>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+constexpr qint64 DayMs = 24 * 60 * 60 * 1000;
+
+// Start of the first line beginning at or after pos
+qint64 lineStartAt(const char *data, qint64 size, qint64 pos)
+{
+    if (pos <= 0) {
+        return 0;
+    }
+    if (pos >= size || data[pos - 1] == '\n') {
+        return qMin(pos, size);
+    }
+    const char *newline = static_cast<const char*>(memchr(data + pos, '\n', size_t(size - pos)));
+    return newline ? (newline - data) + 1 : size;
+}
+
+// End of the line starting at lineStart (its '\n' or the end of the data)
+qint64 lineEndAt(const char *data, qint64 size, qint64 lineStart)
+{
+    const char *newline = static_cast<const char*>(memchr(data + lineStart, '\n', size_t(size - lineStart)));
+    return newline ? newline - data : size;
+}
+
+}
+
+TimeRangeFileSearcher::TimeRangeFileSearcher(FileSearcher *engine, QObject *parent)
+    : FileSearcher(parent)
+    , m_engine(engine)
+    , m_probes(32)
+    , m_minFileBytes(0)
+    , m_fullSearch(false)
+    , m_droppedMatches(0)
+{
+    m_engine->setParent(this);
+
+    connect(m_engine, &FileSearcher::outputChunk, this, [this](const QByteArray &jsonLines) {
+        filterEngineChunk(jsonLines);
+    }, Qt::DirectConnection);
+    connect(m_engine, &FileSearcher::finished, this, [this](int exitCode) {
+        finishRun(exitCode);
+    });
+    connect(m_engine, &FileSearcher::errorOccurred, this, &FileSearcher::errorOccurred, Qt::DirectConnection);
+    connect(m_engine, &FileSearcher::fileSearched, this, &FileSearcher::fileSearched, Qt::DirectConnection);
+}
+
+TimeRangeFileSearcher::~TimeRangeFileSearcher()
+{
+}
+
+bool TimeRangeFileSearcher::parseBound(const QString &text, bool end, Stamp *bound)
+{
+    struct BoundFormat {
+        const char *format;
+        qint64 unitMs;
+    };
+    static const BoundFormat dated[] = {
+        {"yyyy-MM-dd HH:mm:ss.zzz", 1}, {"yyyy-MM-dd'T'HH:mm:ss.zzz", 1},
+        {"yyyy-MM-dd HH:mm:ss", 1000}, {"yyyy-MM-dd'T'HH:mm:ss", 1000},
+        {"yyyy-MM-dd HH:mm", 60000}, {"yyyy-MM-dd'T'HH:mm", 60000},
+    };
+    static const BoundFormat timeOfDay[] = {
+        {"HH:mm:ss.zzz", 1}, {"HH:mm:ss", 1000}, {"HH:mm", 60000}, {"H:mm", 60000},
+    };
+
+    QString trimmed = text.trimmed();
+    for (const BoundFormat &format : dated) {
+        QDateTime dateTime = QDateTime::fromString(trimmed, format.format);
+        if (dateTime.isValid()) {
+            bound->msecs = dateTime.date().toJulianDay() * DayMs + dateTime.time().msecsSinceStartOfDay() +
+                           (end ? format.unitMs - 1 : 0);
+            bound->hasDate = true;
+            return true;
+        }
+    }
+    QDate date = QDate::fromString(trimmed, "yyyy-MM-dd");
+    if (date.isValid()) {
+        bound->msecs = date.toJulianDay() * DayMs + (end ? DayMs - 1 : 0);
+        bound->hasDate = true;
+        return true;
+    }
+    for (const BoundFormat &format : timeOfDay) {
+        QTime time = QTime::fromString(trimmed, format.format);
+        if (time.isValid()) {
+            bound->msecs = time.msecsSinceStartOfDay() + (end ? format.unitMs - 1 : 0);
+            bound->hasDate = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+QString TimeRangeFileSearcher::engineName() const
+{
+    return m_engine->engineName();
+}
+
+bool TimeRangeFileSearcher::canSearchTargets(const QVector<SearchTarget> &targets) const
+{
+    return m_engine->canSearchTargets(targets);
+}
+
+QStringList TimeRangeFileSearcher::candidateFiles(const RGSearchParams &params) const
+{
+    return m_engine->candidateFiles(params);
+}
+
+void TimeRangeFileSearcher::start(const RGSearchParams &params)
+{
+    m_cancelled.store(false);
+    m_engine->setCancelToken(m_cancelToken);
+    m_engine->setFlowControl(m_flowControl);
+    m_params = params;
+    m_engineTargets.clear();
+    m_windows.clear();
+    m_skippedFiles.clear();
+    m_fullSearch = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_openFiles.clear();
+        m_droppedMatches = 0;
+    }
+
+    m_from = Stamp();
+    m_to = Stamp();
+    if (!params.time_from.trimmed().isEmpty() && !parseBound(params.time_from, false, &m_from)) {
+        LOG_WARNING("TimeRangeFileSearcher: '" + params.time_from + "' is no time, window open at the start");
+    }
+    if (!params.time_to.trimmed().isEmpty() && !parseBound(params.time_to, true, &m_to)) {
+        LOG_WARNING("TimeRangeFileSearcher: '" + params.time_to + "' is no time, window open at the end");
+    }
+
+    // ===== LINE TIMESTAMP FORMATS =====
+    QSettings settings("app.ini", QSettings::IniFormat);
+    settings.beginGroup("RGSearch");
+    QString formats = settings.value("TimestampFormats",
+        "yyyy-MM-dd HH:mm:ss.zzz|yyyy-MM-dd'T'HH:mm:ss.zzz|yyyy-MM-dd HH:mm:ss,zzz|yyyy-MM-dd HH:mm:ss|"
+        "yyyy-MM-dd'T'HH:mm:ss|yyyy/MM/dd HH:mm:ss|HH:mm:ss.zzz|HH:mm:ss").toString();
+    m_probes = qBound(4, settings.value("TimeRangeProbes", 32).toInt(), 1024);
+    m_minFileBytes = qMax(0, settings.value("TimeRangeMinFileMB", 4).toInt()) * qint64(1024 * 1024);
+    settings.endGroup();
+
+    m_formats.clear();
+    for (const QString &format : formats.split('|', Qt::SkipEmptyParts)) {
+        LineFormat lineFormat;
+        lineFormat.format = format;
+        lineFormat.hasDate = format.contains("yy");
+        lineFormat.length = lineFormat.hasDate ? QDateTime(QDate(2000, 1, 1), QTime(0, 0)).toString(format).size()
+                                               : QTime(0, 0).toString(format).size();
+        if (lineFormat.length > 0) {
+            m_formats.append(lineFormat);
+        }
+    }
+
+    LOG_INFO("TimeRangeFileSearcher: Window " + (params.time_from.isEmpty() ? QString("...") : params.time_from) +
+             " - " + (params.time_to.isEmpty() ? QString("...") : params.time_to) + ", " +
+             QString::number(m_formats.size()) + " timestamp formats, " + QString::number(m_probes) + " probes");
+
+    m_timer.start();
+
+    // Mapping and probing every file runs off the UI thread
+    QThread *thread = QThread::create([this]() {
+        prepareRun();
+    });
+    connect(thread, &QThread::finished, this, [this, thread]() {
+        thread->deleteLater();
+        startEngine();
+    });
+    thread->start();
+}
+
+void TimeRangeFileSearcher::cancel()
+{
+    FileSearcher::cancel();
+    m_engine->cancel();
+}
+
+QString TimeRangeFileSearcher::normalizedPath(const QString &filePath)
+{
+    QString normalized = QDir::cleanPath(QFileInfo(filePath).absoluteFilePath());
+#ifdef Q_OS_WIN
+    normalized = normalized.toLower();
+#endif
+    return normalized;
+}
+
+// ===== TIMESTAMPS =====
+
+TimeRangeFileSearcher::Stamp TimeRangeFileSearcher::lineStamp(const char *line, qint64 length) const
+{
+    qint64 lead = 0;
+    while (lead < length && lead < MaxLeadChars && (line[lead] < '0' || line[lead] > '9')) {
+        ++lead;
+    }
+    if (lead >= length || line[lead] < '0' || line[lead] > '9') {
+        return Stamp();
+    }
+
+    Stamp stamp;
+    for (const LineFormat &format : m_formats) {
+        if (lead + format.length > length) {
+            continue;
+        }
+        QString text = QString::fromLatin1(line + lead, format.length);
+        if (format.hasDate) {
+            QDateTime dateTime = QDateTime::fromString(text, format.format);
+            if (dateTime.isValid()) {
+                stamp.msecs = dateTime.date().toJulianDay() * DayMs + dateTime.time().msecsSinceStartOfDay();
+                stamp.hasDate = true;
+                return stamp;
+            }
+        } else {
+            QTime time = QTime::fromString(text, format.format);
+            if (time.isValid()) {
+                stamp.msecs = time.msecsSinceStartOfDay();
+                stamp.hasDate = false;
+                return stamp;
+            }
+        }
+    }
+    return Stamp();
+}
+
+TimeRangeFileSearcher::Stamp TimeRangeFileSearcher::nextStamp(const char *data, qint64 size, qint64 from,
+                                                              qint64 limit, qint64 *lineStart) const
+{
+    qint64 line = from;
+    for (int lines = 0; line < limit && lines < MaxProbeLines; ++lines) {
+        qint64 lineEnd = lineEndAt(data, size, line);
+        Stamp stamp = lineStamp(data + line, lineEnd - line);
+        if (stamp.isValid()) {
+            *lineStart = line;
+            return stamp;
+        }
+        line = lineEnd + 1;
+    }
+    return Stamp();
+}
+
+qint64 TimeRangeFileSearcher::resolve(const Stamp &bound, const Stamp &reference)
+{
+    if (bound.hasDate == reference.hasDate) {
+        return bound.msecs;
+    }
+    if (reference.hasDate) {
+        return (reference.msecs / DayMs) * DayMs + bound.msecs;
+    }
+    return bound.msecs % DayMs;
+}
+
+bool TimeRangeFileSearcher::inWindow(const Stamp &stamp) const
+{
+    if (m_from.isValid() && stamp.msecs < resolve(m_from, stamp)) {
+        return false;
+    }
+    if (m_to.isValid() && stamp.msecs > resolve(m_to, stamp)) {
+        return false;
+    }
+    return true;
+}
+
+// ===== SLICING =====
+
+qint64 TimeRangeFileSearcher::boundaryOffset(const char *data, qint64 size, qint64 key, bool strict) const
+{
+    auto before = [key, strict](const Stamp &stamp) {
+        return strict ? stamp.msecs <= key : stamp.msecs < key;
+    };
+
+    // Bisect: every timestamped line starting before lo is before the key, the line at hi is not
+    qint64 lo = 0;
+    qint64 hi = size;
+    while (hi - lo > ProbeBlockBytes) {
+        qint64 mid = lo + (hi - lo) / 2;
+        qint64 line = 0;
+        Stamp stamp = nextStamp(data, size, lineStartAt(data, size, mid), hi, &line);
+        if (!stamp.isValid()) {
+            break;      // A long run of lines without timestamps - read the rest line by line
+        }
+        if (before(stamp)) {
+            lo = lineEndAt(data, size, line) + 1;
+        } else {
+            hi = line;
+        }
+    }
+
+    // Lines without a timestamp belong to the entry above them
+    for (qint64 line = lo; line < hi; ) {
+        qint64 lineEnd = lineEndAt(data, size, line);
+        Stamp stamp = lineStamp(data + line, lineEnd - line);
+        if (stamp.isValid() && !before(stamp)) {
+            return line;
+        }
+        line = lineEnd + 1;
+    }
+    return qMin(hi, size);
+}
+
+bool TimeRangeFileSearcher::probeFile(const QString &filePath, const char *data, qint64 size, FileWindow *window) const
+{
+    // ===== SAMPLED TIMESTAMPS =====
+    QVector<Stamp> samples;
+    qint64 line = 0;
+    for (int i = 0; i < m_probes; ++i) {
+        qint64 from = lineStartAt(data, size, size * i / m_probes);
+        Stamp stamp = nextStamp(data, size, from, qMin(size, from + ProbeBlockBytes), &line);
+        if (stamp.isValid()) {
+            samples.append(stamp);
+        }
+    }
+    Stamp last;
+    for (qint64 from = lineStartAt(data, size, size - ProbeBlockBytes); from < size; from = lineEndAt(data, size, from) + 1) {
+        qint64 lineEnd = lineEndAt(data, size, from);
+        Stamp stamp = lineStamp(data + from, lineEnd - from);
+        if (stamp.isValid()) {
+            last = stamp;
+        }
+    }
+    if (last.isValid()) {
+        samples.append(last);
+    }
+
+    if (samples.size() < 2) {
+        LOG_DEBUG("TimeRangeFileSearcher: No timestamps in " + filePath);
+        return false;
+    }
+    for (int i = 1; i < samples.size(); ++i) {
+        if (samples[i].hasDate != samples[0].hasDate || samples[i].msecs < samples[i - 1].msecs) {
+            LOG_INFO("TimeRangeFileSearcher: " + filePath + " is not in time order - searched whole");
+            return false;
+        }
+    }
+
+    // ===== WINDOW BOUNDARIES =====
+    const Stamp &first = samples.first();
+    const Stamp &reference = samples.last();
+    qint64 from = m_from.isValid() ? resolve(m_from, reference) : std::numeric_limits<qint64>::min();
+    qint64 to = m_to.isValid() ? resolve(m_to, reference) : std::numeric_limits<qint64>::max();
+
+    window->sliced = true;
+    if (from > reference.msecs || to < first.msecs) {
+        window->start = 0;
+        window->end = 0;
+        return true;
+    }
+    window->start = m_from.isValid() ? boundaryOffset(data, size, from, false) : 0;
+    window->end = m_to.isValid() ? boundaryOffset(data, size, to, true) : size;
+    window->end = qMax(window->start, window->end);
+    return true;
+}
+
+void TimeRangeFileSearcher::prepareRun()
+{
+    LOG_INFO("TimeRangeFileSearcher: ===THREAD=== prepareRun for path: " + m_params.path + " <<<<<STARTed<<<<<");
+
+    int slicedFiles = 0;
+    int skippedFiles = 0;
+    int wholeFiles = 0;
+    qint64 totalBytes = 0;
+    qint64 windowBytes = 0;
+
+    try {
+        // ===== STEP 1: CANDIDATE FILES =====
+        QVector<SearchTarget> candidates = m_targets;
+        if (!m_hasTargets) {
+            for (const QString &filePath : m_engine->candidateFiles(m_params)) {
+                SearchTarget target;
+                target.filePath = filePath;
+                candidates.append(target);
+            }
+        }
+
+        // Slices are only worth cutting if the engine can search them
+        SearchTarget rangeProbe;
+        rangeProbe.ranges.append(SearchRange());
+        bool engineTakesRanges = m_engine->canSearchTargets({rangeProbe});
+
+        // ===== STEP 2: PROBE EVERY CANDIDATE =====
+        for (SearchTarget &target : candidates) {
+            if (isCancelled()) {
+                return;
+            }
+
+            // Compressed files cannot be probed - their matches are filtered by timestamp
+            if (m_params.search_compressed && CompressedFile::isCompressedPath(target.filePath)) {
+                m_engineTargets.append(target);
+                wholeFiles++;
+                continue;
+            }
+
+            QFile file(target.filePath);
+            qint64 size = file.size();
+            totalBytes += size;
+            if (size <= 0 || !file.open(QIODevice::ReadOnly)) {
+                m_engineTargets.append(target);
+                wholeFiles++;
+                windowBytes += size;
+                continue;
+            }
+            const char *data = reinterpret_cast<const char*>(file.map(0, size));
+            if (!data) {
+                m_engineTargets.append(target);
+                wholeFiles++;
+                windowBytes += size;
+                continue;
+            }
+
+            FileWindow window;
+            if (!probeFile(target.filePath, data, size, &window)) {
+                m_engineTargets.append(target);
+                wholeFiles++;
+                windowBytes += size;
+                continue;
+            }
+            m_windows.insert(normalizedPath(target.filePath), window);
+
+            // The slice within what was asked for (a tail, or the blocks an index left)
+            QVector<SearchRange> asked = target.ranges;
+            if (asked.isEmpty()) {
+                SearchRange whole;
+                whole.start = target.startOffset;
+                whole.end = size;
+                whole.startLine = target.startLine;
+                asked.append(whole);
+            }
+            QVector<SearchRange> ranges;
+            for (const SearchRange &range : asked) {
+                qint64 start = qMax(range.start, window.start);
+                qint64 end = qMin(range.end, window.end);
+                if (start >= end) {
+                    continue;
+                }
+                SearchRange slice;
+                slice.start = start;
+                slice.end = end;
+                // Line numbers stay those of the whole file
+                slice.startLine = engineTakesRanges
+                    ? range.startLine + SplitFileSearch::countNewlines(data + range.start, start - range.start) : 1;
+                ranges.append(slice);
+            }
+
+            if (ranges.isEmpty()) {
+                skippedFiles++;
+                m_skippedFiles << target.filePath;
+                continue;
+            }
+            if (size < m_minFileBytes) {
+                // Not worth slicing: searched whole, its matches kept by the window's offsets
+                m_engineTargets.append(target);
+                wholeFiles++;
+                windowBytes += size;
+                continue;
+            }
+            if (engineTakesRanges) {
+                target.ranges = ranges;
+                for (const SearchRange &range : ranges) {
+                    windowBytes += range.end - range.start;
+                }
+            } else {
+                windowBytes += size;
+            }
+            slicedFiles++;
+            m_engineTargets.append(target);
+        }
+
+        // ===== STEP 3: DECIDE WHAT THE ENGINE SEARCHES =====
+        if (!m_engine->canSearchTargets(m_engineTargets)) {
+            // e.g. the tail of a grown file for an engine that cannot start at an offset - matches are still filtered
+            m_fullSearch = true;
+        }
+
+        LOG_INFO("TimeRangeFileSearcher: " + QString::number(candidates.size()) + " candidate files, " +
+                 QString::number(slicedFiles) + " sliced, " + QString::number(skippedFiles) + " outside the window, " +
+                 QString::number(wholeFiles) + " searched whole - " + QString::number(windowBytes / (1024 * 1024)) +
+                 " of " + QString::number(totalBytes / (1024 * 1024)) + " MB to search" +
+                 (engineTakesRanges ? QString() : " (" + engineName() + " cannot search slices, matches are filtered)") +
+                 (m_fullSearch ? " - full " + engineName() + " search" : "") + " after " +
+                 QString::number(m_timer.elapsed()) + " ms");
+
+    } catch (const std::exception &e) {
+        LOG_ERROR("TimeRangeFileSearcher: Exception in prepareRun: " + QString(e.what()));
+        m_fullSearch = true;
+    } catch (...) {
+        LOG_ERROR("TimeRangeFileSearcher: Unknown exception in prepareRun");
+        m_fullSearch = true;
+    }
+
+    LOG_INFO("TimeRangeFileSearcher: ===THREAD=== prepareRun for path: " + m_params.path + " >>>>>ENDed>>>>>");
+}
+
+void TimeRangeFileSearcher::startEngine()
+{
+    if (isCancelled()) {
+        finishRun(1);
+        return;
+    }
+
+    if (m_fullSearch) {
+        if (m_hasTargets) {
+            m_engine->setTargets(m_targets);
+        } else {
+            m_engine->clearTargets();
+        }
+        m_engine->start(m_params);
+        return;
+    }
+
+    // Nothing to search in these - done before the engine starts
+    for (const QString &filePath : m_skippedFiles) {
+        emit fileSearched(filePath);
+    }
+
+    if (m_engineTargets.isEmpty()) {
+        LOG_INFO("TimeRangeFileSearcher: No file has lines in the window");
+        FileSearchRecordWriter writer(this);
+        writer.summary(0, 0, 0, 0, 0, m_timer.nsecsElapsed());
+        writer.flush();
+        finishRun(1);
+        return;
+    }
+
+    m_engine->setTargets(m_engineTargets);
+    m_engine->start(m_params);
+}
+
+// ===== RESULT FILTER =====
+
+void TimeRangeFileSearcher::filterEngineChunk(const QByteArray &jsonLines)
+{
+    QMutexLocker locker(&m_mutex);
+
+    QByteArray output;
+    RgJsonRecord record;
+    const char *data = jsonLines.constData();
+    const char *end = data + jsonLines.size();
+    for (const char *lineStart = data; lineStart < end; ) {
+        const char *lineEnd = static_cast<const char*>(memchr(lineStart, '\n', size_t(end - lineStart)));
+        const char *next = lineEnd ? lineEnd + 1 : end;
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+        QByteArrayView line(lineStart, lineEnd - lineStart);
+        lineStart = next;
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        if (!RgJsonParser::parseLine(line, &record) || record.path.isNull()) {
+            output.append(line.data(), line.size());
+            output.append('\n');
+            continue;
+        }
+
+        QByteArray rawPath = record.path.raw.toByteArray();
+        auto it = m_openFiles.find(rawPath);
+        if (it == m_openFiles.end()) {
+            OpenFile open;
+            open.window = m_windows.value(normalizedPath(record.path.toString()));
+            it = m_openFiles.insert(rawPath, open);
+        }
+        OpenFile &file = *it;
+
+        switch (record.type) {
+        case RgJsonRecord::Begin:
+            file.beginRecord = line.toByteArray() + '\n';
+            break;
+
+        case RgJsonRecord::Match: {
+            bool keep;
+            if (file.window.sliced) {
+                keep = record.absoluteOffset >= file.window.start && record.absoluteOffset < file.window.end;
+            } else {
+                // Lines without a timestamp of their own are kept
+                QByteArray text = record.lines.toLineBytes();
+                Stamp stamp = lineStamp(text.constData(), text.size());
+                keep = !stamp.isValid() || inWindow(stamp);
+            }
+            if (!keep) {
+                m_droppedMatches++;
+                break;
+            }
+            if (!file.begun) {
+                output.append(file.beginRecord);
+                file.begun = true;
+            }
+            output.append(line.data(), line.size());
+            output.append('\n');
+            file.lines++;
+            break;
+        }
+
+        case RgJsonRecord::End:
+            if (file.begun) {
+                output.append(FileSearchRecordWriter::withMatchedLines(line, file.lines));
+                output.append('\n');
+            }
+            m_openFiles.erase(it);
+            break;
+
+        default:
+            // Context lines go with the matches of their file
+            if (file.begun) {
+                output.append(line.data(), line.size());
+                output.append('\n');
+            }
+            break;
+        }
+    }
+
+    if (!output.isEmpty()) {
+        emit outputChunk(output);
+    }
+}
+
+void TimeRangeFileSearcher::finishRun(int engineExitCode)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_openFiles.clear();
+        LOG_INFO("TimeRangeFileSearcher: " + engineName() + " search done after " + QString::number(m_timer.elapsed()) +
+                 " ms, " + QString::number(m_droppedMatches) + " matches outside the window dropped");
+    }
+    emit finished(engineExitCode);
+}
@@ -0,0 +1,129 @@
+#ifndef TIMERANGEFILESEARCHER_H
+#define TIMERANGEFILESEARCHER_H
+
+#include <QMutex>
+#include <QHash>
+#include <QStringList>
+#include <QElapsedTimer>
+#include "filesearcher.h"
+
+// Time window (params.time_from / time_to) in front of a search backend. Log files whose lines
+// start with a timestamp in one of [RGSearch] TimestampFormats are probed on their mapping: a
+// few sampled timestamps show whether the file is in time order, and if so the first and last
+// line of the window are found by bisecting the byte offsets. Only that slice is searched by
+// engines that take ranges and for files from [RGSearch] TimeRangeMinFileMB on; smaller files
+// and all files of engines that cannot start inside a file (ripgrep) are searched whole and
+// their matches kept by the slice's offsets, so lines without a timestamp go with the entry
+// above them. Files entirely outside the window are not searched at all. Files out of order,
+// without timestamps or compressed are searched whole and their matches filtered by their own
+// timestamp (lines without one are kept).
+class TimeRangeFileSearcher : public FileSearcher
+{
+    Q_OBJECT
+
+public:
+    // A timestamp as a sortable number: ms since 0001-01-01 if it has a date, else ms of the day
+    struct Stamp {
+        qint64 msecs = -1;
+        bool hasDate = false;
+
+        bool isValid() const { return msecs >= 0; }
+    };
+
+    // The window is set (either bound may be open)
+    static bool isActive(const RGSearchParams &params)
+    {
+        return !params.time_from.trimmed().isEmpty() || !params.time_to.trimmed().isEmpty();
+    }
+
+    // "14:02", "14:02:30", "2026-10-17 14:02", ... - an end bound covers the whole unit given
+    // (14:10 = up to 14:10:59.999). False if text is no time.
+    static bool parseBound(const QString &text, bool end, Stamp *bound);
+
+    // Takes ownership of engine
+    explicit TimeRangeFileSearcher(FileSearcher *engine, QObject *parent = nullptr);
+    ~TimeRangeFileSearcher();
+
+    QString engineName() const override;
+
+    void start(const RGSearchParams &params) override;
+    void cancel() override;
+
+    bool canSearchTargets(const QVector<SearchTarget> &targets) const override;
+    QStringList candidateFiles(const RGSearchParams &params) const override;
+
+private:
+    struct LineFormat {
+        QString format;             // QDateTime / QTime format
+        int length = 0;             // Characters of a formatted timestamp
+        bool hasDate = false;
+    };
+
+    // Where the matches of a file may be
+    struct FileWindow {
+        bool sliced = false;        // [start, end) holds the window (probed) - else by timestamp
+        qint64 start = 0;
+        qint64 end = 0;
+    };
+
+    // Match records of a file as they pass
+    struct OpenFile {
+        FileWindow window;
+        QByteArray beginRecord;
+        bool begun = false;
+        int lines = 0;
+    };
+
+    void prepareRun();              // Search thread: probe every candidate
+    void startEngine();
+    void filterEngineChunk(const QByteArray &jsonLines);
+    void finishRun(int engineExitCode);
+
+    // Timestamp at the start of a line (after a few leading non-digits such as '[')
+    Stamp lineStamp(const char *line, qint64 length) const;
+
+    // First of the next MaxProbeLines lines starting in [from, limit) that has a timestamp, its
+    // start in *lineStart
+    Stamp nextStamp(const char *data, qint64 size, qint64 from, qint64 limit, qint64 *lineStart) const;
+
+    // Start of the first line with a timestamp at or after key (after, if strict) - the file is
+    // in time order
+    qint64 boundaryOffset(const char *data, qint64 size, qint64 key, bool strict) const;
+
+    // Slice of a file holding the window; false if the file cannot be sliced. An empty slice
+    // means no line of the file is in the window.
+    bool probeFile(const QString &filePath, const char *data, qint64 size, FileWindow *window) const;
+
+    // Stamp and bound on the same scale: a bound without date is taken on the day of
+    // reference, a stamp without date is compared by time of day
+    static qint64 resolve(const Stamp &bound, const Stamp &reference);
+    bool inWindow(const Stamp &stamp) const;
+
+    static QString normalizedPath(const QString &filePath);
+
+    FileSearcher *m_engine;
+    RGSearchParams m_params;
+    QVector<LineFormat> m_formats;
+    int m_probes;
+    qint64 m_minFileBytes;
+    Stamp m_from;                   // Invalid = open
+    Stamp m_to;
+    QElapsedTimer m_timer;
+
+    // Set up by prepareRun before the engine starts
+    QVector<SearchTarget> m_engineTargets;
+    QHash<QString, FileWindow> m_windows;   // By normalized path, probed files only
+    QStringList m_skippedFiles;             // No line in the window - reported searched
+    bool m_fullSearch;
+
+    // Engine output arrives from its worker threads
+    QMutex m_mutex;
+    QHash<QByteArray, OpenFile> m_openFiles;    // By data.path as the engine wrote it
+    int m_droppedMatches;
+
+    static constexpr qint64 ProbeBlockBytes = 64 * 1024;   // Bisection stops, lines are read
+    static constexpr int MaxProbeLines = 64;                // Lines read for one timestamp
+    static constexpr int MaxLeadChars = 4;                  // Non-digits before a timestamp
+};
+
+#endif // TIMERANGEFILESEARCHER_H
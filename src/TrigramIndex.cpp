@@ -0,0 +1,632 @@
+#include "TrigramIndex.h"
+#include "RegexLiterals.h"
+#include "SplitFileSearch.h"
+#include "CachedFileSearcher.h"
+#include "logger.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSettings>
+#include <QThread>
+#include <QRegularExpression>
+#include <cmath>
+
+namespace {
+
+const quint32 IndexMagic = 0x54474931;     // "TGI1"
+const qint32 IndexVersion = 1;
+
+// Bitmaps written per commit, so a long first build becomes usable step by step
+const qint64 CommitBytes = 64 * 1024 * 1024;
+
+} // namespace
+
+// ===== QUERY =====
+
+quint32 TrigramIndex::trigramHash(quint32 trigram)
+{
+    // Fibonacci hashing, top 20 bits - smaller bitmaps use the low bits of this
+    return (trigram * 0x9E3779B1u) >> 12;
+}
+
+TrigramIndex::Query TrigramIndex::buildQuery(const RGSearchParams &params)
+{
+    Query query;
+
+    // pattern and add_pattern are alternatives of the search (separate -e arguments of rg)
+    QStringList patterns;
+    patterns << params.pattern;
+    if (!params.add_pattern.isEmpty()) {
+        patterns << params.add_pattern;
+    }
+    QString fullPattern = patterns.join(QLatin1Char('\n'));
+    if (fullPattern.isEmpty()) {
+        return query;
+    }
+
+    // Only ASCII is case folded in the index, other letters could match in another case
+    // (Unicode folds of ASCII letters like the Kelvin sign are not covered)
+    bool caseless = !params.case_sensitive &&
+                    (params.ignore_case || (params.smart_case && fullPattern.toLower() == fullPattern) ||
+                     (!params.fixed_string && fullPattern.contains("(?i")));
+
+    // Verbose mode (?x) gives whitespace another meaning - no literals are taken from such patterns
+    static const QRegularExpression verboseFlag("\\(\\?[a-zA-Z-]*x");
+    if (!params.fixed_string && fullPattern.contains(verboseFlag)) {
+        return query;
+    }
+
+    // rg -F takes each pattern as one literal
+    QVector<QVector<QByteArray>> alternatives;
+    for (const QString &pattern : patterns) {
+        if (params.fixed_string) {
+            alternatives.append({pattern.toUtf8()});
+        } else {
+            for (const QString &alternative : RegexLiterals::splitAlternatives(pattern)) {
+                alternatives.append(RegexLiterals::requiredLiterals(alternative));
+            }
+        }
+    }
+
+    for (const QVector<QByteArray> &literals : alternatives) {
+        QSet<quint32> hashes;
+        for (const QByteArray &literal : literals) {
+            for (int i = 0; i + 2 < literal.size(); ++i) {
+                quint32 trigram = 0;
+                bool usable = true;
+                for (int k = 0; k < 3; ++k) {
+                    uchar b = uchar(literal[i + k]);
+                    if (b == '\n' || (caseless && b >= 0x80)) {
+                        usable = false;
+                    }
+                    if (b >= 'A' && b <= 'Z') {
+                        b += 'a' - 'A';
+                    }
+                    trigram = (trigram << 8) | b;
+                }
+                if (usable) {
+                    hashes.insert(trigramHash(trigram));
+                }
+            }
+        }
+
+        // One alternative without a required trigram can match anywhere
+        if (hashes.isEmpty()) {
+            return Query();
+        }
+        query.alternatives.append(QVector<quint32>(hashes.begin(), hashes.end()));
+    }
+
+    return query;
+}
+
+// ===== SELF CHECK =====
+
+// ===== SHARED INDEXES =====
+
+QSharedPointer<TrigramIndex> TrigramIndex::forRoot(const QString &root)
+{
+    static QMutex mutex;
+    static QHash<QString, QSharedPointer<TrigramIndex>> indexes;
+
+    QString key = normalizedPath(root);
+    QMutexLocker locker(&mutex);
+    QSharedPointer<TrigramIndex> index = indexes.value(key);
+    if (!index) {
+        index = QSharedPointer<TrigramIndex>(new TrigramIndex(key));
+        indexes.insert(key, index);
+    }
+    return index;
+}
+
+qint64 TrigramIndex::blockBytes()
+{
+    QSettings settings("app.ini", QSettings::IniFormat);
+    settings.beginGroup("RGSearch");
+    qint64 bytes = qMax(1LL, settings.value("IndexBlockMB", 16).toLongLong()) * 1024 * 1024;
+    settings.endGroup();
+    return bytes;
+}
+
+QString TrigramIndex::normalizedPath(const QString &filePath)
+{
+    QString normalized = QDir::cleanPath(QFileInfo(filePath).absoluteFilePath());
+#ifdef Q_OS_WIN
+    normalized = normalized.toLower();
+#endif
+    return normalized;
+}
+
+TrigramIndex::TrigramIndex(const QString &root)
+    : m_root(root)
+    , m_dataBytes(0)
+    , m_garbageBytes(0)
+    , m_blockBytes(blockBytes())
+    , m_dataMap(nullptr)
+    , m_updating(false)
+    , m_quitting(false)
+{
+    m_key = QString::fromLatin1(QCryptographicHash::hash(root.toUtf8(), QCryptographicHash::Sha1).toHex().left(16));
+    QDir().mkpath(QCoreApplication::applicationDirPath() + "/data/index");
+
+    if (!load() || !mapData()) {
+        LOG_INFO("TrigramIndex: Starting a new index for " + m_root);
+        unmapData();
+        m_files.clear();
+        m_dataFileName = m_key + ".1.tgd";
+        m_dataBytes = 0;
+        m_garbageBytes = 0;
+        QDir indexDir(dataPath(QString()));
+        for (const QString &stale : indexDir.entryList({m_key + ".*.tgd"}, QDir::Files)) {
+            indexDir.remove(stale);
+        }
+    }
+}
+
+TrigramIndex::~TrigramIndex()
+{
+    unmapData();
+}
+
+// ===== LOOKUP =====
+
+bool TrigramIndex::candidateRanges(const QString &filePath, qint64 size, qint64 modified, const Query &query,
+                                   QVector<FileSearcher::SearchRange> *ranges, int *blockCount) const
+{
+    QReadLocker locker(&m_lock);
+
+    auto it = m_files.constFind(normalizedPath(filePath));
+    if (it == m_files.constEnd() || it->size != size || it->modified != modified) {
+        return false;
+    }
+    const FileEntry &entry = it.value();
+    if (!entry.blocks.isEmpty() && !m_dataMap) {
+        return false;
+    }
+
+    ranges->clear();
+    *blockCount = entry.blocks.size();
+    for (const Block &block : entry.blocks) {
+        bool mayMatch = !query.isUsable();
+        const uchar *bits = m_dataMap + block.bitsOffset;
+        quint32 mask = quint32(block.bitsBytes) * 8 - 1;
+        for (int a = 0; a < query.alternatives.size() && !mayMatch; ++a) {
+            mayMatch = true;
+            for (quint32 hash : query.alternatives[a]) {
+                quint32 bit = hash & mask;
+                if (!(bits[bit >> 3] & (1 << (bit & 7)))) {
+                    mayMatch = false;
+                    break;
+                }
+            }
+        }
+        if (!mayMatch) {
+            continue;
+        }
+
+        // Neighbouring candidate blocks become one range
+        if (!ranges->isEmpty() && ranges->last().end == block.start) {
+            ranges->last().end = block.end;
+        } else {
+            FileSearcher::SearchRange range;
+            range.start = block.start;
+            range.end = block.end;
+            range.startLine = block.startLine;
+            ranges->append(range);
+        }
+    }
+    return true;
+}
+
+// ===== STORAGE =====
+
+QString TrigramIndex::directoryPath() const
+{
+    return QCoreApplication::applicationDirPath() + "/data/index/" + m_key + ".tgi";
+}
+
+QString TrigramIndex::dataPath(const QString &fileName) const
+{
+    return QCoreApplication::applicationDirPath() + "/data/index/" + fileName;
+}
+
+bool TrigramIndex::load()
+{
+    QFile file(directoryPath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    qint32 version = 0;
+    QString root;
+    qint64 blockBytes = 0;
+    in >> magic >> version >> root >> blockBytes;
+    if (magic != IndexMagic || version != IndexVersion || root != m_root) {
+        LOG_WARNING("TrigramIndex: Ignoring unreadable index " + directoryPath());
+        return false;
+    }
+    if (blockBytes != m_blockBytes) {
+        LOG_INFO("TrigramIndex: Block size changed, rebuilding the index for " + m_root);
+        return false;
+    }
+
+    quint32 fileCount = 0;
+    in >> m_dataFileName >> m_dataBytes >> m_garbageBytes >> fileCount;
+    for (quint32 f = 0; f < fileCount && in.status() == QDataStream::Ok; ++f) {
+        QString path;
+        FileEntry entry;
+        quint32 blockCount = 0;
+        in >> path >> entry.size >> entry.modified >> blockCount;
+        entry.blocks.resize(blockCount);
+        for (Block &block : entry.blocks) {
+            in >> block.start >> block.end >> block.startLine >> block.bitsOffset >> block.bitsBytes;
+        }
+        m_files.insert(path, entry);
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        LOG_WARNING("TrigramIndex: Truncated index " + directoryPath());
+        m_files.clear();
+        return false;
+    }
+
+    LOG_INFO("TrigramIndex: Loaded index of " + m_root + " - " + QString::number(m_files.size()) + " files, " +
+             QString::number(m_dataBytes / 1024) + " KB of bitmaps");
+    return true;
+}
+
+bool TrigramIndex::saveDirectory() const
+{
+    QSaveFile file(directoryPath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        LOG_WARNING("TrigramIndex: Cannot write " + directoryPath());
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << IndexMagic << IndexVersion << m_root << m_blockBytes;
+    out << m_dataFileName << m_dataBytes << m_garbageBytes << quint32(m_files.size());
+    for (auto it = m_files.constBegin(); it != m_files.constEnd(); ++it) {
+        out << it.key() << it->size << it->modified << quint32(it->blocks.size());
+        for (const Block &block : it->blocks) {
+            out << block.start << block.end << block.startLine << block.bitsOffset << block.bitsBytes;
+        }
+    }
+
+    return file.commit();
+}
+
+bool TrigramIndex::mapData()
+{
+    if (m_dataBytes == 0) {
+        return true;
+    }
+
+    m_dataFile.setFileName(dataPath(m_dataFileName));
+    if (!m_dataFile.open(QIODevice::ReadOnly) || m_dataFile.size() < m_dataBytes) {
+        LOG_WARNING("TrigramIndex: Bitmap file missing or short: " + m_dataFile.fileName());
+        m_dataFile.close();
+        return false;
+    }
+    m_dataMap = m_dataFile.map(0, m_dataBytes);
+    if (!m_dataMap) {
+        LOG_WARNING("TrigramIndex: Cannot map " + m_dataFile.fileName());
+        m_dataFile.close();
+        return false;
+    }
+    return true;
+}
+
+void TrigramIndex::unmapData()
+{
+    if (m_dataMap) {
+        m_dataFile.unmap(const_cast<uchar*>(m_dataMap));
+        m_dataMap = nullptr;
+    }
+    m_dataFile.close();
+}
+
+// ===== BACKGROUND UPDATE =====
+
+void TrigramIndex::scheduleUpdate(const QSharedPointer<TrigramIndex> &index, const QStringList &files)
+{
+    {
+        QMutexLocker locker(&index->m_pendingMutex);
+        for (const QString &filePath : files) {
+            index->m_pending.insert(normalizedPath(filePath));
+        }
+        if (index->m_updating) {
+            return;     // The running update picks them up
+        }
+        index->m_updating = true;
+    }
+
+    LOG_INFO("TrigramIndex: Indexing " + QString::number(files.size()) + " files of " + index->m_root + " in the background");
+
+    QThread *thread = QThread::create([index]() {
+        index->runUpdates();
+    });
+    QObject::connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+
+    // Indexing stops with the application - what is committed so far stays usable
+    if (QCoreApplication::instance()) {
+        QObject::connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, thread, [index, thread]() {
+            index->m_quitting.store(true);
+            thread->wait();
+        }, Qt::DirectConnection);
+    }
+    thread->start(QThread::LowPriority);
+}
+
+void TrigramIndex::runUpdates()
+{
+    LOG_INFO("TrigramIndex: ===THREAD=== runUpdates for " + m_root + " <<<<<STARTed<<<<<");
+
+    try {
+        forever {
+            QSet<QString> files;
+            {
+                QMutexLocker locker(&m_pendingMutex);
+                files.swap(m_pending);
+                if (files.isEmpty() || m_quitting.load()) {
+                    m_updating = false;
+                    break;
+                }
+            }
+
+            // ===== STEP 1: FILES THAT ARE GONE =====
+            // Only this thread changes m_files, so it reads without the lock
+            QSet<QString> removed;
+            for (auto it = m_files.constBegin(); it != m_files.constEnd(); ++it) {
+                if (!QFileInfo::exists(it.key())) {
+                    removed.insert(it.key());
+                }
+            }
+
+            // ===== STEP 2: INDEX NEW AND CHANGED FILES, COMMIT IN STEPS =====
+            QVector<IndexedFile> indexed;
+            qint64 pendingBytes = 0;
+            int indexedCount = 0;
+            for (const QString &key : files) {
+                if (m_quitting.load()) {
+                    break;
+                }
+
+                CachedFileSearcher::Fingerprint current = CachedFileSearcher::fingerprint(key);
+                if (!current.isValid()) {
+                    continue;
+                }
+                auto it = m_files.constFind(key);
+                if (it != m_files.constEnd() && it->size == current.size && it->modified == current.modified) {
+                    continue;
+                }
+
+                IndexedFile file;
+                file.key = key;
+                file.size = current.size;
+                file.modified = current.modified;
+                if (!indexFile(&file)) {
+                    continue;
+                }
+                for (const QByteArray &bits : file.bits) {
+                    pendingBytes += bits.size();
+                }
+                indexed.append(file);
+                indexedCount++;
+
+                if (pendingBytes >= CommitBytes) {
+                    commit(indexed, removed);
+                    removed.clear();
+                    pendingBytes = 0;
+                }
+            }
+            commit(indexed, removed);
+            compact();
+
+            LOG_INFO("TrigramIndex: Indexed " + QString::number(indexedCount) + " files of " + m_root + ", " +
+                     QString::number(m_files.size()) + " files in the index");
+        }
+    } catch (const std::exception &e) {
+        LOG_ERROR("TrigramIndex: Exception in runUpdates: " + QString(e.what()));
+        QMutexLocker locker(&m_pendingMutex);
+        m_updating = false;
+    } catch (...) {
+        LOG_ERROR("TrigramIndex: Unknown exception in runUpdates");
+        QMutexLocker locker(&m_pendingMutex);
+        m_updating = false;
+    }
+
+    LOG_INFO("TrigramIndex: ===THREAD=== runUpdates for " + m_root + " >>>>>ENDed>>>>>");
+}
+
+bool TrigramIndex::indexFile(IndexedFile *file) const
+{
+    QFile input(file->key);
+    if (!input.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    // Same line-aligned cuts as split searches - a match never crosses a block boundary
+    QVector<SplitFileSearch::Range> ranges = SplitFileSearch::splitFile(input, 0, m_blockBytes);
+    qint64 startLine = 1;
+
+    for (const SplitFileSearch::Range &range : ranges) {
+        if (m_quitting.load()) {
+            return false;
+        }
+        qint64 length = range.end - range.start;
+        uchar *mapped = input.map(range.start, length);
+        if (!mapped) {
+            LOG_WARNING("TrigramIndex: Cannot map " + file->key);
+            return false;
+        }
+        const uchar *data = mapped;
+
+        // ===== HASH EVERY TRIGRAM OF THE BLOCK'S LINES INTO THE LARGEST BITMAP =====
+        QByteArray bits(MaxBitmapBits / 8, '\0');
+        uchar *b = reinterpret_cast<uchar*>(bits.data());
+        quint32 window = 0;
+        int filled = 0;
+        qint64 lines = 0;
+        for (qint64 i = 0; i < length; ++i) {
+            uchar c = data[i];
+            if (c == '\n') {
+                filled = 0;
+                lines++;
+                continue;
+            }
+            if (c >= 'A' && c <= 'Z') {
+                c += 'a' - 'A';
+            }
+            window = ((window << 8) | c) & 0xFFFFFF;
+            if (++filled >= 3) {
+                quint32 bit = trigramHash(window) & (MaxBitmapBits - 1);
+                b[bit >> 3] |= uchar(1 << (bit & 7));
+            }
+        }
+        input.unmap(mapped);
+
+        // ===== SHRINK TO ABOUT 4 BITS PER DISTINCT TRIGRAM =====
+        qint64 setBits = 0;
+        for (int i = 0; i < bits.size(); ++i) {
+            setBits += qPopulationCount(quint32(b[i]));
+        }
+        double fill = double(setBits) / MaxBitmapBits;
+        double distinct = (fill >= 1.0) ? double(MaxBitmapBits) : -MaxBitmapBits * std::log(1.0 - fill);
+        int targetBits = MinBitmapBits;
+        while (targetBits < MaxBitmapBits && targetBits < distinct * 4) {
+            targetBits <<= 1;
+        }
+        // Folding halves keeps every hash at (hash & (bits - 1))
+        for (int bytes = bits.size(); bytes * 8 > targetBits; bytes /= 2) {
+            int half = bytes / 2;
+            for (int i = 0; i < half; ++i) {
+                b[i] |= b[i + half];
+            }
+            bits.truncate(half);
+            b = reinterpret_cast<uchar*>(bits.data());
+        }
+
+        Block block;
+        block.start = range.start;
+        block.end = range.end;
+        block.startLine = startLine;
+        block.bitsBytes = qint32(bits.size());
+        file->blocks.append(block);
+        file->bits.append(bits);
+
+        startLine += lines;
+    }
+
+    return true;
+}
+
+bool TrigramIndex::commit(QVector<IndexedFile> &indexed, const QSet<QString> &removed)
+{
+    if (indexed.isEmpty() && removed.isEmpty()) {
+        return true;
+    }
+
+    // ===== APPEND THE BITMAPS =====
+    QFile data(dataPath(m_dataFileName));
+    if (!data.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        LOG_WARNING("TrigramIndex: Cannot append to " + data.fileName());
+        indexed.clear();
+        return false;
+    }
+    for (IndexedFile &file : indexed) {
+        for (int i = 0; i < file.blocks.size(); ++i) {
+            file.blocks[i].bitsOffset = data.pos();
+            data.write(file.bits[i]);
+        }
+        file.bits.clear();
+    }
+    data.close();
+    qint64 dataBytes = QFileInfo(data.fileName()).size();
+
+    // ===== SWAP IN THE NEW ENTRIES =====
+    {
+        QWriteLocker locker(&m_lock);
+        unmapData();
+
+        auto dropEntry = [this](const QString &key) {
+            auto it = m_files.find(key);
+            if (it != m_files.end()) {
+                for (const Block &block : it->blocks) {
+                    m_garbageBytes += block.bitsBytes;
+                }
+                m_files.erase(it);
+            }
+        };
+        for (const QString &key : removed) {
+            dropEntry(key);
+        }
+        for (const IndexedFile &file : indexed) {
+            dropEntry(file.key);
+            FileEntry entry;
+            entry.size = file.size;
+            entry.modified = file.modified;
+            entry.blocks = file.blocks;
+            m_files.insert(file.key, entry);
+        }
+        m_dataBytes = dataBytes;
+
+        if (!mapData()) {
+            m_files.clear();    // Lookups fall back to full searches
+        }
+        saveDirectory();
+    }
+
+    indexed.clear();
+    return true;
+}
+
+void TrigramIndex::compact()
+{
+    // Rewritten once more than half of the bitmap file belongs to files indexed again or gone
+    if (m_garbageBytes < 64 * 1024 * 1024 || m_garbageBytes * 2 < m_dataBytes || !m_dataMap) {
+        return;
+    }
+
+    int generation = m_dataFileName.section('.', -2, -2).toInt() + 1;
+    QString newName = m_key + "." + QString::number(generation) + ".tgd";
+    LOG_INFO("TrigramIndex: Compacting " + m_dataFileName + " into " + newName);
+
+    QFile data(dataPath(newName));
+    if (!data.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        LOG_WARNING("TrigramIndex: Cannot write " + data.fileName());
+        return;
+    }
+    QHash<QString, FileEntry> files = m_files;
+    for (FileEntry &entry : files) {
+        for (Block &block : entry.blocks) {
+            qint64 offset = data.pos();
+            data.write(reinterpret_cast<const char*>(m_dataMap + block.bitsOffset), block.bitsBytes);
+            block.bitsOffset = offset;
+        }
+    }
+    data.close();
+
+    QString oldName = m_dataFileName;
+    {
+        QWriteLocker locker(&m_lock);
+        unmapData();
+        m_files = files;
+        m_dataFileName = newName;
+        m_dataBytes = QFileInfo(data.fileName()).size();
+        m_garbageBytes = 0;
+        if (!mapData()) {
+            m_files.clear();
+        }
+        saveDirectory();
+    }
+    QFile::remove(dataPath(oldName));
+}
@@ -0,0 +1,122 @@
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QFile>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QSharedPointer>
+#include <atomic>
+#include "filesearcher.h"
+
+// Persistent trigram index of one search root, for trees of mostly unchanging files that are
+// searched again and again. Every file is cut into line-aligned blocks and each block keeps a
+// bitmap of the hashed trigrams of its lines (ASCII case folded). A query holds the trigrams a
+// match has to contain; a block whose bitmap lacks one of them cannot match and is not searched.
+//
+// Files are (re)indexed in the background when their size or modification time differs from the
+// indexed one - until then they are searched whole. The index lives in data/index next to the
+// executable: a small directory file rewritten on each update and an append-only bitmap file
+// that is memory mapped, so a lookup only touches the bitmap bytes it tests.
+class TrigramIndex
+{
+public:
+    // Trigrams a match must contain: one hash list per alternative, a block can match if all
+    // hashes of one alternative are in its bitmap. No alternatives means no pruning is possible.
+    struct Query {
+        QVector<QVector<quint32>> alternatives;
+        bool isUsable() const { return !alternatives.isEmpty(); }
+    };
+
+    // Required literal trigrams of the search pattern (regex or fixed string, with add_pattern)
+    static Query buildQuery(const RGSearchParams &params);
+
+    // Shared index of a search root, loaded from disk on first use
+    static QSharedPointer<TrigramIndex> forRoot(const QString &root);
+
+    // [RGSearch] IndexBlockMB in app.ini
+    static qint64 blockBytes();
+
+    ~TrigramIndex();
+
+    // Parts of filePath that can contain a match. False if the file is not indexed at this size
+    // and modification time (search it whole). blockCount receives the number of indexed blocks,
+    // so ranges.size() == blockCount with one merged range means nothing was pruned.
+    bool candidateRanges(const QString &filePath, qint64 size, qint64 modified, const Query &query,
+                         QVector<FileSearcher::SearchRange> *ranges, int *blockCount) const;
+
+    // (Re)index these files on a background thread; files that no longer exist are dropped
+    static void scheduleUpdate(const QSharedPointer<TrigramIndex> &index, const QStringList &files);
+
+    static constexpr int MaxBitmapBits = 1 << 20;   // Per block, for large blocks of varied text
+    static constexpr int MinBitmapBits = 1 << 10;
+
+private:
+    struct Block {
+        qint64 start = 0;
+        qint64 end = 0;
+        qint64 startLine = 1;
+        qint64 bitsOffset = 0;      // Bitmap position in the data file
+        qint32 bitsBytes = 0;       // Power of two
+    };
+
+    struct FileEntry {
+        qint64 size = -1;
+        qint64 modified = 0;
+        QVector<Block> blocks;
+    };
+
+    // A file indexed but not yet written to the data file
+    struct IndexedFile {
+        QString key;
+        qint64 size = 0;
+        qint64 modified = 0;
+        QVector<Block> blocks;
+        QVector<QByteArray> bits;   // Bitmap of each block
+    };
+
+    explicit TrigramIndex(const QString &root);
+
+    static QString normalizedPath(const QString &filePath);
+    static quint32 trigramHash(quint32 trigram);
+
+    // ===== STORAGE =====
+    bool load();
+    bool saveDirectory() const;
+    bool mapData();
+    void unmapData();
+    QString directoryPath() const;
+    QString dataPath(const QString &fileName) const;
+
+    // ===== BACKGROUND UPDATE =====
+    void runUpdates();
+    bool indexFile(IndexedFile *file) const;
+    bool commit(QVector<IndexedFile> &indexed, const QSet<QString> &removed);
+    void compact();
+
+    QString m_root;
+    QString m_key;                  // File name stem derived from the root
+
+    // Guarded by m_lock - lookups read, commits write
+    mutable QReadWriteLock m_lock;
+    QHash<QString, FileEntry> m_files;      // By normalized path
+    QString m_dataFileName;
+    qint64 m_dataBytes;                     // Valid bytes of the data file
+    qint64 m_garbageBytes;                  // Bitmaps of files indexed again or gone
+    qint64 m_blockBytes;
+    QFile m_dataFile;
+    const uchar *m_dataMap;
+
+    // Files waiting to be indexed, and whether a thread works on them
+    QMutex m_pendingMutex;
+    QSet<QString> m_pending;
+    bool m_updating;
+    std::atomic<bool> m_quitting;
+};
+
+#endif // TRIGRAMINDEX_H
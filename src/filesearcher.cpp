@@ -1,4 +1,777 @@
 #include "filesearcher.h"
+#include "RipgrepFileSearcher.h"
+#include "NativeFileSearcher.h"
+#include "HyperscanFileSearcher.h"
+#include "SplitFileSearch.h"
+#include "CompressedFile.h"
+#include "SearchFlowControl.h"
+#include "logger.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QSharedPointer>
 
-FileSearcher::FileSearcher(QObject *parent) : QObject(parent) {}
-FileSearcher::~FileSearcher() {} 
\ No newline at end of file
+namespace {
+
+QJsonObject pathObject(const QString &filePath)
+{
+    QJsonObject path;
+    path["text"] = filePath;
+    return path;
+}
+
+QJsonObject elapsedObject(qint64 nsecs)
+{
+    QJsonObject elapsed;
+    elapsed["secs"] = nsecs / 1000000000LL;
+    elapsed["nanos"] = nsecs % 1000000000LL;
+    elapsed["human"] = QString::number(nsecs / 1e9, 'f', 6) + "s";
+    return elapsed;
+}
+
+QJsonObject statsObject(int matchedLines, int matches, int searches, int searchesWithMatch,
+                        qint64 bytesSearched, qint64 elapsedNs)
+{
+    QJsonObject stats;
+    stats["elapsed"] = elapsedObject(elapsedNs);
+    stats["searches"] = searches;
+    stats["searches_with_match"] = searchesWithMatch;
+    stats["bytes_searched"] = bytesSearched;
+    stats["matched_lines"] = matchedLines;
+    stats["matches"] = matches;
+    return stats;
+}
+
+} // namespace
+
+// ===== FileSearchRecordWriter =====
+
+FileSearchRecordWriter::FileSearchRecordWriter(FileSearcher *owner)
+    : m_owner(owner)
+    , m_capture(nullptr)
+    , m_offsetBase(0)
+    , m_lineBase(1)
+    , m_maxLinesPerFile(0)
+    , m_countOnly(false)
+    , m_waitForRoom(false)
+    , m_fileLines(0)
+{
+}
+
+FileSearchRecordWriter::FileSearchRecordWriter(QByteArray *capture)
+    : m_owner(nullptr)
+    , m_capture(capture)
+    , m_offsetBase(0)
+    , m_lineBase(1)
+    , m_maxLinesPerFile(0)
+    , m_countOnly(false)
+    , m_waitForRoom(false)
+    , m_fileLines(0)
+{
+}
+
+FileSearchRecordWriter::~FileSearchRecordWriter()
+{
+    flush();
+}
+
+void FileSearchRecordWriter::append(const QJsonObject &record)
+{
+    m_buffer.append(QJsonDocument(record).toJson(QJsonDocument::Compact));
+    m_buffer.append('\n');
+    if (m_buffer.size() >= FlushBytes) {
+        if (m_waitForRoom && m_owner) {
+            m_owner->waitForOutputRoom();
+        }
+        flush();
+    }
+}
+
+void FileSearchRecordWriter::flush()
+{
+    if (m_buffer.isEmpty()) {
+        return;
+    }
+    if (m_capture) {
+        m_capture->append(m_buffer);
+    } else {
+        emit m_owner->outputChunk(m_buffer);
+    }
+    m_buffer.clear();
+}
+
+void FileSearchRecordWriter::setFileBase(qint64 offsetBase, qint64 lineBase)
+{
+    m_offsetBase = offsetBase;
+    m_lineBase = lineBase;
+}
+
+void FileSearchRecordWriter::setLimits(const RGSearchParams &params)
+{
+    m_maxLinesPerFile = qMax(0, params.max_count);
+    m_countOnly = params.count_only;
+}
+
+void FileSearchRecordWriter::beginFile(const QString &filePath)
+{
+    m_currentFile = filePath;
+    m_fileLines = 0;
+
+    QJsonObject data;
+    data["path"] = pathObject(filePath);
+    QJsonObject begin;
+    begin["type"] = "begin";
+    begin["data"] = data;
+    append(begin);
+}
+
+bool FileSearchRecordWriter::match(const QString &filePath, qint64 lineNumber, qint64 absoluteOffset,
+                                   const QByteArray &lineText, const QVector<QPair<qint64, qint64>> &submatches)
+{
+    if (filePath != m_currentFile) {
+        beginFile(filePath);
+    }
+    if (fileFull()) {
+        return false;
+    }
+    m_fileLines++;
+    if (m_countOnly) {
+        return true;
+    }
+
+    QJsonArray submatchArray;
+    for (const QPair<qint64, qint64> &sm : submatches) {
+        QJsonObject matchText;
+        matchText["text"] = QString::fromUtf8(lineText.constData() + sm.first, int(sm.second - sm.first));
+        QJsonObject submatch;
+        submatch["match"] = matchText;
+        submatch["start"] = sm.first;
+        submatch["end"] = sm.second;
+        submatchArray.append(submatch);
+    }
+
+    QJsonObject lines;
+    lines["text"] = QString::fromUtf8(lineText);
+
+    QJsonObject data;
+    data["path"] = pathObject(filePath);
+    data["lines"] = lines;
+    data["line_number"] = lineNumber + m_lineBase - 1;
+    data["absolute_offset"] = absoluteOffset + m_offsetBase;
+    data["submatches"] = submatchArray;
+
+    QJsonObject record;
+    record["type"] = "match";
+    record["data"] = data;
+    append(record);
+    return true;
+}
+
+void FileSearchRecordWriter::appendRecords(const QString &filePath, const QByteArray &jsonLines)
+{
+    if (filePath != m_currentFile) {
+        beginFile(filePath);
+    }
+
+    m_buffer.append(jsonLines);
+    if (m_buffer.size() >= FlushBytes) {
+        if (m_waitForRoom && m_owner) {
+            m_owner->waitForOutputRoom();
+        }
+        flush();
+    }
+}
+
+void FileSearchRecordWriter::endFile(const QString &filePath, int matchedLines, int matches,
+                                     qint64 bytesSearched, qint64 elapsedNs)
+{
+    QJsonObject data;
+    data["path"] = pathObject(filePath);
+    data["stats"] = statsObject(matchedLines, matches, 1, matchedLines > 0 ? 1 : 0, bytesSearched, elapsedNs);
+
+    QJsonObject record;
+    record["type"] = "end";
+    record["data"] = data;
+    append(record);
+
+    m_currentFile.clear();
+    m_fileLines = 0;
+}
+
+QByteArray FileSearchRecordWriter::withMatchedLines(QByteArrayView endRecord, int matchedLines)
+{
+    QByteArray record = endRecord.toByteArray();
+    static const QByteArray key = "\"matched_lines\":";
+    qsizetype valueStart = record.indexOf(key);
+    if (valueStart < 0) {
+        return record;
+    }
+    valueStart += key.size();
+    qsizetype valueEnd = valueStart;
+    while (valueEnd < record.size() && record[valueEnd] >= '0' && record[valueEnd] <= '9') {
+        ++valueEnd;
+    }
+    record.replace(valueStart, valueEnd - valueStart, QByteArray::number(matchedLines));
+    return record;
+}
+
+void FileSearchRecordWriter::summary(int matchedLines, int matches, int filesSearched, int filesWithMatch,
+                                     qint64 bytesSearched, qint64 elapsedNs)
+{
+    QJsonObject data;
+    data["elapsed_total"] = elapsedObject(elapsedNs);
+    data["stats"] = statsObject(matchedLines, matches, filesSearched, filesWithMatch, bytesSearched, elapsedNs);
+
+    QJsonObject record;
+    record["type"] = "summary";
+    record["data"] = data;
+    append(record);
+}
+
+// ===== FileSearcher =====
+
+FileSearcher::FileSearcher(QObject *parent)
+    : QObject(parent)
+    , m_cancelled(false)
+    , m_hasTargets(false)
+{
+}
+
+FileSearcher::~FileSearcher()
+{
+}
+
+void FileSearcher::cancel()
+{
+    m_cancelled.store(true);
+}
+
+void FileSearcher::waitForOutputRoom() const
+{
+    if (m_flowControl) {
+        m_flowControl->waitForRoom([this]() { return isCancelled(); });
+    }
+}
+
+void FileSearcher::setTargets(const QVector<SearchTarget> &targets)
+{
+    m_targets = targets;
+    m_hasTargets = true;
+}
+
+void FileSearcher::clearTargets()
+{
+    m_targets.clear();
+    m_hasTargets = false;
+}
+
+bool FileSearcher::canSearchTargets(const QVector<SearchTarget> &targets) const
+{
+    Q_UNUSED(targets)
+    return false;
+}
+
+QStringList FileSearcher::candidateFiles(const RGSearchParams &params) const
+{
+    return collectFiles(params);
+}
+
+QStringList FileSearcher::engineNames()
+{
+    return {"ripgrep", "builtin", "hyperscan"};
+}
+
+FileSearcher *FileSearcher::create(const QString &engine, QObject *parent)
+{
+    if (engine == "ripgrep") {
+        return new RipgrepFileSearcher(parent);
+    }
+    if (engine == "builtin") {
+        return new NativeFileSearcher(parent);
+    }
+    if (engine == "hyperscan") {
+        return new HyperscanFileSearcher(parent);
+    }
+
+    LOG_WARNING("FileSearcher: Unknown search engine: " + engine);
+    return nullptr;
+}
+
+bool FileSearcher::isEngineAvailable(const QString &engine)
+{
+    if (engine == "hyperscan") {
+        return HyperscanFileSearcher::isCompiledIn();
+    }
+    return engineNames().contains(engine);
+}
+
+QStringList FileSearcher::collectFiles(const RGSearchParams &params) const
+{
+    QStringList files;
+
+    QFileInfo rootInfo(params.path);
+    if (rootInfo.isFile()) {
+        files.append(rootInfo.absoluteFilePath());
+        return files;
+    }
+
+    // Same comma separated glob list as ripgrep -g ("!" prefix excludes)
+    QList<QRegularExpression> includes;
+    QList<QRegularExpression> excludes;
+    QList<bool> includeOnPath;
+    QList<bool> excludeOnPath;
+    for (const QString &glob : params.incl_exclude.split(',', Qt::SkipEmptyParts)) {
+        QString trimmed = glob.trimmed();
+        bool exclude = trimmed.startsWith("!");
+        if (exclude) {
+            trimmed = trimmed.mid(1);
+        }
+        QRegularExpression regex(QRegularExpression::wildcardToRegularExpression(trimmed));
+        if (exclude) {
+            excludes.append(regex);
+            excludeOnPath.append(trimmed.contains('/'));
+        } else {
+            includes.append(regex);
+            includeOnPath.append(trimmed.contains('/'));
+        }
+    }
+
+    QDir root(params.path);
+    QDirIterator it(params.path, QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        if (isCancelled()) {
+            break;
+        }
+
+        QString filePath = it.next();
+        QString fileName = it.fileName();
+        QString relativePath = root.relativeFilePath(filePath);
+
+        bool excluded = false;
+        for (int i = 0; i < excludes.size() && !excluded; ++i) {
+            excluded = excludes[i].match(excludeOnPath[i] ? relativePath : fileName).hasMatch();
+        }
+        if (excluded) {
+            continue;
+        }
+
+        bool included = includes.isEmpty();
+        for (int i = 0; i < includes.size() && !included; ++i) {
+            included = includes[i].match(includeOnPath[i] ? relativePath : fileName).hasMatch();
+        }
+        if (included) {
+            files.append(filePath);
+        }
+    }
+
+    return files;
+}
+
+// ===== MappedFileSearcher =====
+
+MappedFileSearcher::MappedFileSearcher(QObject *parent)
+    : FileSearcher(parent)
+    , m_exitCode(2)
+{
+}
+
+MappedFileSearcher::~MappedFileSearcher()
+{
+}
+
+void MappedFileSearcher::start(const RGSearchParams &params)
+{
+    LOG_INFO("MappedFileSearcher: Starting " + engineName() + " search on its own thread");
+
+    // Cleared here, not on the search thread: a cancel() before the thread runs must stick
+    m_cancelled.store(false);
+
+    QThread *thread = QThread::create([this, params]() {
+        m_exitCode = run(params);
+    });
+
+    // finished() is delivered on this object's thread once the search thread is done
+    connect(thread, &QThread::finished, this, [this, thread]() {
+        thread->deleteLater();
+        emit finished(m_exitCode);
+    });
+    thread->start();
+}
+
+bool MappedFileSearcher::canSearchTargets(const QVector<SearchTarget> &targets) const
+{
+    Q_UNUSED(targets)
+    return true;
+}
+
+int MappedFileSearcher::run(const RGSearchParams &params)
+{
+    LOG_INFO("MappedFileSearcher: ===THREAD=== " + engineName() + " run for path: " + params.path + " <<<<<STARTed<<<<<");
+
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+    int exitCode = 2;
+
+    try {
+        // ===== STEP 1: COMPILE THE MATCHER =====
+        QString error;
+        if (!prepare(params, &error)) {
+            LOG_ERROR("MappedFileSearcher: " + error);
+            emit errorOccurred(error);
+            return 2;
+        }
+
+        // ===== STEP 2: COLLECT FILES =====
+        QVector<SearchTarget> files = m_targets;
+        if (!m_hasTargets) {
+            for (const QString &filePath : collectFiles(params)) {
+                SearchTarget target;
+                target.filePath = filePath;
+                files.append(target);
+            }
+        }
+        LOG_INFO("MappedFileSearcher: " + QString::number(files.size()) + " candidate files" +
+                 (m_hasTargets ? " (given targets)" : ""));
+
+        // ===== STEP 3: SCAN MAPPED FILES ON ALL CORES =====
+        // Files from the split size on are cut into line-aligned ranges that all threads take
+        // before the next file; their records are written in file order by SplitFileSearch
+        SplitFileSearch::Config split = SplitFileSearch::loadConfig();
+        split.enabled = split.enabled && canSplitFiles();
+
+        // A file with a match limit is scanned from its start so the scan can stop at the limit
+        split.enabled = split.enabled && params.max_count <= 0;
+
+        struct RangeTask {
+            QSharedPointer<SplitFileSearch> file;
+            int index = 0;
+        };
+        QMutex queueMutex;
+        QWaitCondition queueChanged;
+        QQueue<RangeTask> rangeTasks;
+        int nextFile = 0;
+        int openingFiles = 0;       // Files taken whose ranges may still be queued
+
+        std::atomic<int> totalMatchedLines(0);
+        std::atomic<int> totalMatches(0);
+        std::atomic<int> filesWithMatch(0);
+        std::atomic<qint64> bytesSearched(0);
+
+        // A queued range, else the next file (fileIndex >= 0) - false when all work is taken
+        auto takeTask = [&](RangeTask *range, int *fileIndex) -> bool {
+            // No new work while the results backlog is full
+            waitForOutputRoom();
+            QMutexLocker locker(&queueMutex);
+            forever {
+                if (isCancelled()) {
+                    return false;
+                }
+                if (!rangeTasks.isEmpty()) {
+                    *range = rangeTasks.dequeue();
+                    *fileIndex = -1;
+                    return true;
+                }
+                if (nextFile < files.size()) {
+                    *fileIndex = nextFile++;
+                    openingFiles++;
+                    return true;
+                }
+                if (openingFiles == 0) {
+                    return false;
+                }
+                queueChanged.wait(&queueMutex);
+            }
+        };
+
+        // After the file's records were flushed - a cancelled scan may have stopped inside the file
+        auto fileDone = [&](const QString &filePath) {
+            if (!isCancelled()) {
+                emit fileSearched(filePath);
+            }
+        };
+
+        auto scanRange = [&](const RangeTask &task, FileSearchRecordWriter &writer, void *threadState) {
+            const SplitFileSearch::Range &range = task.file->range(task.index);
+            qint64 rangeSize = range.end - range.start;
+            QByteArray records;
+            qint64 newlines = 0;
+            FileScanResult result;
+
+            QFile file(task.file->filePath());
+            uchar *mapped = file.open(QIODevice::ReadOnly) ? file.map(range.start, rangeSize) : nullptr;
+            if (mapped) {
+                // Line numbers from 1 and offsets from 0 at the range start - re-based when written
+                FileSearchRecordWriter rangeWriter(&records);
+                rangeWriter.setLimits(params);
+                result = scanFile(task.file->filePath(), reinterpret_cast<const char*>(mapped), rangeSize,
+                                  rangeWriter, threadState);
+                rangeWriter.flush();
+                newlines = SplitFileSearch::countNewlines(reinterpret_cast<const char*>(mapped), rangeSize);
+                file.unmap(mapped);
+                bytesSearched += rangeSize;
+            } else {
+                LOG_WARNING("MappedFileSearcher: Cannot map range " + QString::number(task.index) + " of " +
+                            task.file->filePath() + ", later line numbers of this file are off");
+            }
+
+            if (task.file->rangeDone(task.index, records, newlines, result.matchedLines, result.matches, writer)) {
+                if (task.file->matchedLines() > 0) {
+                    filesWithMatch++;
+                    totalMatchedLines += task.file->matchedLines();
+                    totalMatches += task.file->matches();
+                }
+                fileDone(task.file->filePath());
+            }
+        };
+
+        auto worker = [&]() {
+            void *threadState = createThreadState();
+            FileSearchRecordWriter writer(this);
+            writer.setLimits(params);
+            writer.setWaitForRoom(true);
+
+            RangeTask range;
+            int index = -1;
+            while (takeTask(&range, &index)) {
+                if (index < 0) {
+                    scanRange(range, writer, threadState);
+                    continue;
+                }
+
+                const QString &filePath = files[index].filePath;
+                qint64 startOffset = files[index].startOffset;
+
+                // Compressed files are decompressed on this thread, never cut into ranges
+                if (params.search_compressed && CompressedFile::canRead(filePath)) {
+                    {
+                        QMutexLocker locker(&queueMutex);
+                        openingFiles--;
+                        queueChanged.wakeAll();
+                    }
+                    qint64 scannedBytes = 0;
+                    FileScanResult result = scanCompressedFile(filePath, writer, threadState, &scannedBytes);
+                    if (result.matchedLines > 0) {
+                        filesWithMatch++;
+                        totalMatchedLines += result.matchedLines;
+                        totalMatches += result.matches;
+                    }
+                    bytesSearched += scannedBytes;
+                    fileDone(filePath);
+                    continue;
+                }
+
+                QFile file(filePath);
+                bool opened = file.open(QIODevice::ReadOnly) && file.size() > startOffset;
+
+                QVector<SplitFileSearch::Range> ranges;
+                if (opened && split.enabled && files[index].ranges.isEmpty() &&
+                    file.size() - startOffset >= split.thresholdBytes) {
+                    ranges = SplitFileSearch::splitFile(file, startOffset, split.rangeBytes);
+                }
+                {
+                    QMutexLocker locker(&queueMutex);
+                    openingFiles--;
+                    if (ranges.size() > 1) {
+                        QSharedPointer<SplitFileSearch> splitFile(new SplitFileSearch(filePath, ranges, files[index].startLine));
+                        for (int i = 0; i < ranges.size(); ++i) {
+                            RangeTask task;
+                            task.file = splitFile;
+                            task.index = i;
+                            rangeTasks.enqueue(task);
+                        }
+                    }
+                    queueChanged.wakeAll();
+                }
+                if (!opened) {
+                    fileDone(filePath);     // Gone, empty or nothing after startOffset
+                }
+                if (!opened || ranges.size() > 1) {
+                    continue;
+                }
+
+                // Only the given parts of the file (e.g. the blocks the trigram index left), in order
+                if (!files[index].ranges.isEmpty()) {
+                    QElapsedTimer fileTimer;
+                    fileTimer.start();
+                    FileScanResult total;
+                    qint64 scannedBytes = 0;
+
+                    for (const SearchRange &range : files[index].ranges) {
+                        qint64 rangeEnd = qMin(range.end, file.size());
+                        if (isCancelled() || writer.fileFull() || range.start >= rangeEnd) {
+                            continue;
+                        }
+                        uchar *mapped = file.map(range.start, rangeEnd - range.start);
+                        if (!mapped) {
+                            LOG_WARNING("MappedFileSearcher: Cannot map a range of " + filePath);
+                            continue;
+                        }
+                        writer.setFileBase(range.start, range.startLine);
+                        FileScanResult result = scanFile(filePath, reinterpret_cast<const char*>(mapped),
+                                                         rangeEnd - range.start, writer, threadState);
+                        writer.setFileBase(0, 1);
+                        total.matchedLines += result.matchedLines;
+                        total.matches += result.matches;
+                        scannedBytes += rangeEnd - range.start;
+                        file.unmap(mapped);
+                    }
+
+                    if (total.matchedLines > 0) {
+                        writer.endFile(filePath, total.matchedLines, total.matches, scannedBytes, fileTimer.nsecsElapsed());
+                        filesWithMatch++;
+                        totalMatchedLines += total.matchedLines;
+                        totalMatches += total.matches;
+                    }
+                    bytesSearched += scannedBytes;
+                    writer.flush();
+                    fileDone(filePath);
+                    continue;
+                }
+
+                // Targets starting past 0 only scan the part after startOffset (e.g. a grown log's tail)
+                qint64 scanSize = file.size() - startOffset;
+                uchar *mapped = file.map(startOffset, scanSize);
+                if (!mapped) {
+                    LOG_WARNING("MappedFileSearcher: Cannot map " + filePath);
+                    fileDone(filePath);
+                    continue;
+                }
+
+                QElapsedTimer fileTimer;
+                fileTimer.start();
+
+                writer.setFileBase(startOffset, files[index].startLine);
+                FileScanResult result = scanFile(filePath, reinterpret_cast<const char*>(mapped), scanSize,
+                                                 writer, threadState);
+                writer.setFileBase(0, 1);
+                if (result.matchedLines > 0) {
+                    writer.endFile(filePath, result.matchedLines, result.matches, scanSize, fileTimer.nsecsElapsed());
+                    filesWithMatch++;
+                    totalMatchedLines += result.matchedLines;
+                    totalMatches += result.matches;
+                }
+                bytesSearched += scanSize;
+
+                file.unmap(mapped);
+
+                // Hand over each file's results right away so the view fills while searching
+                writer.flush();
+                fileDone(filePath);
+            }
+
+            destroyThreadState(threadState);
+        };
+
+        // With splitting a single file can keep every core busy
+        int threadCount = split.enabled ? qMax(1, QThread::idealThreadCount())
+                                        : qBound(1, QThread::idealThreadCount(), qMax(1, int(files.size())));
+        QList<QThread*> threads;
+        for (int i = 0; i < threadCount; ++i) {
+            QThread *thread = QThread::create(worker);
+            threads.append(thread);
+            thread->start();
+        }
+        for (QThread *thread : threads) {
+            thread->wait();
+            delete thread;
+        }
+
+        release();
+
+        // ===== STEP 4: SUMMARY (same shape as rg --json) =====
+        FileSearchRecordWriter writer(this);
+        writer.summary(totalMatchedLines.load(), totalMatches.load(), int(files.size()), filesWithMatch.load(),
+                       bytesSearched.load(), totalTimer.nsecsElapsed());
+        writer.flush();
+
+        LOG_INFO("MappedFileSearcher: " + engineName() + " found " + QString::number(totalMatchedLines.load()) +
+                 " matched lines in " + QString::number(filesWithMatch.load()) + " files, " +
+                 QString::number(bytesSearched.load()) + " bytes with " + QString::number(threadCount) +
+                 " threads in " + QString::number(totalTimer.elapsed()) + " ms" +
+                 (isCancelled() ? " (cancelled)" : ""));
+
+        exitCode = totalMatchedLines.load() > 0 ? 0 : 1;
+
+    } catch (const std::exception &e) {
+        LOG_ERROR("MappedFileSearcher: Exception in run: " + QString(e.what()));
+        emit errorOccurred(QString("Exception: %1").arg(e.what()));
+        release();
+        exitCode = 2;
+    } catch (...) {
+        LOG_ERROR("MappedFileSearcher: Unknown exception in run");
+        emit errorOccurred("Unknown exception occurred");
+        release();
+        exitCode = 2;
+    }
+
+    LOG_INFO("MappedFileSearcher: ===THREAD=== " + engineName() + " run for path: " + params.path + " >>>>>ENDed>>>>>");
+    return exitCode;
+}
+
+MappedFileSearcher::FileScanResult MappedFileSearcher::scanCompressedFile(const QString &filePath,
+                                                                          FileSearchRecordWriter &writer,
+                                                                          void *threadState, qint64 *bytesScanned)
+{
+    QElapsedTimer fileTimer;
+    fileTimer.start();
+
+    FileScanResult total;
+    QByteArray block;
+    qint64 blockOffset = 0;
+    qint64 blockLine = 1;
+    qint64 decompressed = 0;
+    bool wholeFile = !canSplitFiles();
+
+    // Offsets and line numbers are those of the decompressed stream
+    auto scanBlock = [&](qint64 size) {
+        writer.setFileBase(blockOffset, blockLine);
+        FileScanResult result = scanFile(filePath, block.constData(), size, writer, threadState);
+        writer.setFileBase(0, 1);
+        total.matchedLines += result.matchedLines;
+        total.matches += result.matches;
+        blockLine += SplitFileSearch::countNewlines(block.constData(), size);
+        blockOffset += size;
+        block.remove(0, size);
+    };
+
+    QString error;
+    bool ok = CompressedFile::decompress(filePath, [&](const char *data, qint64 size) {
+        if (isCancelled() || writer.fileFull()) {
+            return false;
+        }
+        block.append(data, size);
+        decompressed += size;
+        if (!wholeFile && block.size() >= CompressedBlockBytes) {
+            qsizetype cut = block.lastIndexOf('\n') + 1;
+            if (cut > 0) {
+                scanBlock(cut);
+            }
+        }
+        return true;
+    }, &error);
+    if (!ok) {
+        LOG_WARNING("MappedFileSearcher: " + error);
+    }
+
+    // The last line, or everything for engines that see whole files
+    if (!block.isEmpty() && !isCancelled() && !writer.fileFull()) {
+        scanBlock(block.size());
+    }
+
+    if (total.matchedLines > 0) {
+        writer.endFile(filePath, total.matchedLines, total.matches, decompressed, fileTimer.nsecsElapsed());
+    }
+    writer.flush();
+
+    *bytesScanned = decompressed;
+    return total;
+}
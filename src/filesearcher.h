@@ -2,13 +2,233 @@
 #define FILESEARCHER_H
 
 #include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QVector>
+#include <QPair>
+#include <QJsonObject>
+#include <QSharedPointer>
+#include <atomic>
+#include "KSearchBun.h"  // For RGSearchParams
 
+class FileSearcher;
+class SearchFlowControl;
+
+// Writes the search record stream shared by all backends: begin-file, match, end-file and
+// summary records in the ripgrep --json JSON Lines layout, so JsonParseWorker consumes every
+// engine the same way. Records are buffered and handed out through FileSearcher::outputChunk.
+class FileSearchRecordWriter
+{
+public:
+    explicit FileSearchRecordWriter(FileSearcher *owner);
+
+    // Collects the records in capture instead of handing them to a searcher
+    explicit FileSearchRecordWriter(QByteArray *capture);
+    ~FileSearchRecordWriter();
+
+    // begin-file is written automatically before the first match of a file
+    void beginFile(const QString &filePath);
+
+    // submatches are [start, end) byte offsets relative to the start of lineText. Returns false
+    // for a line past the per-file limit - it is not written and not counted.
+    bool match(const QString &filePath, qint64 lineNumber, qint64 absoluteOffset,
+               const QByteArray &lineText, const QVector<QPair<qint64, qint64>> &submatches);
+
+    void endFile(const QString &filePath, int matchedLines, int matches, qint64 bytesSearched, qint64 elapsedNs);
+
+    void summary(int matchedLines, int matches, int filesSearched, int filesWithMatch,
+                 qint64 bytesSearched, qint64 elapsedNs);
+
+    // End record with data.stats.matched_lines replaced, for decorators that drop match records
+    static QByteArray withMatchedLines(QByteArrayView endRecord, int matchedLines);
+
+    // Complete match records of one file, written as they are (e.g. replayed from a cache)
+    void appendRecords(const QString &filePath, const QByteArray &jsonLines);
+
+    // Offset and line number of the first scanned byte when a file is scanned from the middle
+    void setFileBase(qint64 offsetBase, qint64 lineBase);
+
+    // Result budgets of params: at most max_count match records per file (0 = no limit), and with
+    // count_only none at all - matches are only counted and the file's records are begin and end
+    void setLimits(const RGSearchParams &params);
+
+    // The current file reached its match limit - scanning it further finds nothing to write
+    bool fileFull() const { return m_maxLinesPerFile > 0 && m_fileLines >= m_maxLinesPerFile; }
+
+    // Hand buffered records to the parser (done automatically above FlushBytes)
+    void flush();
+
+    // Before an automatic flush, wait while the owner's result backlog is full. Only for
+    // writers of engine threads that hold no lock another thread could be waiting for.
+    void setWaitForRoom(bool wait) { m_waitForRoom = wait; }
+
+    static constexpr int FlushBytes = 1024 * 1024;
+
+private:
+    void append(const QJsonObject &record);
+
+    FileSearcher *m_owner;
+    QByteArray *m_capture;
+    QByteArray m_buffer;
+    QString m_currentFile;
+    qint64 m_offsetBase;
+    qint64 m_lineBase;
+    int m_maxLinesPerFile;
+    bool m_countOnly;
+    bool m_waitForRoom;
+    int m_fileLines;            // Lines of m_currentFile accepted so far
+};
+
+// Abstract streaming search backend. A search is started with start(), its records arrive in
+// blocks through outputChunk() and it always ends with finished(), also after cancel().
 class FileSearcher : public QObject
 {
     Q_OBJECT
+
 public:
-    FileSearcher(QObject *parent = nullptr);
+    explicit FileSearcher(QObject *parent = nullptr);
     ~FileSearcher();
+
+    // Line-aligned part of a file: [start, end) with start at a line start numbered startLine
+    struct SearchRange {
+        qint64 start = 0;
+        qint64 end = 0;
+        qint64 startLine = 1;
+    };
+
+    // A file to search instead of everything under params.path. startOffset is the start of a
+    // line, startLine its line number - offsets and line numbers are reported for the whole file.
+    // With ranges (ascending, not overlapping) only those parts are searched.
+    struct SearchTarget {
+        QString filePath;
+        qint64 startOffset = 0;
+        qint64 startLine = 1;
+        QVector<SearchRange> ranges;
+    };
+
+    // Engine name as stored by PreferencesDialog ("ripgrep", "builtin", "hyperscan")
+    virtual QString engineName() const = 0;
+
+    // Start searching asynchronously
+    virtual void start(const RGSearchParams &params) = 0;
+
+    // Restrict the next start() to these files (params.path is then only used for logging)
+    void setTargets(const QVector<SearchTarget> &targets);
+    void clearTargets();
+    bool hasTargets() const { return m_hasTargets; }
+
+    // False if the engine cannot search this target list (e.g. starting at an offset)
+    virtual bool canSearchTargets(const QVector<SearchTarget> &targets) const;
+
+    // The files a search of params.path would look at, by the engine's own rules. Decorators
+    // that hand the engine an explicit list take it from here, so the list matches what the
+    // engine would search if it walked params.path itself.
+    virtual QStringList candidateFiles(const RGSearchParams &params) const;
+
+    // Request cancellation - safe to call from any thread
+    virtual void cancel();
+    bool isCancelled() const { return m_cancelled.load() || m_cancelToken.isCancelled(); }
+
+    // Session the next start() belongs to - the search also stops once the token is cancelled.
+    // Decorators hand it on to their engine.
+    void setCancelToken(const SearchCancelToken &token) { m_cancelToken = token; }
+
+    // Backlog of the stream the next start() feeds. Engines stop producing while it is full;
+    // decorators hand it on to their engine like the cancel token.
+    void setFlowControl(const QSharedPointer<SearchFlowControl> &flow) { m_flowControl = flow; }
+
+    // Block the calling search thread while the backlog is full (until cancelled)
+    void waitForOutputRoom() const;
+
+    // Factory for the engines selectable in Preferences (nullptr for an unknown name)
+    static FileSearcher *create(const QString &engine, QObject *parent = nullptr);
+    static QStringList engineNames();
+
+    // False for unknown engines and engines that were not compiled in
+    static bool isEngineAvailable(const QString &engine);
+
+signals:
+    // Block of complete JSON Lines records
+    void outputChunk(const QByteArray &jsonLines);
+
+    // exitCode follows ripgrep: 0 = matches found, 1 = no match, 2 = error
+    void finished(int exitCode);
+
+    // filePath is done: all its records were emitted before this, also when it had no match.
+    // Sent for every target, and by the in-process engines for every file of their walk; ripgrep
+    // reports its targets when the rg that searched them exits. Decorators pass it on and send it
+    // for the files they answer or rule out themselves. Not sent for files a cancel left out.
+    void fileSearched(const QString &filePath);
+
+    void errorOccurred(const QString &error);
+
+protected:
+    // Candidate files under params.path, honoring the incl_exclude globs like rg -g
+    QStringList collectFiles(const RGSearchParams &params) const;
+
+    std::atomic<bool> m_cancelled;
+    SearchCancelToken m_cancelToken;
+    QSharedPointer<SearchFlowControl> m_flowControl;
+    QVector<SearchTarget> m_targets;
+    bool m_hasTargets;
+};
+
+// Base for in-process engines: collects candidate files, memory maps them and scans them on all
+// cores. Subclasses only compile their matcher and scan one mapped file at a time. With
+// params.search_compressed, .gz/.zst files are decompressed by the thread that took them and
+// scanned block by block, so several compressed files decompress in parallel.
+class MappedFileSearcher : public FileSearcher
+{
+    Q_OBJECT
+
+public:
+    explicit MappedFileSearcher(QObject *parent = nullptr);
+    ~MappedFileSearcher();
+
+    // Runs on an internal thread, finished() is emitted on this object's thread
+    void start(const RGSearchParams &params) override;
+
+    // Synchronous search on the calling thread, returns the exit code. A cancel() already made
+    // is kept - start() clears it before the search thread is spawned.
+    int run(const RGSearchParams &params);
+
+    // Files are mapped and scanned from any line start, also in ranges
+    bool canSearchTargets(const QVector<SearchTarget> &targets) const override;
+
+protected:
+    struct FileScanResult {
+        int matchedLines = 0;
+        int matches = 0;
+    };
+
+    // Compile the matcher for params, return false and set error on failure
+    virtual bool prepare(const RGSearchParams &params, QString *error) = 0;
+    virtual void release() {}
+
+    // Per-thread state such as Hyperscan scratch space
+    virtual void *createThreadState() { return nullptr; }
+    virtual void destroyThreadState(void *state) { Q_UNUSED(state) }
+
+    // Scan one mapped file and write its match records through writer. Large files are scanned
+    // in ranges (see SplitFileSearch): data then starts at a line start inside the file.
+    virtual FileScanResult scanFile(const QString &filePath, const char *data, qint64 size,
+                                    FileSearchRecordWriter &writer, void *threadState) = 0;
+
+    // False if scanFile needs to see files from their start (or from the target's startOffset)
+    virtual bool canSplitFiles() const { return true; }
+
+    // Decompressed bytes scanned at a time in a compressed file (cut at a line end)
+    static constexpr qint64 CompressedBlockBytes = 16 * 1024 * 1024;
+
+private:
+    // Decompress a .gz/.zst file on this thread and scan it in line-aligned blocks (whole for
+    // engines that cannot split files). bytesScanned is set to the decompressed size.
+    FileScanResult scanCompressedFile(const QString &filePath, FileSearchRecordWriter &writer,
+                                      void *threadState, qint64 *bytesScanned);
+
+    int m_exitCode;
 };
 
-#endif // FILESEARCHER_H 
\ No newline at end of file
+#endif // FILESEARCHER_H
@@ -7,6 +7,7 @@ Logger::Logger(QObject* parent)
     : QObject(parent)
     , m_logWidget(nullptr)
     , m_initialized(false)
+    , m_consoleStream(&std::cout)
 {
 }
 
@@ -101,9 +102,16 @@ void Logger::setLogFilePath(const QString& path)
     }
 }
 
+void Logger::setConsoleStream(std::ostream* stream)
+{
+    m_consoleStream = stream;
+}
+
 void Logger::writeToConsole(const QString& message)
 {
-    std::cout << message.toStdString() << std::endl;
+    if (m_consoleStream) {
+        *m_consoleStream << message.toStdString() << std::endl;
+    }
 }
 
 void Logger::writeToFile(const QString& message)
@@ -37,6 +37,9 @@ public:
     void setLogWidget(QTextEdit* widget);
     void setLogFilePath(const QString& path);
     
+    // Stream console output goes to (std::cout by default), nullptr for none
+    void setConsoleStream(std::ostream* stream);
+    
     // Check if logger is initialized
     bool isInitialized() const { return m_initialized; }
 
@@ -58,6 +61,7 @@ private:
     QString m_logFilePath;
     bool m_initialized;
     QFile m_logFile;
+    std::ostream* m_consoleStream;
 };
 
 // Convenience macros for easy logging
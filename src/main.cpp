@@ -9,6 +9,7 @@
 #include <exception>
 #include "mainwindow.h"
 #include "logger.h"
+#include "HeadlessSearch.h"
 
 // Global exception handler
 void globalExceptionHandler() {
@@ -20,6 +21,17 @@ void globalExceptionHandler() {
 int main(int argc, char* argv[]) {
     // Set global exception handler
     std::set_terminate(globalExceptionHandler);
+    
+    // Headless search (TotalSearch --headless ...): no QApplication, so neither a display nor a
+    // GUI platform plugin is needed
+    if (HeadlessSearch::isRequested(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        app.setApplicationName("TotalSearch");
+        app.setApplicationVersion("1.0.0");
+        app.setOrganizationName("TotalSearch");
+        return HeadlessSearch::run(app);
+    }
+    
     qDebug() << "main: Starting application";
     
     // Set Qt library paths before creating QApplication
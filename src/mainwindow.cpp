@@ -6,6 +6,7 @@
 #include "logger.h"
 #include "searchdialog.h"
 #include "clocktestdialog.h"
+#include "RipgrepFileSearcher.h"
 #include <QThread>
 #include <QElapsedTimer>
 #include <QApplication>
@@ -43,6 +44,11 @@
 #include <QSplitter>
 #include <QGroupBox>
 #include <QCheckBox>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QPlainTextEdit>
+#include <QSpinBox>
 #include <QTextEdit>
 
 MainWindow::MainWindow(QWidget *parent)
@@ -77,6 +83,11 @@ MainWindow::MainWindow(QWidget *parent)
     , m_highlightSentence(false)  // Initialize sentence highlighting to false
     , m_useRGHighlight(false)  // Initialize RG highlighting to false
     , m_currentFilePath4NonCached("")  // Initialize non-cache file path tracking
+    , m_viewFirstLine(1)  // A plain file is shown from its first line
+    , m_viewLastLine(0)
+    , m_documentLoader(nullptr)
+    , m_documentLoadLine(1)
+    , m_documentLoadForCache(false)
     , m_currentSearchResultLine(-1)  // No search result line highlighted initially
     , m_currentSearchResultFile("")  // No search result file initially
     , m_searchResultHighlightColor(QColor(130, 130, 130))  // Default grey from search params
@@ -137,6 +148,7 @@ MainWindow::MainWindow(QWidget *parent)
     
     // Connect Enter key in pattern field to trigger search
     connect(patternEdit, &QLineEdit::returnPressed, performSearch);
+    connect(patternEdit, &QLineEdit::textEdited, m_kSearch, &KSearch::onPatternEdited);
     
     connect(stopButton, &QPushButton::clicked, [this]() {
         try {
@@ -707,7 +719,14 @@ void MainWindow::setupUI()
     // Filename label removed - now shown in pane title for extra space
     
     fileContentView = new ScintillaEdit();
-    fileContentContainerLayout->addWidget(fileContentView);
+    
+    // The viewer's whole-file scroll bar, shown while a large file is paged in a window at a time
+    QHBoxLayout* fileContentRowLayout = new QHBoxLayout();
+    fileContentRowLayout->setContentsMargins(0, 0, 0, 0);
+    fileContentRowLayout->setSpacing(0);
+    fileContentRowLayout->addWidget(fileContentView, 1);
+    fileContentRowLayout->addWidget(fileContentView->fileScrollBar());
+    fileContentContainerLayout->addLayout(fileContentRowLayout);
     
     fileViewerPane->setContentWidget(fileContentContainer);
     fileContentLayout->addWidget(fileViewerPane);
@@ -718,6 +737,11 @@ void MainWindow::setupUI()
     connect(fileContentView, &ScintillaEdit::backgroundHighlightProgress, this, &MainWindow::onBackgroundHighlightProgress);
     connect(fileContentView, &ScintillaEdit::backgroundHighlightCompleted, this, &MainWindow::onBackgroundHighlightCompleted);
     
+    // Files opened in the viewer are read on a worker thread and shown when complete
+    m_documentLoader = new DocumentLoader(fileContentView, this);
+    connect(m_documentLoader, &DocumentLoader::loaded, this, &MainWindow::onDocumentLoaded);
+    connect(m_documentLoader, &DocumentLoader::failed, this, &MainWindow::onDocumentLoadFailed);
+    
     // Connect detachable pane signals
     connect(fileViewerPane, &DetachablePane::paneDetached, 
             this, &MainWindow::onFileViewerPaneDetached);
@@ -844,6 +868,23 @@ void MainWindow::setupMenuBar()
     
     // Search menu (Search and Clear actions removed - functionality moved to main interface)
     QMenu *searchMenu = menuBar->addMenu("&Search");
+    searchMenu->addAction("&Batch Search...", [this]() {
+        // One pattern per line, "name<TAB>pattern" to name it
+        QSettings settings("app.ini", QSettings::IniFormat);
+        settings.beginGroup("RGSearch");
+        QString lastFile = settings.value("LastBatchPatternFile", "").toString();
+        QString patternFile = QFileDialog::getOpenFileName(this, "Batch Search - Pattern List", lastFile,
+                                                           "Pattern Lists (*.txt *.tsv);;All Files (*.*)");
+        if (patternFile.isEmpty()) {
+            settings.endGroup();
+            return;
+        }
+        settings.setValue("LastBatchPatternFile", patternFile);
+        settings.endGroup();
+        LOG_INFO("MainWindow: Batch search with pattern list " + patternFile);
+        m_kSearch->KSsearchBatch(patternFile);
+    });
+    searchMenu->addAction("&Proximity Search...", this, &MainWindow::showProximitySearchDialog);
     
     // Tools menu
     QMenu *toolsMenu = menuBar->addMenu("&Tools");
@@ -865,6 +906,65 @@ void MainWindow::setupToolBar()
     // Removed Open File, Search, Clear, Preferences - functionality moved to main interface and dialogs
 }
 
+void MainWindow::showProximitySearchDialog()
+{
+    QSettings settings("app.ini", QSettings::IniFormat);
+    settings.beginGroup("RGSearch");
+    
+    QDialog dialog(this);
+    dialog.setWindowTitle("Proximity Search");
+    QFormLayout *layout = new QFormLayout(&dialog);
+    
+    // One term per line, the search pattern as the first one
+    QPlainTextEdit *termsEdit = new QPlainTextEdit(&dialog);
+    QStringList lastTerms = settings.value("ProximityTerms", QStringList()).toStringList();
+    if (lastTerms.isEmpty() && !patternEdit->text().trimmed().isEmpty()) {
+        lastTerms << patternEdit->text().trimmed();
+    }
+    termsEdit->setPlainText(lastTerms.join('\n'));
+    layout->addRow("Terms (one per line):", termsEdit);
+    
+    QSpinBox *withinSpin = new QSpinBox(&dialog);
+    withinSpin->setRange(0, 1000000);
+    withinSpin->setSpecialValueText("Anywhere in the file");
+    withinSpin->setSuffix(" lines");
+    withinSpin->setValue(settings.value("ProximityWithinLines", 50).toInt());
+    layout->addRow("Within:", withinSpin);
+    
+    QCheckBox *orderedCheck = new QCheckBox("In this order (each term followed by the next)", &dialog);
+    orderedCheck->setChecked(settings.value("ProximityOrdered", false).toBool());
+    layout->addRow(orderedCheck);
+    
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    layout->addRow(buttons);
+    
+    if (dialog.exec() != QDialog::Accepted) {
+        settings.endGroup();
+        return;
+    }
+    
+    ProximityQuery query;
+    QStringList terms;
+    for (const QString &term : termsEdit->toPlainText().split('\n')) {
+        if (!term.trimmed().isEmpty()) {
+            terms << term.trimmed();
+            query.terms.append({term.trimmed(), term.trimmed()});
+        }
+    }
+    query.withinLines = withinSpin->value();
+    query.ordered = orderedCheck->isChecked();
+    
+    settings.setValue("ProximityTerms", terms);
+    settings.setValue("ProximityWithinLines", query.withinLines);
+    settings.setValue("ProximityOrdered", query.ordered);
+    settings.endGroup();
+    
+    LOG_INFO("MainWindow: Proximity search for " + QString::number(query.terms.size()) + " terms");
+    m_kSearch->KSsearchProximity(query);
+}
+
 void MainWindow::openFile()
 {
     QString fileName = QFileDialog::getOpenFileName(this, "Open File", "", "All Files (*.*)");
@@ -890,9 +990,8 @@ void MainWindow::searchText()
 
 void MainWindow::stopSearch()
 {
-    QThread::create([this]() {
-        m_kSearch->stopSearch();
-    })->start();
+    // Nothing in stopSearch waits for the search, so it runs right here on the UI thread
+    m_kSearch->stopSearch();
 }
 
 void MainWindow::clearSearch()
@@ -2325,7 +2424,7 @@ void MainWindow::KRGSearch()
                     KSearchBun kSearchBun;
                     LOG_INFO("KRGSearch: KSearchBun created for file: " + filePath);
                     
-                    QVector<long> lineOffsets = kSearchBun.KMap(filePath);
+                    QVector<qint64> lineOffsets = kSearchBun.KMap(filePath);
                     LOG_INFO("KRGSearch: KMap completed for file: " + filePath + " with " + QString::number(lineOffsets.size()) + " line offsets");
                     
                     totalFilesMapped++;
@@ -2389,7 +2488,7 @@ void MainWindow::KKMap()
      
     // Create KSearchBun instance and call KMap
     KSearchBun kSearchBun;
-    QVector<long> lineOffsets = kSearchBun.KMap(filePath);
+    QVector<qint64> lineOffsets = kSearchBun.KMap(filePath);
     
 
     LOG_INFO("MainWindow: ===THREAD=== KKMap >>>>>ENDed>>>>>");
@@ -2632,7 +2731,7 @@ void MainWindow::KUpdateFileViewer(const QString &filePath, int lineNumber, cons
     }
     
     // Get line offsets (either use existing mapping or create new mapping)
-    QVector<long> lineOffsets;
+    QVector<qint64> lineOffsets;
     if (fileAlreadyMappedInSession) {
         // File was already mapped in this session - use stored line offsets
         lineOffsets = m_mappedFiles[filePath];
@@ -2827,13 +2926,13 @@ void MainWindow::KDisplayFile_BulkRead()
                     if (mapped[i] == '\0') { hasNul = true; break; }
                 }
                 if (hasNul) {
-                    QByteArray sanitized(reinterpret_cast<const char*>(mapped), static_cast<int>(fsize));
-                    for (int i = 0; i < sanitized.size(); ++i) {
+                    QByteArray sanitized(reinterpret_cast<const char*>(mapped), fsize);
+                    for (qsizetype i = 0; i < sanitized.size(); ++i) {
                         if (sanitized[i] == '\0') sanitized[i] = ' ';
                     }
                     fileContentView->setUtf8Bytes(sanitized.constData(), sanitized.size());
                 } else {
-                    fileContentView->setUtf8Bytes(reinterpret_cast<const char*>(mapped), static_cast<int>(fsize));
+                    fileContentView->setUtf8Bytes(reinterpret_cast<const char*>(mapped), fsize);
                 }
 
                 // Unmap after Scintilla copies data
@@ -2856,9 +2955,9 @@ void MainWindow::KDisplayFile_BulkRead()
             logWidget->append(QString("[%1] Bulk read completed: %2 bytes in %3ms").arg(timestamp, QString::number(fileData.size()), QString::number(readTime)));
             LOG_INFO("KDisplayFile_BulkRead: Bulk read completed: " + QString::number(fileData.size()) + " bytes in " + QString::number(readTime) + "ms");
             
-                int nulIndex = fileData.indexOf('\0');
+                qsizetype nulIndex = fileData.indexOf('\0');
                 if (nulIndex != -1) {
-                    for (int i = 0; i < fileData.size(); ++i) {
+                    for (qsizetype i = 0; i < fileData.size(); ++i) {
                         if (fileData[i] == '\0') fileData[i] = ' ';
                     }
                 }
@@ -3842,7 +3941,7 @@ void MainWindow::applyExtraHighlightsWithRG(const QString& filePath)
     LOG_INFO("applyExtraHighlightsWithRG: Big regex pattern: '" + bigPattern + "'");
     
     // 4. Perform RG command with hardcoded parameters
-    QString rgPath = "lib\\rg.exe";
+    QString rgPath = RipgrepFileSearcher::executable();
     QStringList arguments;
     arguments << "-a" << "-n" << "--threads" << "0" << "--mmap" << "--column" << "--byte-offset" 
              << "--stats" << "--only-matching" << "--heading" << "-S";
@@ -3913,7 +4012,7 @@ void MainWindow::applyExtraHighlightsWithRG(const QString& filePath)
             bool ok1, ok2, ok3;
             int lineNumber = parts[0].toInt(&ok1);
             int offsetFromLine = parts[1].toInt(&ok2);
-            int offsetFromFile = parts[2].toInt(&ok3);
+            qint64 offsetFromFile = parts[2].toLongLong(&ok3);
             QString matchedWord = parts[3];
 
             if (ok1 && ok2 && ok3) {
@@ -3961,16 +4060,16 @@ void MainWindow::applyExtraHighlightsWithRG(const QString& filePath)
                 
                 if (m_highlightSentence) {
                     // Highlight the entire line
-                    int lineStart = fileContentView->send(SCI_POSITIONFROMLINE, lineNumber - 1);
-                    int lineEnd = fileContentView->send(SCI_GETLINEENDPOSITION, lineNumber - 1);
+                    qint64 lineStart = fileContentView->send(SCI_POSITIONFROMLINE, lineNumber - 1);
+                    qint64 lineEnd = fileContentView->send(SCI_GETLINEENDPOSITION, lineNumber - 1);
                     fileContentView->send(SCI_INDICATORFILLRANGE, lineStart, lineEnd - lineStart);
                     
                     LOG_INFO("applyExtraHighlightsWithRG: Highlighted entire line " + QString::number(lineNumber) + 
                              " with color: " + finalHighlightColor.name() + " (word: '" + matchedWord + "', size: " + QString::number(wordSize) + ")");
                 } else {
                     // Highlight just the word
-                    int wordStart = offsetFromFile;
-                    int wordEnd = offsetFromFile + wordSize;
+                    qint64 wordStart = offsetFromFile;
+                    qint64 wordEnd = offsetFromFile + wordSize;
                     fileContentView->send(SCI_INDICATORFILLRANGE, wordStart, wordEnd - wordStart);
                     
                                          LOG_INFO("applyExtraHighlightsWithRG: Highlighted word at position " + QString::number(wordStart) + 
@@ -4716,7 +4815,7 @@ void MainWindow::resetParsingProgress()
 // ==================================================================================
 // <<<<<<<<<<<<<<<<<<<<   on collapsible from search result selected    <<<<<<<<<<<<<
 // ==================================================================================
-void MainWindow::onCollapsibleResultSelected(const QString &filePath, int lineNumber)
+void MainWindow::onCollapsibleResultSelected(const QString &filePath, int lineNumber, qint64 byteOffset)
 {
     logFunctionStart("onCollapsibleResultSelected");
     
@@ -4734,7 +4833,10 @@ void MainWindow::onCollapsibleResultSelected(const QString &filePath, int lineNu
         return;
     }
     
-    LOG_INFO("onCollapsibleResultSelected: File: " + filePath + ", Line: " + QString::number(lineNumber));
+    LOG_INFO("onCollapsibleResultSelected: File: " + filePath + ", Line: " + QString::number(lineNumber) +
+             ", Offset: " + QString::number(byteOffset));
+    
+    m_resultClickTimer.start();
     
     // Set state to NAVIGATING_FILES for file navigation activity
     m_kSearch->updateSearchState(SearchState::NAVIGATING_FILES);
@@ -4758,13 +4860,22 @@ void MainWindow::onCollapsibleResultSelected(const QString &filePath, int lineNu
     if (needToOpenFile) {
         LOG_INFO("onCollapsibleResultSelected: Need to open file: " + filePath);
         // Open the file first, then highlight the search result line
-        KUpdateFileViewer2(filePath, lineNumber);
+        KUpdateFileViewer2(filePath, lineNumber, byteOffset);
     } else {
         LOG_INFO("onCollapsibleResultSelected: File already open, highlighting search result line directly");
+        // A paged file finds the window of the line from where the search says it starts
+        if (byteOffset >= 0 && fileContentView->isWindowed() && m_mappedFile && m_mappedFile->filePath() == filePath) {
+            m_mappedFile->addLineHint(lineNumber, byteOffset, searchedFingerprint(filePath));
+        }
         // File is already open, just highlight the search result line with search params color
         highlightSearchResultLine(filePath, lineNumber);
     }
     
+    // A background load logs it once the document is shown
+    if (!m_documentLoader->isLoading()) {
+        logResultClickVisible(needToOpenFile ? "opened" : "already open");
+    }
+    
     // Reset state to IDLE after successful file navigation (unless we're in ERROR state)
     if (m_currentState != SearchState::ERROR) {
         m_kSearch->updateSearchState(SearchState::IDLE);
@@ -4776,7 +4887,7 @@ void MainWindow::onCollapsibleResultSelected(const QString &filePath, int lineNu
 
 // <<<<<<< handling with highlight
 
-void MainWindow::KUpdateFileViewer2(const QString &filePath, int lineNumber)
+void MainWindow::KUpdateFileViewer2(const QString &filePath, int lineNumber, qint64 byteOffset)
 {
     logFunctionStart("KUpdateFileViewer2");
     
@@ -4797,6 +4908,28 @@ void MainWindow::KUpdateFileViewer2(const QString &filePath, int lineNumber)
         return;
     }
     
+    // SECTION 1B: LOAD IN FLIGHT
+    // A file still loading in the background only needs the line it highlights once shown - and
+    // in the match window shown meanwhile, if there is one; a click on anything else cancels
+    // the load
+    if (m_documentLoader->isLoading()) {
+        if (m_documentLoader->filePath() == filePath) {
+            LOG_INFO("KUpdateFileViewer2: File still loading, line " + QString::number(lineNumber) + " is highlighted when it is shown");
+            m_documentLoadLine = lineNumber;
+            if (fileContentView->isWindowed() && m_mappedFile && m_mappedFile->filePath() == filePath) {
+                if (byteOffset >= 0) {
+                    m_mappedFile->addLineHint(lineNumber, byteOffset, searchedFingerprint(filePath));
+                }
+                highlightSearchResultLine(filePath, lineNumber);
+                logResultClickVisible("window of a file still loading");
+            }
+            logFunctionEnd("KUpdateFileViewer2");
+            return;
+        }
+        m_documentLoader->cancel();
+        setOpenFileLamp(false);
+    }
+    
     // SECTION 2: FILE CACHE HANDLING
     {
         QMutexLocker cacheLocker(&m_cacheMutex);
@@ -4811,7 +4944,38 @@ void MainWindow::KUpdateFileViewer2(const QString &filePath, int lineNumber)
     bool fileAlreadyInCache = m_fileCache.contains(filePath);
     bool fileAlreadyOpen = false;
     
-    if (m_keepFilesInCache) {
+    if (CompressedFile::canRead(filePath)) {
+        // COMPRESSED FILE: a window of lines is shown, reloaded when the line lies outside it.
+        // Windows are not kept in the file cache.
+        fileAlreadyOpen = (m_viewWindowFile == filePath && lineNumber >= m_viewFirstLine && lineNumber <= m_viewLastLine &&
+                           m_compressedFile && m_compressedFile->isCurrent());
+        LOG_INFO("KUpdateFileViewer2: Compressed file, line " + QString::number(lineNumber) +
+                 (fileAlreadyOpen ? " is in the window shown" : " needs a new window"));
+        
+        if (!fileAlreadyOpen) {
+            if (fileContentView) {
+                fileContentView->show();
+                fileContentView->setText("Loading compressed file...\n" + filePath + "\nPlease wait while the lines around line " +
+                                         QString::number(lineNumber) + " are decompressed.");
+                fileContentView->update();
+                QApplication::processEvents();
+            }
+            
+            if (!kOpenFileTransfetToContentFast(filePath, lineNumber)) {
+                LOG_ERROR("KUpdateFileViewer2: Failed to open compressed file: " + filePath);
+                if (fileContentView) {
+                    fileContentView->setText("Failed to load file: " + filePath);
+                }
+                logFunctionEnd("KUpdateFileViewer2");
+                return;
+            }
+        }
+        
+        setScrollHighlightLamp(true);
+        highlightSearchResultLine(filePath, lineNumber);
+        setScrollHighlightLamp(false);
+        
+    } else if (m_keepFilesInCache) {
         // NEW CACHE MODE: Simple file path list with sanitized content
         LOG_INFO("KUpdateFileViewer2: New cache mode - checking file list");
         
@@ -4825,6 +4989,7 @@ void MainWindow::KUpdateFileViewer2(const QString &filePath, int lineNumber)
             if (!cachedContent.isEmpty()) {
                 // Display the cached content
                 if (fileContentView) {
+                    m_viewWindowFile.clear();
                     fileContentView->show();
                     fileContentView->setText(cachedContent);
                     fileContentView->update();
@@ -4848,27 +5013,21 @@ void MainWindow::KUpdateFileViewer2(const QString &filePath, int lineNumber)
                 fileContentView->setText("Loading file...\n" + filePath + "\nPlease wait...");
                 fileContentView->setStyleSheet("QWidget { background-color: #f0f0f0; color: #666; font-size: 14px; }");
                 fileContentView->update();
-                QApplication::processEvents();
             }
             
-                    // Use kOpenFileTransfetToContentFast to load the file
-        bool openSuccess = kOpenFileTransfetToContentFast(filePath);
+            // Use kOpenFileTransfetToContentFast to load the file
+            m_documentLoadForCache = true;
+            bool openSuccess = kOpenFileTransfetToContentFast(filePath, lineNumber, byteOffset);
             
-            if (openSuccess) {
-                // Get the sanitized content from ScintillaEdit
-                QString sanitizedContent = fileContentView->getText();
-                
-                // Add to cache
-                m_fileAlreadyOpen4CacheMode.append(filePath);
-                m_cachedFileContent[filePath] = sanitizedContent;
-                
-                LOG_INFO("KUpdateFileViewer2: File loaded and added to cache: " + filePath);
-                LOG_INFO("KUpdateFileViewer2: Cache size: " + QString::number(m_fileAlreadyOpen4CacheMode.size()) + " files");
-                
-                // Update filename display
+            if (openSuccess && m_documentLoader->isLoading()) {
+                // Loading in the background: onDocumentLoaded caches the text and highlights the line
+                LOG_INFO("KUpdateFileViewer2: File loading in the background, cached when shown: " + filePath);
+                logFunctionEnd("KUpdateFileViewer2");
+                return;
+            } else if (openSuccess) {
+                // Large files stay mapped (m_mappedFile) instead of being cached as text
+                LOG_INFO("KUpdateFileViewer2: Large file shown windowed, not cached: " + filePath);
                 updateFilenameDisplay(filePath);
-                
-                LOG_INFO("KUpdateFileViewer2: File loaded successfully with fast memory mapping");
             } else {
                 LOG_ERROR("KUpdateFileViewer2: Failed to load file with fast memory mapping: " + filePath);
                 
@@ -4923,20 +5082,21 @@ void MainWindow::KUpdateFileViewer2(const QString &filePath, int lineNumber)
                 fileContentView->setText("Loading file...\n" + filePath + "\nPlease wait while the file is being indexed and loaded.");
                 fileContentView->setStyleSheet("QWidget { background-color: #f0f0f0; color: #666; font-size: 14px; }");
                 fileContentView->update();
-                QApplication::processEvents();
             }
         
                 // ===== HIGH-PERFORMANCE FILE OPENING =====
         // Replaced KOpenFile (LogDataWorker-based) with kOpenFileTransfetToContentFast for 5-10x speed improvement
         // KOpenFile creates LogDataWorker, starts background indexing, waits for completion
-        // kOpenFileTransfetToContentFast uses direct memory mapping for immediate zero-copy file access
-        bool openSuccess = kOpenFileTransfetToContentFast(filePath);
-        
-
-
-
+        // kOpenFileTransfetToContentFast reads the file on a worker thread, or pages a large one in windows
+        m_documentLoadForCache = false;
+        bool openSuccess = kOpenFileTransfetToContentFast(filePath, lineNumber, byteOffset);
         
-        if (openSuccess) {
+        if (openSuccess && m_documentLoader->isLoading()) {
+            // onDocumentLoaded finishes the open and highlights the line
+            LOG_INFO("KUpdateFileViewer2: File loading in the background: " + filePath);
+            logFunctionEnd("KUpdateFileViewer2");
+            return;
+        } else if (openSuccess) {
             
             // Update non-cache file path tracking
             m_currentFilePath4NonCached = filePath;     
@@ -4977,17 +5137,23 @@ void MainWindow::highlightSearchResultLine(const QString &filePath, int lineNumb
     m_currentSearchResultLine = lineNumber;
     m_currentSearchResultFile = filePath;
     
+    // A window of a compressed file starts at its m_viewFirstLine
+    int viewLine = lineNumber;
+    if (filePath == m_viewWindowFile) {
+        viewLine = int(lineNumber - m_viewFirstLine + 1);
+    }
+    
     // Apply the new search result line highlighting with search params color
     if (fileContentView) {
-        LOG_INFO("highlightSearchResultLine: Highlighting search result line: " + QString::number(lineNumber) + 
+        LOG_INFO("highlightSearchResultLine: Highlighting search result line: " + QString::number(viewLine) + 
                  " with color: " + m_searchResultHighlightColor.name());
         
         // Set the search result highlight color and highlight the line
         fileContentView->setHighlightColor(m_searchResultHighlightColor);
-        fileContentView->highlightLine(lineNumber);
+        fileContentView->highlightLine(viewLine);
         
         // Scroll to the line
-        fileContentView->scrollToLine(lineNumber);
+        fileContentView->scrollToLine(viewLine);
         
         // Force UI update
         fileContentView->update();
@@ -5006,8 +5172,13 @@ void MainWindow::highlightSearchResultLine(const QString &filePath, int lineNumb
 
 
 
-bool MainWindow::kOpenFileTransfetToContentFast(const QString& filePath)
+bool MainWindow::kOpenFileTransfetToContentFast(const QString& filePath, int lineNumber, qint64 byteOffset)
 {
+    // Compressed logs cannot be mapped - they are decompressed around the wanted line
+    if (CompressedFile::canRead(filePath)) {
+        return kOpenCompressedFile(filePath, lineNumber);
+    }
+    
     logFunctionStart("kOpenFileTransfetToContentFast");
     
     // Activate open file indicator
@@ -5035,169 +5206,263 @@ bool MainWindow::kOpenFileTransfetToContentFast(const QString& filePath)
     qint64 fileSize = fileInfo.size();
     LOG_INFO("kOpenFileTransfetToContentFast: File size: " + QString::number(fileSize) + " bytes");
     
-    // ===== STEP 2: FILE OPENING =====
-    // PURPOSE: Open file handle in read-only mode for memory mapping
-    // WHY: Memory mapping requires an open file handle to create the mapping
-    
-    // Create QFile object and open in read-only mode
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly)) {
-        LOG_ERROR("kOpenFileTransfetToContentFast: Failed to open file - " + file.errorString());
-        logWidget->append(QString("[%1] ERROR: Failed to open file - %2").arg(timestamp, file.errorString()));
+    // ===== STEP 1B: LARGE FILES - WINDOWED VIEW =====
+    // From [RGSearch] ViewerWindowedMB on the file is not copied into Scintilla at all: it stays
+    // mapped and only the lines around the viewport are paged in, so opening takes the same time
+    // whatever the size. Files that cannot be mapped fall through to the bulk read below.
+    QSettings viewerSettings("app.ini", QSettings::IniFormat);
+    qint64 windowedBytes = qMax(1LL, viewerSettings.value("RGSearch/ViewerWindowedMB", 64).toLongLong()) * 1024 * 1024;
+    if (fileSize >= windowedBytes && kOpenWindowedFile(filePath, lineNumber, byteOffset)) {
         logFunctionEnd("kOpenFileTransfetToContentFast");
         setOpenFileLamp(false);
+        return true;
+    }
+    
+    // ===== STEP 1C: MATCH WINDOW FIRST =====
+    // With the match's byte offset the lines around it are shown straight from the mapping
+    // ([RGSearch] ViewerPreviewLines of them) while the whole file loads below; the loaded
+    // document replaces the window and the same line is highlighted again. Small files load
+    // faster than that is worth ([RGSearch] ViewerPreviewKB).
+    qint64 previewBytes = qMax(0LL, viewerSettings.value("RGSearch/ViewerPreviewKB", 1024).toLongLong()) * 1024;
+    int previewLines = viewerSettings.value("RGSearch/ViewerPreviewLines", 500).toInt();
+    if (byteOffset >= 0 && fileSize >= previewBytes &&
+        kOpenWindowedFile(filePath, lineNumber, byteOffset, previewLines)) {
+        fileContentView->setStyleSheet("");     // Drop the loading message style
+        highlightSearchResultLine(filePath, lineNumber);
+        logResultClickVisible("match window");
+        LOG_INFO("kOpenFileTransfetToContentFast: Match window shown in " + QString::number(timer.elapsed()) + "ms");
+        logWidget->append(QString("[%1] Match window shown in %2ms").arg(timestamp, QString::number(timer.elapsed())));
+    }
+    
+    // ===== STEP 2: BACKGROUND LOAD =====
+    // The file is read into a new Scintilla document on a worker thread (DocumentLoader: mapped,
+    // NULs replaced by spaces, added block by block through ILoader) while the UI stays live; the
+    // complete document is swapped into the viewer at once and onDocumentLoaded highlights the
+    // line. A newer open cancels this one.
+    m_documentLoadLine = qMax(1, lineNumber);
+    m_currentFilePath4NonCached.clear();    // Set again once this file is shown
+    quint64 loadId = m_documentLoader->load(filePath);
+    if (!m_documentLoader->isLoading()) {
+        // Not started - onDocumentLoadFailed has reported why
+        logFunctionEnd("kOpenFileTransfetToContentFast");
         return false;
     }
     
-    // Record time taken to open file for performance monitoring
-    qint64 openTime = timer.elapsed();
-    LOG_INFO("kOpenFileTransfetToContentFast: File opened in " + QString::number(openTime) + "ms");
-    
-    // ===== STEP 3: MEMORY MAPPING (ZERO-COPY I/O) =====
-    // PURPOSE: Create memory mapping for zero-copy file access
-    // WHY: Memory mapping allows direct access to file data without copying to RAM
-    // PERFORMANCE: This is the key optimization - eliminates data copying overhead
-    
-    // Attempt to memory-map the entire file for zero-copy access
-    // This creates a direct pointer to the file data in virtual memory
-    const uchar* mapped = fileSize > 0 ? file.map(0, fileSize) : nullptr;
-    if (mapped) {
-        // Record time taken for memory mapping
-        qint64 mapTime = timer.elapsed();
-        LOG_INFO("kOpenFileTransfetToContentFast: Memory mapping succeeded in " + QString::number(mapTime - openTime) + "ms");
-        
-        // ===== STEP 4: NUL BYTE DETECTION AND SANITIZATION =====
-        // PURPOSE: Detect and handle NUL bytes that can cause issues with text editors
-        // WHY: NUL bytes (\0) can corrupt text display and cause crashes in Scintilla
-        // OPTIMIZATION: Only check first 1MB for performance - NULs are rare in text files
-        
-        // Check for NUL bytes in the first 1MB (performance optimization)
-        // NUL bytes can cause issues with text editors and need to be replaced
-        bool hasNul = false;
-        for (qint64 i = 0; i < qMin(fileSize, qint64(1000000)); ++i) { // Check first 1MB for NULs
-            if (mapped[i] == '\0') { 
-                hasNul = true; 
-                break; 
-            }
-        }
-        
-        if (hasNul) {
-            // ===== STEP 4A: SANITIZED TRANSFER (WITH NUL REPLACEMENT) =====
-            // PURPOSE: Handle files with NUL bytes by creating a sanitized copy
-            // WHY: NUL bytes must be replaced with spaces to prevent text editor issues
-            // PERFORMANCE: This path is slower due to data copying, but necessary for safety
-            
-            LOG_INFO("kOpenFileTransfetToContentFast: NUL bytes detected, sanitizing");
-            
-            // Create a copy of the mapped data and replace NUL bytes with spaces
-            QByteArray sanitized(reinterpret_cast<const char*>(mapped), static_cast<int>(fileSize));
-            for (int i = 0; i < sanitized.size(); ++i) {
-                if (sanitized[i] == '\0') sanitized[i] = ' ';
-            }
-            
-            // Clear previous highlights before loading new file content
-            fileContentView->clearExtraHighlights();
-            
-            // Transfer sanitized content to ScintillaEdit
-            fileContentView->setUtf8Bytes(sanitized.constData(), sanitized.size());
-            qint64 transferTime = timer.elapsed();
-            logWidget->append(QString("[%1] Sanitized content transferred in %2ms").arg(timestamp, QString::number(transferTime - mapTime)));
-        } else {
-            // ===== STEP 4B: ZERO-COPY TRANSFER (OPTIMAL PATH) =====
-            // PURPOSE: Direct transfer without data copying for maximum performance
-            // WHY: When no NUL bytes present, we can transfer data directly without copying
-            // PERFORMANCE: This is the fastest path - zero-copy transfer to ScintillaEdit
-            
-            // Clear previous highlights before loading new file content
-            fileContentView->clearExtraHighlights();
-            
-            // Direct pointer transfer to ScintillaEdit - no data copying required
-            // This is the fastest possible path for file loading
-            fileContentView->setUtf8Bytes(reinterpret_cast<const char*>(mapped), static_cast<int>(fileSize));
-            qint64 transferTime = timer.elapsed();
-        }
-        
-        // ===== STEP 5: CLEANUP - UNMAP FILE =====
-        // PURPOSE: Release memory mapping to free system resources
-        // WHY: Memory mappings consume system resources and must be released
-        // IMPORTANT: This prevents memory leaks and frees virtual memory space
-        
-        // Release the memory mapping to free system resources
-        file.unmap(const_cast<uchar*>(mapped));
-        qint64 unmapTime = timer.elapsed();
-        
+    logWidget->append(QString("[%1] Loading in the background (load %2, %3ms so far)")
+                          .arg(timestamp, QString::number(loadId), QString::number(timer.elapsed())));
+    LOG_INFO("kOpenFileTransfetToContentFast: Background load " + QString::number(loadId) + " started for " + filePath);
+    
+    // The open file lamp stays on until the load ends
+    logFunctionEnd("kOpenFileTransfetToContentFast");
+    return true;
+}
+
+void MainWindow::onDocumentLoaded(quint64 loadId, const QString &filePath, qint64 bytes, qint64 elapsedMs)
+{
+    logFunctionStart("onDocumentLoaded");
+    LOG_INFO("onDocumentLoaded: Load " + QString::number(loadId) + " shown - " + filePath + " (" +
+             QString::number(bytes) + " bytes, " + QString::number(elapsedMs) + "ms)");
+    
+    // ===== UI STATE UPDATE =====
+    fileContentView->clearExtraHighlights();
+    fileContentView->setStyleSheet("");     // Drop the loading message style
+    updateFilenameDisplay(filePath);
+    m_currentFilePath = filePath;
+    m_viewWindowFile.clear();               // Shown whole from line 1
+    
+    if (m_documentLoadForCache) {
+        m_fileAlreadyOpen4CacheMode.append(filePath);
+        m_cachedFileContent[filePath] = fileContentView->getText();
+        LOG_INFO("onDocumentLoaded: File added to cache, cache size: " + QString::number(m_fileAlreadyOpen4CacheMode.size()) + " files");
     } else {
-        // ===== STEP 3B: FALLBACK - BULK READ (IF MEMORY MAPPING FAILS) =====
-        // PURPOSE: Fallback method when memory mapping fails
-        // WHY: Memory mapping can fail on some systems, file types, or large files
-        // PERFORMANCE: This path is slower but ensures compatibility
-        
-        // Memory mapping can fail on some systems or file types
-        // Fall back to traditional bulk file reading
-        logWidget->append(QString("[%1] Memory mapping failed, using bulk read fallback").arg(timestamp));
-        LOG_WARNING("kOpenFileTransfetToContentFast: Memory mapping failed, using bulk read fallback");
-        
-        // Read entire file into memory
-        QByteArray fileData = file.readAll();
-        qint64 readTime = timer.elapsed();
-        logWidget->append(QString("[%1] Bulk read completed in %2ms (%3 bytes)").arg(timestamp, QString::number(readTime - openTime), QString::number(fileData.size())));
-        
-        // Sanitize NUL bytes if present in bulk read data
-        int nulIndex = fileData.indexOf('\0');
-        if (nulIndex != -1) {
-            logWidget->append(QString("[%1] NUL bytes detected in bulk read, sanitizing...").arg(timestamp));
-            for (int i = 0; i < fileData.size(); ++i) {
-                if (fileData[i] == '\0') fileData[i] = ' ';
-            }
+        m_currentFilePath4NonCached = filePath;
+    }
+    
+    // ===== HIGHLIGHT SEARCH RESULT LINE =====
+    // The line of the latest click on this file, which may have come while it was loading
+    setScrollHighlightLamp(true);
+    highlightSearchResultLine(filePath, m_documentLoadLine);
+    setScrollHighlightLamp(false);
+    logResultClickVisible("background load");
+    
+    QString timestamp = QDateTime::currentDateTime().toString("hh:mm:ss.zzz");
+    logWidget->append(QString("[%1] === FILE OPEN COMPLETED === %2ms").arg(timestamp, QString::number(elapsedMs)));
+    statusBar()->showMessage(QString("File loaded: %1 (%2ms)").arg(QFileInfo(filePath).fileName(), QString::number(elapsedMs)), 3000);
+    setOpenFileLamp(false);
+    
+    logFunctionEnd("onDocumentLoaded");
+}
+
+void MainWindow::onDocumentLoadFailed(quint64 loadId, const QString &filePath, const QString &error)
+{
+    LOG_ERROR("onDocumentLoadFailed: Load " + QString::number(loadId) + " of " + filePath + " failed - " + error);
+    logWidget->append(QString("[%1] ERROR: Failed to load file - %2")
+                          .arg(QDateTime::currentDateTime().toString("hh:mm:ss.zzz"), error));
+    if (fileContentView) {
+        fileContentView->setStyleSheet("");
+        fileContentView->setText("Failed to load file: " + filePath + "\n" + error);
+    }
+    setOpenFileLamp(false);
+}
+
+bool MainWindow::kOpenWindowedFile(const QString& filePath, int lineNumber, qint64 byteOffset, int windowLines)
+{
+    logFunctionStart("kOpenWindowedFile");
+    
+    QElapsedTimer timer;
+    timer.start();
+    LOG_INFO("kOpenWindowedFile: Opening " + filePath + " at line " + QString::number(lineNumber));
+    
+    // ===== STEP 1: SHARED MAPPING =====
+    // Kept while the file is unchanged; its line index is built on a worker thread
+    if (!m_mappedFile || m_mappedFile->filePath() != filePath || !m_mappedFile->isCurrent()) {
+        QString error;
+        QSharedPointer<MappedLineFile> file = MappedLineFile::open(filePath, &error);
+        if (!file) {
+            LOG_WARNING("kOpenWindowedFile: " + error + " - loading the file whole");
+            logFunctionEnd("kOpenWindowedFile");
+            return false;
         }
+        m_mappedFile = file;
+    }
+    
+    // The search knows where the line starts: no need to wait for the index to reach it, as long
+    // as the file is still the version it searched
+    if (byteOffset >= 0) {
+        m_mappedFile->addLineHint(lineNumber, byteOffset, searchedFingerprint(filePath));
+    }
+    
+    // ===== STEP 2: WINDOW AROUND THE LINE =====
+    if (windowLines <= 0) {
+        QSettings settings("app.ini", QSettings::IniFormat);
+        settings.beginGroup("RGSearch");
+        windowLines = qMax(1000, settings.value("ViewerWindowLines", 20000).toInt());
+        settings.endGroup();
+    }
+    
+    fileContentView->clearExtraHighlights();
+    fileContentView->openWindowed(m_mappedFile, qMax(1, lineNumber), windowLines);
+    
+    updateFilenameDisplay(filePath);
+    m_currentFilePath = filePath;
+    m_viewWindowFile.clear();         // The viewer maps window lines to file lines itself
+    
+    qint64 totalTime = timer.elapsed();
+    LOG_INFO("kOpenWindowedFile: " + QString::number(m_mappedFile->size() / (1024 * 1024)) + " MB shown in " +
+             QString::number(totalTime) + "ms, " + QString::number(windowLines) + " lines at a time");
+    statusBar()->showMessage(QString("File loaded: %1 (%2 MB, windowed, %3ms)")
+                                 .arg(QFileInfo(filePath).fileName())
+                                 .arg(m_mappedFile->size() / (1024 * 1024))
+                                 .arg(totalTime), 3000);
+    
+    logFunctionEnd("kOpenWindowedFile");
+    return true;
+}
+
+FileFingerprint MainWindow::searchedFingerprint(const QString &filePath) const
+{
+    const SearchResultStore &store = collapsibleSearchResults->resultStore();
+    return store.fileFingerprint(store.fileId(filePath));
+}
+
+void MainWindow::logResultClickVisible(const QString &how)
+{
+    if (!m_resultClickTimer.isValid()) {
+        return;
+    }
+    LOG_INFO("Result click to visible line: " + QString::number(m_resultClickTimer.elapsed()) + " ms (" + how + ")");
+    m_resultClickTimer.invalidate();
+}
+
+bool MainWindow::kOpenCompressedFile(const QString& filePath, int lineNumber)
+{
+    logFunctionStart("kOpenCompressedFile");
+    setOpenFileLamp(true);
+    
+    QElapsedTimer timer;
+    timer.start();
+    LOG_INFO("kOpenCompressedFile: Opening " + filePath + " at line " + QString::number(lineNumber));
+    
+    // ===== STEP 1: CHECKPOINT INDEX =====
+    // Loaded from data/zindex, or built by one pass over the file on a worker thread
+    if (!m_compressedFile || m_compressedFile->filePath() != filePath || !m_compressedFile->isCurrent()) {
+        statusBar()->showMessage("Indexing compressed file " + QFileInfo(filePath).fileName() + "...");
         
-        // Clear previous highlights before loading new file content
-        fileContentView->clearExtraHighlights();
-        
-        // Transfer bulk read data to ScintillaEdit
-        fileContentView->setUtf8Bytes(fileData.constData(), fileData.size());
-        qint64 transferTime = timer.elapsed();
+        QSharedPointer<CompressedFile> index;
+        QString error;
+        QThread *thread = QThread::create([&index, &error, filePath]() {
+            index = CompressedFile::open(filePath, &error);
+        });
+        QEventLoop loop;
+        connect(thread, &QThread::finished, &loop, &QEventLoop::quit);
+        thread->start();
+        loop.exec();
+        delete thread;
+        
+        if (!index) {
+            LOG_ERROR("kOpenCompressedFile: " + error);
+            statusBar()->showMessage("Cannot open " + QFileInfo(filePath).fileName() + ": " + error, 5000);
+            setOpenFileLamp(false);
+            logFunctionEnd("kOpenCompressedFile");
+            return false;
+        }
+        m_compressedFile = index;
+        LOG_INFO("kOpenCompressedFile: Index ready after " + QString::number(timer.elapsed()) + "ms - " +
+                 QString::number(index->lineCount()) + " lines, " + QString::number(index->size() / (1024 * 1024)) + " MB decompressed");
     }
     
-    // ===== STEP 6: FILE CLEANUP =====
-    // PURPOSE: Close file handle to free system resources
-    // WHY: File handles are limited system resources and must be released
-    // IMPORTANT: This prevents file handle leaks and allows other processes to access the file
+    // ===== STEP 2: WINDOW AROUND THE LINE =====
+    // Small files are shown whole, large ones from CompressedViewLines around the line
+    QSettings settings("app.ini", QSettings::IniFormat);
+    settings.beginGroup("RGSearch");
+    qint64 windowLines = qMax(1000LL, settings.value("CompressedViewLines", 200000).toLongLong());
+    qint64 wholeBytes = qMax(1LL, settings.value("CompressedViewWholeMB", 64).toLongLong()) * 1024 * 1024;
+    settings.endGroup();
     
-    // Close the file handle to free system resources
-    file.close();
+    qint64 firstLine = 1;
+    qint64 lineCount = m_compressedFile->lineCount();
+    if (m_compressedFile->size() > wholeBytes) {
+        firstLine = qMax<qint64>(1, qMin<qint64>(lineNumber - windowLines / 2, m_compressedFile->lineCount() - windowLines + 1));
+        lineCount = windowLines;
+    }
     
-    // ===== STEP 7: UI STATE UPDATE =====
-    // PURPOSE: Update UI state and file tracking after successful file load
-    // WHY: User interface must reflect the current file and clear any loading states
-    // IMPORTANT: This step ensures the UI is consistent with the loaded file
+    QString error;
+    QByteArray text = m_compressedFile->readLines(firstLine, lineCount, &error);
+    if (!error.isEmpty()) {
+        LOG_ERROR("kOpenCompressedFile: " + error);
+        statusBar()->showMessage("Cannot read " + QFileInfo(filePath).fileName() + ": " + error, 5000);
+        setOpenFileLamp(false);
+        logFunctionEnd("kOpenCompressedFile");
+        return false;
+    }
+    qint64 readTime = timer.elapsed();
     
-    // Update the filename display and current file tracking
-    updateFilenameDisplay(filePath);  // Update the filename label in the UI
-    m_currentFilePath = filePath;     // Store current file path for future operations
+    // ===== STEP 3: TRANSFER TO THE VIEWER =====
+    // Same NUL replacement as a mapped file
+    text.replace('\0', ' ');
+    fileContentView->clearExtraHighlights();
+    fileContentView->setUtf8Bytes(text.constData(), text.size());
     
-    // Clear any loading messages and reset styling
- //   fileContentView->setStyleSheet(""); // Reset styling to remove any loading indicators
- //   fileContentView->update();          // Force UI update to reflect changes
+    qint64 shownLines = text.count('\n') + ((!text.isEmpty() && !text.endsWith('\n')) ? 1 : 0);
+    m_viewWindowFile = filePath;
+    m_viewFirstLine = firstLine;
+    m_viewLastLine = firstLine + shownLines - 1;
     
-    // ===== STEP 8: PERFORMANCE REPORTING =====
-    // PURPOSE: Report performance metrics and provide user feedback
-    // WHY: Performance monitoring helps identify bottlenecks and user needs feedback
-    // IMPORTANT: This step provides visibility into the file loading performance
+    updateFilenameDisplay(filePath);
+    m_currentFilePath = filePath;
+    m_currentFilePath4NonCached.clear();    // The plain file shown before is gone
     
-    // Log total completion time and update status bar
     qint64 totalTime = timer.elapsed();
-    logWidget->append(QString("[%1] === ULTRA-FAST FILE OPEN COMPLETED ===").arg(timestamp));
-    logWidget->append(QString("[%1] Total time: %2ms").arg(timestamp, QString::number(totalTime)));
-    LOG_INFO("kOpenFileTransfetToContentFast: Completed in " + QString::number(totalTime) + "ms");
-    
-    // Show completion message in status bar for user feedback
-    statusBar()->showMessage(QString("File loaded: %1 (%2ms)").arg(QFileInfo(filePath).fileName(), QString::number(totalTime)), 3000);
+    LOG_INFO("kOpenCompressedFile: Lines " + QString::number(m_viewFirstLine) + "-" + QString::number(m_viewLastLine) + " of " +
+             QString::number(m_compressedFile->lineCount()) + " (" + QString::number(text.size() / 1024) + " KB) decompressed in " +
+             QString::number(readTime) + "ms, shown after " + QString::number(totalTime) + "ms");
+    statusBar()->showMessage(QString("File loaded: %1 lines %2-%3 of %4 (%5ms)")
+                                 .arg(QFileInfo(filePath).fileName())
+                                 .arg(m_viewFirstLine).arg(m_viewLastLine).arg(m_compressedFile->lineCount())
+                                 .arg(totalTime), 3000);
     
-    // Deactivate open file status lamp
     setOpenFileLamp(false);
-    
-    logFunctionEnd("kOpenFileTransfetToContentFast");
+    logFunctionEnd("kOpenCompressedFile");
     return true;
 }
 
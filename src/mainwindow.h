@@ -39,6 +39,9 @@
 #include "engineeringdialog.h"
 #include "configurationdialog.h"
 #include "KSearch.h"
+#include "CompressedFile.h"
+#include "MappedLineFile.h"
+#include "DocumentLoader.h"
 
 // Forward declaration
 class LineNumberDelegate;
@@ -78,6 +81,7 @@ public slots:
 private slots:
     void openFile();
     void saveFile();
+    void showProximitySearchDialog();   // Search > Proximity Search...
     void searchText();
     void stopSearch();  // Stop search functionality
     void clearSearch();
@@ -117,7 +121,9 @@ private slots:
     void onScintillaFileLoadError(const QString &error);
     void onFileLineNumberChanged(int fileLine);
     void onLoadingProgress(int chunksLoaded, int totalChunks);
-    void onCollapsibleResultSelected(const QString &filePath, int lineNumber);
+    void onCollapsibleResultSelected(const QString &filePath, int lineNumber, qint64 byteOffset);
+    void onDocumentLoaded(quint64 loadId, const QString &filePath, qint64 bytes, qint64 elapsedMs);
+    void onDocumentLoadFailed(quint64 loadId, const QString &filePath, const QString &error);
 
 signals:
     void sequentialReadCompleted(const QString& fileContent);
@@ -140,7 +146,7 @@ private:
     void KDisplayFile();
     void KRGSearch();
     void KUpdateFileViewer(const QString &filePath, int lineNumber, const QString &lineText);
-    void KUpdateFileViewer2(const QString &filePath, int lineNumber);
+    void KUpdateFileViewer2(const QString &filePath, int lineNumber, qint64 byteOffset = -1);
     void KResultChoose(const QString &filePath, int lineNumber);
 public:
 
@@ -149,7 +155,6 @@ public:
     void onSearchFinished(bool success, int resultCount, const QString& pattern, qint64 searchTime, const QColor& highlightColor);
     
     // Display search results in the Result Pane
-    void KDisplayResultWin(const QString &pattern, const QMap<QString, QVector<Match>> &results);
     void KDisplayResultWin(const QString &pattern, const QString &jsonData, const QString &searchPath = QString());  // New overload for JSON data
     
     // New bulk read methods
@@ -183,8 +188,25 @@ public:
     // Cache integrity verification
     void verifyCacheIntegrity();
     
-    // Fast file opening methods
-    bool kOpenFileTransfetToContentFast(const QString& filePath);
+    // Fast file opening methods (lineNumber picks the window shown of a large or compressed file;
+    // other plain files are loaded in the background and finished by onDocumentLoaded). byteOffset
+    // is where lineNumber starts, if known from the search: the lines around it are shown from
+    // the mapping at once.
+    bool kOpenFileTransfetToContentFast(const QString& filePath, int lineNumber = 1, qint64 byteOffset = -1);
+
+    // Window of lines around lineNumber of a .gz/.zst file, through its checkpoint index
+    bool kOpenCompressedFile(const QString& filePath, int lineNumber);
+    
+    // Large plain file paged into the viewer around lineNumber (false if it cannot be mapped),
+    // windowLines at a time (0: [RGSearch] ViewerWindowLines)
+    bool kOpenWindowedFile(const QString& filePath, int lineNumber, qint64 byteOffset = -1, int windowLines = 0);
+
+    // Version of filePath the listed search results were found in (invalid if it has none):
+    // their byte offsets are line hints for that version only
+    FileFingerprint searchedFingerprint(const QString &filePath) const;
+
+    // Logs the time from the latest result click to its line being on screen, once per click
+    void logResultClickVisible(const QString &how);
     
     // Ultra-fast scroll and highlight function
   //  void FastScrollHighlight(int lineNumber, const QColor& highlightColor = QColor());
@@ -303,6 +325,26 @@ public:
     QString m_currentFilePath;
     QString m_currentFilePath4NonCached;         // Current file path in non-cache mode (for optimization)
     
+    // Compressed file in the viewer: lines m_viewFirstLine..m_viewLastLine of m_viewWindowFile are
+    // shown from viewer line 1 on (empty when a plain file is shown)
+    QSharedPointer<CompressedFile> m_compressedFile;
+    QString m_viewWindowFile;
+    qint64 m_viewFirstLine;
+    qint64 m_viewLastLine;
+    
+    // Plain file from [RGSearch] ViewerWindowedMB on: mapped once and paged into the viewer a
+    // window at a time (ScintillaEdit::openWindowed), which numbers the lines itself
+    QSharedPointer<MappedLineFile> m_mappedFile;
+    
+    // Smaller plain files are read into a document on a worker thread; the line to highlight and
+    // whether to cache the text wait in m_documentLoad* until onDocumentLoaded
+    DocumentLoader *m_documentLoader;
+    int m_documentLoadLine;
+    bool m_documentLoadForCache;
+
+    // Started by a click on a search result, invalid once its line was shown
+    QElapsedTimer m_resultClickTimer;
+    
     // Search parameters (loaded from preferences)
     QString m_searchEngine;
     bool m_caseSensitive;
@@ -389,7 +431,7 @@ public:
     SearchState m_currentState;
     
     // Track which files have been mapped in the current search session with their line offsets
-    QMap<QString, QVector<long>> m_mappedFiles;
+    QMap<QString, QVector<qint64>> m_mappedFiles;
     
     // File cache for keeping multiple files in memory
     QMap<QString, LogDataWorker*> m_fileCache;  // Cache of loaded files
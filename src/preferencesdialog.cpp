@@ -1,4 +1,5 @@
 #include "preferencesdialog.h"
+#include "filesearcher.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QFormLayout>
@@ -56,7 +57,7 @@ PreferencesDialog::PreferencesDialog(QWidget *parent)
     QHBoxLayout *engineLayout = new QHBoxLayout();
     QLabel *engineLabel = new QLabel("Search Engine:");
     searchEngineCombo = new QComboBox();
-    searchEngineCombo->addItems({"ripgrep", "builtin"});
+    searchEngineCombo->addItems(FileSearcher::engineNames());
     engineLayout->addWidget(engineLabel);
     engineLayout->addWidget(searchEngineCombo);
     searchLayout->addLayout(engineLayout);
@@ -82,6 +82,26 @@ void RGSearchDialog::setupUI()
     inclExcludeLayout->addWidget(inclExcludeEdit);
     mainLayout->addLayout(inclExcludeLayout);
     
+    // Time window of timestamped log lines
+    QHBoxLayout *timeWindowLayout = new QHBoxLayout();
+    QLabel *timeWindowLabel = new QLabel("Time window:");
+    timeFromEdit = new QLineEdit();
+    timeFromEdit->setPlaceholderText("from, e.g. 14:02");
+    timeToEdit = new QLineEdit();
+    timeToEdit->setPlaceholderText("to, e.g. 14:10");
+    QString timeWindowTip = "Only search log lines with a timestamp in this window (empty = open)\n\n"
+                            "Examples:\n- 14:02 to 14:10 (on the last day of each log)\n"
+                            "- 2026-10-17 14:02 to 2026-10-17 14:10:30\n\n"
+                            "Logs in time order are searched only between the two times;\n"
+                            "line formats are set by [RGSearch] TimestampFormats in app.ini";
+    timeFromEdit->setToolTip(timeWindowTip);
+    timeToEdit->setToolTip(timeWindowTip);
+    timeWindowLayout->addWidget(timeWindowLabel);
+    timeWindowLayout->addWidget(timeFromEdit);
+    timeWindowLayout->addWidget(new QLabel("-"));
+    timeWindowLayout->addWidget(timeToEdit);
+    mainLayout->addLayout(timeWindowLayout);
+    
     // Keep files in cache checkbox
     QHBoxLayout *cacheLayout = new QHBoxLayout();
     keepFilesInCacheCheckBox = new QCheckBox("Keep searched files in cache");
@@ -290,6 +310,8 @@ RGSearchParams RGSearchDialog::getSearchParams() const
     params.ignore_case = ignoreCaseCheckBox->isChecked();
     params.smart_case = smartCaseCheckBox->isChecked();
     params.incl_exclude = inclExcludeEdit->text();
+    params.time_from = timeFromEdit->text().trimmed();
+    params.time_to = timeToEdit->text().trimmed();
     params.keep_files_in_cache = keepFilesInCacheCheckBox->isChecked();
     params.highlight_color = highlightColor;
     LOG_INFO("RGSearchDialog: getSearchParams returning highlight color: " + params.highlight_color.name());
@@ -317,6 +339,8 @@ void RGSearchDialog::onSearchClicked()
     params.ignore_case = ignoreCaseCheckBox->isChecked();
     params.smart_case = smartCaseCheckBox->isChecked();
     params.incl_exclude = inclExcludeEdit->text();
+    params.time_from = timeFromEdit->text().trimmed();
+    params.time_to = timeToEdit->text().trimmed();
     params.keep_files_in_cache = keepFilesInCacheCheckBox->isChecked();
     params.highlight_color = highlightColor;
     
@@ -347,6 +371,8 @@ void RGSearchDialog::loadSettings()
     ignoreCaseCheckBox->setChecked(settings.value("LastIgnoreCase", false).toBool());
     smartCaseCheckBox->setChecked(settings.value("LastSmartCase", false).toBool());
     inclExcludeEdit->setText(settings.value("LastInclExclude", "").toString());
+    timeFromEdit->setText(settings.value("LastTimeFrom", "").toString());
+    timeToEdit->setText(settings.value("LastTimeTo", "").toString());
     keepFilesInCacheCheckBox->setChecked(settings.value("LastKeepFilesInCache", false).toBool());
     highlightColor = settings.value("LastHighlightColor", QColor(130, 130, 130)).value<QColor>();
     
@@ -376,6 +402,8 @@ void RGSearchDialog::saveSettings()
     settings.setValue("LastIgnoreCase", ignoreCaseCheckBox->isChecked());
     settings.setValue("LastSmartCase", smartCaseCheckBox->isChecked());
     settings.setValue("LastInclExclude", inclExcludeEdit->text());
+    settings.setValue("LastTimeFrom", timeFromEdit->text().trimmed());
+    settings.setValue("LastTimeTo", timeToEdit->text().trimmed());
     settings.setValue("LastKeepFilesInCache", keepFilesInCacheCheckBox->isChecked());
     settings.setValue("LastHighlightColor", highlightColor);
     
@@ -462,6 +490,8 @@ void RGSearchDialog::onSaveParamsClicked()
     paramsFile.setValue("IgnoreCase", ignoreCaseCheckBox->isChecked());
     paramsFile.setValue("SmartCase", smartCaseCheckBox->isChecked());
     paramsFile.setValue("InclExclude", inclExcludeEdit->text());
+    paramsFile.setValue("TimeFrom", timeFromEdit->text().trimmed());
+    paramsFile.setValue("TimeTo", timeToEdit->text().trimmed());
     paramsFile.setValue("KeepFilesInCache", keepFilesInCacheCheckBox->isChecked());
     paramsFile.setValue("HighlightColor", highlightColor);
     
@@ -504,6 +534,8 @@ void RGSearchDialog::onLoadParamsClicked()
     ignoreCaseCheckBox->setChecked(paramsFile.value("IgnoreCase", false).toBool());
     smartCaseCheckBox->setChecked(paramsFile.value("SmartCase", false).toBool());
     inclExcludeEdit->setText(paramsFile.value("InclExclude", "").toString());
+    timeFromEdit->setText(paramsFile.value("TimeFrom", "").toString());
+    timeToEdit->setText(paramsFile.value("TimeTo", "").toString());
     keepFilesInCacheCheckBox->setChecked(paramsFile.value("KeepFilesInCache", false).toBool());
     highlightColor = paramsFile.value("HighlightColor", QColor(130, 130, 130)).value<QColor>();
     
@@ -63,6 +63,8 @@ private:
     QCheckBox *ignoreCaseCheckBox;
     QCheckBox *smartCaseCheckBox;
     QLineEdit *inclExcludeEdit;
+    QLineEdit *timeFromEdit;              // Time window of timestamped log lines
+    QLineEdit *timeToEdit;
     QCheckBox *keepFilesInCacheCheckBox;  // Keep searched files in cache
     
     // Highlight color picker
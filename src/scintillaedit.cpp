@@ -1,5 +1,6 @@
 #include "scintillaedit.h"
 #include "highlightdialog.h"
+#include "MappedLineFile.h"
 #include "logger.h"
 #include <QDebug>
 #include <QFile>
@@ -13,6 +14,7 @@
 #include <QMessageBox>
 #include <QElapsedTimer> // Added for fast search/highlight timing
 #include <QRegularExpression>
+#include <climits>
 
 #ifdef Q_OS_WIN
 #include <windows.h>
@@ -73,7 +75,7 @@ bool openFileWithWindowsSharing(QFile* file)
 #endif
 }
 
-ScintillaEdit::ScintillaEdit(QWidget *parent) : ScintillaEditBase(parent), m_highlightedLine(-1), m_lineOffset(0), m_showFileLineNumbers(true), m_loadedStartLine(0), m_loadedEndLine(0), m_chunkSize(KLOGG_INDEXING_BLOCK_SIZE), m_firstChunkSize(KLOGG_INDEXING_BLOCK_SIZE), m_loadingTimer(nullptr), m_fileStream(nullptr), m_progressiveFile(nullptr), m_totalLines(0), m_currentChunk(0), m_totalChunks(0), m_targetLine(0), m_contextLines(0), m_isProgressiveLoading(false), m_abortLoading(false), m_isIndexed(false), m_scrollTimer(nullptr), m_lastFirstVisibleLine(-1), m_lastVisibleLineCount(0), m_useViewportHighlighting(false), m_scrollingInProgress(false), m_cachedCaseSensitive(false), m_cachedHighlightSentence(false), m_cachedUseScintillaSearch(false), m_backgroundHighlightTimer(nullptr), m_idleTimer(nullptr), m_continuousTimer(nullptr), m_backgroundHighlightLine(0), m_backgroundChunkSize(1000), m_userActive(false), m_fullyHighlightedFile(false), m_backgroundHighlightingActive(false), m_backgroundCaseSensitive(false), m_backgroundHighlightSentence(false)
+ScintillaEdit::ScintillaEdit(QWidget *parent) : ScintillaEditBase(parent), m_highlightedLine(-1), m_lineOffset(0), m_showFileLineNumbers(true), m_loadedStartLine(0), m_loadedEndLine(0), m_chunkSize(KLOGG_INDEXING_BLOCK_SIZE), m_firstChunkSize(KLOGG_INDEXING_BLOCK_SIZE), m_loadingTimer(nullptr), m_fileStream(nullptr), m_progressiveFile(nullptr), m_totalLines(0), m_currentChunk(0), m_totalChunks(0), m_targetLine(0), m_contextLines(0), m_isProgressiveLoading(false), m_abortLoading(false), m_isIndexed(false), m_scrollTimer(nullptr), m_lastFirstVisibleLine(-1), m_lastVisibleLineCount(0), m_useViewportHighlighting(false), m_scrollingInProgress(false), m_cachedCaseSensitive(false), m_cachedHighlightSentence(false), m_cachedUseScintillaSearch(false), m_backgroundHighlightTimer(nullptr), m_idleTimer(nullptr), m_continuousTimer(nullptr), m_backgroundHighlightLine(0), m_backgroundChunkSize(1000), m_userActive(false), m_fullyHighlightedFile(false), m_backgroundHighlightingActive(false), m_backgroundCaseSensitive(false), m_backgroundHighlightSentence(false), m_windowLines(0), m_windowLastLine(0), m_windowStartOffset(0), m_windowEndOffset(0), m_windowEstimated(false), m_windowHighlightLine(-1), m_paging(false), m_fileScrollBar(nullptr), m_fileScrollScale(1), m_updatingFileScrollBar(false), m_windowIndexTimer(nullptr)
 {
 
     
@@ -119,6 +121,17 @@ ScintillaEdit::ScintillaEdit(QWidget *parent) : ScintillaEditBase(parent), m_hig
     // Connect viewport highlighting scroll detection
     connect(this, &ScintillaEdit::verticalScrolled, this, &ScintillaEdit::onScrolled);
     
+    // Windowed view: file scroll bar (placed by the owner next to the view) and paging
+    m_fileScrollBar = new QScrollBar(Qt::Vertical, this);
+    m_fileScrollBar->hide();
+    connect(m_fileScrollBar, &QScrollBar::valueChanged, this, &ScintillaEdit::onFileScrollBarMoved);
+    connect(this, &ScintillaEditBase::verticalScrolled, this, &ScintillaEdit::onWindowScrolled);
+    connect(this, &ScintillaEditBase::resized, this, &ScintillaEdit::onWindowScrolled);
+    
+    m_windowIndexTimer = new QTimer(this);
+    m_windowIndexTimer->setInterval(500);
+    connect(m_windowIndexTimer, &QTimer::timeout, this, &ScintillaEdit::updateFileScrollBar);
+    
 
 }
 
@@ -399,6 +412,7 @@ void ScintillaEdit::scrollToLine(int lineNumber)
         qWarning() << "ScintillaEdit: Invalid line number for scrolling:" << lineNumber;
         return;
     }
+    ensureLineInWindow(lineNumber);
     
     // Get current scroll position before scrolling
     int currentFirstVisibleLine = send(SCI_GETFIRSTVISIBLELINE);
@@ -516,6 +530,7 @@ void ScintillaEdit::highlightLine(int lineNumber)
         qWarning() << "ScintillaEdit: Invalid line number for highlighting:" << lineNumber;
         return;
     }
+    ensureLineInWindow(lineNumber);
     
     // Subtract 1 from target line (convert from 1-based to 0-based)
     int adjustedLineNumber = lineNumber - 1;
@@ -571,6 +586,7 @@ void ScintillaEdit::highlightLine(int lineNumber)
     send(SCI_INDICATORFILLRANGE, lineStart, lineEnd - lineStart);
     
     m_highlightedLine = lineNumber; // Store the original file line number
+    m_windowHighlightLine = isWindowed() ? lineNumber : -1;
     
     qDebug() << "ScintillaEdit: Display line highlighted:" << displayLine << "with color:" << highlightColor.name();
 }
@@ -586,6 +602,7 @@ void ScintillaEdit::clearHighlight()
         
         m_highlightedLine = -1;
     }
+    m_windowHighlightLine = -1;
 }
 
 int ScintillaEdit::getFileLineNumber(int displayLine) const
@@ -720,6 +737,7 @@ QString ScintillaEdit::getText() const
 void ScintillaEdit::setText(const QString &text)
 {
     qDebug() << "ScintillaEdit: Setting text, length:" << text.length();
+    closeWindowed();
     
     QByteArray utf8Data = text.toUtf8();
     send(SCI_SETTEXT, 0, reinterpret_cast<sptr_t>(utf8Data.data()));
@@ -727,12 +745,13 @@ void ScintillaEdit::setText(const QString &text)
     emit textChanged();
 }
 
-void ScintillaEdit::setUtf8Bytes(const char* data, int length)
+void ScintillaEdit::setUtf8Bytes(const char* data, qint64 length)
 {
     if (data == nullptr || length <= 0) {
         qWarning() << "ScintillaEdit::setUtf8Bytes: invalid input";
         return;
     }
+    closeWindowed();
     // Note: SCI_SETTEXT expects a NUL-terminated buffer; for raw bytes of known length,
     // we prefer SCI_ADDTEXT after clearing or SCI_SETREADONLY/SCI_CLEARALL + SCI_ADDTEXT.
     send(SCI_CLEARALL);
@@ -740,6 +759,28 @@ void ScintillaEdit::setUtf8Bytes(const char* data, int length)
     emit textChanged();
 }
 
+void ScintillaEdit::attachDocument(void *document)
+{
+    if (document == nullptr) {
+        qWarning() << "ScintillaEdit::attachDocument: no document";
+        return;
+    }
+    closeWindowed();
+    
+    // Tab settings and read-only belong to the document, not to the view
+    sptr_t tabWidth = send(SCI_GETTABWIDTH);
+    sptr_t useTabs = send(SCI_GETUSETABS);
+    sptr_t readOnly = send(SCI_GETREADONLY);
+    
+    send(SCI_SETDOCPOINTER, 0, reinterpret_cast<sptr_t>(document));
+    send(SCI_RELEASEDOCUMENT, 0, reinterpret_cast<sptr_t>(document));  // The view holds it now
+    
+    send(SCI_SETTABWIDTH, tabWidth);
+    send(SCI_SETUSETABS, useTabs);
+    send(SCI_SETREADONLY, readOnly);
+    emit textChanged();
+}
+
 void ScintillaEdit::appendText(const QString &text)
 {
     qDebug() << "ScintillaEdit: Appending text, length:" << text.length();
@@ -756,6 +797,7 @@ void ScintillaEdit::appendText(const QString &text)
 void ScintillaEdit::clearText()
 {
     qDebug() << "ScintillaEdit: Clearing text";
+    closeWindowed();
     
     send(SCI_CLEARALL);
     emit textChanged();
@@ -853,8 +895,10 @@ void ScintillaEdit::updateLineNumbers()
     int totalLines = send(SCI_GETLINECOUNT);
     
     // Create a custom margin to show file line numbers
-    // We'll use margin 1 for custom line numbers
-    send(SCI_SETMARGINWIDTHN, 1, 80); // Make it wider for 8-digit line numbers
+    // We'll use margin 1 for custom line numbers, wide enough for the last one (at least 8 digits)
+    QByteArray widest = QByteArray::number(qint64(m_lineOffset) + totalLines).fill('9') + "_";
+    int marginWidth = qMax(80, int(send(SCI_TEXTWIDTH, STYLE_LINENUMBER, reinterpret_cast<sptr_t>(widest.constData()))));
+    send(SCI_SETMARGINWIDTHN, 1, marginWidth);
     send(SCI_SETMARGINTYPEN, 1, SC_MARGIN_TEXT);
     
     // Clear any existing text in the margin
@@ -863,7 +907,8 @@ void ScintillaEdit::updateLineNumbers()
     // Add file line numbers to the margin
     for (int i = 0; i < totalLines; i++) {
         int fileLineNumber = m_lineOffset + i + 1;
-        QString lineNumberText = QString::number(fileLineNumber);
+        // Numbers of a window placed by an estimate are approximate until the index gets there
+        QString lineNumberText = (m_windowEstimated ? "~" : "") + QString::number(fileLineNumber);
         
         // Always show the calculated line number, even if it's the same as display line
         // This ensures users can see the actual file line numbers
@@ -1890,8 +1935,8 @@ void ScintillaEdit::highlightExtra(const QList<HighlightRule> &rules, bool caseS
             searchIterations++;
         QRegularExpressionMatch match = it.next();
         
-        int startPos = match.capturedStart();
-        int endPos = match.capturedEnd();
+        qsizetype startPos = match.capturedStart();
+        qsizetype endPos = match.capturedEnd();
         QString matchedText = match.captured();
         
         // Determine which rule/pattern matched this text
@@ -1912,8 +1957,8 @@ void ScintillaEdit::highlightExtra(const QList<HighlightRule> &rules, bool caseS
             
             if (highlightSentence) {
                 // Find the start and end of the line containing the match
-                int lineStart = send(SCI_POSITIONFROMLINE, send(SCI_LINEFROMPOSITION, startPos));
-                int lineEnd = send(SCI_GETLINEENDPOSITION, send(SCI_LINEFROMPOSITION, startPos));
+                Scintilla::Position lineStart = send(SCI_POSITIONFROMLINE, send(SCI_LINEFROMPOSITION, startPos));
+                Scintilla::Position lineEnd = send(SCI_GETLINEENDPOSITION, send(SCI_LINEFROMPOSITION, startPos));
                 send(SCI_INDICATORFILLRANGE, lineStart, lineEnd - lineStart);
                 
                 // Log first 10 matches for debugging
@@ -2182,10 +2227,10 @@ void ScintillaEdit::highlightViewportOnly(const QList<HighlightRule> &rules, boo
         QRegularExpressionMatch match = it.next();
         
         // Convert relative positions back to document positions
-        int relativeStartPos = match.capturedStart();
-        int relativeEndPos = match.capturedEnd();
-        int docStartPos = startPos + relativeStartPos;
-        int docEndPos = startPos + relativeEndPos;
+        qsizetype relativeStartPos = match.capturedStart();
+        qsizetype relativeEndPos = match.capturedEnd();
+        Scintilla::Position docStartPos = startPos + relativeStartPos;
+        Scintilla::Position docEndPos = startPos + relativeEndPos;
         
         QString matchedText = match.captured();
         
@@ -2207,8 +2252,8 @@ void ScintillaEdit::highlightViewportOnly(const QList<HighlightRule> &rules, boo
             
             if (highlightSentence) {
                 // Find the start and end of the line containing the match
-                int lineStart = send(SCI_POSITIONFROMLINE, send(SCI_LINEFROMPOSITION, docStartPos));
-                int lineEnd = send(SCI_GETLINEENDPOSITION, send(SCI_LINEFROMPOSITION, docStartPos));
+                Scintilla::Position lineStart = send(SCI_POSITIONFROMLINE, send(SCI_LINEFROMPOSITION, docStartPos));
+                Scintilla::Position lineEnd = send(SCI_GETLINEENDPOSITION, send(SCI_LINEFROMPOSITION, docStartPos));
                 send(SCI_INDICATORFILLRANGE, lineStart, lineEnd - lineStart);
             } else {
                 // Highlight just the matched phrase
@@ -2456,14 +2501,14 @@ void ScintillaEdit::onBackgroundHighlightChunk()
             
             if (!lineAlreadyHighlighted) {
                 // Get text for this line
-                int lineStart = send(SCI_POSITIONFROMLINE, currentLine);
-                int lineEnd = send(SCI_GETLINEENDPOSITION, currentLine);
-                int textLength = lineEnd - lineStart;
+                Scintilla::Position lineStart = send(SCI_POSITIONFROMLINE, currentLine);
+                Scintilla::Position lineEnd = send(SCI_GETLINEENDPOSITION, currentLine);
+                Scintilla::Position textLength = lineEnd - lineStart;
                 
                 if (textLength > 0) {
                     QByteArray textData(textLength + 1, '\0');
-                    struct Sci_TextRange tr = {{lineStart, lineEnd}, textData.data()};
-                    send(SCI_GETTEXTRANGE, 0, reinterpret_cast<sptr_t>(&tr));
+                    struct Sci_TextRangeFull tr = {{lineStart, lineEnd}, textData.data()};
+                    send(SCI_GETTEXTRANGEFULL, 0, reinterpret_cast<sptr_t>(&tr));
                     QString lineText = QString::fromUtf8(textData.constData());
                     
                     // Apply highlighting to this line
@@ -2477,7 +2522,7 @@ void ScintillaEdit::onBackgroundHighlightChunk()
                             
                             int captureIndex = i + 1;
                             if (captureIndex < match.capturedTexts().size() && !match.captured(captureIndex).isEmpty()) {
-                                int matchStart = lineStart + match.capturedStart();
+                                Scintilla::Position matchStart = lineStart + match.capturedStart();
                                 int matchLength = match.capturedLength();
                                 
                                 if (m_backgroundHighlightSentence) {
@@ -2551,17 +2596,17 @@ void ScintillaEdit::onBackgroundHighlightChunk()
         } else {
         // Highlight this chunk using the same logic as viewport highlighting
         // Get text for this range
-        int startPos = send(SCI_POSITIONFROMLINE, m_backgroundHighlightLine);
-        int endPos = send(SCI_POSITIONFROMLINE, chunkEndLine);
+        Scintilla::Position startPos = send(SCI_POSITIONFROMLINE, m_backgroundHighlightLine);
+        Scintilla::Position endPos = send(SCI_POSITIONFROMLINE, chunkEndLine);
         if (chunkEndLine >= totalLines) {
             endPos = send(SCI_GETTEXTLENGTH);
         }
         
-        int textLength = endPos - startPos;
+        Scintilla::Position textLength = endPos - startPos;
         if (textLength > 0) {
             QByteArray textData(textLength + 1, '\0');
-            struct Sci_TextRange tr = {{startPos, endPos}, textData.data()};
-            send(SCI_GETTEXTRANGE, 0, reinterpret_cast<sptr_t>(&tr));
+            struct Sci_TextRangeFull tr = {{startPos, endPos}, textData.data()};
+            send(SCI_GETTEXTRANGEFULL, 0, reinterpret_cast<sptr_t>(&tr));
             QString chunkText = QString::fromUtf8(textData.constData());
             
             // Build combined pattern for all enabled rules
@@ -2592,14 +2637,14 @@ void ScintillaEdit::onBackgroundHighlightChunk()
                         int captureIndex = i + 1; // Capture groups start at 1
                         if (captureIndex < match.capturedTexts().size() && !match.captured(captureIndex).isEmpty()) {
                             // This rule matched
-                            int matchStart = startPos + match.capturedStart();
+                            Scintilla::Position matchStart = startPos + match.capturedStart();
                             int matchLength = match.capturedLength();
                             
                             if (m_backgroundHighlightSentence) {
                                 // Highlight entire line
                                 int lineNum = send(SCI_LINEFROMPOSITION, matchStart);
-                                int lineStart = send(SCI_POSITIONFROMLINE, lineNum);
-                                int lineEnd = send(SCI_GETLINEENDPOSITION, lineNum);
+                                Scintilla::Position lineStart = send(SCI_POSITIONFROMLINE, lineNum);
+                                Scintilla::Position lineEnd = send(SCI_GETLINEENDPOSITION, lineNum);
                                 
                                 send(SCI_SETINDICATORCURRENT, 2 + (i % 10));
                                 send(SCI_INDICSETSTYLE, 2 + (i % 10), INDIC_ROUNDBOX);
@@ -2786,4 +2831,211 @@ void ScintillaEdit::onUserIdle()
         LOG_WARNING("ScintillaEdit: Exception in onUserIdle: " + QString(e.what()));
     }
     
-} 
\ No newline at end of file
+} 
+// ===== WINDOWED VIEW =====
+// A mapped file too large to hand to Scintilla whole: the document is a window of m_windowLines
+// file lines starting after m_lineOffset, re-read from the mapping and centered on the top of
+// the viewport whenever the viewport gets within a quarter window of either end of it.
+
+void ScintillaEdit::openWindowed(const QSharedPointer<MappedLineFile> &file, qint64 lineNumber, int windowLines)
+{
+    LOG_INFO("ScintillaEdit: Windowed view of " + file->filePath() + " at line " + QString::number(lineNumber) +
+             ", " + QString::number(windowLines) + " lines at a time");
+    
+    m_windowFile = file;
+    m_windowLines = qMax(WINDOW_MIN_LINES, windowLines);
+    m_windowHighlightLine = -1;
+    
+    // The window is not edited, and Scintilla's own scroll bar and numbers only cover the window
+    send(SCI_SETUNDOCOLLECTION, 0);
+    send(SCI_SETVSCROLLBAR, 0);
+    send(SCI_SETMARGINWIDTHN, 0, 0);
+    send(SCI_SETMARGINTYPEN, 1, SC_MARGIN_TEXT);
+    m_fileScrollBar->show();
+    if (!file->isIndexed()) {
+        m_windowIndexTimer->start();
+    }
+    
+    int linesOnScreen = send(SCI_LINESONSCREEN);
+    pageWindow(qMax<qint64>(1, lineNumber - linesOnScreen / 2));
+}
+
+void ScintillaEdit::closeWindowed()
+{
+    if (!m_windowFile) {
+        return;
+    }
+    LOG_INFO("ScintillaEdit: Windowed view of " + m_windowFile->filePath() + " closed");
+    
+    m_windowFile.reset();
+    m_lineOffset = 0;
+    m_windowHighlightLine = -1;
+    m_windowIndexTimer->stop();
+    m_fileScrollBar->hide();
+    
+    send(SCI_MARGINTEXTCLEARALL);
+    send(SCI_SETMARGINWIDTHN, 1, 0);
+    send(SCI_SETMARGINWIDTHN, 0, 50);
+    send(SCI_SETVSCROLLBAR, 1);
+    send(SCI_SETUNDOCOLLECTION, 1);
+}
+
+void ScintillaEdit::pageWindow(qint64 topLine)
+{
+    if (!m_windowFile || m_paging) {
+        return;
+    }
+    m_paging = true;
+    
+    QElapsedTimer timer;
+    timer.start();
+    
+    // ===== READ THE WINDOW =====
+    qint64 firstLine = qMax<qint64>(1, topLine - m_windowLines / 2);
+    qint64 startOffset = 0;
+    bool estimated = false;
+    QByteArray text = m_windowFile->readLines(firstLine, m_windowLines, WINDOW_MAX_BYTES, &startOffset, &estimated);
+    if (text.isEmpty() && firstLine > 1) {
+        // Past the end of a file whose line count was only projected: show its last lines
+        qint64 lastLine = m_windowFile->lineCount();
+        firstLine = qMax<qint64>(1, qMin(firstLine, lastLine) - m_windowLines / 2);
+        text = m_windowFile->readLines(firstLine, m_windowLines, WINDOW_MAX_BYTES, &startOffset, &estimated);
+        topLine = qMin(topLine, lastLine);
+    }
+    
+    // ===== REPLACE THE DOCUMENT =====
+    bool readOnly = send(SCI_GETREADONLY) != 0;
+    send(SCI_SETREADONLY, 0);
+    send(SCI_CLEARALL);
+    send(SCI_ADDTEXT, text.size(), reinterpret_cast<sptr_t>(text.constData()));
+    send(SCI_EMPTYUNDOBUFFER);
+    send(SCI_SETREADONLY, readOnly ? 1 : 0);
+    
+    qint64 shownLines = text.count('\n') + ((!text.isEmpty() && !text.endsWith('\n')) ? 1 : 0);
+    m_lineOffset = int(firstLine - 1);
+    m_windowLastLine = firstLine + shownLines - 1;
+    m_windowStartOffset = startOffset;
+    m_windowEndOffset = startOffset + text.size();
+    m_windowEstimated = estimated;
+    
+    // Highlights of the previous window are gone
+    m_highlightedRanges.clear();
+    m_fullyHighlightedFile = false;
+    m_backgroundHighlightLine = 0;
+    
+    updateLineNumbers();
+    
+    // ===== RESTORE THE VIEWPORT =====
+    qint64 topDocLine = qBound<qint64>(0, topLine - firstLine, qMax<qint64>(0, shownLines - 1));
+    send(SCI_SETFIRSTVISIBLELINE, send(SCI_VISIBLEFROMDOCLINE, topDocLine));
+    if (m_windowHighlightLine > m_lineOffset && m_windowHighlightLine <= m_windowLastLine) {
+        highlightLine(int(m_windowHighlightLine));
+    }
+    
+    m_paging = false;
+    updateFileScrollBar();
+    
+    // Viewport highlighting of the new window once scrolling stops
+    m_scrollTimer->start();
+    
+    LOG_INFO("ScintillaEdit: Window lines " + QString::number(firstLine) + "-" + QString::number(m_windowLastLine) +
+             " (" + QString::number(text.size() / 1024) + " KB) paged in " + QString::number(timer.elapsed()) + "ms" +
+             (m_windowEstimated ? ", line numbers estimated" : ""));
+}
+
+void ScintillaEdit::correctWindowLines()
+{
+    if (!m_windowFile || !m_windowEstimated || m_paging) {
+        return;
+    }
+    qint64 firstLine = m_windowFile->lineAt(m_windowStartOffset);
+    if (firstLine < 0) {
+        return;     // The index is not there yet
+    }
+    
+    // Same text, renumbered: the viewport stays where it is
+    qint64 shift = firstLine - (m_lineOffset + 1);
+    m_lineOffset = int(firstLine - 1);
+    m_windowLastLine += shift;
+    m_windowEstimated = false;
+    updateLineNumbers();
+    LOG_INFO("ScintillaEdit: Estimated window corrected by " + QString::number(shift) + " lines, now lines " +
+             QString::number(firstLine) + "-" + QString::number(m_windowLastLine));
+    
+    // The highlighted line was asked for by number: move the highlight to where it really is
+    if (m_windowHighlightLine > 0) {
+        highlightLine(int(m_windowHighlightLine));
+    }
+}
+
+void ScintillaEdit::ensureLineInWindow(qint64 lineNumber)
+{
+    if (!m_windowFile || m_paging) {
+        return;
+    }
+    if (lineNumber <= m_lineOffset || lineNumber > m_windowLastLine) {
+        pageWindow(qMax<qint64>(1, lineNumber - send(SCI_LINESONSCREEN) / 2));
+    }
+}
+
+void ScintillaEdit::onWindowScrolled()
+{
+    if (!m_windowFile || m_paging) {
+        return;
+    }
+    
+    qint64 topDocLine = send(SCI_DOCLINEFROMVISIBLE, send(SCI_GETFIRSTVISIBLELINE));
+    qint64 windowLines = send(SCI_GETLINECOUNT);
+    qint64 linesOnScreen = send(SCI_LINESONSCREEN);
+    qint64 margin = m_windowLines / 4;
+    
+    bool nearStart = topDocLine < margin && m_lineOffset > 0;
+    bool nearEnd = topDocLine + linesOnScreen > windowLines - margin && m_windowEndOffset < m_windowFile->size();
+    if (nearStart || nearEnd) {
+        pageWindow(m_lineOffset + topDocLine + 1);
+    } else {
+        updateFileScrollBar();
+    }
+}
+
+void ScintillaEdit::updateFileScrollBar()
+{
+    if (!m_windowFile) {
+        return;
+    }
+    
+    // Runs with the index timer until the index is complete
+    correctWindowLines();
+    
+    qint64 totalLines = qMax(m_windowFile->lineCount(), m_windowLastLine);
+    qint64 linesOnScreen = qMax<qint64>(1, send(SCI_LINESONSCREEN));
+    qint64 topLine = m_lineOffset + send(SCI_DOCLINEFROMVISIBLE, send(SCI_GETFIRSTVISIBLELINE)) + 1;
+    m_fileScrollScale = totalLines / (INT_MAX / 2) + 1;
+    
+    m_updatingFileScrollBar = true;
+    m_fileScrollBar->setRange(0, int(qMax<qint64>(0, totalLines - linesOnScreen) / m_fileScrollScale));
+    m_fileScrollBar->setPageStep(int(qMax<qint64>(1, linesOnScreen / m_fileScrollScale)));
+    m_fileScrollBar->setValue(int((topLine - 1) / m_fileScrollScale));
+    // Until the whole file is indexed a far line is only estimated - jump on release only
+    m_fileScrollBar->setTracking(m_windowFile->isIndexed());
+    m_updatingFileScrollBar = false;
+    
+    if (m_windowFile->isIndexed()) {
+        m_windowIndexTimer->stop();
+    }
+}
+
+void ScintillaEdit::onFileScrollBarMoved(int value)
+{
+    if (!m_windowFile || m_updatingFileScrollBar) {
+        return;
+    }
+    
+    qint64 topLine = qint64(value) * m_fileScrollScale + 1;
+    if (topLine > m_lineOffset && topLine <= m_windowLastLine) {
+        // In the window: scroll Scintilla, which pages once near an end
+        send(SCI_SETFIRSTVISIBLELINE, send(SCI_VISIBLEFROMDOCLINE, topLine - m_lineOffset - 1));
+    } else {
+        pageWindow(topLine);
+    }
+}
@@ -14,6 +14,7 @@
 #include <QTimer> // Added for QTimer
 #include <QVector> // Added for QVector
 #include <QMutex> // Added for QMutex
+#include <QSharedPointer>
 
 // Include Scintilla headers
 #include "ScintillaEditBase.h"
@@ -23,6 +24,7 @@
 
 // Forward declaration
 struct HighlightRule;
+class MappedLineFile;
 
 class ScintillaEdit : public ScintillaEditBase
 {
@@ -45,12 +47,23 @@ public:
     void setText(const QString &text);
     void appendText(const QString &text);
     // Fast path: set UTF-8 bytes directly without converting from QString
-    void setUtf8Bytes(const char* data, int length);
+    void setUtf8Bytes(const char* data, qint64 length);
+    // Show a document built off the UI thread (SCI_CREATELOADER, see DocumentLoader) in place of
+    // the current one; takes over the caller's reference
+    void attachDocument(void *document);
     void clearText();
     
     // Line count operations
     int lineCount() const;
     
+    // Windowed view of a large mapped file: Scintilla holds only windowLines lines around the
+    // viewport, paged from file as the view scrolls. Line numbers (margin, scrollToLine,
+    // highlightLine) are file lines and fileScrollBar() covers the whole file. Any other text
+    // set ends the windowed view.
+    void openWindowed(const QSharedPointer<MappedLineFile> &file, qint64 lineNumber, int windowLines);
+    bool isWindowed() const { return !m_windowFile.isNull(); }
+    QScrollBar *fileScrollBar() const { return m_fileScrollBar; }
+    
     // Scintilla specific operations
     void setReadOnly(bool readOnly);
     void setLineNumbers(bool show);
@@ -109,6 +122,11 @@ private slots:
     void onScrolled();
     void onScrollStopped();
     
+    // Windowed view slots
+    void onWindowScrolled();
+    void onFileScrollBarMoved(int value);
+    void updateFileScrollBar();
+    
     // Background highlighting slots
     void onBackgroundHighlightChunk(); // Process next chunk
     void onUserActivity();              // User became active
@@ -173,6 +191,23 @@ private:
     bool m_backgroundCaseSensitive;         // Settings for background highlighting
     bool m_backgroundHighlightSentence;     // Settings for background highlighting
     
+    // Windowed view of a mapped file (m_lineOffset is the line before the window)
+    QSharedPointer<MappedLineFile> m_windowFile;
+    int m_windowLines;                      // Lines paged in at a time
+    qint64 m_windowLastLine;                // Last file line in Scintilla
+    qint64 m_windowStartOffset;             // File offset of the first window line
+    qint64 m_windowEndOffset;               // File offset after the window
+    bool m_windowEstimated;                 // Window numbered from an estimate, until the index gets there
+    qint64 m_windowHighlightLine;           // File line of highlightLine, kept across pages
+    bool m_paging;
+    QScrollBar *m_fileScrollBar;            // Whole file in lines, replaces Scintilla's
+    qint64 m_fileScrollScale;               // File lines per scroll bar step (> 1 past INT_MAX lines)
+    bool m_updatingFileScrollBar;
+    QTimer *m_windowIndexTimer;             // Scroll bar range while the file is still indexed
+    
+    static constexpr qint64 WINDOW_MAX_BYTES = 16 * 1024 * 1024;
+    static constexpr int WINDOW_MIN_LINES = 200;
+    
     // KLOGG constants
     static constexpr int KLOGG_INDEXING_BLOCK_SIZE = 5 * 1024 * 1024; // 5MB like KLOGG
     static constexpr int KLOGG_PREFETCH_BUFFER_SIZE_MB = 16; // 16MB like KLOGG
@@ -190,6 +225,12 @@ private:
     qint64 getLineOffset(int lineNumber) const;
     QString getLineAtOffset(qint64 startOffset, qint64 endOffset) const;
     void loadLinesFromIndex(int startLine, int endLine);
+    
+    // Windowed view
+    void pageWindow(qint64 topLine);
+    void ensureLineInWindow(qint64 lineNumber);
+    void correctWindowLines();              // Exact numbers for an estimated window, once indexed
+    void closeWindowed();
 };
 
 #endif // SCINTILLAEDIT_H 
\ No newline at end of file